@@ -2,7 +2,12 @@
 #define JSONFILEMANAGER_H
 #include <fstream>
 #include <nlohmann/json.hpp>
+#include "exchange/kvJsonScanner.h"
+#include "utils/compression.h"
+#include "utils/ioBackend.h"
 #include "utils/kvEntry.h"
+#include "utils/metrics.h"
+#include "utils/workerBuffers.h"
 using json = nlohmann::json;
 
 // 使用虚拟函数来支持 Mock
@@ -13,6 +18,10 @@ public:
 
     // 解析 JSON 文件的纯虚函数
     virtual DataType parse(const std::string &jsonStr) = 0; // 改为虚函数
+    // 提示 filePath 即将被解析，可提前发起读取
+    virtual void prefetch(const std::string &filePath) { (void)filePath; }
+    // 解析时可用于并行子任务（按帧解压）的调度器，nullptr 表示在调用线程内完成
+    virtual void setScheduler(TaskScheduler *scheduler) { (void)scheduler; }
 
 protected:
     JsonFileManagerBase() = default;
@@ -21,13 +30,51 @@ protected:
 class JsonFileManager : public JsonFileManagerBase
 {
 public:
+    // 快速路径与 nlohmann 解析结果一致，关闭仅用于对比
+    void setFastParse(bool fastParse) { fastParse_ = fastParse; }
+    bool getFastParse() const { return fastParse_; }
+    void setIoBackend(const std::shared_ptr<IoBackend> &backend) { backend_ = backend; }
+
+    void prefetch(const std::string &filePath) override { backend_->prefetch(filePath); }
+    void setScheduler(TaskScheduler *scheduler) override { scheduler_ = scheduler; }
+
     DataType parse(const std::string &filePath)
     {
-        json j = load(filePath);
-        KvData data;
+        static MetricsHistogram &parseLatency = metricsHistogram("bingest_exchange_parse_ns", "JsonFileManager::parse latency per file");
+        static MetricsCounter &parsedEntries = metricsCounter("bingest_exchange_parsed_entries_total", "entries parsed from kv json");
+        static MetricsCounter &fallbacks = metricsCounter("bingest_exchange_parse_fallback_total", "files the KV scanner handed back to nlohmann::json");
+        ScopedLatency timer(parseLatency);
+        FileBufferLease fileBuffer;
+        const std::string &buffer = read(filePath, *fileBuffer);
+        KvData data = WorkerBuffers::local().takeVector();
+        if (fastParse_)
+        {
+            if (!scanner_.parse(buffer.data(), buffer.size(), data).isError())
+            {
+                parsedEntries.add(data.size());
+                return data;
+            }
+            fallbacks.add();
+        }
+
+        json j = json::parse(buffer);
         for (const auto &item : j)
         {
-            if (item.is_object() && item.contains("key") && item.contains("value"))
+            if (item.is_object() && item.contains("key") && item.contains("type"))
+            {
+                // 集合类型的记录，格式见 kvEntry.h
+                KvEntry entry;
+                try
+                {
+                    from_json(item, entry);
+                }
+                catch (const json::exception &e)
+                {
+                    throw std::runtime_error("Invalid JSON format: " + std::string(e.what()));
+                }
+                data.push_back(std::move(entry));
+            }
+            else if (item.is_object() && item.contains("key") && item.contains("value"))
             {
                 KvEntry entry;
                 entry.key = item["key"].get<std::string>();
@@ -47,18 +94,42 @@ public:
                 throw std::runtime_error("Invalid JSON format");
             }
         }
+        parsedEntries.add(data.size());
         return data;
     };
 
     json load(const std::string &filePath)
     {
-        std::ifstream in(filePath);
-        if (!in)
-            throw std::runtime_error("File open failed: " + filePath);
-        json j;
-        in >> j;
-        return j;
+        FileBufferLease fileBuffer;
+        return json::parse(read(filePath, *fileBuffer));
     }
+
+private:
+    // 按扩展名识别压缩输入（*.gz / *.zst / *.lz4），整体解压到内存中的解析缓冲区，不落临时文件。
+    // 返回 fileBuffer 中的内容，缓冲区容量跨文件复用
+    const std::string &read(const std::string &filePath, WorkerBuffers::FileBuffer &fileBuffer)
+    {
+        WorkerBuffers &buffers = WorkerBuffers::local();
+        size_t capacity = fileBuffer.input.capacity();
+        Result res = backend_->readFile(filePath, fileBuffer.input);
+        if (res.isError())
+            throw std::runtime_error((res.getRet() == Result::Ret::kFileOpenError ? "File open failed: " : "File read failed: ") + res.message_raw());
+        buffers.noteFill(fileBuffer.input, capacity);
+        Codec codec = codecFromPath(filePath);
+        if (codec == Codec::kNone)
+            return fileBuffer.input;
+        capacity = fileBuffer.plain.capacity();
+        res = decompress(codec, fileBuffer.input, fileBuffer.plain, scheduler_);
+        if (res.isError())
+            throw std::runtime_error("Decompress failed: " + filePath + ": " + res.message_raw());
+        buffers.noteFill(fileBuffer.plain, capacity);
+        return fileBuffer.plain;
+    }
+
+    bool fastParse_ = true;
+    std::shared_ptr<IoBackend> backend_ = defaultIoBackend();
+    TaskScheduler *scheduler_ = nullptr;
+    KvJsonScanner scanner_;
 };
 
 #endif // JSONFILEMANAGER_H
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef CROSS_FILE_DEDUP_H
+#define CROSS_FILE_DEDUP_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "utils/bloomFilter.h"
+#include "utils/kvEntry.h"
+#include "utils/result.h"
+#include "utils/taskScheduler.h"
+
+class JsonFileManagerBase;
+
+// 跨文件去重预处理：目录转换时每个输入单独排序去重，同一个 key 出现在多个文件时会进入多个 SST，
+// ingest 后以导入顺序而不是 timestamp 决定胜者。该预处理只精确处理“可能重复”的 key，唯一 key 不产生任何合并开销：
+//   1. 并行解析全部输入，把 key 插入 seen 过滤器；插入前已存在的再插入 dup 过滤器（至少出现两次的近似集合）
+//   2. 再并行解析一遍，只把命中 dup 过滤器的条目按 ComparePair 选出每个 key 最新的一条及其所在输入
+//   3. 转换时 keep() 丢弃非胜者输入中的这些 key
+// 第 2 步的精确表只包含重复 key 与少量误判，通常只占数据量的几个百分点
+class CrossFileDedup
+{
+public:
+    // 过滤器按输入总字节数估算 key 数（每条约 kBytesPerEntryEstimate 字节，宁多勿少）
+    static constexpr size_t kBytesPerEntryEstimate = 48;
+    static constexpr size_t kCompressionRatioEstimate = 8;
+
+    explicit CrossFileDedup(double bitsPerKey = 12) : bitsPerKey_(bitsPerKey) {}
+
+    // inputs 为相对 DEFAULTDIC 的路径，fileManager 的 parse 需要可重入
+    Result build(JsonFileManagerBase *fileManager, const std::vector<std::string> &inputs, TaskScheduler &scheduler);
+
+    // input 中的 entry 是否保留：不是重复 key 时保留；否则仅当 input 是该 key 最新一条所在的输入时保留
+    // （同一输入内的多条由转换时的排序去重处理）。build 之后只读，可并发调用
+    bool keep(const std::string &input, const KvEntry &entry) const;
+
+    // 原地删除 input 中应丢弃的条目，返回删除条数
+    size_t filter(const std::string &input, DataType &data) const;
+
+    size_t numCandidates() const { return numCandidates_; }
+    // 确实出现在多个输入中的 key 数
+    size_t numDuplicateKeys() const { return numDuplicateKeys_; }
+    size_t filterBytes() const { return dup_ ? seen_->memoryBytes() + dup_->memoryBytes() : 0; }
+
+private:
+    struct Winner
+    {
+        KvEntry entry;
+        uint32_t input = 0;
+        bool multiInput = false; // 出现在不止一个输入中
+    };
+
+    // 精确表按 key 哈希分区，每个分区一把锁
+    struct Partition
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, Winner> winners;
+    };
+    static constexpr size_t kNumPartitions = 64;
+
+    double bitsPerKey_;
+    std::unique_ptr<BlockedBloomFilter> seen_;
+    std::unique_ptr<BlockedBloomFilter> dup_;
+    std::unordered_map<std::string, uint32_t> inputIndex_;
+    std::vector<std::unique_ptr<Partition>> partitions_;
+    size_t numCandidates_ = 0;
+    size_t numDuplicateKeys_ = 0;
+};
+
+#endif // CROSS_FILE_DEDUP_H
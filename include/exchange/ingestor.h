@@ -0,0 +1,91 @@
+#ifndef INGESTOR_H
+#define INGESTOR_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "rocksdb/db.h"
+#include "rocksdb/options.h"
+#include "utils/result.h"
+
+using json = nlohmann::json;
+
+// 一个待 ingest 的 SST：key 范围为原始字节，按目标 CF 的 comparator 比较
+struct IngestFile
+{
+    std::string path;
+    std::string columnFamily = rocksdb::kDefaultColumnFamilyName;
+    std::string smallestKey;
+    std::string largestKey;
+    uint64_t fileSize = 0;
+    uint64_t entries = 0;
+};
+
+// 一次 IngestExternalFile 调用：同一个 CF 中两两不重叠的文件，按 smallestKey 排序
+struct IngestBatch
+{
+    std::string columnFamily;
+    std::vector<IngestFile> files;
+    std::vector<int> expectedLevels; // 与 files 一一对应
+    rocksdb::IngestExternalFileOptions options;
+};
+
+struct IngestPlan
+{
+    std::vector<IngestBatch> batches; // 按执行顺序
+    int numLevels = 7;
+
+    size_t numFiles() const;
+    // 文件路径写成相对 baseDir 的路径，便于整个目录上传后在别处执行
+    json toJson(const std::string &baseDir) const;
+};
+
+// ingest 规划：每次 IngestExternalFile 都有一次 memtable 重叠检查（可能触发 flush）和一次 version edit，
+// 一次调用内有重叠的文件只能放进 L0。规划器按导入顺序读入文件（后导入的在 key 重叠时覆盖先导入的），
+// 把每个文件放进“比所有与它重叠的先导入文件所在组都晚”的最早一组，得到组数最少的、组内两两不重叠的调用序列，
+// 并按 RocksDB 的放置规则（落在不与任何已有文件重叠的最深层）估计每个文件的层级。
+// 层级估计假设这些 key 范围在目标 DB 中原本没有数据
+class IngestPlanner
+{
+public:
+    explicit IngestPlanner(const rocksdb::Options &options = rocksdb::Options());
+
+    // 让 RocksDB 移动（硬链接）文件而不是拷贝
+    void setMoveFiles(bool moveFiles) { moveFiles_ = moveFiles; }
+    // 导入到最底层、序列号为 0，即比 DB 中已有的数据都旧（回填）；要求 DB 以 allow_ingest_behind 打开，
+    // 且每个 CF 的文件两两不重叠（只能规划成一组）
+    void setIngestBehind(bool ingestBehind) { ingestBehind_ = ingestBehind; }
+    // CF 的 comparator，默认按 Pika 列族名取 pikaCfComparator，其他 CF 使用 options 中的 comparator
+    void setComparator(const std::string &columnFamily, const rocksdb::Comparator *comparator) { comparators_[columnFamily] = comparator; }
+
+    // 按导入顺序追加
+    void add(IngestFile file) { files_.push_back(std::move(file)); }
+    // exchange 写出的清单（data_3.manifest.json）：按 CF 列出的文件与十六进制 key 范围，文件路径相对清单所在目录
+    Result addManifest(const std::string &manifestPath);
+    // 没有清单的 SST：打开文件读取首尾 key
+    Result addSst(const std::string &sstPath, const std::string &columnFamily = rocksdb::kDefaultColumnFamilyName);
+    // exchange 的输出目录：清单与未被清单列出的 *.sst，按输出编号（data_3 的 3）排序后依次加入
+    Result addDirectory(const std::string &dir);
+
+    size_t size() const { return files_.size(); }
+
+    Result plan(IngestPlan &plan) const;
+
+    // 按顺序执行；handles 按 CF 名查找，缺少 default 时使用 db->DefaultColumnFamily()
+    static Result execute(rocksdb::DB *db, const std::map<std::string, rocksdb::ColumnFamilyHandle *> &handles, const IngestPlan &plan);
+
+private:
+    const rocksdb::Comparator *comparatorOf(const std::string &columnFamily) const;
+
+    rocksdb::Options options_;
+    bool moveFiles_ = false;
+    bool ingestBehind_ = false;
+    std::map<std::string, const rocksdb::Comparator *> comparators_;
+    std::vector<IngestFile> files_;
+};
+
+// 把规划写到 path（临时文件 + rename）
+Result writeIngestPlan(const IngestPlan &plan, const std::string &path);
+
+#endif // INGESTOR_H
@@ -0,0 +1,44 @@
+#ifndef KV_JSON_SCANNER_H
+#define KV_JSON_SCANNER_H
+
+#include <cstddef>
+#include "utils/kvEntry.h"
+#include "utils/result.h"
+
+// 结构扫描使用的指令集，运行时按 CPU 选择
+enum class SimdLevel
+{
+    kScalar = 0,
+    kSse42,
+    kAvx2,
+};
+
+const char *simdLevelName(SimdLevel level);
+// 当前 CPU 支持的最高级别
+SimdLevel detectSimdLevel();
+
+// KV dump 专用解析器：输入固定为 [{"key": "...", "value": "...", "expire": N}, ...]（DataGen 的缩进输出与紧凑输出均可），
+// 直接解码为 DataType，不构造 json 节点。字符串内用 SIMD 一次跳过 16/32 字节找下一个引号、反斜杠或控制字符，
+// 缩进空白同样整块跳过，非 ASCII 字节按 UTF-8 校验。遇到快速路径不处理的内容（集合记录、未知字段、非整数 expire、
+// 非法 UTF-8、语法错误等）时返回错误，
+// 由调用方回退到 nlohmann::json，因此错误信息与兼容性不变
+class KvJsonScanner
+{
+public:
+    // level 超出 CPU 支持时降到支持的最高级别
+    explicit KvJsonScanner(SimdLevel level = detectSimdLevel());
+
+    // 解析 [data, data + size)，失败时 out 被清空，message 给出偏移与原因
+    Result parse(const char *data, size_t size, DataType &out) const;
+
+    SimdLevel level() const { return level_; }
+
+    using FindFn = const char *(*)(const char *p, const char *end);
+
+private:
+    SimdLevel level_;
+    FindFn findStringSpecial_; // 第一个 '"'、'\\' 或 < 0x20 的字节，没有时返回 end
+    FindFn skipSpace_;         // 第一个非空白字节，没有时返回 end
+};
+
+#endif // KV_JSON_SCANNER_H
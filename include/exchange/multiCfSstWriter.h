@@ -0,0 +1,104 @@
+#ifndef MULTI_CF_SST_WRITER_H
+#define MULTI_CF_SST_WRITER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "rocksdb/options.h"
+#include "rocksdb/sst_file_writer.h"
+#include "utils/pikaLayout.h"
+#include "utils/result.h"
+#include "utils/taskScheduler.h"
+
+using json = nlohmann::json;
+
+// 切分目标：任一项大于 0 时开启切分，每写入一条检查，达到目标即切到下一个文件
+struct SstSplitPolicy
+{
+    uint64_t targetFileSize = 0;
+    size_t targetFileEntries = 0;
+
+    bool splitting() const { return targetFileSize > 0 || targetFileEntries > 0; }
+};
+
+// 切分模式下的第 part 个输出：dir/data_3.sst -> dir/data_3.0002.sst
+std::string sstPartPath(const std::string &outputSstPath, size_t part);
+
+// 依次写入 numEntries 条已排序的数据，put 负责第 i 条的 Put。输出先写到临时文件，finalPaths 与 tempPaths 一一对应，
+// infos 非空时追加每个文件的 ExternalSstFileInfo；失败时已清理临时文件
+Result writeSortedSst(size_t numEntries, const std::function<rocksdb::Status(rocksdb::SstFileWriter &, size_t)> &put,
+                      const rocksdb::Options &options, rocksdb::ColumnFamilyHandle *cfh, const SstSplitPolicy &split,
+                      const std::string &outputSstPath, std::vector<std::string> &tempPaths, std::vector<std::string> &finalPaths,
+                      std::vector<rocksdb::ExternalSstFileInfo> *infos = nullptr);
+
+// 清单中 key 范围的编码：字节串 <-> 小写十六进制。清单的写入方（manifest()）、读取方（IngestPlanner、sstcheck）
+// 与工作日志的哈希都使用这一对函数
+std::string toHex(const std::string &bytes);
+// hex 长度为奇数或含非十六进制字符时返回 false
+bool fromHex(const std::string &hex, std::string &bytes);
+
+// 一个列族的输出配置，options.comparator 必须与目标 CF 相同（排序与 SstFileWriter 都使用它）
+struct CfSpec
+{
+    std::string name;
+    rocksdb::Options options;
+    rocksdb::ColumnFamilyHandle *handle = nullptr;
+};
+
+// 一次解析扇出到多个列族：调用方把每条记录路由到各 CF 的排序缓冲区，write() 为每个非空 CF 提交一个子任务，
+// 各自排序后用独立的 SstFileWriter 并发写入临时文件；任一 CF 失败时清理全部临时文件，保证一组输出要么全部可发布要么都不发布。
+// 发布由调用方完成，之后可用 manifest() 生成这一组输出的清单
+class MultiCfSstWriter
+{
+public:
+    explicit MultiCfSstWriter(std::vector<CfSpec> cfs, const SstSplitPolicy &split = SstSplitPolicy());
+
+    size_t size() const { return cfs_.size(); }
+    const CfSpec &cf(size_t cf) const { return cfs_.at(cf); }
+
+    // 路由一条条目到 cf 的排序缓冲区（不加锁，write() 之前由单个线程调用）
+    void add(size_t cf, std::string key, std::string value) { buffers_.at(cf).emplace_back(std::move(key), std::move(value)); }
+    // 整体移入已展开好的条目，避免逐条拷贝
+    void addAll(size_t cf, std::vector<KvPair> &&pairs);
+
+    // 开启后写入前为每个 CF 计算与顺序无关的摘要，写完后流式比对临时文件
+    void setValidate(bool validate) { validate_ = validate; }
+
+    // 把每个非空 CF 写到 pathOf(cf)（切分时为其分片）的临时文件；scheduler 为 nullptr 时临时创建不超过 numThreads 个线程。
+    // 在调度器的 worker 内调用时 wait 会协助执行子任务，可以嵌套在文件级任务中
+    Result write(TaskScheduler *scheduler, size_t numThreads, const std::function<std::string(size_t cf)> &pathOf);
+
+    // write() 成功后按 CF 顺序展开的临时 / 最终路径
+    std::vector<std::string> tempPaths() const;
+    std::vector<std::string> finalPaths() const;
+    uint64_t numEntries() const;
+
+    // 一组输出的清单：{"columnFamilies": [{name, comparator, entries, files: [{file, fileSize, entries, smallestKey, largestKey}]}]}，
+    // file 为相对 baseDir 的路径，key 为十六进制（Pika 布局下 key 含二进制字节）。没有条目的 CF 不出现
+    json manifest(const std::string &baseDir) const;
+
+private:
+    struct CfResult
+    {
+        std::vector<std::string> tempPaths;
+        std::vector<std::string> finalPaths;
+        std::vector<rocksdb::ExternalSstFileInfo> infos;
+    };
+
+    Result writeCf(size_t cf, const std::string &outputSstPath);
+
+    std::vector<CfSpec> cfs_;
+    SstSplitPolicy split_;
+    bool validate_ = false;
+    std::vector<std::vector<KvPair>> buffers_;
+    std::vector<CfResult> results_;
+};
+
+// 清单中一个文件的描述：{file, fileSize, entries, smallestKey, largestKey}，file 为相对 baseDir 的路径，key 为十六进制
+json sstFileManifest(const std::string &finalPath, const rocksdb::ExternalSstFileInfo &info, const std::string &baseDir);
+
+// Pika 4.x 布局的各列族配置：comparator 取 pikaCfComparator，handles 中为 nullptr 的 CF 由 SstFileWriter 自行处理
+std::vector<CfSpec> pikaCfSpecs(const rocksdb::Options &options, const std::vector<rocksdb::ColumnFamilyHandle *> &handles);
+
+#endif // MULTI_CF_SST_WRITER_H
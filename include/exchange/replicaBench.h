@@ -0,0 +1,92 @@
+#ifndef REPLICA_BENCH_H
+#define REPLICA_BENCH_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "rocksdb/options.h"
+#include "exchange/multiCfSstWriter.h"
+#include "mock/fileManager.h"
+#include "utils/kvEntry.h"
+#include "utils/result.h"
+#include "utils/valueEncoder.h"
+
+using json = nlohmann::json;
+
+// 把 DataGen 生成的每个“文件”留在内存里，两种同步方式回放同一份数据集
+class DatasetCollector : public FileManagerBase
+{
+public:
+    Result write(const DataType &data) override;
+
+    // 取走收集到的数据：每个文件按 ComparePair 去重（同一 key 只留最新一条），
+    // 非 string 记录被丢弃并计入 skipped（flat 输出只支持 string）
+    std::vector<DataType> take(size_t *skipped = nullptr);
+
+private:
+    std::mutex mutex_;
+    std::vector<DataType> files_;
+};
+
+// 一种同步方式从开始到从节点追平的测量结果
+struct ReplicaBenchStats
+{
+    std::string mode;
+    uint64_t entries = 0;
+    uint64_t userBytes = 0;           // key + 编码后 value 的字节数（单个节点应写入的逻辑数据量）
+    double wallSeconds = 0;           // 到从节点追平、两侧 flush 完成且没有待执行的 compaction
+    double primarySeconds = 0;        // 主节点完成自身写入的时刻，之后的时间都是从节点的追赶
+    uint64_t bytesWritten = 0;        // 期间进程 write 系列系统调用的字节数（/proc/self/io 的 wchar）：WAL、flush、compaction、SST 生成与拷贝
+    uint64_t storageBytesWritten = 0; // 同期提交到块设备层的字节数（write_bytes），tmpfs 或容器内可能为 0
+    uint64_t binlogBytes = 0;         // 主从链路上传输的 binlog
+    uint64_t objectBytes = 0;         // 经对象存储搬运的 SST 与清单（主节点上传一次 + 从节点下载一次）
+    uint64_t primaryDiskBytes = 0;    // 结束时两个 DB 目录的大小
+    uint64_t replicaDiskBytes = 0;
+    std::string primaryDigest;        // 结束时 DB 全量内容的 KvDigest，主从以及两种方式之间必须相同
+    std::string replicaDigest;
+
+    uint64_t bytesMoved() const { return binlogBytes + objectBytes; }
+    // 两个节点实际写入的字节数 / 两个节点应写入的用户字节数
+    double writeAmplification() const;
+    json toJson() const;
+};
+
+// 主从追平压测：两个嵌入式 RocksDB 分别作为主、从节点，比较同一份数据集的两种同步方式：
+// 写路径复制（主节点批量 WriteBatch，binlog 逐条发给从节点重放）与 S3 + INGEST_SST（生成 SST 与清单，两侧各自 ingest）。
+// 从节点在独立线程上消费 binlog，与主节点并发执行；每次运行前清空 workDir 下对应模式的目录
+class ReplicaBench
+{
+public:
+    explicit ReplicaBench(std::string workDir);
+
+    // 两个 DB 共用的 Options，create_if_missing 总是打开
+    void setOptions(const rocksdb::Options &options) { options_ = options; }
+    // 主节点每个 WriteBatch 的条数
+    void setBatchSize(size_t batchSize) { batchSize_ = batchSize == 0 ? 1 : batchSize; }
+    size_t getBatchSize() const { return batchSize_; }
+    // 写路径的每次 Write 是否 fsync WAL
+    void setSyncWrites(bool sync) { syncWrites_ = sync; }
+    void setValueEncoder(const std::shared_ptr<const ValueEncoder> &encoder) { encoder_ = encoder; }
+    // 生成 SST 时的切分目标，与 exchange 的 -b / -e 相同
+    void setSplitPolicy(const SstSplitPolicy &split) { split_ = split; }
+
+    // 主节点按 batchSize 条一个 WriteBatch 写入，每条记录作为一条 binlog 发给从节点，从节点逐条 Write
+    Result runWriteBatch(const std::vector<DataType> &files, ReplicaBenchStats &stats);
+
+    // 每个文件：主节点生成 SST 与清单并上传到 s3/，ingest 后只发一条携带清单的 INGEST_SST binlog；
+    // 从节点按清单从 s3/ 下载后 ingest。文件按顺序 ingest，跨文件的重复 key 与写路径一样后写入者胜
+    Result runIngest(const std::vector<DataType> &files, ReplicaBenchStats &stats);
+
+private:
+    std::string workDir_;
+    rocksdb::Options options_;
+    size_t batchSize_ = 1000;
+    bool syncWrites_ = false;
+    std::shared_ptr<const ValueEncoder> encoder_ = defaultValueEncoder();
+    SstSplitPolicy split_;
+};
+
+#endif // REPLICA_BENCH_H
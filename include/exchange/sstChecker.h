@@ -0,0 +1,76 @@
+#ifndef SST_CHECKER_H
+#define SST_CHECKER_H
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "rocksdb/options.h"
+#include "utils/result.h"
+#include "utils/valueEncoder.h"
+
+using json = nlohmann::json;
+
+class JsonFileManagerBase;
+
+// 单个 SST 的校验结果与摘要
+struct SstFileSummary
+{
+    std::string path;
+    bool ok = false;
+    std::string error;
+
+    uint64_t fileSize = 0;
+    uint64_t entries = 0;
+    std::string smallestKey;
+    std::string largestKey;
+    uint64_t persistentEntries = 0; // timestamp 为 0（不过期）的条数
+    uint32_t minExpire = 0;         // 非 0 timestamp 的最小值
+    uint32_t maxExpire = 0;
+
+    json toJson() const;
+};
+
+// 基于 rocksdb::SstFileReader 的 SST 校验：
+// 校验块 checksum，顺序遍历检查 key 严格递增（即无乱序、无重复），
+// 并按 value 编码（默认 ttl，即 value 末尾 4 字节）解码 expire。
+// 遍历是流式的，不在内存中保留文件内容。
+class SstChecker
+{
+public:
+    explicit SstChecker(const rocksdb::Options &opts = rocksdb::Options()) : options_(opts) {}
+
+    Result checkFile(const std::string &sstPath, SstFileSummary &summary) const;
+
+    // 与源 JSON 逐条比对：源数据经 ComparePair 排序、去重后，key 与编码后的 value 必须与 SST 完全一致。
+    // 校验时刻已过期的源条目允许缺失（exchange 转换时会丢弃过期数据）
+    Result crossCheckJson(const std::string &sstPath, JsonFileManagerBase *fileManager,
+                          const std::string &jsonPath) const;
+    // 一组输出与它的全部输入比对：sstPaths 为按顺序排列的切分各段（首尾相接即整组的有序数据），
+    // jsonPaths 为合并转换的各个输入（可以是压缩文件），合并后排序、去重
+    Result crossCheckJson(const std::vector<std::string> &sstPaths, JsonFileManagerBase *fileManager,
+                          const std::vector<std::string> &jsonPaths) const;
+
+    // 与 manifest 中记录的条目比对：entries / smallestKey / largestKey / fileSize（存在时）
+    static Result crossCheckManifest(const SstFileSummary &summary, const json &manifestEntry);
+
+    // 并发校验多个文件，summaries 与 paths 一一对应；返回第一个失败文件的 Result
+    Result checkFiles(const std::vector<std::string> &paths, std::vector<SstFileSummary> &summaries) const;
+
+    // 由校验结果生成 manifest：{"files": [{file, fileSize, entries, smallestKey, largestKey, ...}]}
+    static json manifest(const std::vector<SstFileSummary> &summaries);
+
+    void setNumThreads(size_t numThreads) { numThreads_ = std::max<size_t>(1, numThreads); }
+    size_t getNumThreads() const { return numThreads_; }
+
+    void setValueEncoder(const std::shared_ptr<const ValueEncoder> &encoder) { encoder_ = encoder; }
+
+private:
+    rocksdb::Options options_;
+    std::shared_ptr<const ValueEncoder> encoder_ = defaultValueEncoder();
+    size_t numThreads_ = std::max(1u, std::thread::hardware_concurrency());
+};
+
+#endif // SST_CHECKER_H
@@ -1,16 +1,33 @@
 #ifndef SST_PROCESSOR_H
 #define SST_PROCESSOR_H
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <string>
 #include <memory>
+#include <thread>
+#include <vector>
 #include "rocksdb/sst_file_writer.h"
+#include "exchange/crossFileDedup.h"
+#include "exchange/multiCfSstWriter.h"
 #include "rocksdb/env.h"
 #include "rocksdb/options.h"
 #include "rocksdb/status.h"
 #include "rocksdb/utilities/db_ttl.h"
+#include "utils/filePublisher.h"
+#include "utils/memoryBudget.h"
+#include "utils/pikaLayout.h"
 #include "utils/result.h"
+#include "utils/shardFunction.h"
+#include "utils/sortDedup.h"
+#include "utils/taskScheduler.h"
+#include "utils/valueEncoder.h"
 #include "exchange/JsonFileManager.h" // 包含 JsonFileManagerBase
 
+class WorkJournal;
+
 class SstProcessor
 {
 public:
@@ -23,15 +40,170 @@ public:
                           const std::string &inputJsonPath,
                           const std::string &outputSstPath);
 
-    // 实现并发处理kv->sst:使用线程池  ThreadPool pool(numThreads_);多线程处理，读取input文件夹，每一个线程单独处理，可以使用processSstFile来处理，不过里面就需要加锁
+    // 把多个输入合并、排序去重后写入 outputSstPath；切分模式下依次写为 partPath(outputSstPath, 0..n-1)，
+    // 并删除上次运行留下的多余分片。outputs 非空时返回实际生成的文件（相对 DEFAULTDIC）
+    Result processSstGroup(JsonFileManagerBase *fileManager,
+                           const std::vector<std::string> &inputJsonPaths,
+                           const std::string &outputSstPath,
+                           std::vector<std::string> *outputs = nullptr);
+
+    // 并发处理目录下所有 kv 文件：每个 *.json 作为一个任务提交到工作窃取调度器，
+    // 输出到 outputDicPath 下同名的 .sst 文件；fileManager 的 parse 需要可重入。
+    // 切分模式下按文件名自然序把相邻的小输入合并为一组（输入总大小不超过目标字节数），
+    // 每组以第一个输入命名输出：data_3.0000.sst、data_3.0001.sst ...
     Result mutiProcessSstFile(JsonFileManagerBase *fileManager, const std::string &inputDicPath,
                               const std::string &outputDicPath);
 
+    // 监视模式：先转换目录下已有的 *.json，之后每当有文件写完（关闭写句柄或由临时名 rename 进来）就立即提交转换，
+    // 同时在途任务数不超过 2 倍线程数。stop 置位，或 idleTimeout（> 0 时）内既没有新文件也没有任务在执行时返回。
+    // 单个文件失败只记录日志，该文件之后再次写完时会重新转换；返回时仍失败的文件会使结果为错误
+    Result watchSstFiles(JsonFileManagerBase *fileManager, const std::string &inputDicPath,
+                         const std::string &outputDicPath, const std::atomic<bool> &stop,
+                         std::chrono::milliseconds idleTimeout = std::chrono::milliseconds(0));
+
+    void setNumThreads(size_t numThreads) { numThreads_ = std::max<size_t>(1, numThreads); }
+    size_t getNumThreads() const { return numThreads_; }
+
+    // 大于 0 时开启抽样往返校验（见 SstValidator）：复用已解析的数据计算源摘要，
+    // 写完后比对 SST 摘要并随机点查 numSamples 条，校验失败时该文件返回错误
+    void setValidateSamples(size_t numSamples) { validateSamples_ = numSamples; }
+    size_t getValidateSamples() const { return validateSamples_; }
+
+    // 大于 0 时开启切分模式：每写入一条后检查 SstFileWriter::FileSize()，达到 bytes 即切到下一个文件。
+    // 通常取目标 CF 的 target_file_size_base，使每个 SST 的大小与 compaction 产出的文件相当
+    void setTargetFileSize(uint64_t bytes) { targetFileSize_ = bytes; }
+    uint64_t getTargetFileSize() const { return targetFileSize_; }
+
+    // 大于 0 时开启切分模式：每个 SST 最多写入 entries 条
+    void setTargetFileEntries(size_t entries) { targetFileEntries_ = entries; }
+    size_t getTargetFileEntries() const { return targetFileEntries_; }
+
+    bool splitting() const { return targetFileSize_ > 0 || targetFileEntries_ > 0; }
+
+    // 写入 SST 的 value 编码，默认 ttl（value | expire），抽样校验使用同一编码
+    void setValueEncoder(const std::shared_ptr<const ValueEncoder> &encoder) { encoder_ = encoder; }
+    const std::shared_ptr<const ValueEncoder> &getValueEncoder() const { return encoder_; }
+
+    // 开启后去重之后丢弃在转换时刻已过期的条目（expire 非 0 且不晚于当前时间），全部过期时不生成输出
+    void setDropExpired(bool dropExpired) { dropExpired_ = dropExpired; }
+    bool getDropExpired() const { return dropExpired_; }
+
+    // 设置后按 Pika 4.x 存储布局输出：解析一次，每条记录（含 hash / set / list / zset）展开路由到 meta 与各 data CF 的缓冲区，
+    // 由 MultiCfSstWriter 为每个 CF 单独排序、并发写入 cfPath(outputSstPath, cf)；没有条目的 CF 不生成文件。
+    // 整组发布后再写 manifestPath(outputSstPath) 清单。未设置时只支持 string 记录，写入单个 SST
+    void setPikaLayout(const std::shared_ptr<const PikaLayout> &layout) { layout_ = layout; }
+    const std::shared_ptr<const PikaLayout> &getPikaLayout() const { return layout_; }
+
+    // Pika 布局下 cf 对应的 ColumnFamilyHandle；未设置时 meta CF 使用构造时传入的 cfh，其余为 nullptr
+    void setColumnFamilyHandle(size_t cf, rocksdb::ColumnFamilyHandle *handle) { cfHandles_.at(cf) = handle; }
+
+    // 大于 0 时 mutiProcessSstFile 先做跨文件去重预处理（见 CrossFileDedup），bitsPerKey 为过滤器每个 key 的位数：
+    // 同一个 key 出现在多个输入中时只保留 ComparePair 意义下最新的一条，其余输入转换时丢弃该 key
+    void setCrossFileDedup(double bitsPerKey) { crossFileDedupBits_ = bitsPerKey; }
+    double getCrossFileDedup() const { return crossFileDedupBits_; }
+
+    // 设置后目录转换在提交每个任务前按输入大小预留内存，预算用尽时等待已提交的任务结束再提交，
+    // 每个任务解析完成后以实测占用修正扩张系数。未设置时不限制
+    void setMemoryBudget(const std::shared_ptr<MemoryBudget> &budget) { memoryBudget_ = budget; }
+    const std::shared_ptr<MemoryBudget> &getMemoryBudget() const { return memoryBudget_; }
+
+    // 排序去重策略，默认 kAuto：按升序段数与抽样重复率为每组输入选择，结果与整体排序后去重相同
+    void setDedupStrategy(DedupStrategy strategy) { dedupStrategy_ = strategy; }
+    DedupStrategy getDedupStrategy() const { return dedupStrategy_; }
+
+    // 设置后每组输入按 function 把记录路由到各分片，每个分片独立排序去重并写入 shardPath(outputSstPath, shard)，
+    // 分片之间并行；每个分片附带清单（与 Pika 布局相同的格式，另含分片号与分片方式），全部分片发布后再写分片索引
+    // shardIndexPath(outputSstPath)。各节点只需导入自己分片目录下的文件。可与切分、Pika 布局同时使用
+    void setShardFunction(const std::shared_ptr<const ShardFunction> &function) { shardFunction_ = function; }
+    const std::shared_ptr<const ShardFunction> &getShardFunction() const { return shardFunction_; }
+
+    // 切分模式下的第 part 个输出：dir/data_3.sst -> dir/data_3.0002.sst
+    static std::string partPath(const std::string &outputSstPath, size_t part);
+
+    // Pika 布局下 cf 的输出：dir/data_3.sst -> dir/data_3.hash_data_cf.sst（切分时再套用 partPath）
+    static std::string cfPath(const std::string &outputSstPath, size_t cf);
+
+    // Pika 布局下一组输出的清单：dir/data_3.sst -> dir/data_3.manifest.json
+    static std::string manifestPath(const std::string &outputSstPath);
+
+    // 分片输出：dir/data_3.sst -> dir/shard_0003/data_3.sst（再套用 cfPath / partPath / manifestPath）
+    static std::string shardPath(const std::string &outputSstPath, size_t shard);
+
+    // 一组分片输出的索引：dir/data_3.sst -> dir/data_3.shards.json
+    static std::string shardIndexPath(const std::string &outputSstPath);
+
+    // 设置后 mutiProcessSstFile 跳过日志中已完成且未变化的文件，并在每个文件转换成功后记录到日志
+    void setJournal(WorkJournal *journal) { journal_ = journal; }
+
+    // 输出先写到 .name.sst.tmp，Finish（及抽样校验）通过后经 publisher 发布；目录转换结束时 flush
+    void setPublisher(const std::shared_ptr<FilePublisher> &publisher) { publisher_ = publisher; }
+
 private:
+    // 转换一组输入，成功后把每个输入记录到工作日志（若已设置）
+    Result convertFile(JsonFileManagerBase *fileManager, const std::vector<std::string> &inputPaths, const std::string &outputPath);
+
+    // 工作日志为 outputPath 记录的全部文件（绝对路径）：processSstGroup 生成的各段 SST，
+    // 加上 Pika 布局的清单，分片输出时再加上各分片的清单与分片索引
+    std::vector<std::string> journalFiles(const std::string &outputPath, const std::vector<std::string> &outputs) const;
+
+    SstSplitPolicy splitPolicy() const { return SstSplitPolicy{targetFileSize_, targetFileEntries_}; }
+
+    // 一个输出（分片输出时为一个分片）写完临时文件、尚未发布时的状态
+    struct PendingOutput
+    {
+        std::string outputSstPath; // 绝对路径
+        size_t shard = 0;
+        std::vector<std::string> tempPaths;
+        std::vector<std::string> finalPaths; // 为空表示没有条目需要输出
+        std::vector<rocksdb::ExternalSstFileInfo> infos;
+        std::unique_ptr<MultiCfSstWriter> cfWriter;
+        uint64_t entries = 0;
+        std::string message; // 没有输出时的说明
+
+        // 删除尚未发布的临时文件
+        void discard();
+    };
+
+    // 对 data 排序、去重、过期过滤后写入 pending.outputSstPath 的临时文件并校验
+    Result writeOutput(DataType &data, uint32_t now, size_t crossDropped, PendingOutput &pending);
+    // 发布临时文件与清单，删除上次运行留下的多余文件
+    Result publishOutput(PendingOutput &pending);
+    // 按 shardFunction_ 路由后逐分片 writeOutput / publishOutput，最后发布分片索引
+    Result writeShards(DataType &data, const std::string &outputSstPath, uint32_t now, std::vector<std::string> *outputs);
+
+    // 把排好序且已去重的 string 数据按 value 编码写入临时文件；finalPaths 与 tempPaths 一一对应，失败时已清理临时文件
+    Result writeSortedData(const DataType &data, const std::string &outputSstPath,
+                           std::vector<std::string> &tempPaths, std::vector<std::string> &finalPaths,
+                           std::vector<rocksdb::ExternalSstFileInfo> *infos = nullptr);
+
+    // 一个输出的清单：Pika 布局下为各 CF 的文件，否则为单个 CF；分片输出时附带分片号与分片方式
+    json outputManifest(const PendingOutput &pending) const;
+    // 先写临时文件再经 publisher 发布，出现清单即表示它描述的 SST 已全部发布
+    Result publishJson(const std::string &path, const json &content);
+
+    // 删除 outputSstPath 名下不在 keep 中的旧输出（多余的分片、本次没有条目的 CF 文件；keep 为空时连同清单）
+    void removeStaleOutputs(const std::string &outputSstPath, const std::vector<std::string> &keep) const;
+    // 删除 outputSstPath 名下的全部输出，分片输出时包括各分片与分片索引
+    void removeOutput(const std::string &outputSstPath) const;
+
     rocksdb::Options options_;
     rocksdb::ColumnFamilyHandle *cfh_; // 可以为 nullptr 表示 default CF
+    std::array<rocksdb::ColumnFamilyHandle *, kPikaCfCount> cfHandles_{};
+    std::shared_ptr<const PikaLayout> layout_;
+    TaskScheduler *scheduler_ = nullptr; // 目录转换期间有效，供单个转换任务内部的并行子任务使用
+    size_t numThreads_ = std::max(1u, std::thread::hardware_concurrency());
+    size_t validateSamples_ = 0;
+    std::shared_ptr<const ValueEncoder> encoder_ = defaultValueEncoder();
+    bool dropExpired_ = false;
+    uint64_t targetFileSize_ = 0;
+    size_t targetFileEntries_ = 0;
+    WorkJournal *journal_ = nullptr;
+    double crossFileDedupBits_ = 0;
+    std::unique_ptr<CrossFileDedup> crossFileDedup_; // 目录转换期间有效
+    std::shared_ptr<FilePublisher> publisher_ = std::make_shared<FilePublisher>();
+    std::shared_ptr<MemoryBudget> memoryBudget_;
+    DedupStrategy dedupStrategy_ = DedupStrategy::kAuto;
+    std::shared_ptr<const ShardFunction> shardFunction_;
 };
 
 #endif // SST_PROCESSOR_H
-
-// 添加一个sst read的小工具
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef SST_VALIDATOR_H
+#define SST_VALIDATOR_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "rocksdb/options.h"
+#include "utils/hash.h"
+#include "utils/kvEntry.h"
+#include "utils/result.h"
+#include "utils/valueEncoder.h"
+
+class JsonFileManagerBase;
+
+// 与顺序无关的 KV 摘要：每个 (key, 编码后的 value) 元组取 128 位哈希，
+// 分别做 XOR 与 128 位加法累加，两侧条数、XOR、和都相等才算一致
+struct KvDigest
+{
+    uint64_t count = 0;
+    Hash128 xorHash;
+    Hash128 sumHash;
+
+    void add(const std::string &key, const std::string &encodedValue) { add(key.data(), key.size(), encodedValue.data(), encodedValue.size()); }
+    void add(const char *key, size_t keySize, const char *value, size_t valueSize);
+    // 合并另一份摘要（例如同一数据切分出的多个 SST）
+    void merge(const KvDigest &other);
+
+    bool operator==(const KvDigest &other) const
+    {
+        return count == other.count && xorHash == other.xorHash && sumHash == other.sumHash;
+    }
+    bool operator!=(const KvDigest &other) const { return !(*this == other); }
+
+    std::string toString() const;
+};
+
+// 抽样往返校验：不做全量比对，只比较源数据与 SST 的摘要，再随机抽取若干 key 到 SST 中点查。
+// 源侧摘要不经过排序，直接用哈希表为每个 key 选出 ComparePair 意义下最新的一条
+// （timestamp 最大，相同时 value 最小），从而独立验证 sort + dedupSorted 的结果。
+class SstValidator
+{
+public:
+    explicit SstValidator(const rocksdb::Options &opts = rocksdb::Options(), size_t numSamples = 1000, uint64_t seed = 0)
+        : options_(opts), numSamples_(numSamples), seed_(seed) {}
+
+    // 源数据摘要；samples 非空时同时从去重后的数据中随机抽取 numSamples 条
+    KvDigest digestSource(const DataType &data, DataType *samples = nullptr) const;
+
+    // 顺序遍历 SST 计算摘要
+    Result digestSst(const std::string &sstPath, KvDigest &digest) const;
+
+    // 对每条样本在 SST 中 Seek，key 必须存在且 value 与编码结果一致
+    Result lookupSamples(const std::string &sstPath, DataType samples) const;
+
+    // 用已计算好的源摘要与样本校验 SST
+    Result verify(const std::string &sstPath, const KvDigest &expected, const DataType &samples) const;
+
+    // 同一份数据按 key 区间切分成多个 SST 时：合并各文件摘要后比对，每条样本到覆盖其 key 的文件中点查
+    Result verify(const std::vector<std::string> &sstPaths, const KvDigest &expected, const DataType &samples) const;
+
+    // 解析源 JSON 后完整跑一遍 digestSource + verify
+    Result validate(JsonFileManagerBase *fileManager, const std::string &jsonPath, const std::string &sstPath) const;
+
+    size_t getNumSamples() const { return numSamples_; }
+
+    // value 的编码方式，必须与写入 SST 时相同
+    void setValueEncoder(const std::shared_ptr<const ValueEncoder> &encoder) { encoder_ = encoder; }
+
+    // 非 0 时源摘要跳过在 now 时刻已过期的条目（与转换时丢弃过期数据对应）
+    void setExpireCutoff(uint32_t now) { expireCutoff_ = now; }
+
+private:
+    rocksdb::Options options_;
+    size_t numSamples_;
+    uint64_t seed_;
+    std::shared_ptr<const ValueEncoder> encoder_ = defaultValueEncoder();
+    uint32_t expireCutoff_ = 0;
+};
+
+#endif // SST_VALIDATOR_H
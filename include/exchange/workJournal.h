@@ -0,0 +1,88 @@
+#ifndef WORK_JOURNAL_H
+#define WORK_JOURNAL_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "utils/result.h"
+
+using json = nlohmann::json;
+
+// 一个输出文件（SST、清单或分片索引）的状态
+struct JournalOutput
+{
+    std::string path;
+    uint64_t size = 0;
+    int64_t mtime = 0; // 为 0 表示未知（旧版日志），总是按内容哈希判定
+    std::string hash;
+};
+
+// 单个输入文件的转换记录
+struct JournalEntry
+{
+    uint64_t size = 0;                // 源文件大小
+    int64_t mtime = 0;                // 源文件修改时间（file_clock 计数）
+    std::string hash;                 // 源文件内容哈希（128 位十六进制）
+    std::string output;               // 所属分组的输出路径，分组变化后记录即失效
+    std::vector<JournalOutput> files; // 这一组实际生成的全部文件，为空表示没有条目需要输出（全部过期或被去重）
+
+    json toJson() const;
+    static JournalEntry fromJson(const json &j);
+};
+
+// 目录转换的持久化工作日志：记录每个输入文件的状态，重跑时跳过已完成且未变化的文件。
+// 由快照 path 与追加日志 path.log 组成：record() 只向 .log 追加一行并 fdatasync，代价与已记录的文件数无关；
+// save() 以「写临时文件 + fsync + rename」原子地写出快照后清空 .log。load() 读取快照后重放 .log，
+// 进程在任意时刻退出都只会丢掉最后一条写了一半的记录。
+// 线程安全，可在多个转换任务中并发调用。
+class WorkJournal
+{
+public:
+    explicit WorkJournal(const std::string &path) : path_(path) {}
+    ~WorkJournal();
+
+    WorkJournal(const WorkJournal &) = delete;
+    WorkJournal &operator=(const WorkJournal &) = delete;
+
+    // 快照不存在时视为空日志
+    Result load();
+    Result save() const;
+
+    // input 为日志中的 key（调用方给出的相对路径），inputPath / outputPath 为实际文件路径。
+    // 记录的输出路径须与 outputPath 相同；源文件与记录的每个输出文件的大小、mtime 均未变时直接判定为最新，
+    // 大小相同但 mtime 变了的文件再比较内容哈希，相同则刷新 mtime。任一输出文件缺失、大小不符或内容被替换时返回 false。
+    bool upToDate(const std::string &input, const std::string &inputPath, const std::string &outputPath);
+
+    // 转换成功后调用：计算源文件与输出文件的哈希，写入记录并追加到 .log
+    Result record(const std::string &input, const std::string &inputPath, const std::string &outputPath);
+    // 一组输入共享一个输出：inputs 为 (日志 key, 实际路径)，files 为这一组实际生成的全部文件（切分的各段、
+    // 各 CF 的文件、清单等），每个文件只哈希一次，所有记录一次追加。files 为空时记录为「空输出」，
+    // 之后只要源文件不变即视为最新
+    Result record(const std::vector<std::pair<std::string, std::string>> &inputs, const std::string &outputPath,
+                  const std::vector<std::string> &files);
+
+    void forget(const std::string &input);
+    bool contains(const std::string &input) const;
+    // 生成了 file 的输入（按记录的键排序），file 不在任何记录中时为空。路径按 weakly_canonical 比较
+    std::vector<std::string> inputsOf(const std::string &file) const;
+    size_t size() const;
+    const std::string &path() const { return path_; }
+
+    // 以 1MB 分块链式 MurmurHash3 计算文件内容哈希
+    static Result hashFile(const std::string &path, std::string &hex);
+
+private:
+    Result saveLocked() const;
+    std::string logPath() const { return path_ + ".log"; }
+
+    std::string path_;
+    mutable std::mutex mutex_;
+    std::map<std::string, JournalEntry> entries_;
+    mutable int logFd_ = -1; // 首次 record() 时打开，save() 截断
+};
+
+#endif // WORK_JOURNAL_H
@@ -1,6 +1,8 @@
 #ifndef DATAGEN_H
 #define DATAGEN_H
 #include "mock/fileManager.h"
+#include "utils/memoryBudget.h"
+#include "utils/taskScheduler.h"
 #include <iostream>
 #include <fstream>
 #include <unordered_set>
@@ -34,9 +36,18 @@ public:
     // 生成文件的函数
     Result generateFile(size_t fileSize);
 
+    // 生成 numEntries 条数据并按 ComparePair 排序（大文件拆成多个子任务时使用）
+    Result generateEntries(size_t numEntries, DataType &data);
+
     // 随机从键池中选择一个键
     Result generateKey();
 
+    // 按配置的 typeRatios 为 key 选择记录类型；未配置时全部为 string
+    KvType pickType(const std::string &key) const;
+
+    // 为集合类型的 entry 随机生成元素
+    void fillCollection(KvEntry &entry, std::mt19937 &gen) const;
+
     // 清空键池
     Result clearKeyPool();
 
@@ -52,9 +63,12 @@ public:
     std::vector<std::string> getKeyPool();
     size_t getNumThreads() const { return numThreads_; }
     void setFileManager(const std::shared_ptr<FileManagerBase> &fileManager) { fileManager_ = std::move(fileManager); }
+    // 设置后每个文件提交前按 文件大小 x 扩张系数 预留内存，预算用尽时等待已提交的文件写完再提交
+    void setMemoryBudget(const std::shared_ptr<MemoryBudget> &budget) { memoryBudget_ = budget; }
 
 private:
     std::shared_ptr<FileManagerBase> fileManager_;
+    std::shared_ptr<MemoryBudget> memoryBudget_;
     // 文件管理器实例
     std::vector<std::string> keyPool_; // 键池
     json config_;                      // 配置文件内容
@@ -67,6 +81,12 @@ private:
     double approxEntrySizeKB_;         // 每个条目的平均大小（KB）
     // std::chrono::seconds poolUpdateInterval_ = std::chrono::seconds(1);         // 键池更新的时间间隔
     size_t numThreads_ = std::max(1u, std::thread::hardware_concurrency() - 1); // 线程数，至少1个线程
+    bool pinThreads_ = false;                                                    // worker 是否绑核
+    bool numaAware_ = false;                                                     // 窃取时是否优先同 NUMA 节点
+    size_t subTaskEntries_ = 50000;                                              // 单个子任务生成的最大条目数
+    size_t collectionSize_ = 8;                                                  // 集合类型的平均元素个数
+    std::vector<double> typeCdf_;                                                // 按 KvType 取值的累积比例，空表示只生成 string
+    TaskScheduler *scheduler_ = nullptr;                                         // generateData 运行期间有效
     std::atomic<bool> stopUpdateThread_{false};
     std::thread updateThread_; // 后台线程用于定期更新键池
 
@@ -5,10 +5,14 @@
 #include <filesystem>
 #include "utils/result.h"
 #include "utils/klog.h"
+#include "utils/filePublisher.h"
+#include <memory>
 #include <vector>
 #include <mutex>
 #include <nlohmann/json.hpp>
 #include "utils/kvEntry.h"
+#include "utils/compression.h"
+#include "utils/kvJsonWriter.h"
 using json = nlohmann::json;
 
 // 创建一个模拟的 FileManager 基类，用于测试
@@ -17,6 +21,8 @@ class FileManagerBase
 public:
     virtual ~FileManagerBase() = default;           // 确保基类有虚析构函数
     virtual Result write(const DataType &data) = 0; // 纯虚函数
+    // 全部写完后调用，批量落盘策略下刷盘尚未持久化的文件
+    virtual Result flush() { return Result(Result::Ret::kOk); }
 };
 
 class FileManager : public FileManagerBase
@@ -40,12 +46,26 @@ public:
     {
         std::lock_guard<std::mutex> lock(mutex_);
         LOG_INFO(dic_ + " is the directory for data files.");
-        filePath_ = dic_ + "/data_" + std::to_string(distname_index_++) + ".json"; // 更新当前文件路径
+        filePath_ = dic_ + "/data_" + std::to_string(distname_index_++) + fileExtension_; // 更新当前文件路径
         LOG_INFO("FileManager Creating file: " + filePath_);
         return Result(Result::Ret::kFileCreated, filePath_);
     }
 
+    // 先写 .data_N.json.tmp，写完后经 publisher 发布为 data_N.json
     Result write(const DataType &data) override;
+    Result flush() override { return publisher_->flush(); }
+
+    void setPublisher(const std::shared_ptr<FilePublisher> &publisher) { publisher_ = publisher; }
+    // kPretty（默认）为 4 空格缩进，kCompact 不含空白
+    void setJsonStyle(KvJsonWriter::Style style) { style_ = style; }
+    void setIoBackend(const std::shared_ptr<IoBackend> &backend) { backend_ = backend; }
+    // 压缩输出，文件名追加对应扩展名（data_N.json.zst），level 为 0 时取默认级别
+    void setCodec(Codec codec, int level = 0)
+    {
+        codec_ = codec;
+        codecLevel_ = level;
+        fileExtension_ = std::string(".json") + codecExtension(codec);
+    }
 
     // 文件路径和扩展名验证
     bool validateFileExtension(const std::string &extension)
@@ -59,6 +79,11 @@ private:
     size_t distname_index_;               // 文件名的索引，用于生成唯一的文件名
     std::string fileExtension_ = ".json"; // 文件扩展名
     std::mutex mutex_;                    // 用于文件名分配的互斥锁
+    std::shared_ptr<FilePublisher> publisher_ = std::make_shared<FilePublisher>();
+    KvJsonWriter::Style style_ = KvJsonWriter::Style::kPretty;
+    std::shared_ptr<IoBackend> backend_ = defaultIoBackend();
+    Codec codec_ = Codec::kNone;
+    int codecLevel_ = 0;
 };
 
 class JsonFileManager
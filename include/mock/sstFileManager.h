@@ -0,0 +1,54 @@
+#ifndef SST_FILEMANAGER_H
+#define SST_FILEMANAGER_H
+#include <string>
+#include <filesystem>
+#include <mutex>
+#include "rocksdb/sst_file_writer.h"
+#include "rocksdb/options.h"
+#include "mock/fileManager.h"
+#include "utils/result.h"
+#include "utils/kvEntry.h"
+#include "utils/valueEncoder.h"
+
+// 直接把生成的数据写成 SST 文件，跳过 JSON 中间格式（压测只需要 SST 时使用）
+// 数据按 ComparePair 排序去重后写入，value 编码默认与 SstProcessor 相同（ttl）
+class SstFileManager : public FileManagerBase
+{
+public:
+    SstFileManager(const std::string &dic, const rocksdb::Options &options = rocksdb::Options())
+        : options_(options), distname_index_(0)
+    {
+        dic_ = DEFAULTDIC / dic;
+        if (!std::filesystem::exists(dic_))
+        {
+            std::filesystem::create_directories(dic_);
+        }
+    }
+
+    // 线程安全的生成文件名
+    Result getFileName()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::string filePath = dic_ + "/data_" + std::to_string(distname_index_++) + fileExtension_;
+        LOG_INFO("SstFileManager Creating file: " + filePath);
+        return Result(Result::Ret::kFileCreated, filePath);
+    }
+
+    // data 已排序时直接写入并跳过重复 key；未排序时先拷贝排序。先写临时文件，Finish 后经 publisher 发布
+    Result write(const DataType &data) override;
+    Result flush() override { return publisher_->flush(); }
+
+    void setPublisher(const std::shared_ptr<FilePublisher> &publisher) { publisher_ = publisher; }
+    void setValueEncoder(const std::shared_ptr<const ValueEncoder> &encoder) { encoder_ = encoder; }
+
+private:
+    rocksdb::Options options_;
+    std::string dic_;                    // 用户指定的文件夹路径
+    size_t distname_index_;              // 文件名的索引，用于生成唯一的文件名
+    std::string fileExtension_ = ".sst"; // 文件扩展名
+    std::mutex mutex_;                   // 用于文件名分配的互斥锁
+    std::shared_ptr<FilePublisher> publisher_ = std::make_shared<FilePublisher>();
+    std::shared_ptr<const ValueEncoder> encoder_ = defaultValueEncoder();
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef ARG_PARSE_H
+#define ARG_PARSE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 命令行参数的数值解析，exchange / replbench 共用。解析失败返回 false，输出参数不变
+
+// 解析 64M、1G、4096 这类大小，单位 K/M/G 按 1024 进位；负数、多余字符与溢出都视为失败
+bool parseByteSize(const std::string &str, uint64_t &bytes);
+
+// 解析非负整数参数，整个字符串都必须是数字
+bool parseCount(const std::string &str, size_t &count);
+
+// 解析有限的小数，整个字符串都必须是数字（如 12、9.5）
+bool parseNumber(const std::string &str, double &value);
+
+#endif // ARG_PARSE_H
@@ -0,0 +1,42 @@
+#ifndef CODING_H
+#define CODING_H
+
+#include <cstdint>
+#include <string>
+
+// 定长小端整数编码，与 RocksDB util/coding.h 的 Fixed32 / Fixed64 相同。
+// value 编码（valueEncoder）与 Pika 布局（pikaLayout）共用
+
+inline void putFixed32(std::string &out, uint32_t v)
+{
+    char buf[4];
+    for (int i = 0; i < 4; ++i)
+        buf[i] = static_cast<char>((v >> (8 * i)) & 0xff);
+    out.append(buf, sizeof(buf));
+}
+
+inline void putFixed64(std::string &out, uint64_t v)
+{
+    char buf[8];
+    for (int i = 0; i < 8; ++i)
+        buf[i] = static_cast<char>((v >> (8 * i)) & 0xff);
+    out.append(buf, sizeof(buf));
+}
+
+inline uint32_t getFixed32(const char *p)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i)
+        v |= static_cast<uint32_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    return v;
+}
+
+inline uint64_t getFixed64(const char *p)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i)
+        v |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    return v;
+}
+
+#endif // CODING_H
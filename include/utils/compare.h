@@ -1,6 +1,7 @@
 #ifndef COMPARE_H
 #define COMPARE_H
 
+#include <iterator>
 #include <string>
 #include "utils/kvEntry.h"
 
@@ -17,8 +18,45 @@ struct ComparePair
         if (lhs.timestamp != rhs.timestamp)
             return lhs.timestamp > rhs.timestamp;
 
-        return lhs.value < rhs.value;
+        if (lhs.value != rhs.value)
+            return lhs.value < rhs.value;
+
+        // 同一 key 的集合记录 value 都为空，再按类型与元素比较，保证排序结果确定
+        if (lhs.type != rhs.type)
+            return lhs.type < rhs.type;
+        return lhs.fields < rhs.fields;
     }
 };
 
+// 已按 ComparePair 排序的数据中 i 之后第一条 key 不同的下标（没有时返回 data.size()）。
+// 同一 key 只保留第一条（即 timestamp 最新的一条），按此步进即可在不改动数据的情况下跳过重复 key
+inline size_t nextDistinctKey(const DataType &data, size_t i)
+{
+    size_t next = i + 1;
+    while (next < data.size() && data[next].key == data[i].key)
+        ++next;
+    return next;
+}
+
+// 对已按 ComparePair 排序的数据原地去重，保留规则同 nextDistinctKey。
+// removed 非空时尾部被淘汰的条目移入其中（其字符串持有被覆盖条目的缓冲区，可回收复用）
+inline void dedupSorted(DataType &data, DataType *removed = nullptr)
+{
+    if (data.empty())
+        return;
+    size_t out = 0;
+    for (size_t i = nextDistinctKey(data, 0); i < data.size();)
+    {
+        // 先算出下一条再移动，移动后 data[i].key 不再可比较
+        size_t next = nextDistinctKey(data, i);
+        ++out;
+        if (out != i)
+            data[out] = std::move(data[i]);
+        i = next;
+    }
+    if (removed)
+        removed->insert(removed->end(), std::make_move_iterator(data.begin() + out + 1), std::make_move_iterator(data.end()));
+    data.resize(out + 1);
+}
+
 #endif
@@ -0,0 +1,62 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <memory>
+#include <string>
+#include "utils/ioBackend.h"
+#include "utils/result.h"
+#include "utils/taskScheduler.h"
+
+// KV 文件的压缩格式，按扩展名识别（data_1.json.zst）。gzip 由 zlib 提供总是可用，
+// zstd / lz4 在构建时找到对应库才编译进来（BINGEST_WITH_ZSTD / BINGEST_WITH_LZ4）
+enum class Codec
+{
+    kNone = 0,
+    kGzip,
+    kZstd,
+    kLz4,
+};
+
+const char *codecName(Codec codec);
+// "" / ".gz" / ".zst" / ".lz4"
+const char *codecExtension(Codec codec);
+// none / gzip（或 gz）/ zstd（或 zst）/ lz4
+bool parseCodec(const std::string &name, Codec &codec);
+bool codecAvailable(Codec codec);
+
+Codec codecFromPath(const std::string &path);
+// 去掉压缩扩展名：data_1.json.zst -> data_1.json，未压缩时原样返回
+std::string stripCodecExtension(const std::string &path);
+
+// 把整个压缩数据解压到 out。zstd 由多个帧组成且每帧都记录了原始大小时（mock 的输出即是如此），
+// 在 scheduler 上按帧并行解压到 out 的对应位置；否则在当前线程流式解压。gzip / lz4 支持多个成员 / 帧首尾相接
+Result decompress(Codec codec, const std::string &data, std::string &out, TaskScheduler *scheduler = nullptr);
+
+// 压缩写入器：明文写入后压缩交给 inner，close 时一并关闭 inner。
+// zstd / lz4 每满 kFrameBytes 明文输出一个带原始大小的独立帧，解压时可按帧并行；gzip 为单个流。level 为 0 时取各格式默认值
+class CompressingWriter : public IoWriter
+{
+public:
+    static constexpr size_t kFrameBytes = 4 << 20;
+
+    static Result create(Codec codec, int level, std::unique_ptr<IoWriter> inner, std::unique_ptr<IoWriter> &writer);
+    ~CompressingWriter() override;
+
+    Result write(const char *data, size_t size) override;
+    Result close() override;
+
+    struct State;
+
+private:
+    CompressingWriter(Codec codec, int level, std::unique_ptr<IoWriter> inner);
+    Result emitFrame(const char *data, size_t size);
+
+    Codec codec_;
+    int level_;
+    std::unique_ptr<IoWriter> inner_;
+    std::string pending_; // 尚未成帧的明文
+    std::string output_;  // 压缩结果缓冲
+    std::unique_ptr<State> state_;
+};
+
+#endif // COMPRESSION_H
@@ -0,0 +1,36 @@
+#ifndef DIR_WATCHER_H
+#define DIR_WATCHER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "utils/result.h"
+
+// 基于 inotify 的目录监视：只报告「写完」的文件，即写句柄关闭（IN_CLOSE_WRITE）
+// 或由临时名 rename 进来（IN_MOVED_TO）的普通文件。
+// inotify 事件队列溢出时退化为重新扫描整个目录，返回目录下所有普通文件。
+class DirWatcher
+{
+public:
+    explicit DirWatcher(const std::string &dir) : dir_(dir) {}
+    ~DirWatcher();
+
+    DirWatcher(const DirWatcher &) = delete;
+    DirWatcher &operator=(const DirWatcher &) = delete;
+
+    Result open();
+
+    // 最多等待 timeout，把期间写完的文件名（不含目录）追加到 names
+    Result poll(std::chrono::milliseconds timeout, std::vector<std::string> &names);
+
+    const std::string &dir() const { return dir_; }
+
+private:
+    void rescan(std::vector<std::string> &names) const;
+
+    std::string dir_;
+    int fd_ = -1;
+    int wd_ = -1;
+};
+
+#endif // DIR_WATCHER_H
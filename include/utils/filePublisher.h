@@ -0,0 +1,60 @@
+#ifndef FILE_PUBLISHER_H
+#define FILE_PUBLISHER_H
+
+#include <mutex>
+#include <set>
+#include <string>
+#include "utils/result.h"
+
+// 输出文件的落盘策略
+enum class SyncPolicy
+{
+    kNone,    // 只 rename，不主动 fsync，由内核回写
+    kPerFile, // 每个文件 fsync 后 rename，再 fsync 所在目录
+    kBatched, // 立即 rename 发布，每 batchSize 个文件做一次 syncfs 并 fsync 涉及的目录
+};
+
+// 解析 none / file / batch[:N]，batch 未给出 N 时 batchSize 保持不变
+Result parseSyncPolicy(const std::string &spec, SyncPolicy &policy, size_t &batchSize);
+
+// 先写同目录下的隐藏临时文件，写完后 rename 到最终路径发布，读方（监视模式、上传）永远看不到半个文件。
+// 落盘代价由 SyncPolicy 控制；批量模式下 rename 后文件立即可见，但只有 flush() 之后才保证持久化。
+// 线程安全，多个写入任务共享同一个实例。
+class FilePublisher
+{
+public:
+    explicit FilePublisher(SyncPolicy policy = SyncPolicy::kNone, size_t batchSize = 64)
+        : policy_(policy), batchSize_(batchSize == 0 ? 1 : batchSize) {}
+    ~FilePublisher();
+
+    FilePublisher(const FilePublisher &) = delete;
+    FilePublisher &operator=(const FilePublisher &) = delete;
+
+    // dir/name -> dir/.name.tmp，以 '.' 开头且扩展名为 .tmp，目录扫描与监视都会忽略
+    static std::string tempPath(const std::string &finalPath);
+
+    // 把写完的 tempPath 按策略发布到 finalPath；失败时删除 tempPath
+    Result publish(const std::string &tempPath, const std::string &finalPath);
+
+    // 写入失败时清理临时文件
+    static void discard(const std::string &tempPath);
+
+    // 把一段内容经 tempPath 整体替换到 finalPath，供指标、追踪、日志快照等进程自身的状态文件使用；
+    // durable 时 rename 前 fsync 文件、rename 后 fsync 目录。不计入发布指标，也不开追踪区间
+    static Result writeFile(const std::string &finalPath, const std::string &content, bool durable = false);
+
+    // 批量模式下把尚未落盘的文件与目录刷盘，其他模式为空操作
+    Result flush();
+
+    SyncPolicy policy() const { return policy_; }
+    size_t batchSize() const { return batchSize_; }
+
+private:
+    SyncPolicy policy_;
+    size_t batchSize_;
+    std::mutex mutex_;
+    std::set<std::string> pendingDirs_; // 自上次 flush 以来有文件发布的目录
+    size_t pendingFiles_ = 0;
+};
+
+#endif // FILE_PUBLISHER_H
@@ -0,0 +1,83 @@
+#ifndef IO_BACKEND_H
+#define IO_BACKEND_H
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include "utils/result.h"
+
+// 顺序写一个文件。write 返回后 data 即可复用，数据可能仍在途；close 等待全部写入完成后关闭文件
+class IoWriter
+{
+public:
+    virtual ~IoWriter() = default;
+    virtual Result write(const char *data, size_t size) = 0;
+    virtual Result close() = 0;
+};
+
+// 输入读取与输出写入的 I/O 后端。实现需可被多个线程同时使用
+class IoBackend
+{
+public:
+    virtual ~IoBackend() = default;
+    virtual const char *name() const = 0;
+
+    // 读取整个文件到 out；文件打不开时返回 kFileOpenError
+    virtual Result readFile(const std::string &path, std::string &out) = 0;
+    // 提示 path 即将被 readFile 读取，后端可提前发起读（只是提示，可以忽略）
+    virtual void prefetch(const std::string &path) { (void)path; }
+    // 创建（截断）path 并返回写入器
+    virtual Result openForWrite(const std::string &path, std::unique_ptr<IoWriter> &writer) = 0;
+};
+
+// 阻塞的 pread / pwrite，prefetch 为 posix_fadvise(WILLNEED)
+class PosixIoBackend : public IoBackend
+{
+public:
+    const char *name() const override { return "posix"; }
+    Result readFile(const std::string &path, std::string &out) override;
+    void prefetch(const std::string &path) override;
+    Result openForWrite(const std::string &path, std::unique_ptr<IoWriter> &writer) override;
+};
+
+// io_uring 后端（直接使用系统调用，不依赖 liburing）：
+//   - 每个线程从池中借用一个 ring，ring 与其注册缓冲区在借用之间复用，不在线程之间共享
+//   - 写入拷贝到注册缓冲区后以 WRITE_FIXED 提交，一次 io_uring_enter 批量提交多个块，写满队列才等待完成
+//   - 读取按 kChunkSize 分块同时提交，单个文件也有队列深度；prefetch 在后台发起读，readFile 直接取走结果。
+//     预读项持有 ring、fd 与整个文件的缓冲区，超过 kReadAheadExpiry 仍未被读取（任务被跳过或失败）时丢弃
+class IoUringBackend : public IoBackend
+{
+public:
+    static constexpr unsigned kQueueDepth = 16;       // 每个 ring 同时在途的请求数
+    static constexpr size_t kChunkSize = 512 << 10;   // 单个请求与注册缓冲区大小
+    static constexpr size_t kMaxReadAheadFiles = 8;   // 预读中的文件数上限
+    static constexpr size_t kMaxReadAheadBytes = 512 << 20;
+    static constexpr std::chrono::milliseconds kReadAheadExpiry{30000};
+
+    // 内核不支持或被禁用时返回错误
+    static Result create(std::shared_ptr<IoBackend> &backend);
+    ~IoUringBackend() override;
+
+    const char *name() const override { return "uring"; }
+    Result readFile(const std::string &path, std::string &out) override;
+    void prefetch(const std::string &path) override;
+    Result openForWrite(const std::string &path, std::unique_ptr<IoWriter> &writer) override;
+
+    // 未被读取的预读项的保留时间，默认 kReadAheadExpiry
+    void setReadAheadExpiry(std::chrono::milliseconds expiry);
+    // 当前持有的预读项数（包括正在发起的）
+    size_t readAheadFiles() const;
+
+    struct Impl;
+
+private:
+    explicit IoUringBackend(std::shared_ptr<Impl> impl) : impl_(std::move(impl)) {}
+    std::shared_ptr<Impl> impl_;
+};
+
+// posix / uring / auto（io_uring 可用时用 uring，否则 posix）
+Result makeIoBackend(const std::string &name, std::shared_ptr<IoBackend> &backend);
+// 默认后端（posix）
+const std::shared_ptr<IoBackend> &defaultIoBackend();
+
+#endif // IO_BACKEND_H
@@ -1,13 +1,28 @@
 #ifndef KLOG_H
 #define KLOG_H
 
-#include <mutex>
-#include <iostream>
-#include <fstream>
+#include <atomic>
 #include <chrono>
-#include <iomanip>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+
+// 编译期日志级别：低于该级别的 LOG_* 在编译期被丢弃，参数表达式不会被求值
+// 0=Debug 1=Info 2=Warning 3=Error，可通过 -DKLOG_MIN_LEVEL=N 覆盖
+#ifndef KLOG_MIN_LEVEL
+#ifdef DEBUG
+#define KLOG_MIN_LEVEL 0
+#else
+#define KLOG_MIN_LEVEL 1
+#endif
+#endif
 
+// 异步日志：每个线程写自己的无锁单生产者环形缓冲，
+// 后台 flusher 线程批量取出后写入常驻打开的日志文件（带缓冲）和控制台
 class KLogger
 {
 public:
@@ -20,83 +35,171 @@ public:
     };
 
     KLogger() = default;
+    ~KLogger();
+
+    KLogger(const KLogger &) = delete;
+    KLogger &operator=(const KLogger &) = delete;
+
+    // 入队一条日志，只在本线程的环形缓冲上操作，不加锁
+    void log(KLogLevel level, std::string msg);
+
+    // 阻塞直到调用前入队的日志全部写出
+    void flush();
+
+    // 运行期级别过滤（编译期过滤之外的第二道门槛）
+    void setLevel(KLogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    bool enabled(KLogLevel level) const { return level >= level_.load(std::memory_order_relaxed); }
+
+    // 切换日志文件（会先 flush 旧文件），空字符串表示不写文件
+    void setLogFile(const std::string &fileName);
+    void setConsole(bool enable) { console_.store(enable, std::memory_order_relaxed); }
 
-    void setKLog(KLogLevel level, const std::string &msg)
+    // 因限流被丢弃的日志条数
+    uint64_t suppressed() const { return suppressed_.load(std::memory_order_relaxed); }
+    void addSuppressed(uint64_t n) { suppressed_.fetch_add(n, std::memory_order_relaxed); }
+
+private:
+    struct Record
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        level_ = level;
-        message_ = msg;
-    }
+        KLogLevel level = Info;
+        std::chrono::system_clock::time_point time;
+        std::string message;
+    };
 
-    void logMessage() const
+    // 单生产者单消费者环形缓冲：生产者为所属线程，消费者为 flusher
+    class Ring
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        switch (level_)
+    public:
+        static constexpr size_t kCapacity = 1024;
+
+        bool push(Record &record);
+        bool pop(Record &record);
+        bool empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+
+        std::atomic<bool> retired{false}; // 所属线程已退出
+
+    private:
+        Record slots_[kCapacity];
+        alignas(64) std::atomic<size_t> head_{0}; // 消费位置
+        alignas(64) std::atomic<size_t> tail_{0}; // 生产位置
+    };
+
+    struct RingHolder
+    {
+        std::shared_ptr<Ring> ring;
+        ~RingHolder()
         {
-#ifdef DEBUG
-        case Debug:
-            std::cout << "[DEBUG] " << message_ << std::endl;
-            break;
-#endif
-        case Info:
-            std::cout << "[INFO] " << message_ << std::endl;
-            break;
-        case Warning:
-            std::cout << "[WARNING] " << message_ << std::endl;
-            break;
-        case Error:
-            std::cerr << "[ERROR] " << message_ << std::endl;
-            break;
+            if (ring)
+                ring->retired.store(true, std::memory_order_release);
         }
-    }
+    };
+
+    Ring &localRing();
+    void start();
+    void flusherLoop();
+    // 取出全部环形缓冲中的日志并写出，返回写出的条数
+    size_t drain();
+    void write(const Record &record);
+
+    std::once_flag started_;
+    std::atomic<bool> running_{false};
+    std::thread flusher_;
+    std::atomic<bool> stop_{false};
+
+    std::mutex ringsMutex_; // 只在线程注册/回收环形缓冲时使用
+    std::vector<std::shared_ptr<Ring>> rings_;
+
+    std::mutex flushMutex_;
+    std::condition_variable flushCv_;
+    std::condition_variable flushedCv_;
+    uint64_t flushRequested_ = 0;
+    uint64_t flushCompleted_ = 0;
+
+    std::mutex fileMutex_; // 只在 flusher 与 setLogFile 之间使用
+    std::FILE *file_ = nullptr;
+    std::string fileName_ = "KLog.txt";
+    bool fileOpened_ = false;
+
+    std::atomic<KLogLevel> level_{Debug};
+    std::atomic<bool> console_{true};
+    std::atomic<uint64_t> suppressed_{0};
+};
+
+inline KLogger klogger;
+
+// 每秒最多放行 perSecond 条，超出部分计入 klogger.suppressed()
+class KLogRateLimiter
+{
+public:
+    explicit KLogRateLimiter(uint32_t perSecond) : perSecond_(perSecond) {}
 
-    void logToFile(const std::string &fileName) const
+    bool allow()
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        std::ofstream logFile(fileName, std::ios::app);
-        if (logFile.is_open())
+        int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+        int64_t window = window_.load(std::memory_order_relaxed);
+        if (now != window && window_.compare_exchange_strong(window, now, std::memory_order_relaxed))
         {
-            auto now = std::chrono::system_clock::now();
-            auto now_time = std::chrono::system_clock::to_time_t(now);
-            logFile << std::put_time(std::localtime(&now_time), "%Y-%m-%d %H:%M:%S") << " ";
-
-            switch (level_)
-            {
-#ifdef DEBUG
-            case Debug:
-                logFile << "[DEBUG] ";
-                break;
-#endif
-            case Info:
-                logFile << "[INFO] ";
-                break;
-            case Warning:
-                logFile << "[WARNING] ";
-                break;
-            case Error:
-                logFile << "[ERROR] ";
-                break;
-            }
-            logFile << message_ << std::endl;
+            count_.store(0, std::memory_order_relaxed);
         }
+        if (count_.fetch_add(1, std::memory_order_relaxed) < perSecond_)
+            return true;
+        klogger.addSuppressed(1);
+        return false;
     }
 
 private:
-    mutable std::mutex mutex_;
-    KLogLevel level_ = Info;
-    std::string message_;
+    const uint32_t perSecond_;
+    std::atomic<int64_t> window_{0};
+    std::atomic<uint32_t> count_{0};
 };
 
-inline KLogger klogger;
+#define KLOG_ENABLED(level) (KLogger::KLogLevel::level >= KLOG_MIN_LEVEL)
+
+#define KLOG(level, content)                                     \
+    do                                                           \
+    {                                                            \
+        if constexpr (KLOG_ENABLED(level))                       \
+        {                                                        \
+            if (klogger.enabled(KLogger::KLogLevel::level))      \
+                klogger.log(KLogger::KLogLevel::level, content); \
+        }                                                        \
+    } while (0)
 
-#define KLOG(level, content)                             \
-    klogger.setKLog(KLogger::KLogLevel::level, content); \
-    klogger.logMessage();                                \
-    klogger.logToFile("KLog.txt")
+// 热路径使用：每 n 次调用只记录一次
+#define KLOG_EVERY_N(level, n, content)                                         \
+    do                                                                          \
+    {                                                                           \
+        if constexpr (KLOG_ENABLED(level))                                      \
+        {                                                                       \
+            static std::atomic<uint64_t> klogOccurrences_{0};                   \
+            if (klogOccurrences_.fetch_add(1, std::memory_order_relaxed) % (n)) \
+                klogger.addSuppressed(1);                                       \
+            else                                                                \
+                KLOG(level, content);                                           \
+        }                                                                       \
+    } while (0)
+
+// 热路径使用：每个调用点每秒最多记录 perSecond 条
+#define KLOG_RATE_LIMITED(level, perSecond, content)          \
+    do                                                        \
+    {                                                         \
+        if constexpr (KLOG_ENABLED(level))                    \
+        {                                                     \
+            static KLogRateLimiter klogLimiter_(perSecond);   \
+            if (klogLimiter_.allow())                         \
+                KLOG(level, content);                         \
+        }                                                     \
+    } while (0)
 
 #define LOG_DEBUG(content) KLOG(Debug, content)
 #define LOG_INFO(content) KLOG(Info, content)
 #define LOG_WARN(content) KLOG(Warning, content)
 #define LOG_ERROR(content) KLOG(Error, content)
 
+#define LOG_DEBUG_EVERY_N(n, content) KLOG_EVERY_N(Debug, n, content)
+#define LOG_WARN_RATE_LIMITED(perSecond, content) KLOG_RATE_LIMITED(Warning, perSecond, content)
+#define LOG_ERROR_RATE_LIMITED(perSecond, content) KLOG_RATE_LIMITED(Error, perSecond, content)
+
 #endif // KLOG_H
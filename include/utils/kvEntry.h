@@ -5,34 +5,158 @@
 #include <vector>
 #include <nlohmann/json.hpp>
 #include <random>
+#include <stdexcept>
 #include "utils/kconfig.h"
 
 using json = nlohmann::json;
 
+// 记录类型，取值与 Pika 4.x storage 的 DataType 一致
+enum class KvType : uint8_t
+{
+    kString = 0,
+    kHash = 1,
+    kSet = 2,
+    kList = 3,
+    kZSet = 4,
+};
+constexpr size_t kNumKvTypes = 5;
+
+// 集合类型的一个元素：hash 为 name/value，set 为 name，zset 为 name/score，list 为 value（保持顺序）
+struct KvField
+{
+    std::string name;
+    std::string value;
+    double score = 0;
+
+    bool operator==(const KvField &other) const
+    {
+        return name == other.name && value == other.value && score == other.score;
+    }
+    bool operator<(const KvField &other) const
+    {
+        if (name != other.name)
+            return name < other.name;
+        if (value != other.value)
+            return value < other.value;
+        return score < other.score;
+    }
+};
+
 struct KvEntry
 {
     std::string key;
-    std::string value;
+    std::string value; // 仅 string 使用
     uint32_t timestamp = 0;
+    KvType type = KvType::kString;
+    std::vector<KvField> fields; // 仅集合类型使用
 
+    // value | timestamp（fixed32 小端），与 TtlSuffixValueEncoder 相同
     std::string encodedValue() const
     {
         std::string v = value;
-        v.append(reinterpret_cast<const char *>(&timestamp), sizeof(timestamp));
+        for (int i = 0; i < 4; ++i)
+            v.push_back(static_cast<char>((timestamp >> (8 * i)) & 0xff));
         return v;
     }
 };
 
+inline const char *kvTypeName(KvType type)
+{
+    switch (type)
+    {
+    case KvType::kHash:
+        return "hash";
+    case KvType::kSet:
+        return "set";
+    case KvType::kList:
+        return "list";
+    case KvType::kZSet:
+        return "zset";
+    default:
+        return "string";
+    }
+}
+
+inline bool parseKvType(const std::string &name, KvType &type)
+{
+    for (KvType t : {KvType::kString, KvType::kHash, KvType::kSet, KvType::kList, KvType::kZSet})
+    {
+        if (name == kvTypeName(t))
+        {
+            type = t;
+            return true;
+        }
+    }
+    return false;
+}
+
 // 类型别名
 using KvData = std::vector<KvEntry>;
 using DataType = KvData;
 
+// data 在内存中的近似占用：vector 容量加上超出 SSO 的字符串堆内存，用于内存预算的实测
+inline size_t kvMemoryBytes(const DataType &data)
+{
+    auto heap = [](const std::string &text)
+    { return text.capacity() > 15 ? text.capacity() + 1 : 0; };
+    size_t bytes = data.capacity() * sizeof(KvEntry);
+    for (const auto &entry : data)
+    {
+        bytes += heap(entry.key) + heap(entry.value) + entry.fields.capacity() * sizeof(KvField);
+        for (const auto &field : entry.fields)
+            bytes += heap(field.name) + heap(field.value);
+    }
+    return bytes;
+}
+
 // -------- JSON 序列化支持 --------
+// string 为 {"key", "value", "expire"}，不带 "type"，与旧文件兼容；集合类型带 "type"：
+//   hash: "fields": {"f": "v"}    set: "members": ["m"]    zset: "members": {"m": 1.5}    list: "values": ["a"]
 inline void to_json(json &j, const KvEntry &entry)
 {
-    j = json{
-        {"key", entry.key},
-        {"value", entry.value}};
+    j = json{{"key", entry.key}};
+    switch (entry.type)
+    {
+    case KvType::kString:
+        j["value"] = entry.value;
+        break;
+    case KvType::kHash:
+    {
+        json fields = json::object();
+        for (const auto &field : entry.fields)
+            fields[field.name] = field.value;
+        j["fields"] = std::move(fields);
+        break;
+    }
+    case KvType::kSet:
+    {
+        json members = json::array();
+        for (const auto &field : entry.fields)
+            members.push_back(field.name);
+        j["members"] = std::move(members);
+        break;
+    }
+    case KvType::kZSet:
+    {
+        json members = json::object();
+        for (const auto &field : entry.fields)
+            members[field.name] = field.score;
+        j["members"] = std::move(members);
+        break;
+    }
+    case KvType::kList:
+    {
+        json values = json::array();
+        for (const auto &field : entry.fields)
+            values.push_back(field.value);
+        j["values"] = std::move(values);
+        break;
+    }
+    }
+    if (entry.type != KvType::kString)
+    {
+        j["type"] = kvTypeName(entry.type);
+    }
 
     if (entry.timestamp != 0)
     {
@@ -43,8 +167,36 @@ inline void to_json(json &j, const KvEntry &entry)
 inline void from_json(const json &j, KvEntry &entry)
 {
     entry.key = j.at("key").get<std::string>();
-    entry.value = j.at("value").get<std::string>();
     entry.timestamp = j.value("expire", 0); // 如果没有则默认 0
+    entry.type = KvType::kString;
+    entry.value.clear();
+    entry.fields.clear();
+    if (j.contains("type") && !parseKvType(j.at("type").get<std::string>(), entry.type))
+    {
+        throw std::runtime_error("Unknown record type: " + j.at("type").get<std::string>());
+    }
+    switch (entry.type)
+    {
+    case KvType::kString:
+        entry.value = j.at("value").get<std::string>();
+        break;
+    case KvType::kHash:
+        for (const auto &item : j.at("fields").items())
+            entry.fields.push_back(KvField{item.key(), item.value().get<std::string>(), 0});
+        break;
+    case KvType::kSet:
+        for (const auto &member : j.at("members"))
+            entry.fields.push_back(KvField{member.get<std::string>(), "", 0});
+        break;
+    case KvType::kZSet:
+        for (const auto &item : j.at("members").items())
+            entry.fields.push_back(KvField{item.key(), "", item.value().get<double>()});
+        break;
+    case KvType::kList:
+        for (const auto &value : j.at("values"))
+            entry.fields.push_back(KvField{"", value.get<std::string>(), 0});
+        break;
+    }
 }
 
 // 返回当前时间戳 + 随机偏移（单位：秒）
@@ -0,0 +1,47 @@
+#ifndef KV_JSON_WRITER_H
+#define KV_JSON_WRITER_H
+
+#include <string>
+#include "utils/ioBackend.h"
+#include "utils/kvEntry.h"
+#include "utils/result.h"
+
+// DataType 的流式 JSON 序列化：逐条写入可复用的缓冲区，满 kFlushBytes 后一次交给 IoWriter 写出，
+// 不构造 json 树。输出与 json(data).dump(4)（kPretty）/ dump()（kCompact）逐字节相同：
+// 对象成员按名字排序，集合中的重复 field 取最后一个，zset 的 score 沿用 nlohmann 的浮点格式。
+// 纯 ASCII 字符串整段拷贝，expire 用 std::to_chars 格式化；非法 UTF-8 返回错误（nlohmann 会抛异常）
+class KvJsonWriter
+{
+public:
+    enum class Style
+    {
+        kCompact,
+        kPretty,
+    };
+    static constexpr size_t kFlushBytes = 4 << 20;
+
+    explicit KvJsonWriter(Style style = Style::kPretty) : style_(style) {}
+
+    void setStyle(Style style) { style_ = style; }
+    Style getStyle() const { return style_; }
+
+    // 序列化 data 并写入 out（不关闭），缓冲区在多次调用之间复用
+    Result write(IoWriter &out, const DataType &data);
+    // 序列化到 out（覆盖原内容）
+    Result serialize(const DataType &data, std::string &out);
+
+private:
+    // out 为空时不刷出，全部留在 buffer_ 中
+    Result encode(const DataType &data, IoWriter *out);
+    Result flushTo(IoWriter &out);
+
+    void newline(int level);
+    void name(const char *text);
+    bool string(const std::string &text);
+    bool entry(const KvEntry &entry);
+
+    Style style_;
+    std::string buffer_;
+};
+
+#endif // KV_JSON_WRITER_H
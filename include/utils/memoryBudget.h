@@ -0,0 +1,80 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+class MemoryReservation;
+
+// 进程内的内存预算：每个任务提交前按 输入字节数 x 扩张系数 预留内存，预算用尽时提交方阻塞，
+// 已提交的任务结束释放后再继续，并发度随数据大小自动收缩。扩张系数由任务实测的内存占用修正。
+// reserve 只应在提交任务的线程上调用：在 worker 内阻塞可能与嵌套的 TaskGroup::wait 互相等待。
+// 线程缓冲池保留的内存经 retain 单独计入：有任务在运行时同样占用预算，但没有任务预留时不阻塞提交，
+// 空闲线程长期保留的缓冲区不会让提交方永远等待
+class MemoryBudget
+{
+public:
+    static constexpr double kDefaultExpansion = 4.0;
+
+    explicit MemoryBudget(uint64_t capacity, double expansion = kDefaultExpansion);
+    ~MemoryBudget();
+
+    MemoryBudget(const MemoryBudget &) = delete;
+    MemoryBudget &operator=(const MemoryBudget &) = delete;
+
+    uint64_t capacity() const { return capacity_; }
+    uint64_t reserved() const;
+    uint64_t retained() const;
+    double expansion() const;
+
+    // inputBytes 字节的输入在内存中预计占用的字节数
+    uint64_t estimate(uint64_t inputBytes) const;
+    // 记录一次实测：inputBytes 的输入实际占用 memoryBytes。偏大时立即采用，偏小时按 1/4 的权重缓慢下调
+    void observe(uint64_t inputBytes, uint64_t memoryBytes);
+
+    // 阻塞到预算足够时预留 bytes；超过总预算的请求按总预算计，即等其他预留全部释放后独占运行
+    MemoryReservation reserve(uint64_t bytes);
+    // 立即预留，可能超出预算，用于不能阻塞的调用方
+    MemoryReservation reserveNow(uint64_t bytes);
+    // 计入缓冲池保留的内存，立即返回（WorkerBuffers 使用）
+    MemoryReservation retain(uint64_t bytes);
+
+    // 物理内存与 cgroup 内存上限中较小者的 3/4
+    static uint64_t autoCapacity();
+
+private:
+    friend class MemoryReservation;
+    void release(uint64_t bytes, bool retained);
+
+    const uint64_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    uint64_t reserved_ = 0; // 任务的预留
+    uint64_t retained_ = 0; // 缓冲池保留的内存
+    double expansion_;
+};
+
+// 一次预留，析构或 release 时归还
+class MemoryReservation
+{
+public:
+    MemoryReservation() = default;
+    MemoryReservation(MemoryReservation &&other) noexcept;
+    MemoryReservation &operator=(MemoryReservation &&other) noexcept;
+    ~MemoryReservation() { release(); }
+
+    uint64_t bytes() const { return bytes_; }
+    void release();
+
+private:
+    friend class MemoryBudget;
+    MemoryReservation(MemoryBudget *budget, uint64_t bytes, bool retained = false)
+        : budget_(budget), bytes_(bytes), retained_(retained) {}
+
+    MemoryBudget *budget_ = nullptr;
+    uint64_t bytes_ = 0;
+    bool retained_ = false;
+};
+
+#endif // MEMORY_BUDGET_H
@@ -0,0 +1,161 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "utils/result.h"
+
+using json = nlohmann::json;
+
+// 每个线程固定映射到一个分片，分片按 cache line 对齐，热路径只做 relaxed 原子加
+size_t metricsShardIndex();
+
+class MetricsCounter
+{
+public:
+    static constexpr size_t kShards = 64;
+
+    void add(uint64_t n = 1) { shards_[metricsShardIndex() % kShards].value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, kShards> shards_;
+};
+
+class MetricsGauge
+{
+public:
+    void set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+    void add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+// HDR 风格的对数-线性直方图：每个 2 的幂区间再均分为 16 个子桶，相对误差约 6%
+class MetricsHistogram
+{
+public:
+    static constexpr size_t kSubBucketBits = 4;
+    static constexpr size_t kSubBuckets = 1 << kSubBucketBits;
+    static constexpr size_t kBuckets = kSubBuckets + (64 - kSubBucketBits) * kSubBuckets;
+    static constexpr size_t kShards = 8;
+
+    struct Snapshot
+    {
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t min = 0;
+        uint64_t max = 0;
+        std::array<uint64_t, kBuckets> buckets{};
+
+        // q 取值 [0, 1]，返回所在桶的中点
+        uint64_t percentile(double q) const;
+        double mean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+    };
+
+    void record(uint64_t value);
+    Snapshot snapshot() const;
+
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketLowerBound(size_t index);
+    static uint64_t bucketUpperBound(size_t index);
+
+private:
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> min{UINT64_MAX};
+        std::atomic<uint64_t> max{0};
+        std::array<std::atomic<uint64_t>, kBuckets> buckets{};
+    };
+    std::array<Shard, kShards> shards_;
+};
+
+// 指标注册表：按名称获取或创建，返回的引用在进程生命周期内有效。
+// 热路径上应把引用缓存到 static 局部变量中，只有首次注册会加锁。
+class MetricsRegistry
+{
+public:
+    static MetricsRegistry &instance();
+
+    MetricsCounter &counter(const std::string &name, const std::string &help = "");
+    MetricsGauge &gauge(const std::string &name, const std::string &help = "");
+    MetricsHistogram &histogram(const std::string &name, const std::string &help = "");
+
+    json toJson() const;
+    std::string toPrometheus() const;
+
+private:
+    template <typename T>
+    struct Entry
+    {
+        std::string help;
+        std::unique_ptr<T> metric;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Entry<MetricsCounter>> counters_;
+    std::map<std::string, Entry<MetricsGauge>> gauges_;
+    std::map<std::string, Entry<MetricsHistogram>> histograms_;
+};
+
+inline MetricsCounter &metricsCounter(const std::string &name, const std::string &help = "") { return MetricsRegistry::instance().counter(name, help); }
+inline MetricsGauge &metricsGauge(const std::string &name, const std::string &help = "") { return MetricsRegistry::instance().gauge(name, help); }
+inline MetricsHistogram &metricsHistogram(const std::string &name, const std::string &help = "") { return MetricsRegistry::instance().histogram(name, help); }
+
+// 作用域计时：析构时把耗时（纳秒）记入直方图
+class ScopedLatency
+{
+public:
+    explicit ScopedLatency(MetricsHistogram &histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedLatency()
+    {
+        histogram_.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                    std::chrono::steady_clock::now() - start_)
+                                                    .count()));
+    }
+
+private:
+    MetricsHistogram &histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// 周期性导出：JSON 快照与 Prometheus 文本文件（textfile collector 格式），均以 rename 原子替换
+class MetricsExporter
+{
+public:
+    MetricsExporter(const std::string &jsonPath, const std::string &promPath,
+                    std::chrono::milliseconds interval = std::chrono::seconds(5));
+    ~MetricsExporter() { stop(); }
+
+    // 停止后台线程并写出最后一次快照
+    void stop();
+    Result writeOnce() const;
+
+private:
+    std::string jsonPath_;
+    std::string promPath_;
+    std::chrono::milliseconds interval_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+#endif // METRICS_H
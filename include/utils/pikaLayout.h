@@ -0,0 +1,86 @@
+#ifndef PIKA_LAYOUT_H
+#define PIKA_LAYOUT_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "rocksdb/comparator.h"
+#include "utils/kvEntry.h"
+#include "utils/valueEncoder.h"
+
+// Pika 4.x storage 的列族：所有类型的 meta（以及 string 本身）都在 default CF，集合元素在各自的 data CF
+enum PikaCf : size_t
+{
+    kPikaMetaCf = 0,
+    kPikaHashDataCf,
+    kPikaSetDataCf,
+    kPikaListDataCf,
+    kPikaZSetDataCf,
+    kPikaZSetScoreCf,
+    kPikaCfCount
+};
+
+// 列族名，与 Pika 建库时使用的名字一致
+const char *pikaCfName(size_t cf);
+
+// 列族的 comparator：list data 与 zset score 使用 Pika 自定义的 comparator（名字必须与 Pika 一致，否则 ingest 失败），
+// 其余为 bytewise。SstFileWriter 与排序都必须使用它
+const rocksdb::Comparator *pikaCfComparator(size_t cf);
+
+using KvPair = std::pair<std::string, std::string>;
+using CfData = std::array<std::vector<KvPair>, kPikaCfCount>;
+
+// 把类型化的记录展开为 Pika 4.x 各列族的 (key, value)。key 格式（reserve 均为 0）：
+//   meta / string : | reserve1 (8B) | encoded key | reserve2 (16B) |
+//   hash/set/zset : | reserve1 | encoded key | version (8B) | field/member | reserve2 |
+//   list data     : | reserve1 | encoded key | version | index (8B) | reserve2 |
+//   zset score    : | reserve1 | encoded key | version | score (8B double) | member | reserve2 |
+// encoded key 把 user key 中的 \x00 转义为 \x00\x01 并以 \x00\x00 结尾，保证前缀唯一。
+// value 格式：
+//   string     : | type | value | reserve (16B) | ctime | etime |
+//   hash/set/zset meta : | type | count (4B) | version | reserve | ctime | etime |
+//   list meta  : | type | count (8B) | version | left index | right index | reserve | ctime | etime |
+//   data       : | value（hash 为 field value，zset data 为 score，set 与 zset score 为空）| reserve | ctime |
+// 整数均为小端 fixed 编码，ctime / etime 为毫秒。ctime 取构造时刻。
+// 同一个集合 key 可能出现在多个输出文件中（默认模式、未开 -D 时），ingest 后各文件的 data CF 元素会并存，
+// 只有版本号与生效的 meta 相同的元素可见。因此每个输出文件用 nextVersion() 取一个自己的版本号，
+// 后 ingest 的 meta 胜出时先前文件的元素整体失效，与 string 的整条覆盖一致
+class PikaLayout
+{
+public:
+    static constexpr size_t kPrefixReserveLength = 8;
+    static constexpr size_t kSuffixReserveLength = 16;
+    // list 元素的初始下标，与 Pika 相同：RPUSH 从 kInitialRightIndex 开始递增
+    static constexpr uint64_t kInitialLeftIndex = 9223372036854775807ULL;
+    static constexpr uint64_t kInitialRightIndex = 9223372036854775808ULL;
+
+    PikaLayout();
+    explicit PikaLayout(uint64_t ctimeMs) : ctimeMs_(ctimeMs), stringEncoder_(ctimeMs) {}
+
+    // 把一条记录以 version 展开追加到 out；同一记录内重复的 field / member 后者覆盖前者，与 HSET / SADD / ZADD 一致
+    void append(const KvEntry &entry, uint64_t version, CfData &out) const;
+    void append(const KvEntry &entry, CfData &out) const { append(entry, version(), out); }
+
+    // 追加 \x00 转义后的 user key 与 \x00\x00 结束符
+    static void encodeUserKey(const std::string &key, std::string &out);
+
+    uint64_t ctimeMs() const { return ctimeMs_; }
+    // 第一个版本号，即 ctime
+    uint64_t version() const { return ctimeMs_; }
+    // 为一个输出文件分配版本号：ctime 加上递增序号，线程安全
+    uint64_t nextVersion() const { return ctimeMs_ + sequence_.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    std::string metaKey(const std::string &key) const;
+    std::string dataKeyPrefix(const std::string &key, uint64_t version) const;
+    void appendDataSuffix(std::string &value) const;
+
+    uint64_t ctimeMs_;
+    mutable std::atomic<uint64_t> sequence_{0};
+    PikaStringValueEncoder stringEncoder_;
+};
+
+#endif // PIKA_LAYOUT_H
@@ -0,0 +1,57 @@
+#ifndef SHARD_FUNCTION_H
+#define SHARD_FUNCTION_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "utils/result.h"
+
+using json = nlohmann::json;
+
+// 把 key 映射到分片，分片 SST 输出（SstProcessor::setShardFunction）据此把每条记录路由到所属分片。
+// 实现必须是纯函数：同一个 key 总是落在同一个分片，与输入文件、线程无关
+class ShardFunction
+{
+public:
+    virtual ~ShardFunction() = default;
+
+    virtual size_t numShards() const = 0;
+    virtual uint32_t shardOf(const std::string &key) const = 0;
+    // 写入清单的描述，导入方可据此核对与集群的分片方式一致
+    virtual json describe() const = 0;
+};
+
+// Codis 风格的 slot：slot = CRC32(hashKey) % numSlots，再查 slot -> 分片表。
+// hashKey 为 key 中第一个 '{' 与其后第一个 '}' 之间的部分（hash tag，与 Codis 相同，可以为空），没有时为整个 key
+class SlotShardFunction : public ShardFunction
+{
+public:
+    // slot 数上限（Codis 为 1024，Redis Cluster 为 16384），防止错误的参数或 slot 表申请巨大的表与分片数组
+    static constexpr size_t kMaxSlots = 1 << 16;
+
+    // slotMap[slot] 为 slot 所属的分片；groups 非空时 groups[shard] 为分片对应的 Codis group_id，写入描述
+    explicit SlotShardFunction(std::vector<uint32_t> slotMap, std::vector<uint32_t> groups = {});
+    // numSlots 个 slot 按连续区间均匀分给 numShards 个分片（Codis 初始分配方式），两者相等时 slot 即分片
+    SlotShardFunction(size_t numSlots, size_t numShards);
+
+    size_t numShards() const override { return numShards_; }
+    size_t numSlots() const { return slotMap_.size(); }
+    uint32_t slotOf(const std::string &key) const;
+    uint32_t shardOf(const std::string &key) const override { return slotMap_[slotOf(key)]; }
+    json describe() const override;
+
+private:
+    std::vector<uint32_t> slotMap_;
+    std::vector<uint32_t> groups_;
+    size_t numShards_ = 0;
+};
+
+// crc32:<slots>[:<shards>]：slot 均匀分给分片，省略 shards 时每个 slot 一个分片；
+// slotmap:<file.json>：slot -> 分片表，文件为分片号数组（下标即 slot，分片号小于 slot 数），
+// 或 Codis 的 slot 列表 [{"id": slot, "group_id": group}, ...]：group_id 0 表示未分配，视为错误；
+// 出现的 group_id 按从小到大映射为连续的分片号 0..n-1。slot 数不超过 SlotShardFunction::kMaxSlots
+Result makeShardFunction(const std::string &spec, std::shared_ptr<const ShardFunction> &function);
+
+#endif // SHARD_FUNCTION_H
@@ -0,0 +1,43 @@
+#ifndef SORT_DEDUP_H
+#define SORT_DEDUP_H
+
+#include <cstddef>
+#include <string>
+#include "utils/kvEntry.h"
+
+// 排序 + 去重的策略。三种策略的结果完全相同：按 ComparePair 排序，同一 key 只保留 ComparePair 意义下最新的一条
+//   - kSort：整体 std::sort 后线性去重
+//   - kMergeRuns：输入由少量升序段组成（如 DataGen 的输出、合并的多个已排序输入）时，只归并这些段；只有一段时不排序
+//   - kHash：开放寻址哈希表先为每个 key 选出最新的一条，只对留下的条目排序，适合重复多且无序的输入
+// kAuto 由 chooseDedupStrategy 按抽样统计选择
+enum class DedupStrategy
+{
+    kAuto,
+    kSort,
+    kMergeRuns,
+    kHash,
+};
+
+const char *dedupStrategyName(DedupStrategy strategy);
+// auto / sort / runs / hash
+bool parseDedupStrategy(const std::string &name, DedupStrategy &strategy);
+
+// 按 ComparePair 的升序段数，超过 maxRuns 后停止计数并返回 maxRuns + 1
+size_t countSortedRuns(const DataType &data, size_t maxRuns);
+
+// 按 key 哈希抽样（同一 key 的所有副本同时被抽中或不被抽中）估计重复条目的占比
+double sampleDuplicateRatio(const DataType &data);
+
+// 升序段不超过 max(kMaxMergeRuns, sqrt(n)) 时归并；否则重复率不低于 kHashDedupMinDuplicates 时哈希去重；其余整体排序
+constexpr size_t kMaxMergeRuns = 64;
+constexpr double kHashDedupMinDuplicates = 0.2;
+DedupStrategy chooseDedupStrategy(const DataType &data);
+
+// 按升序段归并排序，结果与 std::sort(ComparePair) 相同
+void mergeRuns(DataType &data);
+
+// 同一 key 只保留 ComparePair 意义下最新的一条，留下的条目保持原有相对顺序（不排序）。
+// removed 非空时被淘汰的条目移入其中。返回淘汰的条数
+size_t hashDedup(DataType &data, DataType *removed = nullptr);
+
+#endif // SORT_DEDUP_H
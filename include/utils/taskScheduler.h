@@ -0,0 +1,107 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "utils/result.h"
+
+class TaskGroup;
+
+// 工作窃取调度器：每个 worker 持有自己的双端队列，
+// 自己从队尾取（LIFO，缓存友好），空闲时从其他 worker 的队首窃取（FIFO）。
+// 可选 CPU 绑核；开启 NUMA 感知时优先窃取同一 NUMA 节点上的 worker。
+class TaskScheduler
+{
+public:
+    using TaskFunc = std::function<Result()>;
+
+    explicit TaskScheduler(size_t numThreads, bool pinThreads = false, bool numaAware = false);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler &) = delete;
+    TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+    size_t size() const { return workers_.size(); }
+
+    // 当前线程若是本调度器的 worker，返回其下标，否则返回 -1
+    int currentWorker() const;
+
+    // 读取 /sys/devices/system/node 得到 cpu -> NUMA 节点映射，读取失败时全部视为节点 0
+    static std::vector<int> cpuNumaNodes();
+
+private:
+    friend class TaskGroup;
+
+    struct Task
+    {
+        TaskFunc func;
+        TaskGroup *group = nullptr;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::vector<size_t> victims; // 窃取顺序（NUMA 感知时同节点在前）
+        int cpu = -1;
+        int node = 0;
+        std::thread thread;
+    };
+
+    void submit(Task task);
+    bool popLocal(size_t index, Task &task);
+    bool steal(size_t thief, Task &task);
+    // 尝试取出并执行一个任务（worker 或 wait() 中的协助线程都会调用）
+    bool runOne(int self);
+    void execute(Task &task);
+    void workerLoop(size_t index);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> queued_{0};
+    std::atomic<size_t> nextWorker_{0};
+    std::atomic<bool> stop_{false};
+    std::mutex idleMutex_;
+    std::condition_variable idleCv_;
+};
+
+// 任务组：提交一批相关任务，支持 wait() 汇合与 cancel() 取消。
+// wait() 在等待期间会协助执行队列中的任务，因此可以在 worker 内部嵌套使用。
+class TaskGroup
+{
+public:
+    explicit TaskGroup(TaskScheduler &scheduler) : scheduler_(scheduler) {}
+    ~TaskGroup() { wait(); }
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    void run(TaskScheduler::TaskFunc func);
+
+    // 等待组内全部任务结束，返回第一个失败任务的 Result（全部成功返回 kOk）
+    Result wait();
+
+    // 取消尚未开始执行的任务，已在执行的任务可通过 isCancelled() 自行检查
+    void cancel() { cancelled_.store(true, std::memory_order_release); }
+    bool isCancelled() const { return cancelled_.load(std::memory_order_acquire); }
+
+private:
+    friend class TaskScheduler;
+
+    void finish(const Result &res);
+
+    TaskScheduler &scheduler_;
+    std::atomic<size_t> pending_{0};
+    std::atomic<bool> cancelled_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    Result firstError_{Result::Ret::kOk};
+    bool hasError_ = false;
+};
+
+#endif // TASK_SCHEDULER_H
@@ -0,0 +1,115 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "utils/result.h"
+
+// 区间追踪：每个线程把 span 记录到自己的缓冲区，结束时导出为 Chrome trace-event JSON
+// （chrome://tracing 或 Perfetto 打开）。编译时未定义 BINGEST_TRACE 时 TRACE_SPAN 宏为空。
+class Tracer
+{
+public:
+    struct Event
+    {
+        const char *name = nullptr; // 必须是字符串字面量
+        std::string detail;         // 可选参数（如文件名），导出到 args.detail
+        uint64_t startUs = 0;
+        uint64_t durUs = 0;
+    };
+
+    static Tracer &instance();
+
+    // TRACE_SPAN 宏是否被编译进来（BINGEST_TRACE）
+    static constexpr bool compiledIn()
+    {
+#ifdef BINGEST_TRACE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // 运行期开关：关闭时 ScopedSpan 不读时钟也不记录
+    void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    void record(Event &&event);
+    uint64_t nowUs() const;
+
+    // 导出所有线程已记录的 span
+    Result dumpChromeTrace(const std::string &path) const;
+    size_t eventCount() const;
+    void clear();
+
+private:
+    struct ThreadBuffer
+    {
+        int tid = 0;
+        std::string threadName;
+        mutable std::mutex mutex; // 只有导出时与所属线程竞争
+        std::vector<Event> events;
+    };
+
+    Tracer();
+    ThreadBuffer &localBuffer();
+
+    std::atomic<bool> enabled_{false};
+    std::chrono::steady_clock::time_point origin_;
+    mutable std::mutex buffersMutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+};
+
+class ScopedSpan
+{
+public:
+    explicit ScopedSpan(const char *name, std::string detail = "")
+    {
+        Tracer &tracer = Tracer::instance();
+        if (tracer.enabled())
+        {
+            active_ = true;
+            event_.name = name;
+            event_.detail = std::move(detail);
+            event_.startUs = tracer.nowUs();
+        }
+    }
+    ~ScopedSpan()
+    {
+        if (active_)
+        {
+            Tracer &tracer = Tracer::instance();
+            event_.durUs = tracer.nowUs() - event_.startUs;
+            tracer.record(std::move(event_));
+        }
+    }
+
+    ScopedSpan(const ScopedSpan &) = delete;
+    ScopedSpan &operator=(const ScopedSpan &) = delete;
+
+private:
+    bool active_ = false;
+    Tracer::Event event_;
+};
+
+#ifdef BINGEST_TRACE
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) ScopedSpan TRACE_CONCAT(traceSpan_, __LINE__)(name)
+#define TRACE_SPAN_ARG(name, detail) ScopedSpan TRACE_CONCAT(traceSpan_, __LINE__)(name, detail)
+#else
+#define TRACE_SPAN(name) \
+    do                   \
+    {                    \
+    } while (0)
+#define TRACE_SPAN_ARG(name, detail) \
+    do                               \
+    {                                \
+    } while (0)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,107 @@
+#ifndef VALUE_ENCODER_H
+#define VALUE_ENCODER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "utils/kvEntry.h"
+#include "utils/result.h"
+
+// 把 KvEntry 编码为写入 SST 的 value。exchange、mock -f sst、sstcheck 与抽样校验共用同一个实例，
+// 保证写入与校验两侧的编码一致。实现必须是无状态或只读的，可在多个转换任务中并发调用。
+class ValueEncoder
+{
+public:
+    virtual ~ValueEncoder() = default;
+
+    virtual const char *name() const = 0;
+
+    // 追加到 out（不清空），便于调用方复用缓冲区
+    virtual void encode(const KvEntry &entry, std::string &out) const = 0;
+
+    std::string encode(const KvEntry &entry) const
+    {
+        std::string out;
+        encode(entry, out);
+        return out;
+    }
+
+    // 从编码后的 value 取回过期时间（秒，0 表示不过期）；value 不符合该格式时返回 false
+    virtual bool decodeExpire(const char *data, size_t size, uint32_t &expire) const = 0;
+
+    // 已写入的 value 是否是 entry 的编码结果；默认逐字节比较
+    virtual bool matches(const KvEntry &entry, const char *data, size_t size) const
+    {
+        std::string encoded = encode(entry);
+        return encoded.size() == size && encoded.compare(0, size, data, size) == 0;
+    }
+};
+
+// 原样写入 value，不携带过期时间
+class RawValueEncoder : public ValueEncoder
+{
+public:
+    const char *name() const override { return "raw"; }
+    using ValueEncoder::encode;
+    void encode(const KvEntry &entry, std::string &out) const override;
+    bool decodeExpire(const char *data, size_t size, uint32_t &expire) const override;
+};
+
+// value | expire（fixed32 小端）：DBWithTTL 风格的后缀，也是 Pika 3.x blackwidow 的 string 格式。
+// 与 KvEntry::encodedValue 一致，是默认编码
+class TtlSuffixValueEncoder : public ValueEncoder
+{
+public:
+    const char *name() const override { return "ttl"; }
+    using ValueEncoder::encode;
+    void encode(const KvEntry &entry, std::string &out) const override;
+    bool decodeExpire(const char *data, size_t size, uint32_t &expire) const override;
+};
+
+// Pika 4.x storage 的 string value：
+// | type (1B, kStrings = 0) | value | reserve (16B) | ctime (fixed64) | etime (fixed64) |
+// ctime / etime 为毫秒时间戳，etime 为 0 表示不过期。ctime 取构造时刻，同一次转换内所有条目相同，
+// 因此同一个实例的编码结果是确定的，抽样校验可以重算。
+class PikaStringValueEncoder : public ValueEncoder
+{
+public:
+    static constexpr uint8_t kStringsType = 0;
+    static constexpr size_t kReserveLength = 16;
+    static constexpr size_t kSuffixLength = kReserveLength + 2 * sizeof(uint64_t);
+
+    PikaStringValueEncoder();
+    explicit PikaStringValueEncoder(uint64_t ctimeMs) : ctimeMs_(ctimeMs) {}
+
+    const char *name() const override { return "pika"; }
+    using ValueEncoder::encode;
+    void encode(const KvEntry &entry, std::string &out) const override;
+    bool decodeExpire(const char *data, size_t size, uint32_t &expire) const override;
+
+    // 忽略 ctime：校验工具与写入方不是同一个实例时 ctime 不同
+    bool matches(const KvEntry &entry, const char *data, size_t size) const override;
+
+    uint64_t ctimeMs() const { return ctimeMs_; }
+
+private:
+    uint64_t ctimeMs_;
+};
+
+// 按名字创建编码器：raw / ttl / pika
+Result makeValueEncoder(const std::string &name, std::shared_ptr<const ValueEncoder> &encoder);
+
+// 默认编码器（ttl），未显式设置编码器的组件都使用它
+const std::shared_ptr<const ValueEncoder> &defaultValueEncoder();
+
+// 当前 unix 时间（秒），作为一次转换的过期判断基准
+uint32_t unixNowSeconds();
+
+// expire 非 0 且不晚于 now 的条目已过期
+inline bool isExpired(const KvEntry &entry, uint32_t now)
+{
+    return entry.timestamp != 0 && entry.timestamp <= now;
+}
+
+// 原地删除已过期的条目并保持相对顺序，返回删除条数。removed 非空时删除位置上的条目移入其中（供回收复用）
+size_t dropExpired(DataType &data, uint32_t now, DataType *removed = nullptr);
+
+#endif // VALUE_ENCODER_H
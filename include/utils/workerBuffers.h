@@ -0,0 +1,96 @@
+#ifndef WORKER_BUFFERS_H
+#define WORKER_BUFFERS_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "utils/kvEntry.h"
+#include "utils/memoryBudget.h"
+
+// 每个线程一份、跨文件复用的缓冲区。处理完一个文件后把条目与缓冲区还回来而不是释放：
+//   - 文件缓冲区：读入的文件内容与解压结果，容量保留到下一个文件
+//   - 条目回收池：还回来的 KvEntry 保留字符串容量，takeEntry 取出后逐字段 assign，不再申请内存
+//   - vector 回收池：DataType 本身的容量同样复用
+// 保留的容量按字节计：单个缓冲区、条目池与每个线程保留的总量各有上限，超过时在回收时从大到小释放，
+// 避免处理过一个超大文件后长期占用。设置了内存预算时，每个线程保留的字节数经 MemoryBudget::retain 计入预算。
+// 线程在 TaskGroup::wait 中可能执行另一个文件的任务，因此文件缓冲区按次借出（FileBufferLease），嵌套时各用各的。
+// 统计按文件汇总到 bingest_worker_* 指标
+class WorkerBuffers
+{
+public:
+    struct FileBuffer
+    {
+        std::string input; // 读入的文件内容
+        std::string plain; // 解压后的文件内容
+    };
+
+    static constexpr size_t kMaxRetainedBufferBytes = 256 << 20; // 单个文件缓冲区 / vector 保留的容量上限
+    static constexpr size_t kMaxSpareBytes = 64 << 20;           // 条目回收池保留的字节上限（含字符串容量）
+    static constexpr size_t kMaxRetainedBytes = 512 << 20;       // 每个线程保留的字节总量上限
+    static constexpr size_t kMaxSpareVectors = 4;
+    static constexpr size_t kMaxSpareFileBuffers = 2;
+
+    // 当前线程的缓冲区
+    static WorkerBuffers &local();
+
+    // 容量不小于 2MB 的缓冲区增长后以 madvise(MADV_HUGEPAGE) 请求透明大页，默认关闭，进程内全局生效
+    static void setHugePages(bool enable);
+    static bool getHugePages();
+
+    // 各线程保留的字节数计入 budget（nullptr 取消），在下一次回收时生效，进程内全局生效
+    static void setMemoryBudget(const std::shared_ptr<MemoryBudget> &budget);
+
+    // 当前保留的字节数：文件缓冲区与 vector 的容量、条目池中条目及其字符串的容量
+    size_t retainedBytes() const;
+
+    // 在 buffer 被填充前后调用：统计复用 / 增长次数，增长且开启大页时对新的缓冲区请求大页
+    void noteFill(std::string &buffer, size_t capacityBefore);
+
+    // 取一个空的 KvEntry，回收池有条目时复用其字符串容量
+    KvEntry takeEntry();
+    // 取一个空的 DataType，复用回收的 vector 容量
+    DataType takeVector();
+
+    // 把 data 的全部条目与 data 本身的容量还回来，data 变为空
+    void recycle(DataType &data);
+    // 只还回 data 的容量（条目已被移走时使用），data 变为空
+    void recycleVector(DataType &data);
+    // 回收池：dedupSorted / dropExpired 移出的条目可直接放入
+    DataType &spare() { return spare_; }
+
+private:
+    friend class FileBufferLease;
+    WorkerBuffers() = default;
+    void trim();
+    void flushStats();
+    void updateReservation();
+
+    DataType spare_;
+    size_t spareBytes_ = 0; // spare_ 占用的字节数，trim 时重新统计
+    std::vector<DataType> vectors_;
+    std::vector<std::unique_ptr<FileBuffer>> fileBuffers_;
+    size_t entriesReused_ = 0;
+    size_t entriesAllocated_ = 0;
+    std::shared_ptr<MemoryBudget> budget_; // 先于 reservation_ 声明，析构时预留先归还
+    MemoryReservation reservation_;
+};
+
+// 从当前线程借出一个文件缓冲区，析构时归还
+class FileBufferLease
+{
+public:
+    FileBufferLease();
+    ~FileBufferLease();
+
+    FileBufferLease(const FileBufferLease &) = delete;
+    FileBufferLease &operator=(const FileBufferLease &) = delete;
+
+    WorkerBuffers::FileBuffer &operator*() { return *buffer_; }
+    WorkerBuffers::FileBuffer *operator->() { return buffer_.get(); }
+
+private:
+    WorkerBuffers &owner_;
+    std::unique_ptr<WorkerBuffers::FileBuffer> buffer_;
+};
+
+#endif // WORKER_BUFFERS_H
@@ -3,9 +3,10 @@
 # 默认参数值
 DEFAULT_SIZE="10M"
 DEFAULT_DICT="kvdict"
+DEFAULT_FORMAT="json"
 
 # 解析命令行参数
-while getopts ":n:d:" opt; do
+while getopts ":n:d:f:" opt; do
   case $opt in
     n)
       size="$OPTARG"
@@ -13,6 +14,9 @@ while getopts ":n:d:" opt; do
     d)
       dict="$OPTARG"
       ;;
+    f)
+      format="$OPTARG"
+      ;;
     \?)
       echo "无效选项: -$OPTARG" >&2
       exit 1
@@ -27,8 +31,9 @@ done
 # 使用默认值（如果用户未输入）
 size=${size:-$DEFAULT_SIZE}
 dict=${dict:-$DEFAULT_DICT}
+format=${format:-$DEFAULT_FORMAT}
 
 # 执行构建和运行命令
 ./build.sh
 cd build
-./mock -n "$size" -d "$dict"
\ No newline at end of file
+./mock -n "$size" -d "$dict" -f "$format"
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "exchange/crossFileDedup.h"
+#include "exchange/JsonFileManager.h"
+#include "utils/compare.h"
+#include "utils/compression.h"
+#include "utils/klog.h"
+#include "utils/metrics.h"
+#include "utils/trace.h"
+#include <algorithm>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+Result CrossFileDedup::build(JsonFileManagerBase *fileManager, const std::vector<std::string> &inputs, TaskScheduler &scheduler)
+{
+    static MetricsHistogram &buildLatency = metricsHistogram("bingest_dedup_prepass_ns", "cross-file dedup pre-pass latency (both scans)");
+    ScopedLatency timer(buildLatency);
+    TRACE_SPAN("dedupPrepass");
+
+    uintmax_t totalBytes = 0;
+    inputIndex_.clear();
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        std::error_code ec;
+        uintmax_t size = fs::file_size(DEFAULTDIC / inputs[i], ec);
+        // 压缩输入按解压后约 kCompressionRatioEstimate 倍估算
+        if (!ec && codecFromPath(inputs[i]) != Codec::kNone)
+            size *= kCompressionRatioEstimate;
+        totalBytes += ec ? 0 : size;
+        inputIndex_.emplace(inputs[i], static_cast<uint32_t>(i));
+    }
+    size_t expectedKeys = std::max<size_t>(1024, totalBytes / kBytesPerEntryEstimate);
+    seen_ = std::make_unique<BlockedBloomFilter>(expectedKeys, bitsPerKey_);
+    dup_ = std::make_unique<BlockedBloomFilter>(expectedKeys, bitsPerKey_);
+    partitions_.clear();
+    for (size_t p = 0; p < kNumPartitions; ++p)
+        partitions_.push_back(std::make_unique<Partition>());
+
+    auto parse = [fileManager](const std::string &input, DataType &data)
+    {
+        try
+        {
+            data = fileManager->parse((DEFAULTDIC / input).string());
+        }
+        catch (const std::exception &e)
+        {
+            return Result(Result::Ret::kFileReadError, "JSON parse failed: " + input + ": " + e.what());
+        }
+        return Result(Result::Ret::kOk);
+    };
+
+    // 第一遍：标记至少出现两次的 key
+    {
+        TRACE_SPAN("dedupMark");
+        TaskGroup group(scheduler);
+        for (const auto &input : inputs)
+        {
+            group.run([this, &parse, input]
+                      {
+                          DataType data;
+                          Result res = parse(input, data);
+                          if (res.isError())
+                              return res;
+                          for (const auto &entry : data)
+                          {
+                              Hash128 hash = murmurHash128(entry.key);
+                              if (seen_->insert(hash))
+                                  dup_->insert(hash);
+                          }
+                          return Result(Result::Ret::kOk); });
+        }
+        Result res = group.wait();
+        if (res.isError())
+            return res;
+    }
+
+    // 第二遍：只为可能重复的 key 精确选出最新的一条（ComparePair 意义下排在最前），相同条目取编号小的输入
+    {
+        TRACE_SPAN("dedupResolve");
+        TaskGroup group(scheduler);
+        for (const auto &input : inputs)
+        {
+            uint32_t index = inputIndex_[input];
+            group.run([this, &parse, input, index]
+                      {
+                          DataType data;
+                          Result res = parse(input, data);
+                          if (res.isError())
+                              return res;
+                          ComparePair newer;
+                          for (auto &entry : data)
+                          {
+                              Hash128 hash = murmurHash128(entry.key);
+                              if (!dup_->mayContain(hash))
+                                  continue;
+                              Partition &partition = *partitions_[hash.hi % kNumPartitions];
+                              std::lock_guard<std::mutex> lock(partition.mutex);
+                              auto it = partition.winners.find(entry.key);
+                              if (it == partition.winners.end())
+                              {
+                                  std::string key = entry.key;
+                                  partition.winners.emplace(std::move(key), Winner{std::move(entry), index, false});
+                                  continue;
+                              }
+                              Winner &winner = it->second;
+                              winner.multiInput = winner.multiInput || winner.input != index;
+                              bool replace = newer(entry, winner.entry) || (!newer(winner.entry, entry) && index < winner.input);
+                              if (replace)
+                              {
+                                  winner.entry = std::move(entry);
+                                  winner.input = index;
+                              }
+                          }
+                          return Result(Result::Ret::kOk); });
+        }
+        Result res = group.wait();
+        if (res.isError())
+            return res;
+    }
+
+    numCandidates_ = 0;
+    numDuplicateKeys_ = 0;
+    for (auto &partition : partitions_)
+    {
+        numCandidates_ += partition->winners.size();
+        // 只在一个输入中出现的候选（误判或同一文件内重复）无需处理，删除以加快 keep() 并释放内存
+        for (auto it = partition->winners.begin(); it != partition->winners.end();)
+        {
+            if (it->second.multiInput)
+            {
+                ++numDuplicateKeys_;
+                ++it;
+            }
+            else
+            {
+                it = partition->winners.erase(it);
+            }
+        }
+    }
+    LOG_INFO("Cross-file dedup pre-pass: " + std::to_string(numCandidates_) + " probable duplicate keys, " +
+             std::to_string(numDuplicateKeys_) + " in multiple files, filters " + std::to_string(filterBytes() >> 10) + " KB");
+    return Result(Result::Ret::kOk, std::to_string(numDuplicateKeys_) + " keys duplicated across files");
+}
+
+bool CrossFileDedup::keep(const std::string &input, const KvEntry &entry) const
+{
+    if (!dup_)
+        return true;
+    Hash128 hash = murmurHash128(entry.key);
+    if (!dup_->mayContain(hash))
+        return true;
+    const Partition &partition = *partitions_[hash.hi % kNumPartitions];
+    auto it = partition.winners.find(entry.key);
+    if (it == partition.winners.end())
+        return true;
+    auto index = inputIndex_.find(input);
+    return index == inputIndex_.end() || index->second == it->second.input;
+}
+
+size_t CrossFileDedup::filter(const std::string &input, DataType &data) const
+{
+    auto end = std::remove_if(data.begin(), data.end(), [&](const KvEntry &entry)
+                              { return !keep(input, entry); });
+    size_t dropped = static_cast<size_t>(data.end() - end);
+    data.erase(end, data.end());
+    return dropped;
+}
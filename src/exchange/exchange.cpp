@@ -1,21 +1,118 @@
+#include <algorithm>
+#include <atomic>
+#include <csignal>
 #include <iostream>
 #include <string>
 #include <unistd.h>
+#include <filesystem>
 #include "exchange/sstProcessor.h"
+#include "exchange/ingestor.h"
 #include "exchange/JsonFileManager.h"
+#include "exchange/workJournal.h"
+#include "utils/argParse.h"
+#include "utils/metrics.h"
+#include "utils/trace.h"
+#include "utils/workerBuffers.h"
+
+static std::atomic<bool> g_stop{false};
+
+// -w 的空闲秒数上限（一天），更长的监视用 -w 0 运行到 Ctrl-C
+static constexpr size_t kMaxWatchIdleSeconds = 86400;
+// -D 的每个 key 位数范围：低于 1 位几乎全部误判，高于 64 位只是浪费内存
+static constexpr double kMinDedupBitsPerKey = 1;
+static constexpr double kMaxDedupBitsPerKey = 64;
+
+static void handleStopSignal(int)
+{
+    g_stop.store(true);
+}
+
+// 为输出目录（分片输出时为每个分片目录）写 ingest_plan.json
+static Result writeIngestPlans(const std::filesystem::path &sstDir, bool sharded, const rocksdb::Options &options)
+{
+    std::vector<std::filesystem::path> dirs;
+    if (sharded)
+    {
+        for (const auto &entry : std::filesystem::directory_iterator(sstDir))
+        {
+            if (entry.is_directory() && entry.path().filename().string().rfind("shard_", 0) == 0)
+                dirs.push_back(entry.path());
+        }
+        std::sort(dirs.begin(), dirs.end());
+    }
+    else
+    {
+        dirs.push_back(sstDir);
+    }
+    for (const auto &dir : dirs)
+    {
+        // ingest 方下载到本地后再导入，下载的副本可以直接交给 RocksDB
+        IngestPlanner planner(options);
+        planner.setMoveFiles(true);
+        Result res = planner.addDirectory(dir.string());
+        IngestPlan plan;
+        if (!res.isError())
+            res = planner.plan(plan);
+        std::string path = (dir / "ingest_plan.json").string();
+        if (!res.isError())
+            res = writeIngestPlan(plan, path);
+        if (res.isError())
+            return res;
+        std::cout << "Ingest plan: " << plan.numFiles() << " files in " << plan.batches.size() << " calls -> " << path << std::endl;
+    }
+    return Result(Result::Ret::kOk);
+}
 
 void print_usage(const char *prog)
 {
-    std::cout << "Usage: " << prog << " -k <kvPath> -s <sst_path>\n";
+    std::cout << "Usage: " << prog << " -k <kvPath> -s <sst_path> [-m <metrics_prefix>] [-t <trace.json>] [-v <samples>] [-r] [-w <idle_seconds>] [-y none|file|batch[:N]] [-b <bytes>|auto] [-e <entries>] [-E raw|ttl|pika] [-K] [-L flat|pika] [-D <bits_per_key>] [-I posix|uring|auto] [-B <bytes>|auto] [-H] [-d auto|sort|runs|hash] [-S crc32:<slots>[:<shards>]|slotmap:<file.json>] [-P]\n"
+              << "  -k/-s 也可以是目录：转换目录下所有 *.json 到对应的 .sst\n"
+              << "  -m 周期导出指标到 <metrics_prefix>.json 与 <metrics_prefix>.prom\n"
+              << "  -t 导出 Chrome trace 到 <trace.json>（需以 -DBINGEST_TRACE=ON 编译）\n"
+              << "  -v 抽样往返校验：比对源数据与 SST 的摘要，并随机点查 <samples> 条\n"
+              << "  -r 目录模式下可续跑：用 <sst_path>/.bingest_journal.json 记录每个文件的状态，重跑时跳过已完成且未变化的文件\n"
+              << "  -w 监视 -k 目录：文件写完即转换，<idle_seconds> 秒（最多 86400）内没有新文件时退出（0 表示直到 Ctrl-C）\n"
+              << "  -y 输出落盘策略：none 只 rename（默认），file 每个文件 fsync，batch[:N] 每 N 个文件 syncfs 一次（默认 64）\n"
+              << "  -b 按大小切分输出 SST（如 64M，auto 取 target_file_size_base），目录模式下合并相邻的小输入\n"
+              << "  -e 每个输出 SST 最多 <entries> 条\n"
+              << "  -E value 编码：raw 原样，ttl 追加 4 字节 expire（默认），pika 为 Pika 4.x string 格式\n"
+              << "  -K 保留转换时已过期的条目（默认丢弃）\n"
+              << "  -L 输出布局：flat 每个输入一个 SST（默认，只支持 string），pika 按 Pika 4.x 存储布局输出 meta 与各 data CF 的 SST\n"
+              << "  -D 目录模式下先做跨文件去重预处理（bloom filter 每个 key <bits_per_key> 位，1 到 64，如 12；不能与 -w 同用），同一 key 只保留最新的一条\n"
+              << "  -I 读取输入的 I/O 后端：posix（默认）、uring（io_uring，批量提交并预读后续输入）或 auto\n"
+              << "  -B 目录模式下并发转换的内存预算（如 16G，auto 取物理内存与 cgroup 上限中较小者的 3/4），预算用尽时等待已提交的任务结束\n"
+              << "  -H 对复用的大块读入缓冲区请求透明大页（madvise MADV_HUGEPAGE）\n"
+              << "  -d 排序去重策略：auto（默认，按升序段数与抽样重复率选择）、sort 整体排序、runs 只归并已排序的段、hash 先哈希去重再排序\n"
+              << "  -S 按分片输出：crc32:<slots>[:<shards>] 为 CRC32(key) % slots 并把 slot 均匀分给各分片，slotmap:<file.json> 为 Codis 风格的 slot 表；\n"
+              << "     每个分片写到 <sst_path>/shard_NNNN/，附带清单，各节点只导入自己的分片\n"
+              << "  -P 目录模式下转换完成后写 ingest 规划 <sst_path>/ingest_plan.json：把输出分成尽量少的、组内 key 范围不重叠的 IngestExternalFile 调用\n";
 }
 
 int main(int argc, char **argv)
 {
     std::string kvPath;
     std::string sstPath;
+    std::string metricsPrefix;
+    std::string tracePath;
+    size_t validateSamples = 0;
+    bool resume = false;
+    long watchIdleSeconds = -1;
+    SyncPolicy syncPolicy = SyncPolicy::kNone;
+    size_t syncBatchSize = 64;
+    std::string targetFileSize;
+    size_t targetFileEntries = 0;
+    std::string valueEncoding = "ttl";
+    bool keepExpired = false;
+    std::string layout = "flat";
+    double crossFileDedupBits = 0;
+    std::string ioBackend = "posix";
+    std::string memoryBudget;
+    std::string dedupStrategy = "auto";
+    std::string shardSpec;
+    bool ingestPlan = false;
 
     int opt;
-    while ((opt = getopt(argc, argv, "k:s:")) != -1)
+    while ((opt = getopt(argc, argv, "k:s:m:t:v:rw:y:b:e:E:KL:D:I:B:Hd:S:P")) != -1)
     {
         switch (opt)
         {
@@ -25,6 +122,91 @@ int main(int argc, char **argv)
         case 's':
             sstPath = optarg;
             break;
+        case 'm':
+            metricsPrefix = optarg;
+            break;
+        case 't':
+            tracePath = optarg;
+            break;
+        case 'v':
+            if (!parseCount(optarg, validateSamples))
+            {
+                std::cerr << "Error: invalid sample count for -v: " << optarg << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'r':
+            resume = true;
+            break;
+        case 'w':
+        {
+            size_t seconds = 0;
+            if (!parseCount(optarg, seconds) || seconds > kMaxWatchIdleSeconds)
+            {
+                std::cerr << "Error: invalid idle seconds for -w (0 to " << kMaxWatchIdleSeconds << "): " << optarg << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+            watchIdleSeconds = static_cast<long>(seconds);
+            break;
+        }
+        case 'y':
+        {
+            Result syncRes = parseSyncPolicy(optarg, syncPolicy, syncBatchSize);
+            if (syncRes.isError())
+            {
+                std::cerr << "Error: " << syncRes.message() << std::endl;
+                return 1;
+            }
+            break;
+        }
+        case 'b':
+            targetFileSize = optarg;
+            break;
+        case 'e':
+            if (!parseCount(optarg, targetFileEntries))
+            {
+                std::cerr << "Error: invalid entry count for -e: " << optarg << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'E':
+            valueEncoding = optarg;
+            break;
+        case 'K':
+            keepExpired = true;
+            break;
+        case 'L':
+            layout = optarg;
+            break;
+        case 'D':
+            if (!parseNumber(optarg, crossFileDedupBits) || crossFileDedupBits < kMinDedupBitsPerKey || crossFileDedupBits > kMaxDedupBitsPerKey)
+            {
+                std::cerr << "Error: invalid bits per key for -D (" << kMinDedupBitsPerKey << " to " << kMaxDedupBitsPerKey << "): " << optarg << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'I':
+            ioBackend = optarg;
+            break;
+        case 'B':
+            memoryBudget = optarg;
+            break;
+        case 'H':
+            WorkerBuffers::setHugePages(true);
+            break;
+        case 'd':
+            dedupStrategy = optarg;
+            break;
+        case 'S':
+            shardSpec = optarg;
+            break;
+        case 'P':
+            ingestPlan = true;
+            break;
         default:
             print_usage(argv[0]);
             return 1;
@@ -40,17 +222,165 @@ int main(int argc, char **argv)
     // 打印参数
     std::cout << "Read JSON file: " << kvPath << " to SST: " << sstPath << std::endl;
 
+    std::unique_ptr<MetricsExporter> exporter;
+    if (!metricsPrefix.empty())
+    {
+        exporter = std::make_unique<MetricsExporter>(metricsPrefix + ".json", metricsPrefix + ".prom", std::chrono::seconds(1));
+    }
+
+    if (!tracePath.empty())
+    {
+        if (!Tracer::compiledIn())
+            std::cerr << "Warning: tracing is compiled out, rebuild with -DBINGEST_TRACE=ON" << std::endl;
+        Tracer::instance().setEnabled(true);
+    }
+
     // 创建 JsonFileManager
     JsonFileManager fileManager;
+    std::shared_ptr<IoBackend> backend;
+    Result backendRes = makeIoBackend(ioBackend, backend);
+    if (backendRes.isError())
+    {
+        std::cerr << "Error: " << backendRes.message() << std::endl;
+        return 1;
+    }
+    fileManager.setIoBackend(backend);
 
     // 创建 SstProcessor
     rocksdb::Options options;
     options.create_if_missing = true;
 
     SstProcessor processor(options);
+    processor.setValidateSamples(validateSamples);
+    processor.setPublisher(std::make_shared<FilePublisher>(syncPolicy, syncBatchSize));
+    std::shared_ptr<const ValueEncoder> encoder;
+    Result encoderRes = makeValueEncoder(valueEncoding, encoder);
+    if (encoderRes.isError())
+    {
+        std::cerr << "Error: " << encoderRes.message() << std::endl;
+        return 1;
+    }
+    processor.setValueEncoder(encoder);
+    if (layout == "pika")
+    {
+        processor.setPikaLayout(std::make_shared<PikaLayout>());
+    }
+    else if (layout != "flat")
+    {
+        std::cerr << "Error: layout must be flat or pika: " << layout << std::endl;
+        return 1;
+    }
+    processor.setDropExpired(!keepExpired);
+    processor.setTargetFileEntries(targetFileEntries);
+    processor.setCrossFileDedup(crossFileDedupBits);
+    DedupStrategy strategy = DedupStrategy::kAuto;
+    if (!parseDedupStrategy(dedupStrategy, strategy))
+    {
+        std::cerr << "Error: dedup strategy must be auto, sort, runs or hash: " << dedupStrategy << std::endl;
+        return 1;
+    }
+    processor.setDedupStrategy(strategy);
+    if (!shardSpec.empty())
+    {
+        std::shared_ptr<const ShardFunction> shardFunction;
+        Result shardRes = makeShardFunction(shardSpec, shardFunction);
+        if (shardRes.isError())
+        {
+            std::cerr << "Error: " << shardRes.message() << std::endl;
+            return 1;
+        }
+        processor.setShardFunction(shardFunction);
+    }
+    if (!targetFileSize.empty())
+    {
+        uint64_t bytes = 0;
+        if (targetFileSize == "auto")
+        {
+            bytes = options.target_file_size_base;
+        }
+        else if (!parseByteSize(targetFileSize, bytes))
+        {
+            std::cerr << "Error: invalid size for -b: " << targetFileSize << std::endl;
+            return 1;
+        }
+        processor.setTargetFileSize(bytes);
+    }
+    if (!memoryBudget.empty())
+    {
+        uint64_t bytes = 0;
+        if (memoryBudget == "auto")
+        {
+            bytes = MemoryBudget::autoCapacity();
+        }
+        else if (!parseByteSize(memoryBudget, bytes) || bytes == 0)
+        {
+            std::cerr << "Error: invalid size for -B: " << memoryBudget << std::endl;
+            return 1;
+        }
+        auto budget = std::make_shared<MemoryBudget>(bytes);
+        processor.setMemoryBudget(budget);
+        WorkerBuffers::setMemoryBudget(budget);
+    }
 
-    // 调用
-    Result result = processor.processSstFile(&fileManager, kvPath, sstPath);
+    // 跨文件去重只在一次性的目录转换中构建：监视模式的输入陆续到达，单文件没有可比较的其他文件
+    if (crossFileDedupBits > 0 && (watchIdleSeconds >= 0 || !std::filesystem::is_directory(DEFAULTDIC / kvPath)))
+    {
+        std::cerr << "Error: -D needs -k to be a directory and cannot be combined with -w" << std::endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // 调用：目录则并发转换全部文件
+    Result result;
+    if (watchIdleSeconds >= 0)
+    {
+        // 允许先启动 exchange 再启动 mock
+        std::filesystem::create_directories(DEFAULTDIC / kvPath);
+    }
+    if (std::filesystem::is_directory(DEFAULTDIC / kvPath))
+    {
+        std::unique_ptr<WorkJournal> journal;
+        if (resume)
+        {
+            journal = std::make_unique<WorkJournal>((DEFAULTDIC / sstPath / ".bingest_journal.json").string());
+            Result journalRes = journal->load();
+            if (journalRes.isError())
+            {
+                std::cerr << "Error: " << journalRes.message() << std::endl;
+                return 1;
+            }
+            processor.setJournal(journal.get());
+        }
+        if (watchIdleSeconds >= 0)
+        {
+            std::signal(SIGINT, handleStopSignal);
+            std::signal(SIGTERM, handleStopSignal);
+            result = processor.watchSstFiles(&fileManager, kvPath, sstPath, g_stop, std::chrono::seconds(watchIdleSeconds));
+        }
+        else
+        {
+            result = processor.mutiProcessSstFile(&fileManager, kvPath, sstPath);
+        }
+    }
+    else
+    {
+        result = processor.processSstFile(&fileManager, kvPath, sstPath);
+    }
+    if (ingestPlan && result.getRet() == Result::Ret::kOk && std::filesystem::is_directory(DEFAULTDIC / sstPath))
+    {
+        Result planRes = writeIngestPlans(DEFAULTDIC / sstPath, processor.getShardFunction() != nullptr, options);
+        if (planRes.isError())
+        {
+            std::cerr << "Error: " << planRes.message() << std::endl;
+            return 1;
+        }
+    }
+    if (!tracePath.empty())
+    {
+        Result traceRes = Tracer::instance().dumpChromeTrace(tracePath);
+        if (traceRes.isError())
+            std::cerr << "Error: " << traceRes.message() << std::endl;
+    }
     if (result.getRet() == Result::Ret::kOk)
     {
         std::cout << "Success: " << result.message() << std::endl;
@@ -0,0 +1,405 @@
+#include "exchange/ingestor.h"
+#include "exchange/multiCfSstWriter.h"
+#include "rocksdb/sst_file_reader.h"
+#include "rocksdb/table_properties.h"
+#include "utils/filePublisher.h"
+#include "utils/metrics.h"
+#include "utils/pikaLayout.h"
+#include "utils/trace.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // 一层中两两不重叠的文件：smallestKey -> largestKey，按 comparator 排序
+    struct KeyLess
+    {
+        const rocksdb::Comparator *comparator;
+        bool operator()(const std::string &a, const std::string &b) const { return comparator->Compare(a, b) < 0; }
+    };
+    using RangeSet = std::map<std::string, std::string, KeyLess>;
+
+    // 区间互不重叠时按 smallestKey 有序也就按 largestKey 有序，只需检查 smallestKey <= largest 的最后一个区间
+    bool overlaps(const RangeSet &ranges, const IngestFile &file)
+    {
+        auto it = ranges.upper_bound(file.largestKey);
+        if (it == ranges.begin())
+            return false;
+        --it;
+        return ranges.key_comp().comparator->Compare(it->second, file.smallestKey) >= 0;
+    }
+
+    // 按导入顺序的输出编号：data_3.manifest.json / data_3.0001.sst -> (3, "data_3")
+    std::pair<size_t, std::string> outputOrder(const std::string &fileName)
+    {
+        std::string stem = fileName.substr(0, fileName.find('.'));
+        size_t number = std::numeric_limits<size_t>::max();
+        if (stem.rfind("data_", 0) == 0 && stem.size() > 5 &&
+            std::all_of(stem.begin() + 5, stem.end(), [](char c)
+                        { return c >= '0' && c <= '9'; }))
+        {
+            number = std::stoull(stem.substr(5));
+        }
+        return {number, stem};
+    }
+}
+
+size_t IngestPlan::numFiles() const
+{
+    size_t total = 0;
+    for (const auto &batch : batches)
+        total += batch.files.size();
+    return total;
+}
+
+json IngestPlan::toJson(const std::string &baseDir) const
+{
+    json list = json::array();
+    size_t l0Files = 0;
+    for (const auto &batch : batches)
+    {
+        json files = json::array();
+        for (size_t i = 0; i < batch.files.size(); ++i)
+        {
+            const IngestFile &file = batch.files[i];
+            files.push_back({{"file", fs::path(file.path).lexically_relative(baseDir).string()},
+                             {"fileSize", file.fileSize},
+                             {"entries", file.entries},
+                             {"smallestKey", toHex(file.smallestKey)},
+                             {"largestKey", toHex(file.largestKey)},
+                             {"expectedLevel", batch.expectedLevels[i]}});
+            if (batch.expectedLevels[i] == 0)
+                ++l0Files;
+        }
+        list.push_back({{"columnFamily", batch.columnFamily},
+                        {"options", {{"moveFiles", batch.options.move_files},
+                                     {"allowGlobalSeqno", batch.options.allow_global_seqno},
+                                     {"writeGlobalSeqno", batch.options.write_global_seqno},
+                                     {"ingestBehind", batch.options.ingest_behind},
+                                     {"allowBlockingFlush", batch.options.allow_blocking_flush},
+                                     {"snapshotConsistency", batch.options.snapshot_consistency}}},
+                        {"files", std::move(files)}});
+    }
+    return json{{"files", numFiles()}, {"calls", batches.size()}, {"l0Files", l0Files}, {"numLevels", numLevels}, {"batches", std::move(list)}};
+}
+
+IngestPlanner::IngestPlanner(const rocksdb::Options &options) : options_(options)
+{
+}
+
+const rocksdb::Comparator *IngestPlanner::comparatorOf(const std::string &columnFamily) const
+{
+    auto it = comparators_.find(columnFamily);
+    if (it != comparators_.end())
+        return it->second;
+    if (columnFamily != rocksdb::kDefaultColumnFamilyName)
+    {
+        for (size_t cf = 0; cf < kPikaCfCount; ++cf)
+        {
+            if (columnFamily == pikaCfName(cf))
+                return pikaCfComparator(cf);
+        }
+    }
+    return options_.comparator;
+}
+
+Result IngestPlanner::addManifest(const std::string &manifestPath)
+{
+    std::ifstream in(manifestPath);
+    if (!in)
+    {
+        return Result(Result::Ret::kFileOpenError, "cannot open manifest " + manifestPath);
+    }
+    fs::path baseDir = fs::path(manifestPath).parent_path();
+    std::vector<IngestFile> files;
+    try
+    {
+        json manifest = json::parse(in);
+        for (const auto &cf : manifest.at("columnFamilies"))
+        {
+            std::string name = cf.at("name").get<std::string>();
+            std::string comparator = cf.at("comparator").get<std::string>();
+            if (comparator != comparatorOf(name)->Name())
+            {
+                return Result(Result::Ret::kInvalidParam, manifestPath + ": column family " + name + " uses comparator " +
+                                                              comparator + ", expected " + comparatorOf(name)->Name());
+            }
+            for (const auto &item : cf.at("files"))
+            {
+                IngestFile file;
+                file.path = (baseDir / item.at("file").get<std::string>()).string();
+                file.columnFamily = name;
+                file.fileSize = item.at("fileSize").get<uint64_t>();
+                file.entries = item.at("entries").get<uint64_t>();
+                if (!fromHex(item.at("smallestKey").get<std::string>(), file.smallestKey) ||
+                    !fromHex(item.at("largestKey").get<std::string>(), file.largestKey))
+                {
+                    return Result(Result::Ret::kInvalidParam, manifestPath + ": invalid key range for " + file.path);
+                }
+                files.push_back(std::move(file));
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        return Result(Result::Ret::kInvalidParam, "invalid manifest " + manifestPath + ": " + e.what());
+    }
+    for (auto &file : files)
+        files_.push_back(std::move(file));
+    return Result(Result::Ret::kOk, manifestPath);
+}
+
+Result IngestPlanner::addSst(const std::string &sstPath, const std::string &columnFamily)
+{
+    rocksdb::Options options = options_;
+    options.comparator = comparatorOf(columnFamily);
+    rocksdb::SstFileReader reader(options);
+    rocksdb::Status status = reader.Open(sstPath);
+    if (!status.ok())
+    {
+        return Result(Result::Ret::kFileOpenError, sstPath + ": " + status.ToString());
+    }
+    IngestFile file;
+    file.path = sstPath;
+    file.columnFamily = columnFamily;
+    std::unique_ptr<rocksdb::Iterator> it(reader.NewIterator(rocksdb::ReadOptions()));
+    it->SeekToFirst();
+    if (!it->Valid())
+    {
+        return Result(Result::Ret::kInvalidParam, sstPath + " has no entries");
+    }
+    file.smallestKey = it->key().ToString();
+    it->SeekToLast();
+    file.largestKey = it->key().ToString();
+    if (auto properties = reader.GetTableProperties())
+        file.entries = properties->num_entries;
+    std::error_code ec;
+    file.fileSize = fs::file_size(sstPath, ec);
+    files_.push_back(std::move(file));
+    return Result(Result::Ret::kOk, sstPath);
+}
+
+Result IngestPlanner::addDirectory(const std::string &dir)
+{
+    // 同一个输出（data_3）有清单时以清单为准，否则加入它的全部 SST
+    std::map<std::pair<size_t, std::string>, std::vector<std::string>> outputs;
+    std::error_code ec;
+    for (const auto &entry : fs::directory_iterator(dir, ec))
+    {
+        std::string name = entry.path().filename().string();
+        if (!entry.is_regular_file() || name.empty() || name[0] == '.')
+            continue;
+        if (entry.path().extension() == ".sst" || (name.size() > 14 && name.compare(name.size() - 14, 14, ".manifest.json") == 0))
+            outputs[outputOrder(name)].push_back(entry.path().string());
+    }
+    if (ec)
+    {
+        return Result(Result::Ret::kFileOpenError, "cannot list " + dir + ": " + ec.message());
+    }
+    for (auto &output : outputs)
+    {
+        std::vector<std::string> &paths = output.second;
+        std::sort(paths.begin(), paths.end());
+        auto manifest = std::find_if(paths.begin(), paths.end(), [](const std::string &path)
+                                     { return fs::path(path).extension() == ".json"; });
+        Result res;
+        if (manifest != paths.end())
+        {
+            res = addManifest(*manifest);
+            if (res.isError())
+                return res;
+            continue;
+        }
+        for (const auto &path : paths)
+        {
+            res = addSst(path);
+            if (res.isError())
+                return res;
+        }
+    }
+    return Result(Result::Ret::kOk, dir);
+}
+
+Result IngestPlanner::plan(IngestPlan &plan) const
+{
+    TRACE_SPAN("ingestPlan");
+    plan = IngestPlan();
+    plan.numLevels = std::max(1, options_.num_levels);
+
+    // 每个 CF 独立分组：文件所在组 = 与它重叠的先导入文件所在组的最大值 + 1，组数即最长的重叠链
+    std::vector<std::string> cfOrder;
+    std::map<std::string, std::vector<std::vector<const IngestFile *>>> groupsByCf;
+    std::map<std::string, std::vector<RangeSet>> rangesByCf;
+    for (const auto &file : files_)
+    {
+        const rocksdb::Comparator *comparator = comparatorOf(file.columnFamily);
+        if (comparator->Compare(file.smallestKey, file.largestKey) > 0)
+        {
+            return Result(Result::Ret::kInvalidParam, file.path + ": smallest key is greater than largest key");
+        }
+        auto &groups = groupsByCf[file.columnFamily];
+        auto &ranges = rangesByCf[file.columnFamily];
+        if (groups.empty())
+            cfOrder.push_back(file.columnFamily);
+        size_t group = 0;
+        for (size_t g = ranges.size(); g-- > 0;)
+        {
+            if (overlaps(ranges[g], file))
+            {
+                group = g + 1;
+                break;
+            }
+        }
+        if (group == ranges.size())
+        {
+            ranges.emplace_back(KeyLess{comparator});
+            groups.emplace_back();
+        }
+        ranges[group].emplace(file.smallestKey, file.largestKey);
+        groups[group].push_back(&file);
+    }
+
+    size_t maxGroups = 0;
+    for (const auto &cf : cfOrder)
+    {
+        size_t numGroups = groupsByCf[cf].size();
+        if (ingestBehind_ && numGroups > 1)
+        {
+            return Result(Result::Ret::kInvalidParam, "ingest behind needs non-overlapping files, column family " + cf +
+                                                          " needs " + std::to_string(numGroups) + " ingest calls");
+        }
+        maxGroups = std::max(maxGroups, numGroups);
+    }
+
+    // 估计层级：与 L0 重叠的留在 L0，否则落在第一个重叠层的上一层，都不重叠时落在最底层。
+    // 按此规则 L1 以下每层的文件两两不重叠，可以用 RangeSet 查询；L0 可能重叠，逐个比较
+    struct PlacedLevels
+    {
+        std::vector<const IngestFile *> level0;
+        std::vector<RangeSet> levels; // levels[l - 1] 为 Ll
+    };
+    std::map<std::string, PlacedLevels> placed;
+    auto emit = [&](const std::string &cf, size_t g)
+    {
+        auto &groups = groupsByCf[cf];
+        if (g >= groups.size())
+            return;
+        const rocksdb::Comparator *comparator = comparatorOf(cf);
+        IngestBatch batch;
+        batch.columnFamily = cf;
+        std::vector<const IngestFile *> files = groups[g];
+        std::sort(files.begin(), files.end(), [comparator](const IngestFile *a, const IngestFile *b)
+                  { return comparator->Compare(a->smallestKey, b->smallestKey) < 0; });
+
+        PlacedLevels &levels = placed[cf];
+        if (levels.levels.empty())
+            levels.levels.assign(plan.numLevels - 1, RangeSet(KeyLess{comparator}));
+        for (const IngestFile *file : files)
+        {
+            int level = plan.numLevels - 1;
+            if (!ingestBehind_)
+            {
+                bool inL0 = std::any_of(levels.level0.begin(), levels.level0.end(), [&](const IngestFile *other)
+                                        { return comparator->Compare(other->largestKey, file->smallestKey) >= 0 &&
+                                                 comparator->Compare(file->largestKey, other->smallestKey) >= 0; });
+                for (int l = 1; !inL0 && l < plan.numLevels; ++l)
+                {
+                    if (overlaps(levels.levels[l - 1], *file))
+                    {
+                        level = l - 1;
+                        break;
+                    }
+                }
+                if (inL0)
+                    level = 0;
+            }
+            batch.files.push_back(*file);
+            batch.expectedLevels.push_back(level);
+        }
+        // 同一次调用内的文件互不重叠，全部估计完再放入
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            if (batch.expectedLevels[i] == 0)
+                levels.level0.push_back(files[i]);
+            else
+                levels.levels[batch.expectedLevels[i] - 1].emplace(files[i]->smallestKey, files[i]->largestKey);
+        }
+
+        batch.options.move_files = moveFiles_;
+        batch.options.allow_global_seqno = true;
+        batch.options.write_global_seqno = false;
+        batch.options.allow_blocking_flush = true;
+        batch.options.ingest_behind = ingestBehind_;
+        plan.batches.push_back(std::move(batch));
+    };
+    // Pika 的 meta 在 default CF：集合元素只有在 meta 指向其版本后才可见，
+    // 因此全部 data CF 先于 default 导入，导入过程中读到的 meta 不会指向尚未导入的元素，中途失败也不会留下空集合
+    for (size_t g = 0; g < maxGroups; ++g)
+    {
+        for (const auto &cf : cfOrder)
+        {
+            if (cf != rocksdb::kDefaultColumnFamilyName)
+                emit(cf, g);
+        }
+    }
+    for (size_t g = 0; g < maxGroups; ++g)
+        emit(rocksdb::kDefaultColumnFamilyName, g);
+    return Result(Result::Ret::kOk, std::to_string(files_.size()) + " files in " + std::to_string(plan.batches.size()) + " ingest calls");
+}
+
+Result IngestPlanner::execute(rocksdb::DB *db, const std::map<std::string, rocksdb::ColumnFamilyHandle *> &handles, const IngestPlan &plan)
+{
+    static MetricsCounter &calls = metricsCounter("bingest_ingest_calls_total", "IngestExternalFile calls issued by IngestPlanner::execute");
+    static MetricsCounter &ingested = metricsCounter("bingest_ingest_files_total", "SST files ingested by IngestPlanner::execute");
+    static MetricsHistogram &latency = metricsHistogram("bingest_ingest_ns", "IngestExternalFile latency per call");
+    TRACE_SPAN("ingest");
+    for (const auto &batch : plan.batches)
+    {
+        rocksdb::ColumnFamilyHandle *handle = nullptr;
+        auto it = handles.find(batch.columnFamily);
+        if (it != handles.end())
+            handle = it->second;
+        else if (batch.columnFamily == rocksdb::kDefaultColumnFamilyName)
+            handle = db->DefaultColumnFamily();
+        if (handle == nullptr)
+        {
+            return Result(Result::Ret::kInvalidParam, "no handle for column family " + batch.columnFamily);
+        }
+        std::vector<std::string> paths;
+        for (const auto &file : batch.files)
+            paths.push_back(file.path);
+        rocksdb::Status status;
+        {
+            ScopedLatency timer(latency);
+            status = db->IngestExternalFile(handle, paths, batch.options);
+        }
+        if (!status.ok())
+        {
+            return Result(Result::Ret::kError, "ingest into " + batch.columnFamily + " failed: " + status.ToString());
+        }
+        calls.add();
+        ingested.add(paths.size());
+    }
+    return Result(Result::Ret::kOk, std::to_string(plan.numFiles()) + " files ingested in " + std::to_string(plan.batches.size()) + " calls");
+}
+
+Result writeIngestPlan(const IngestPlan &plan, const std::string &path)
+{
+    std::string tempPath = FilePublisher::tempPath(path);
+    {
+        std::ofstream out(tempPath);
+        out << plan.toJson(fs::path(path).parent_path().string()).dump(4);
+        out.close();
+        if (!out)
+        {
+            FilePublisher::discard(tempPath);
+            return Result(Result::Ret::kFileWriteError, "Failed to write " + tempPath);
+        }
+    }
+    FilePublisher publisher;
+    return publisher.publish(tempPath, path);
+}
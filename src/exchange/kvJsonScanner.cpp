@@ -0,0 +1,500 @@
+#include "exchange/kvJsonScanner.h"
+#include "utils/workerBuffers.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define KV_SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    inline bool isSpace(char c)
+    {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    inline bool isStringSpecial(char c)
+    {
+        return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+    }
+
+    const char *findStringSpecialScalar(const char *p, const char *end)
+    {
+        while (p < end && !isStringSpecial(*p))
+            ++p;
+        return p;
+    }
+
+    const char *skipSpaceScalar(const char *p, const char *end)
+    {
+        while (p < end && isSpace(*p))
+            ++p;
+        return p;
+    }
+
+#ifdef KV_SCANNER_X86
+    // PCMPESTRI：区间匹配 [0x00, 0x1f]、'"'、'\\'，返回块内第一个命中位置（没有命中时为 16）
+    __attribute__((target("sse4.2"))) const char *findStringSpecialSse42(const char *p, const char *end)
+    {
+        const __m128i set = _mm_setr_epi8(0x00, 0x1f, '"', '"', '\\', '\\', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        for (; p + 16 <= end; p += 16)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            int index = _mm_cmpestri(set, 6, block, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+            if (index < 16)
+                return p + index;
+        }
+        return findStringSpecialScalar(p, end);
+    }
+
+    // PCMPESTRI 取反：块内第一个不属于 " \n\r\t" 的字节
+    __attribute__((target("sse4.2"))) const char *skipSpaceSse42(const char *p, const char *end)
+    {
+        const __m128i set = _mm_setr_epi8(' ', '\n', '\r', '\t', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+        for (; p + 16 <= end; p += 16)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            int index = _mm_cmpestri(set, 4, block, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT);
+            if (index < 16)
+                return p + index;
+        }
+        return skipSpaceScalar(p, end);
+    }
+
+    __attribute__((target("avx2"))) const char *findStringSpecialAvx2(const char *p, const char *end)
+    {
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i backslash = _mm256_set1_epi8('\\');
+        const __m256i control = _mm256_set1_epi8(0x1f);
+        for (; p + 32 <= end; p += 32)
+        {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            // 无符号 v <= 0x1f 等价于 max(v, 0x1f) == 0x1f
+            __m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash)),
+                                           _mm256_cmpeq_epi8(_mm256_max_epu8(block, control), control));
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+            if (mask != 0)
+                return p + __builtin_ctz(mask);
+        }
+        return findStringSpecialSse42(p, end);
+    }
+
+    __attribute__((target("avx2"))) const char *skipSpaceAvx2(const char *p, const char *end)
+    {
+        for (; p + 32 <= end; p += 32)
+        {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            __m256i space = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n'))),
+                                            _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t'))));
+            uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(space));
+            if (mask != 0)
+                return p + __builtin_ctz(mask);
+        }
+        return skipSpaceSse42(p, end);
+    }
+#endif
+
+    // 与 nlohmann::json 一样按 RFC 3629 校验：拒绝过长编码、代理区与超出 U+10FFFF 的码点。
+    // 引号、反斜杠与控制字符都是 ASCII，不会出现在多字节序列中间，因此可以逐段独立校验
+    bool validUtf8(const char *p, const char *end)
+    {
+        const unsigned char *s = reinterpret_cast<const unsigned char *>(p);
+        const unsigned char *e = reinterpret_cast<const unsigned char *>(end);
+        while (s < e)
+        {
+            // 整段 ASCII 按 8 字节跳过
+            if (e - s >= 8)
+            {
+                uint64_t word;
+                std::memcpy(&word, s, sizeof(word));
+                if ((word & 0x8080808080808080ULL) == 0)
+                {
+                    s += 8;
+                    continue;
+                }
+            }
+            unsigned char c = *s;
+            if (c < 0x80)
+            {
+                ++s;
+                continue;
+            }
+            size_t length;
+            unsigned char low = 0x80;
+            unsigned char high = 0xbf;
+            if (c >= 0xc2 && c <= 0xdf)
+                length = 2;
+            else if (c >= 0xe0 && c <= 0xef)
+            {
+                length = 3;
+                if (c == 0xe0)
+                    low = 0xa0;
+                else if (c == 0xed)
+                    high = 0x9f;
+            }
+            else if (c >= 0xf0 && c <= 0xf4)
+            {
+                length = 4;
+                if (c == 0xf0)
+                    low = 0x90;
+                else if (c == 0xf4)
+                    high = 0x8f;
+            }
+            else
+                return false;
+            if (static_cast<size_t>(e - s) < length || s[1] < low || s[1] > high)
+                return false;
+            for (size_t i = 2; i < length; ++i)
+            {
+                if (s[i] < 0x80 || s[i] > 0xbf)
+                    return false;
+            }
+            s += length;
+        }
+        return true;
+    }
+
+    void appendUtf8(std::string &out, uint32_t cp)
+    {
+        if (cp < 0x80)
+        {
+            out.push_back(static_cast<char>(cp));
+        }
+        else if (cp < 0x800)
+        {
+            out.push_back(static_cast<char>(0xc0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+        }
+        else if (cp < 0x10000)
+        {
+            out.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(0xf0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+        }
+    }
+
+    bool parseHex4(const char *p, const char *end, uint32_t &value)
+    {
+        if (end - p < 4)
+            return false;
+        value = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            char c = p[i];
+            value <<= 4;
+            if (c >= '0' && c <= '9')
+                value |= c - '0';
+            else if (c >= 'a' && c <= 'f')
+                value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                value |= c - 'A' + 10;
+            else
+                return false;
+        }
+        return true;
+    }
+
+    // 单次解析的游标，出错时记录原因并停止
+    struct Cursor
+    {
+        const char *p;
+        const char *end;
+        KvJsonScanner::FindFn findStringSpecial;
+        KvJsonScanner::FindFn skipSpace;
+        WorkerBuffers &buffers; // 条目取自当前线程的回收池，字符串在原有容量内 assign
+        const char *error = nullptr;
+
+        bool fail(const char *reason)
+        {
+            error = reason;
+            return false;
+        }
+
+        // 缩进通常很短，先看一个字节，避免为单个空格进入向量循环
+        void space()
+        {
+            if (p < end && isSpace(*p))
+                p = skipSpace(p + 1, end);
+        }
+
+        bool expect(char c)
+        {
+            space();
+            if (p >= end || *p != c)
+                return fail("unexpected character");
+            ++p;
+            return true;
+        }
+
+        // p 指向开头的引号
+        bool string(std::string &out)
+        {
+            if (p >= end || *p != '"')
+                return fail("expected string");
+            ++p;
+            out.clear();
+            while (true)
+            {
+                const char *q = findStringSpecial(p, end);
+                if (!validUtf8(p, q))
+                    return fail("invalid UTF-8 in string");
+                out.append(p, q);
+                p = q;
+                if (p >= end)
+                    return fail("unterminated string");
+                if (*p == '"')
+                {
+                    ++p;
+                    return true;
+                }
+                if (*p != '\\')
+                    return fail("control character in string");
+                if (!escape(out))
+                    return false;
+            }
+        }
+
+        bool escape(std::string &out)
+        {
+            if (end - p < 2)
+                return fail("unterminated escape");
+            char c = p[1];
+            p += 2;
+            switch (c)
+            {
+            case '"':
+            case '\\':
+            case '/':
+                out.push_back(c);
+                return true;
+            case 'b':
+                out.push_back('\b');
+                return true;
+            case 'f':
+                out.push_back('\f');
+                return true;
+            case 'n':
+                out.push_back('\n');
+                return true;
+            case 'r':
+                out.push_back('\r');
+                return true;
+            case 't':
+                out.push_back('\t');
+                return true;
+            case 'u':
+                break;
+            default:
+                return fail("invalid escape");
+            }
+
+            uint32_t cp;
+            if (!parseHex4(p, end, cp))
+                return fail("invalid \\u escape");
+            p += 4;
+            if (cp >= 0xdc00 && cp <= 0xdfff)
+                return fail("unpaired surrogate");
+            if (cp >= 0xd800 && cp <= 0xdbff)
+            {
+                uint32_t low;
+                if (end - p < 6 || p[0] != '\\' || p[1] != 'u' || !parseHex4(p + 2, end, low) || low < 0xdc00 || low > 0xdfff)
+                    return fail("unpaired surrogate");
+                p += 6;
+                cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+            }
+            appendUtf8(out, cp);
+            return true;
+        }
+
+        // 只接受不超过 uint32 的非负整数，小数、负数与指数交给通用解析
+        bool uint32(uint32_t &value)
+        {
+            const char *start = p;
+            uint64_t v = 0;
+            while (p < end && *p >= '0' && *p <= '9' && p - start <= 10)
+            {
+                v = v * 10 + static_cast<uint64_t>(*p - '0');
+                ++p;
+            }
+            size_t digits = static_cast<size_t>(p - start);
+            if (digits == 0 || digits > 10 || v > UINT32_MAX || (digits > 1 && *start == '0'))
+                return fail("unsupported expire");
+            if (p < end && (*p == '.' || *p == 'e' || *p == 'E'))
+                return fail("unsupported expire");
+            value = static_cast<uint32_t>(v);
+            return true;
+        }
+
+        // 字段名只认 key / value / expire，直接比较原始字节
+        int fieldName()
+        {
+            static const struct
+            {
+                const char *text;
+                size_t size;
+            } names[] = {{"\"key\"", 5}, {"\"value\"", 7}, {"\"expire\"", 8}};
+            for (int i = 0; i < 3; ++i)
+            {
+                if (static_cast<size_t>(end - p) >= names[i].size && std::memcmp(p, names[i].text, names[i].size) == 0)
+                {
+                    p += names[i].size;
+                    return i;
+                }
+            }
+            fail("unsupported field");
+            return -1;
+        }
+
+        bool entry(KvEntry &entry)
+        {
+            if (!expect('{'))
+                return false;
+            bool hasKey = false;
+            bool hasValue = false;
+            while (true)
+            {
+                space();
+                int field = fieldName();
+                if (field < 0 || !expect(':'))
+                    return false;
+                space();
+                bool ok = field == 0 ? string(entry.key) : field == 1 ? string(entry.value)
+                                                                      : uint32(entry.timestamp);
+                if (!ok)
+                    return false;
+                hasKey = hasKey || field == 0;
+                hasValue = hasValue || field == 1;
+
+                space();
+                if (p < end && *p == ',')
+                {
+                    ++p;
+                    continue;
+                }
+                if (p < end && *p == '}')
+                {
+                    ++p;
+                    break;
+                }
+                return fail("unexpected character");
+            }
+            if (!hasKey || !hasValue)
+                return fail("missing key or value");
+            return true;
+        }
+
+        bool array(DataType &out)
+        {
+            if (!expect('['))
+                return false;
+            space();
+            if (p < end && *p == ']')
+            {
+                ++p;
+            }
+            else
+            {
+                while (true)
+                {
+                    KvEntry kv = buffers.takeEntry();
+                    if (!entry(kv))
+                        return false;
+                    out.push_back(std::move(kv));
+                    space();
+                    if (p < end && *p == ',')
+                    {
+                        ++p;
+                        continue;
+                    }
+                    if (p < end && *p == ']')
+                    {
+                        ++p;
+                        break;
+                    }
+                    return fail("unexpected character");
+                }
+            }
+            space();
+            if (p != end)
+                return fail("trailing characters");
+            return true;
+        }
+    };
+}
+
+const char *simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::kAvx2:
+        return "avx2";
+    case SimdLevel::kSse42:
+        return "sse4.2";
+    default:
+        return "scalar";
+    }
+}
+
+SimdLevel detectSimdLevel()
+{
+#ifdef KV_SCANNER_X86
+    static const SimdLevel level = []
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return SimdLevel::kAvx2;
+        if (__builtin_cpu_supports("sse4.2"))
+            return SimdLevel::kSse42;
+        return SimdLevel::kScalar;
+    }();
+    return level;
+#else
+    return SimdLevel::kScalar;
+#endif
+}
+
+KvJsonScanner::KvJsonScanner(SimdLevel level)
+    : level_(std::min(level, detectSimdLevel())),
+      findStringSpecial_(findStringSpecialScalar),
+      skipSpace_(skipSpaceScalar)
+{
+#ifdef KV_SCANNER_X86
+    if (level_ == SimdLevel::kAvx2)
+    {
+        findStringSpecial_ = findStringSpecialAvx2;
+        skipSpace_ = skipSpaceAvx2;
+    }
+    else if (level_ == SimdLevel::kSse42)
+    {
+        findStringSpecial_ = findStringSpecialSse42;
+        skipSpace_ = skipSpaceSse42;
+    }
+#endif
+}
+
+Result KvJsonScanner::parse(const char *data, size_t size, DataType &out) const
+{
+    out.clear();
+    // 缩进输出每条约 70 字节加上 key/value 本身，按 64 字节预估只会略多
+    out.reserve(size / 64);
+    WorkerBuffers &buffers = WorkerBuffers::local();
+    Cursor cursor{data, data + size, findStringSpecial_, skipSpace_, buffers};
+    if (!cursor.array(out))
+    {
+        // 已解析的条目还给回收池，回退解析时不至于全部释放
+        buffers.spare().insert(buffers.spare().end(), std::make_move_iterator(out.begin()), std::make_move_iterator(out.end()));
+        out.clear();
+        return Result(Result::Ret::kInvalidParam, std::string(cursor.error) + " at offset " + std::to_string(cursor.p - data));
+    }
+    return Result(Result::Ret::kOk);
+}
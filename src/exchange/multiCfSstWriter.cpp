@@ -0,0 +1,324 @@
+#include "exchange/multiCfSstWriter.h"
+#include "exchange/sstValidator.h"
+#include "utils/filePublisher.h"
+#include "utils/metrics.h"
+#include "utils/trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    int hexDigit(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+}
+
+std::string toHex(const std::string &bytes)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(bytes.size() * 2);
+    for (unsigned char c : bytes)
+    {
+        out.push_back(digits[c >> 4]);
+        out.push_back(digits[c & 0xf]);
+    }
+    return out;
+}
+
+bool fromHex(const std::string &hex, std::string &bytes)
+{
+    if (hex.size() % 2 != 0)
+        return false;
+    std::string out;
+    out.reserve(hex.size() / 2);
+    for (size_t i = 0; i < hex.size(); i += 2)
+    {
+        int hi = hexDigit(hex[i]);
+        int lo = hexDigit(hex[i + 1]);
+        if (hi < 0 || lo < 0)
+            return false;
+        out.push_back(static_cast<char>(hi << 4 | lo));
+    }
+    bytes = std::move(out);
+    return true;
+}
+
+std::string sstPartPath(const std::string &outputSstPath, size_t part)
+{
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%04zu.sst", part);
+    fs::path path(outputSstPath);
+    return (path.parent_path() / (path.stem().string() + suffix)).string();
+}
+
+Result writeSortedSst(size_t numEntries, const std::function<rocksdb::Status(rocksdb::SstFileWriter &, size_t)> &put,
+                      const rocksdb::Options &options, rocksdb::ColumnFamilyHandle *cfh, const SstSplitPolicy &split,
+                      const std::string &outputSstPath, std::vector<std::string> &tempPaths, std::vector<std::string> &finalPaths,
+                      std::vector<rocksdb::ExternalSstFileInfo> *infos)
+{
+    static MetricsHistogram &putLatency = metricsHistogram("bingest_exchange_sst_put_ns", "SstFileWriter::Put phase latency per file");
+    static MetricsHistogram &finishLatency = metricsHistogram("bingest_exchange_sst_finish_ns", "SstFileWriter::Finish latency per file");
+
+    auto fail = [&](const Result &res)
+    {
+        for (const auto &tempPath : tempPaths)
+            FilePublisher::discard(tempPath);
+        return res;
+    };
+
+    // 创建 SstFileWriter
+    rocksdb::SstFileWriter writer(rocksdb::EnvOptions(), options, cfh);
+    auto openPart = [&]()
+    {
+        finalPaths.push_back(split.splitting() ? sstPartPath(outputSstPath, finalPaths.size()) : outputSstPath);
+        tempPaths.push_back(FilePublisher::tempPath(finalPaths.back()));
+        return writer.Open(tempPaths.back());
+    };
+    auto finishPart = [&]()
+    {
+        TRACE_SPAN("finish");
+        ScopedLatency timer(finishLatency);
+        rocksdb::ExternalSstFileInfo info;
+        rocksdb::Status status = writer.Finish(&info);
+        if (status.ok() && infos)
+            infos->push_back(std::move(info));
+        return status;
+    };
+
+    auto status = openPart();
+    if (!status.ok())
+    {
+        return fail(Result(Result::Ret::kFileWriteError, "Failed to open SST file: " + status.ToString()));
+    }
+
+    // 写入去重后的数据，切分模式下达到目标大小或条数即切到下一个文件
+    size_t partEntries = 0;
+    {
+        TRACE_SPAN("write");
+        ScopedLatency timer(putLatency);
+        for (size_t i = 0; i < numEntries; ++i)
+        {
+            status = put(writer, i);
+            if (!status.ok())
+            {
+                writer.Finish().PermitUncheckedError();
+                return fail(Result(Result::Ret::kFileWriteError, "Put failed: " + status.ToString()));
+            }
+            ++partEntries;
+
+            bool full = (split.targetFileEntries > 0 && partEntries >= split.targetFileEntries) ||
+                        (split.targetFileSize > 0 && writer.FileSize() >= split.targetFileSize);
+            if (full && i + 1 < numEntries)
+            {
+                status = finishPart();
+                if (status.ok())
+                    status = openPart();
+                if (!status.ok())
+                {
+                    return fail(Result(Result::Ret::kFileWriteError, "Failed to roll SST file: " + status.ToString()));
+                }
+                partEntries = 0;
+            }
+        }
+    }
+
+    // 完成 SST 写入
+    status = finishPart();
+    if (!status.ok())
+    {
+        return fail(Result(Result::Ret::kFileWriteError, "Finish failed: " + status.ToString()));
+    }
+    return Result(Result::Ret::kOk, finalPaths.front());
+}
+
+MultiCfSstWriter::MultiCfSstWriter(std::vector<CfSpec> cfs, const SstSplitPolicy &split)
+    : cfs_(std::move(cfs)), split_(split), buffers_(cfs_.size()), results_(cfs_.size())
+{
+}
+
+void MultiCfSstWriter::addAll(size_t cf, std::vector<KvPair> &&pairs)
+{
+    std::vector<KvPair> &buffer = buffers_.at(cf);
+    if (buffer.empty())
+    {
+        buffer = std::move(pairs);
+        return;
+    }
+    buffer.insert(buffer.end(), std::make_move_iterator(pairs.begin()), std::make_move_iterator(pairs.end()));
+}
+
+Result MultiCfSstWriter::writeCf(size_t cf, const std::string &outputSstPath)
+{
+    TRACE_SPAN_ARG("writeCf", cfs_[cf].name);
+    std::vector<KvPair> &pairs = buffers_[cf];
+    CfResult &result = results_[cf];
+    const rocksdb::Options &options = cfs_[cf].options;
+
+    // 摘要与顺序无关，排序前计算，独立验证排序与写入
+    KvDigest expected;
+    if (validate_)
+    {
+        for (const auto &pair : pairs)
+            expected.add(pair.first, pair.second);
+    }
+    {
+        TRACE_SPAN("sort");
+        const rocksdb::Comparator *comparator = options.comparator;
+        std::sort(pairs.begin(), pairs.end(), [comparator](const KvPair &a, const KvPair &b)
+                  { return comparator->Compare(a.first, b.first) < 0; });
+    }
+
+    Result res = writeSortedSst(
+        pairs.size(), [&pairs](rocksdb::SstFileWriter &writer, size_t i)
+        { return writer.Put(pairs[i].first, pairs[i].second); },
+        options, cfs_[cf].handle, split_, outputSstPath, result.tempPaths, result.finalPaths, &result.infos);
+    // 写完即释放缓冲区，其他 CF 仍在写入时降低峰值内存
+    std::vector<KvPair>().swap(pairs);
+    if (res.isError() || !validate_)
+    {
+        return res;
+    }
+
+    TRACE_SPAN("validate");
+    SstValidator validator(options, 0);
+    res = validator.verify(result.tempPaths, expected, DataType());
+    if (res.isError())
+    {
+        for (const auto &tempPath : result.tempPaths)
+            FilePublisher::discard(tempPath);
+        result = CfResult();
+    }
+    return res;
+}
+
+Result MultiCfSstWriter::write(TaskScheduler *scheduler, size_t numThreads, const std::function<std::string(size_t cf)> &pathOf)
+{
+    static MetricsCounter &cfWriters = metricsCounter("bingest_exchange_cf_writers_total", "per-column-family writers run by MultiCfSstWriter");
+    std::vector<size_t> cfs;
+    for (size_t cf = 0; cf < cfs_.size(); ++cf)
+    {
+        results_[cf] = CfResult();
+        if (!buffers_[cf].empty())
+            cfs.push_back(cf);
+    }
+    if (cfs.empty())
+    {
+        return Result(Result::Ret::kInvalidParam, "no entries for any column family");
+    }
+
+    Result res(Result::Ret::kOk);
+    {
+        std::unique_ptr<TaskScheduler> localScheduler;
+        if (scheduler == nullptr)
+        {
+            localScheduler = std::make_unique<TaskScheduler>(std::max<size_t>(1, std::min(numThreads, cfs.size())));
+            scheduler = localScheduler.get();
+        }
+        TaskGroup group(*scheduler);
+        for (size_t cf : cfs)
+        {
+            std::string path = pathOf(cf);
+            group.run([this, cf, path]
+                      { return writeCf(cf, path); });
+        }
+        res = group.wait();
+    }
+    cfWriters.add(cfs.size());
+
+    if (res.isError())
+    {
+        // 一个 CF 失败时整组都不发布，避免 meta 与 data 不一致
+        for (auto &result : results_)
+        {
+            for (const auto &tempPath : result.tempPaths)
+                FilePublisher::discard(tempPath);
+            result = CfResult();
+        }
+        return res;
+    }
+    return Result(Result::Ret::kOk, std::to_string(cfs.size()) + " column families written");
+}
+
+std::vector<std::string> MultiCfSstWriter::tempPaths() const
+{
+    std::vector<std::string> paths;
+    for (const auto &result : results_)
+        paths.insert(paths.end(), result.tempPaths.begin(), result.tempPaths.end());
+    return paths;
+}
+
+std::vector<std::string> MultiCfSstWriter::finalPaths() const
+{
+    std::vector<std::string> paths;
+    for (const auto &result : results_)
+        paths.insert(paths.end(), result.finalPaths.begin(), result.finalPaths.end());
+    return paths;
+}
+
+uint64_t MultiCfSstWriter::numEntries() const
+{
+    uint64_t entries = 0;
+    for (const auto &result : results_)
+    {
+        for (const auto &info : result.infos)
+            entries += info.num_entries;
+    }
+    return entries;
+}
+
+json MultiCfSstWriter::manifest(const std::string &baseDir) const
+{
+    json cfs = json::array();
+    for (size_t cf = 0; cf < cfs_.size(); ++cf)
+    {
+        const CfResult &result = results_[cf];
+        if (result.finalPaths.empty())
+            continue;
+        json files = json::array();
+        uint64_t entries = 0;
+        for (size_t i = 0; i < result.finalPaths.size() && i < result.infos.size(); ++i)
+        {
+            entries += result.infos[i].num_entries;
+            files.push_back(sstFileManifest(result.finalPaths[i], result.infos[i], baseDir));
+        }
+        cfs.push_back({{"name", cfs_[cf].name},
+                       {"comparator", cfs_[cf].options.comparator->Name()},
+                       {"entries", entries},
+                       {"files", std::move(files)}});
+    }
+    return json{{"columnFamilies", std::move(cfs)}};
+}
+
+json sstFileManifest(const std::string &finalPath, const rocksdb::ExternalSstFileInfo &info, const std::string &baseDir)
+{
+    return json{{"file", fs::path(finalPath).lexically_relative(baseDir).string()},
+                {"fileSize", info.file_size},
+                {"entries", info.num_entries},
+                {"smallestKey", toHex(info.smallest_key)},
+                {"largestKey", toHex(info.largest_key)}};
+}
+
+std::vector<CfSpec> pikaCfSpecs(const rocksdb::Options &options, const std::vector<rocksdb::ColumnFamilyHandle *> &handles)
+{
+    std::vector<CfSpec> specs(kPikaCfCount);
+    for (size_t cf = 0; cf < kPikaCfCount; ++cf)
+    {
+        specs[cf].name = pikaCfName(cf);
+        specs[cf].options = options;
+        specs[cf].options.comparator = pikaCfComparator(cf);
+        specs[cf].handle = cf < handles.size() ? handles[cf] : nullptr;
+    }
+    return specs;
+}
@@ -0,0 +1,455 @@
+#include "exchange/replicaBench.h"
+#include "exchange/sstValidator.h"
+#include "utils/compare.h"
+#include "utils/filePublisher.h"
+#include "utils/trace.h"
+#include "rocksdb/db.h"
+#include "rocksdb/write_batch.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // /proc/self/io 的累计写入字节数，不可用时为 0
+    struct IoCounters
+    {
+        uint64_t wchar = 0;
+        uint64_t writeBytes = 0;
+    };
+
+    IoCounters readIoCounters()
+    {
+        IoCounters counters;
+        std::ifstream in("/proc/self/io");
+        std::string name;
+        uint64_t value = 0;
+        while (in >> name >> value)
+        {
+            if (name == "wchar:")
+                counters.wchar = value;
+            else if (name == "write_bytes:")
+                counters.writeBytes = value;
+        }
+        return counters;
+    }
+
+    uint64_t directorySize(const fs::path &dir)
+    {
+        std::error_code ec;
+        uint64_t total = 0;
+        for (fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+        {
+            if (it->is_regular_file(ec))
+                total += it->file_size(ec);
+        }
+        return total;
+    }
+
+    Result statusResult(const rocksdb::Status &status, const std::string &what)
+    {
+        if (status.ok())
+            return Result(Result::Ret::kOk);
+        return Result(Result::Ret::kError, what + ": " + status.ToString());
+    }
+
+    Result openNode(const fs::path &path, rocksdb::Options options, std::unique_ptr<rocksdb::DB> &db)
+    {
+        std::error_code ec;
+        fs::create_directories(path, ec);
+        options.create_if_missing = true;
+        rocksdb::DB *raw = nullptr;
+        Result res = statusResult(rocksdb::DB::Open(options, path.string(), &raw), "open " + path.string());
+        db.reset(raw);
+        return res;
+    }
+
+    // 主从都落盘完毕才算追平：flush memtable 后等待后台 compaction 结束，写放大才包含它们
+    Result quiesce(rocksdb::DB *db)
+    {
+        Result res = statusResult(db->Flush(rocksdb::FlushOptions()), "flush");
+        if (res.isError())
+            return res;
+        for (;;)
+        {
+            uint64_t pending = 0;
+            uint64_t running = 0;
+            db->GetIntProperty("rocksdb.compaction-pending", &pending);
+            db->GetIntProperty("rocksdb.num-running-compactions", &running);
+            if (pending == 0 && running == 0)
+                return Result(Result::Ret::kOk);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    std::string dbDigest(rocksdb::DB *db)
+    {
+        KvDigest digest;
+        std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(rocksdb::ReadOptions()));
+        for (it->SeekToFirst(); it->Valid(); it->Next())
+            digest.add(it->key().data(), it->key().size(), it->value().data(), it->value().size());
+        return digest.toString();
+    }
+
+    // 以普通读写拷贝，模拟从对象存储上传 / 下载，拷贝的字节计入 wchar
+    Result copyObject(const fs::path &from, const fs::path &to, uint64_t &bytes)
+    {
+        std::ifstream in(from, std::ios::binary);
+        if (!in)
+            return Result(Result::Ret::kFileOpenError, "cannot open " + from.string());
+        std::ofstream out(to, std::ios::binary | std::ios::trunc);
+        out << in.rdbuf();
+        out.close();
+        if (!out)
+            return Result(Result::Ret::kFileWriteError, "cannot write " + to.string());
+        bytes += fs::file_size(to);
+        return Result(Result::Ret::kOk);
+    }
+
+    // 主从之间的 binlog 链路：从节点在独立线程上按顺序重放，出错后丢弃剩余记录
+    class BinlogReplayer
+    {
+    public:
+        explicit BinlogReplayer(std::function<Result(const std::string &)> apply)
+            : apply_(std::move(apply)), thread_([this]
+                                                { run(); }) {}
+
+        ~BinlogReplayer() { finish(); }
+
+        void push(std::string record)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                queue_.push_back(std::move(record));
+            }
+            cv_.notify_one();
+        }
+
+        // 等待已发送的记录全部重放完，返回第一个错误
+        Result finish()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                closed_ = true;
+            }
+            cv_.notify_one();
+            if (thread_.joinable())
+                thread_.join();
+            return result_;
+        }
+
+    private:
+        void run()
+        {
+            std::string record;
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    cv_.wait(lock, [this]
+                             { return closed_ || !queue_.empty(); });
+                    if (queue_.empty())
+                        return;
+                    record = std::move(queue_.front());
+                    queue_.pop_front();
+                }
+                if (result_.isError())
+                    continue;
+                Result res = apply_(record);
+                if (res.isError())
+                    result_ = res;
+            }
+        }
+
+        std::function<Result(const std::string &)> apply_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::deque<std::string> queue_;
+        bool closed_ = false;
+        Result result_ = Result(Result::Ret::kOk);
+        std::thread thread_;
+    };
+
+    // 两种模式共同的收尾：等从节点追平、两侧落盘，再记录时间、I/O 与结果摘要
+    Result finishRun(BinlogReplayer &replayer, rocksdb::DB *primary, rocksdb::DB *replica, const fs::path &dir,
+                     Clock::time_point start, const IoCounters &before, ReplicaBenchStats &stats)
+    {
+        Result res = replayer.finish();
+        if (res.isError())
+            return res;
+        res = quiesce(primary);
+        if (!res.isError())
+            res = quiesce(replica);
+        if (res.isError())
+            return res;
+        stats.wallSeconds = secondsSince(start);
+        IoCounters after = readIoCounters();
+        stats.bytesWritten = after.wchar - before.wchar;
+        stats.storageBytesWritten = after.writeBytes - before.writeBytes;
+
+        stats.primaryDigest = dbDigest(primary);
+        stats.replicaDigest = dbDigest(replica);
+        stats.primaryDiskBytes = directorySize(dir / "primary");
+        stats.replicaDiskBytes = directorySize(dir / "replica");
+        if (stats.primaryDigest != stats.replicaDigest)
+        {
+            return Result(Result::Ret::kDataSizeMismatch, stats.mode + ": replica digest " + stats.replicaDigest +
+                                                              " != primary " + stats.primaryDigest);
+        }
+        return Result(Result::Ret::kOk, stats.mode + " done");
+    }
+}
+
+Result DatasetCollector::write(const DataType &data)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_.push_back(data);
+    return Result(Result::Ret::kOk);
+}
+
+std::vector<DataType> DatasetCollector::take(size_t *skipped)
+{
+    std::vector<DataType> files;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        files.swap(files_);
+    }
+    size_t dropped = 0;
+    for (auto &data : files)
+    {
+        if (!std::is_sorted(data.begin(), data.end(), ComparePair()))
+            std::sort(data.begin(), data.end(), ComparePair());
+        dedupSorted(data);
+        size_t before = data.size();
+        data.erase(std::remove_if(data.begin(), data.end(), [](const KvEntry &entry)
+                                  { return entry.type != KvType::kString; }),
+                   data.end());
+        dropped += before - data.size();
+    }
+    if (skipped)
+        *skipped = dropped;
+    return files;
+}
+
+double ReplicaBenchStats::writeAmplification() const
+{
+    return userBytes == 0 ? 0 : static_cast<double>(bytesWritten) / static_cast<double>(userBytes * 2);
+}
+
+json ReplicaBenchStats::toJson() const
+{
+    return json{{"mode", mode},
+                {"entries", entries},
+                {"userBytes", userBytes},
+                {"wallSeconds", wallSeconds},
+                {"primarySeconds", primarySeconds},
+                {"bytesWritten", bytesWritten},
+                {"storageBytesWritten", storageBytesWritten},
+                {"writeAmplification", writeAmplification()},
+                {"binlogBytes", binlogBytes},
+                {"objectBytes", objectBytes},
+                {"bytesMoved", bytesMoved()},
+                {"primaryDiskBytes", primaryDiskBytes},
+                {"replicaDiskBytes", replicaDiskBytes},
+                {"digest", primaryDigest}};
+}
+
+ReplicaBench::ReplicaBench(std::string workDir) : workDir_(std::move(workDir))
+{
+}
+
+Result ReplicaBench::runWriteBatch(const std::vector<DataType> &files, ReplicaBenchStats &stats)
+{
+    TRACE_SPAN("replicaBench.writeBatch");
+    stats = ReplicaBenchStats();
+    stats.mode = "writebatch";
+    fs::path dir = fs::path(workDir_) / stats.mode;
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+
+    std::unique_ptr<rocksdb::DB> primary;
+    std::unique_ptr<rocksdb::DB> replica;
+    Result res = openNode(dir / "primary", options_, primary);
+    if (!res.isError())
+        res = openNode(dir / "replica", options_, replica);
+    if (res.isError())
+        return res;
+    rocksdb::WriteOptions writeOptions;
+    writeOptions.sync = syncWrites_;
+
+    IoCounters before = readIoCounters();
+    Clock::time_point start = Clock::now();
+    // 从节点与 Pika 的 binlog 重放一样，每条记录单独 Write
+    BinlogReplayer replayer([&](const std::string &record)
+                            {
+                                rocksdb::WriteBatch batch(record);
+                                return statusResult(replica->Write(writeOptions, &batch), "replica write"); });
+
+    rocksdb::WriteBatch batch;
+    rocksdb::WriteBatch record;
+    std::vector<std::string> pending;
+    pending.reserve(batchSize_);
+    std::string value;
+    // 主节点提交一个 batch 后才把其中的记录写入 binlog
+    auto commit = [&]()
+    {
+        if (batch.Count() == 0)
+            return Result(Result::Ret::kOk);
+        Result committed = statusResult(primary->Write(writeOptions, &batch), "primary write");
+        batch.Clear();
+        for (auto &item : pending)
+            replayer.push(std::move(item));
+        pending.clear();
+        return committed;
+    };
+    for (const auto &data : files)
+    {
+        for (const auto &entry : data)
+        {
+            value.clear();
+            encoder_->encode(entry, value);
+            batch.Put(entry.key, value);
+            record.Clear();
+            record.Put(entry.key, value);
+            stats.binlogBytes += record.Data().size();
+            pending.push_back(record.Data());
+            ++stats.entries;
+            stats.userBytes += entry.key.size() + value.size();
+            if (static_cast<size_t>(batch.Count()) >= batchSize_)
+            {
+                res = commit();
+                if (res.isError())
+                    return res;
+            }
+        }
+    }
+    res = commit();
+    if (res.isError())
+        return res;
+    stats.primarySeconds = secondsSince(start);
+    return finishRun(replayer, primary.get(), replica.get(), dir, start, before, stats);
+}
+
+Result ReplicaBench::runIngest(const std::vector<DataType> &files, ReplicaBenchStats &stats)
+{
+    TRACE_SPAN("replicaBench.ingest");
+    stats = ReplicaBenchStats();
+    stats.mode = "ingest";
+    fs::path dir = fs::path(workDir_) / stats.mode;
+    fs::path staging = dir / "staging";
+    fs::path s3 = dir / "s3";
+    fs::path download = dir / "download";
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    for (const auto &path : {staging, s3, download})
+        fs::create_directories(path, ec);
+
+    std::unique_ptr<rocksdb::DB> primary;
+    std::unique_ptr<rocksdb::DB> replica;
+    Result res = openNode(dir / "primary", options_, primary);
+    if (!res.isError())
+        res = openNode(dir / "replica", options_, replica);
+    if (res.isError())
+        return res;
+    rocksdb::IngestExternalFileOptions ingestOptions;
+    ingestOptions.move_files = true;
+    FilePublisher publisher;
+
+    IoCounters before = readIoCounters();
+    Clock::time_point start = Clock::now();
+    // 从节点收到 INGEST_SST 后按清单顺序下载并 ingest；downloaded 只在重放线程上修改
+    uint64_t downloaded = 0;
+    BinlogReplayer replayer([&](const std::string &record)
+                            {
+                                std::vector<std::string> paths;
+                                try
+                                {
+                                    json manifest = json::parse(record);
+                                    for (const auto &file : manifest.at("columnFamilies").at(0).at("files"))
+                                    {
+                                        std::string name = file.at("file").get<std::string>();
+                                        Result copied = copyObject(s3 / name, download / name, downloaded);
+                                        if (copied.isError())
+                                            return copied;
+                                        paths.push_back((download / name).string());
+                                    }
+                                }
+                                catch (const std::exception &e)
+                                {
+                                    return Result(Result::Ret::kInvalidParam, std::string("bad INGEST_SST record: ") + e.what());
+                                }
+                                return statusResult(replica->IngestExternalFile(paths, ingestOptions), "replica ingest"); });
+
+    uint64_t uploaded = 0;
+    std::string value;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        const DataType &data = files[i];
+        if (data.empty())
+            continue;
+        std::string name = "data_" + std::to_string(i);
+        std::vector<std::string> tempPaths;
+        std::vector<std::string> finalPaths;
+        std::vector<rocksdb::ExternalSstFileInfo> infos;
+        res = writeSortedSst(
+            data.size(), [&](rocksdb::SstFileWriter &writer, size_t k)
+            {
+                value.clear();
+                encoder_->encode(data[k], value);
+                stats.userBytes += data[k].key.size() + value.size();
+                return writer.Put(data[k].key, value); },
+            options_, nullptr, split_, (staging / (name + ".sst")).string(), tempPaths, finalPaths, &infos);
+        for (size_t k = 0; !res.isError() && k < tempPaths.size(); ++k)
+            res = publisher.publish(tempPaths[k], finalPaths[k]);
+        if (res.isError())
+            return res;
+        stats.entries += data.size();
+
+        // 清单格式与 exchange 的单 CF 清单相同，上传到 s3/ 后作为 INGEST_SST 的内容
+        json fileList = json::array();
+        for (size_t k = 0; k < finalPaths.size(); ++k)
+        {
+            fileList.push_back(sstFileManifest(finalPaths[k], infos[k], staging.string()));
+            res = copyObject(finalPaths[k], s3 / fs::path(finalPaths[k]).filename(), uploaded);
+            if (res.isError())
+                return res;
+        }
+        json manifest = {{"columnFamilies", json::array({{{"name", rocksdb::kDefaultColumnFamilyName},
+                                                          {"comparator", options_.comparator->Name()},
+                                                          {"entries", data.size()},
+                                                          {"files", std::move(fileList)}}})},
+                         {"output", name}};
+        std::string content = manifest.dump();
+        {
+            std::ofstream out(s3 / (name + ".manifest.json"), std::ios::trunc);
+            out << content;
+            if (!out)
+                return Result(Result::Ret::kFileWriteError, "cannot upload manifest " + name);
+        }
+        uploaded += content.size();
+
+        res = statusResult(primary->IngestExternalFile(finalPaths, ingestOptions), "primary ingest");
+        if (res.isError())
+            return res;
+        stats.binlogBytes += content.size();
+        replayer.push(std::move(content));
+    }
+    stats.primarySeconds = secondsSince(start);
+    res = finishRun(replayer, primary.get(), replica.get(), dir, start, before, stats);
+    stats.objectBytes = uploaded + downloaded;
+    return res;
+}
@@ -0,0 +1,248 @@
+#include "exchange/sstChecker.h"
+#include "exchange/JsonFileManager.h"
+#include "rocksdb/sst_file_reader.h"
+#include "utils/compare.h"
+#include "utils/klog.h"
+#include "utils/metrics.h"
+#include "utils/taskScheduler.h"
+#include "utils/trace.h"
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+
+namespace fs = std::filesystem;
+
+json SstFileSummary::toJson() const
+{
+    json j = {{"file", fs::path(path).filename().string()},
+              {"fileSize", fileSize},
+              {"entries", entries},
+              {"smallestKey", smallestKey},
+              {"largestKey", largestKey},
+              {"persistentEntries", persistentEntries},
+              {"minExpire", minExpire},
+              {"maxExpire", maxExpire}};
+    if (!ok)
+        j["error"] = error;
+    return j;
+}
+
+Result SstChecker::checkFile(const std::string &sstPath, SstFileSummary &summary) const
+{
+    static MetricsHistogram &checkLatency = metricsHistogram("bingest_sstcheck_file_ns", "SstChecker::checkFile latency per file");
+    static MetricsCounter &checkedEntries = metricsCounter("bingest_sstcheck_entries_total", "entries verified by sstcheck");
+    ScopedLatency timer(checkLatency);
+    TRACE_SPAN_ARG("checkFile", sstPath);
+
+    summary = SstFileSummary();
+    summary.path = sstPath;
+    auto fail = [&summary](Result::Ret ret, const std::string &msg)
+    {
+        summary.error = msg;
+        return Result(ret, summary.path + ": " + msg);
+    };
+
+    std::error_code ec;
+    summary.fileSize = fs::file_size(sstPath, ec);
+    if (ec)
+        return fail(Result::Ret::kFileOpenError, ec.message());
+
+    rocksdb::SstFileReader reader(options_);
+    rocksdb::Status status = reader.Open(sstPath);
+    if (!status.ok())
+        return fail(Result::Ret::kFileReadError, "open failed: " + status.ToString());
+    status = reader.VerifyChecksum();
+    if (!status.ok())
+        return fail(Result::Ret::kFileReadError, "checksum mismatch: " + status.ToString());
+
+    const rocksdb::Comparator *cmp = options_.comparator;
+    rocksdb::ReadOptions readOptions;
+    readOptions.fill_cache = false; // 只顺序扫描一遍，不污染 block cache
+    std::unique_ptr<rocksdb::Iterator> it(reader.NewIterator(readOptions));
+    std::string prevKey;
+    for (it->SeekToFirst(); it->Valid(); it->Next())
+    {
+        rocksdb::Slice key = it->key();
+        rocksdb::Slice value = it->value();
+        if (summary.entries > 0)
+        {
+            int c = cmp->Compare(rocksdb::Slice(prevKey), key);
+            if (c == 0)
+                return fail(Result::Ret::kInvalidRange, "duplicate key '" + key.ToString() + "' at entry " + std::to_string(summary.entries));
+            if (c > 0)
+                return fail(Result::Ret::kInvalidRange, "key '" + key.ToString() + "' out of order at entry " + std::to_string(summary.entries));
+        }
+        uint32_t timestamp = 0;
+        if (!encoder_->decodeExpire(value.data(), value.size(), timestamp))
+            return fail(Result::Ret::kDataSizeMismatch, "value of key '" + key.ToString() + "' is not " + encoder_->name() + " encoded");
+        if (timestamp == 0)
+        {
+            ++summary.persistentEntries;
+        }
+        else
+        {
+            summary.minExpire = summary.minExpire == 0 ? timestamp : std::min(summary.minExpire, timestamp);
+            summary.maxExpire = std::max(summary.maxExpire, timestamp);
+        }
+
+        if (summary.entries == 0)
+            summary.smallestKey = key.ToString();
+        prevKey.assign(key.data(), key.size());
+        ++summary.entries;
+    }
+    if (!it->status().ok())
+        return fail(Result::Ret::kFileReadError, "iterator error: " + it->status().ToString());
+    summary.largestKey = prevKey;
+
+    auto props = reader.GetTableProperties();
+    if (props && props->num_entries != summary.entries)
+    {
+        return fail(Result::Ret::kDataSizeMismatch, "table properties report " + std::to_string(props->num_entries) +
+                                                        " entries, iterated " + std::to_string(summary.entries));
+    }
+
+    checkedEntries.add(summary.entries);
+    summary.ok = true;
+    return Result(Result::Ret::kOk, sstPath);
+}
+
+Result SstChecker::crossCheckJson(const std::string &sstPath, JsonFileManagerBase *fileManager,
+                                  const std::string &jsonPath) const
+{
+    return crossCheckJson(std::vector<std::string>{sstPath}, fileManager, std::vector<std::string>{jsonPath});
+}
+
+Result SstChecker::crossCheckJson(const std::vector<std::string> &sstPaths, JsonFileManagerBase *fileManager,
+                                  const std::vector<std::string> &jsonPaths) const
+{
+    if (sstPaths.empty() || jsonPaths.empty())
+        return Result(Result::Ret::kInvalidParam, "crossCheckJson needs at least one sst and one json file");
+    std::string jsonName = jsonPaths.front() + (jsonPaths.size() > 1 ? " (+" + std::to_string(jsonPaths.size() - 1) + " inputs)" : "");
+    TRACE_SPAN_ARG("crossCheckJson", jsonName);
+    DataType data;
+    try
+    {
+        for (const auto &jsonPath : jsonPaths)
+        {
+            DataType part = fileManager->parse(jsonPath);
+            if (data.empty())
+                data = std::move(part);
+            else
+                data.insert(data.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+        }
+    }
+    catch (const std::exception &e)
+    {
+        return Result(Result::Ret::kFileReadError, "JSON parse failed: " + std::string(e.what()));
+    }
+    std::sort(data.begin(), data.end(), ComparePair());
+    dedupSorted(data);
+
+    // 切分的各段依次接续：前一段的最后一条之后紧接着下一段的第一条
+    uint32_t now = unixNowSeconds();
+    size_t i = 0;
+    size_t entries = 0;
+    for (const auto &sstPath : sstPaths)
+    {
+        rocksdb::SstFileReader reader(options_);
+        rocksdb::Status status = reader.Open(sstPath);
+        if (!status.ok())
+            return Result(Result::Ret::kFileReadError, sstPath + ": open failed: " + status.ToString());
+
+        std::unique_ptr<rocksdb::Iterator> it(reader.NewIterator(rocksdb::ReadOptions()));
+        for (it->SeekToFirst(); it->Valid(); it->Next(), ++i, ++entries)
+        {
+            // 转换时被丢弃的过期条目
+            while (i < data.size() && it->key() != rocksdb::Slice(data[i].key) && isExpired(data[i], now))
+                ++i;
+            if (i >= data.size())
+                return Result(Result::Ret::kDataSizeMismatch, sstPath + ": more entries than " + jsonName);
+            if (it->key() != rocksdb::Slice(data[i].key))
+            {
+                return Result(Result::Ret::kDataSizeMismatch, sstPath + ": key mismatch at entry " + std::to_string(entries) +
+                                                                  ", sst '" + it->key().ToString() + "' json '" + data[i].key + "'");
+            }
+            if (!encoder_->matches(data[i], it->value().data(), it->value().size()))
+                return Result(Result::Ret::kDataSizeMismatch, sstPath + ": value mismatch for key '" + data[i].key + "'");
+        }
+    }
+    while (i < data.size() && isExpired(data[i], now))
+        ++i;
+    if (i != data.size())
+    {
+        return Result(Result::Ret::kDataSizeMismatch, sstPaths.back() + ": " + std::to_string(entries) + " entries, " + jsonName +
+                                                          " has " + std::to_string(data.size()) + " unique keys");
+    }
+    return Result(Result::Ret::kOk, sstPaths.front());
+}
+
+Result SstChecker::crossCheckManifest(const SstFileSummary &summary, const json &manifestEntry)
+{
+    auto mismatch = [&summary](const std::string &field, const std::string &expected, const std::string &actual)
+    {
+        return Result(Result::Ret::kDataSizeMismatch, summary.path + ": manifest " + field + " " + expected + ", actual " + actual);
+    };
+    try
+    {
+        if (manifestEntry.contains("entries") && manifestEntry["entries"].get<uint64_t>() != summary.entries)
+            return mismatch("entries", manifestEntry["entries"].dump(), std::to_string(summary.entries));
+        if (manifestEntry.contains("fileSize") && manifestEntry["fileSize"].get<uint64_t>() != summary.fileSize)
+            return mismatch("fileSize", manifestEntry["fileSize"].dump(), std::to_string(summary.fileSize));
+        if (manifestEntry.contains("smallestKey") && manifestEntry["smallestKey"].get<std::string>() != summary.smallestKey)
+            return mismatch("smallestKey", manifestEntry["smallestKey"].dump(), summary.smallestKey);
+        if (manifestEntry.contains("largestKey") && manifestEntry["largestKey"].get<std::string>() != summary.largestKey)
+            return mismatch("largestKey", manifestEntry["largestKey"].dump(), summary.largestKey);
+    }
+    catch (const std::exception &e)
+    {
+        return Result(Result::Ret::kConfigError, summary.path + ": invalid manifest entry: " + e.what());
+    }
+    return Result(Result::Ret::kOk, summary.path);
+}
+
+Result SstChecker::checkFiles(const std::vector<std::string> &paths, std::vector<SstFileSummary> &summaries) const
+{
+    summaries.assign(paths.size(), SstFileSummary());
+    if (paths.empty())
+        return Result(Result::Ret::kOk, "No sst files to check.");
+
+    // 大文件先提交，小文件填补空闲 worker
+    std::vector<size_t> order(paths.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::vector<uintmax_t> sizes(paths.size(), 0);
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        std::error_code ec;
+        sizes[i] = fs::file_size(paths[i], ec);
+    }
+    std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b)
+                     { return sizes[a] > sizes[b]; });
+
+    TaskScheduler scheduler(std::min(numThreads_, paths.size()));
+    TaskGroup group(scheduler);
+    for (size_t i : order)
+    {
+        group.run([this, &paths, &summaries, i]
+                  {
+                      Result res = checkFile(paths[i], summaries[i]);
+                      if (res.isError())
+                      {
+                          LOG_ERROR("SST check failed: " + res.message_raw());
+                      }
+                      return res; });
+    }
+    Result res = group.wait();
+    if (res.isError())
+        return res;
+    return Result(Result::Ret::kOk, std::to_string(paths.size()) + " SST files verified.");
+}
+
+json SstChecker::manifest(const std::vector<SstFileSummary> &summaries)
+{
+    json files = json::array();
+    for (const auto &summary : summaries)
+        files.push_back(summary.toJson());
+    return json{{"files", files}};
+}
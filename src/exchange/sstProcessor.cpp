@@ -1,27 +1,238 @@
 #include "exchange/sstProcessor.h"
 #include "exchange/JsonFileManager.h"
+#include "exchange/sstValidator.h"
+#include "exchange/workJournal.h"
+#include "utils/dirWatcher.h"
 #include "utils/compare.h"
+#include "utils/compression.h"
+#include "utils/klog.h"
+#include "utils/metrics.h"
+#include "utils/trace.h"
+#include "utils/sortDedup.h"
+#include "utils/workerBuffers.h"
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
 #include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <set>
 
 namespace fs = std::filesystem;
 
+namespace
+{
+    // 文件名自然序：数字段按数值比较，data_2 排在 data_10 之前，新生成的文件总是追加在末尾
+    bool naturalLess(const std::string &a, const std::string &b)
+    {
+        size_t i = 0, j = 0;
+        while (i < a.size() && j < b.size())
+        {
+            if (std::isdigit(static_cast<unsigned char>(a[i])) && std::isdigit(static_cast<unsigned char>(b[j])))
+            {
+                size_t ei = i, ej = j;
+                while (ei < a.size() && std::isdigit(static_cast<unsigned char>(a[ei])))
+                    ++ei;
+                while (ej < b.size() && std::isdigit(static_cast<unsigned char>(b[ej])))
+                    ++ej;
+                std::string na = a.substr(i, ei - i), nb = b.substr(j, ej - j);
+                na.erase(0, std::min(na.find_first_not_of('0'), na.size()));
+                nb.erase(0, std::min(nb.find_first_not_of('0'), nb.size()));
+                if (na.size() != nb.size())
+                    return na.size() < nb.size();
+                if (na != nb)
+                    return na < nb;
+                i = ei;
+                j = ej;
+            }
+            else
+            {
+                if (a[i] != b[j])
+                    return a[i] < b[j];
+                ++i;
+                ++j;
+            }
+        }
+        return a.size() - i < b.size() - j;
+    }
+
+    // 目录中的 KV 输入：*.json 及其压缩形式 *.json.gz / *.json.zst / *.json.lz4
+    bool isKvInput(const std::string &name)
+    {
+        return fs::path(stripCodecExtension(name)).extension() == ".json";
+    }
+
+    // 输入对应的输出文件名：data_1.json.zst -> data_1.sst（同名的压缩与未压缩输入会映射到同一个输出，不要混放）
+    std::string sstName(const std::string &name)
+    {
+        return fs::path(stripCodecExtension(name)).replace_extension(".sst").string();
+    }
+
+    // 一组一起转换的输入及其输出
+    struct ConvertTask
+    {
+        std::vector<std::string> inputs; // 相对 DEFAULTDIC
+        std::string output;              // 相对 DEFAULTDIC
+        uintmax_t bytes = 0;             // 输入总大小
+    };
+}
+
+std::string SstProcessor::partPath(const std::string &outputSstPath, size_t part)
+{
+    return sstPartPath(outputSstPath, part);
+}
+
+std::string SstProcessor::cfPath(const std::string &outputSstPath, size_t cf)
+{
+    fs::path path(outputSstPath);
+    return (path.parent_path() / (path.stem().string() + "." + pikaCfName(cf) + ".sst")).string();
+}
+
+std::string SstProcessor::manifestPath(const std::string &outputSstPath)
+{
+    fs::path path(outputSstPath);
+    return (path.parent_path() / (path.stem().string() + ".manifest.json")).string();
+}
+
+std::string SstProcessor::shardPath(const std::string &outputSstPath, size_t shard)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "shard_%04zu", shard);
+    fs::path path(outputSstPath);
+    return (path.parent_path() / name / path.filename()).string();
+}
+
+std::string SstProcessor::shardIndexPath(const std::string &outputSstPath)
+{
+    fs::path path(outputSstPath);
+    return (path.parent_path() / (path.stem().string() + ".shards.json")).string();
+}
+
+void SstProcessor::PendingOutput::discard()
+{
+    for (const auto &tempPath : tempPaths)
+        FilePublisher::discard(tempPath);
+    tempPaths.clear();
+    finalPaths.clear();
+}
+
 Result SstProcessor::processSstFile(JsonFileManagerBase *fileManager,
                                     const std::string &inputJsonPath,
                                     const std::string &outputSstPath)
 {
+    return processSstGroup(fileManager, {inputJsonPath}, outputSstPath);
+}
+
+Result SstProcessor::processSstGroup(JsonFileManagerBase *fileManager,
+                                     const std::vector<std::string> &inputJsonPaths,
+                                     const std::string &outputSstPath,
+                                     std::vector<std::string> *outputs)
+{
+    static MetricsCounter &crossDuplicates = metricsCounter("bingest_exchange_cross_file_duplicates_total", "entries dropped because another input holds a newer version of the key");
+
+    if (inputJsonPaths.empty())
+    {
+        return Result(Result::Ret::kInvalidParam, "no input for " + outputSstPath);
+    }
+    TRACE_SPAN_ARG("processSstFile", inputJsonPaths.front());
+
+    // 条目与 vector 取自当前线程的回收池，无论从哪个分支返回都还回去，下一个文件复用
+    WorkerBuffers &buffers = WorkerBuffers::local();
     DataType data;
-    std::string ac_inputJsonPath = DEFAULTDIC / inputJsonPath;
+    struct Recycle
+    {
+        WorkerBuffers &buffers;
+        DataType &data;
+        ~Recycle() { buffers.recycle(data); }
+    } recycle{buffers, data};
+    size_t crossDropped = 0;
     std::string ac_outputSstPath = DEFAULTDIC / outputSstPath;
-    try
+    for (const auto &inputJsonPath : inputJsonPaths)
     {
-        data = fileManager->parse(ac_inputJsonPath); // 使用传入的 fileManager 进行解析
+        std::string ac_inputJsonPath = DEFAULTDIC / inputJsonPath;
+        try
+        {
+            TRACE_SPAN("parse");
+            DataType part = fileManager->parse(ac_inputJsonPath); // 使用传入的 fileManager 进行解析
+            if (crossFileDedup_)
+            {
+                // 其他输入中有更新版本的 key 在这里丢弃，不进入本组的排序
+                size_t dropped = crossFileDedup_->filter(inputJsonPath, part);
+                crossDropped += dropped;
+                crossDuplicates.add(dropped);
+            }
+            if (data.empty())
+            {
+                data = std::move(part);
+            }
+            else
+            {
+                data.insert(data.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+                buffers.recycleVector(part);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            return Result(Result::Ret::kFileReadError, "JSON parse failed: " + std::string(e.what()));
+        }
     }
-    catch (const std::exception &e)
+    if (memoryBudget_)
+    {
+        // 解析缓冲区此时已释放，以最大的单个输入近似它在峰值中的份额
+        uintmax_t inputBytes = 0;
+        uintmax_t largest = 0;
+        for (const auto &inputJsonPath : inputJsonPaths)
+        {
+            std::error_code ec;
+            uintmax_t size = fs::file_size(DEFAULTDIC / inputJsonPath, ec);
+            inputBytes += ec ? 0 : size;
+            largest = std::max(largest, ec ? 0 : size);
+        }
+        memoryBudget_->observe(inputBytes, kvMemoryBytes(data) + largest);
+    }
+
+    // 过期判断基准在整组转换内固定，源摘要与写入使用同一时刻
+    uint32_t now = dropExpired_ ? unixNowSeconds() : 0;
+
+    if (shardFunction_)
     {
-        return Result(Result::Ret::kFileReadError, "JSON parse failed: " + std::string(e.what()));
+        return writeShards(data, ac_outputSstPath, now, outputs);
     }
 
+    PendingOutput pending;
+    pending.outputSstPath = ac_outputSstPath;
+    Result res = writeOutput(data, now, crossDropped, pending);
+    if (res.isError())
+    {
+        return res;
+    }
+    res = publishOutput(pending);
+    if (outputs && !res.isError())
+    {
+        outputs->clear();
+        for (const auto &path : pending.finalPaths)
+            outputs->push_back(fs::path(path).lexically_relative(DEFAULTDIC).string());
+    }
+    return res;
+}
+
+Result SstProcessor::writeOutput(DataType &data, uint32_t now, size_t crossDropped, PendingOutput &pending)
+{
+    static MetricsHistogram &sortLatency = metricsHistogram("bingest_exchange_sort_ns", "ComparePair sort latency per file");
+    static MetricsHistogram &dedupLatency = metricsHistogram("bingest_exchange_dedup_ns", "dedup latency per file");
+    static MetricsCounter &duplicates = metricsCounter("bingest_exchange_duplicates_total", "entries dropped by dedup");
+    static MetricsCounter &sortFiles = metricsCounter("bingest_exchange_dedup_sort_total", "groups sorted in full before dedup");
+    static MetricsCounter &mergeRunsFiles = metricsCounter("bingest_exchange_dedup_merge_runs_total", "groups made of a few sorted runs that were only merged");
+    static MetricsCounter &hashDedupFiles = metricsCounter("bingest_exchange_dedup_hash_total", "groups deduplicated by hash before sorting the survivors");
+    static MetricsCounter &expired = metricsCounter("bingest_exchange_expired_total", "entries dropped as already expired at conversion time");
+    static MetricsCounter &written = metricsCounter("bingest_exchange_sst_entries_total", "entries written to sst");
+
+    WorkerBuffers &buffers = WorkerBuffers::local();
+    const std::string &ac_outputSstPath = pending.outputSstPath;
+
     // 确保输出路径的父目录存在
     try
     {
@@ -39,49 +250,782 @@ Result SstProcessor::processSstFile(JsonFileManagerBase *fileManager,
         return Result(Result::Ret::kFileWriteError, "Failed to create directory: " + std::string(e.what()));
     }
 
-    // 创建 SstFileWriter
-    rocksdb::SstFileWriter writer(rocksdb::EnvOptions(), options_, cfh_);
+    // 抽样校验的源摘要必须在排序前、独立于 ComparePair 计算
+    SstValidator validator(options_, validateSamples_);
+    validator.setValueEncoder(encoder_);
+    validator.setExpireCutoff(now);
+    KvDigest expected;
+    DataType samples;
+    if (validateSamples_ > 0 && !layout_)
+    {
+        expected = validator.digestSource(data, &samples);
+    }
+
+    // 排序并去重：同一 key 只保留最新的一条。已排序或由少量升序段组成的输入只归并，重复多的无序输入先哈希去重再排序
+    DedupStrategy strategy = dedupStrategy_;
+    if (strategy == DedupStrategy::kAuto)
+    {
+        TRACE_SPAN("dedupPlan");
+        strategy = chooseDedupStrategy(data);
+    }
+    switch (strategy)
+    {
+    case DedupStrategy::kMergeRuns:
+        mergeRunsFiles.add();
+        break;
+    case DedupStrategy::kHash:
+        hashDedupFiles.add();
+        break;
+    default:
+        sortFiles.add();
+        break;
+    }
+    size_t beforeDedup = data.size();
+    if (strategy == DedupStrategy::kHash)
+    {
+        TRACE_SPAN("dedup");
+        ScopedLatency timer(dedupLatency);
+        hashDedup(data, &buffers.spare());
+    }
+    {
+        TRACE_SPAN("sort");
+        ScopedLatency timer(sortLatency);
+        if (strategy == DedupStrategy::kMergeRuns)
+            mergeRuns(data);
+        else
+            std::sort(data.begin(), data.end(), ComparePair());
+    }
+    if (strategy != DedupStrategy::kHash)
+    {
+        TRACE_SPAN("dedup");
+        ScopedLatency timer(dedupLatency);
+        dedupSorted(data, &buffers.spare());
+    }
+    duplicates.add(beforeDedup - data.size());
+
+    // 同一 key 的最新一条已过期时整个 key 都是死数据，在去重之后丢弃
+    if (dropExpired_)
+    {
+        size_t dropped = dropExpired(data, now, &buffers.spare());
+        expired.add(dropped);
+        if (data.empty() && dropped > 0)
+        {
+            pending.message = "All " + std::to_string(dropped) + " entries expired, no SST for " + ac_outputSstPath;
+            return Result(Result::Ret::kOk, pending.message);
+        }
+    }
+    if (data.empty() && crossDropped > 0)
+    {
+        pending.message = "All " + std::to_string(crossDropped) + " entries have newer versions in other inputs, no SST for " + ac_outputSstPath;
+        return Result(Result::Ret::kOk, pending.message);
+    }
+
+    // 写入临时文件，由 publishOutput 发布到最终路径
+    std::vector<std::string> &tempPaths = pending.tempPaths;
+    std::vector<std::string> &finalPaths = pending.finalPaths;
+    std::unique_ptr<MultiCfSstWriter> &cfWriter = pending.cfWriter;
+    Result res;
+    if (layout_)
+    {
+        // 一次遍历把每条记录路由到各 CF 的缓冲区，各 CF 的摘要在 MultiCfSstWriter 内部逐个比对
+        cfWriter = std::make_unique<MultiCfSstWriter>(
+            pikaCfSpecs(options_, {cfHandles_[kPikaMetaCf] != nullptr ? cfHandles_[kPikaMetaCf] : cfh_, cfHandles_[kPikaHashDataCf],
+                                   cfHandles_[kPikaSetDataCf], cfHandles_[kPikaListDataCf], cfHandles_[kPikaZSetDataCf],
+                                   cfHandles_[kPikaZSetScoreCf]}),
+            splitPolicy());
+        cfWriter->setValidate(validateSamples_ > 0);
+        {
+            TRACE_SPAN("layout");
+            // 每个输出一个版本号：同一集合 key 出现在多个输出中时，ingest 后只有生效 meta 对应的元素可见
+            uint64_t version = layout_->nextVersion();
+            CfData cfData;
+            for (const auto &entry : data)
+            {
+                layout_->append(entry, version, cfData);
+            }
+            buffers.recycle(data);
+            for (size_t cf = 0; cf < kPikaCfCount; ++cf)
+            {
+                cfWriter->addAll(cf, std::move(cfData[cf]));
+            }
+        }
+        res = cfWriter->write(scheduler_, numThreads_, [&](size_t cf)
+                              { return cfPath(ac_outputSstPath, cf); });
+        if (res.isError())
+        {
+            return res;
+        }
+        tempPaths = cfWriter->tempPaths();
+        finalPaths = cfWriter->finalPaths();
+        pending.entries = cfWriter->numEntries();
+    }
+    else
+    {
+        auto typed = std::find_if(data.begin(), data.end(), [](const KvEntry &entry)
+                                  { return entry.type != KvType::kString; });
+        if (typed != data.end())
+        {
+            return Result(Result::Ret::kInvalidParam, "key " + typed->key + " is a " + kvTypeName(typed->type) +
+                                                          " record, typed records need the pika layout");
+        }
+        res = writeSortedData(data, ac_outputSstPath, tempPaths, finalPaths, &pending.infos);
+        if (res.isError())
+        {
+            return res;
+        }
+        pending.entries = data.size();
+
+        // 校验临时文件，未通过的 SST 不会出现在最终路径
+        if (validateSamples_ > 0)
+        {
+            TRACE_SPAN("validate");
+            res = validator.verify(tempPaths, expected, samples);
+            if (res.isError())
+            {
+                pending.discard();
+                return res;
+            }
+        }
+    }
+    written.add(pending.entries);
+    return res;
+}
+
+Result SstProcessor::publishOutput(PendingOutput &pending)
+{
+    static MetricsCounter &files = metricsCounter("bingest_exchange_sst_files_total", "sst files created");
+    const std::string &ac_outputSstPath = pending.outputSstPath;
+    const std::vector<std::string> &finalPaths = pending.finalPaths;
+    if (finalPaths.empty())
+    {
+        removeStaleOutputs(ac_outputSstPath, {});
+        return Result(Result::Ret::kOk, pending.message);
+    }
+
+    Result res;
+    for (size_t i = 0; i < pending.tempPaths.size(); ++i)
+    {
+        res = publisher_->publish(pending.tempPaths[i], finalPaths[i]);
+        if (res.isError())
+        {
+            for (size_t j = i + 1; j < pending.tempPaths.size(); ++j)
+                FilePublisher::discard(pending.tempPaths[j]);
+            pending.tempPaths.clear();
+            return res;
+        }
+    }
+    pending.tempPaths.clear();
+    files.add(finalPaths.size());
+    if (pending.cfWriter || shardFunction_)
+    {
+        res = publishJson(manifestPath(ac_outputSstPath), outputManifest(pending));
+        if (res.isError())
+        {
+            return res;
+        }
+    }
+
+    // 重新转换后分片变少、或某个 CF 不再有条目时，删除上次运行留下的多余文件
+    removeStaleOutputs(ac_outputSstPath, finalPaths);
+
+    if (finalPaths.size() == 1)
+    {
+        return Result(Result::Ret::kOk, "SST file created successfully: " + finalPaths.front());
+    }
+    return Result(Result::Ret::kOk, std::to_string(finalPaths.size()) + " SST files created successfully: " +
+                                        finalPaths.front() + " ... " + finalPaths.back());
+}
+
+Result SstProcessor::writeSortedData(const DataType &data, const std::string &outputSstPath,
+                                     std::vector<std::string> &tempPaths, std::vector<std::string> &finalPaths,
+                                     std::vector<rocksdb::ExternalSstFileInfo> *infos)
+{
+    std::string value;
+    return writeSortedSst(
+        data.size(), [&](rocksdb::SstFileWriter &writer, size_t i)
+        {
+            value.clear();
+            encoder_->encode(data[i], value);
+            return writer.Put(data[i].key, value); },
+        options_, cfh_, splitPolicy(), outputSstPath, tempPaths, finalPaths, infos);
+}
+
+Result SstProcessor::writeShards(DataType &data, const std::string &outputSstPath, uint32_t now, std::vector<std::string> *outputs)
+{
+    static MetricsCounter &shardOutputs = metricsCounter("bingest_exchange_shard_outputs_total", "non-empty per-shard outputs written");
+    static MetricsHistogram &routeLatency = metricsHistogram("bingest_exchange_shard_route_ns", "time routing one group's entries to shards");
+
+    // 按分片路由，条目保持相对顺序；之后每个分片独立排序去重，同一 key 的所有版本总在同一分片
+    size_t numShards = shardFunction_->numShards();
+    std::vector<DataType> shards(numShards);
+    {
+        TRACE_SPAN("shard");
+        ScopedLatency timer(routeLatency);
+        std::vector<uint32_t> shardOf(data.size());
+        std::vector<size_t> counts(numShards);
+        for (size_t i = 0; i < data.size(); ++i)
+        {
+            shardOf[i] = shardFunction_->shardOf(data[i].key);
+            ++counts[shardOf[i]];
+        }
+        for (size_t shard = 0; shard < numShards; ++shard)
+            shards[shard].reserve(counts[shard]);
+        for (size_t i = 0; i < data.size(); ++i)
+            shards[shardOf[i]].push_back(std::move(data[i]));
+        WorkerBuffers::local().recycleVector(data);
+    }
+
+    std::vector<PendingOutput> pendings(numShards);
+    std::vector<size_t> nonEmpty;
+    for (size_t shard = 0; shard < numShards; ++shard)
+    {
+        pendings[shard].outputSstPath = shardPath(outputSstPath, shard);
+        pendings[shard].shard = shard;
+        if (!shards[shard].empty())
+            nonEmpty.push_back(shard);
+    }
+
+    // 各分片的排序、写入与校验作为子任务并行，全部成功后再并行发布各分片的 SST 与清单
+    auto forEachShard = [&](const std::vector<size_t> &targets, const std::function<Result(size_t)> &fn)
+    {
+        if (targets.empty())
+            return Result(Result::Ret::kOk);
+        std::unique_ptr<TaskScheduler> localScheduler;
+        TaskScheduler *scheduler = scheduler_;
+        if (scheduler == nullptr)
+        {
+            localScheduler = std::make_unique<TaskScheduler>(std::max<size_t>(1, std::min(numThreads_, targets.size())));
+            scheduler = localScheduler.get();
+        }
+        TaskGroup group(*scheduler);
+        for (size_t shard : targets)
+            group.run([&fn, shard]
+                      { return fn(shard); });
+        return group.wait();
+    };
+    Result res = forEachShard(nonEmpty, [&](size_t shard)
+                              {
+                                  TRACE_SPAN_ARG("writeShard", std::to_string(shard));
+                                  Result shardRes = writeOutput(shards[shard], now, 0, pendings[shard]);
+                                  WorkerBuffers::local().recycle(shards[shard]);
+                                  return shardRes; });
+    if (res.isError())
+    {
+        // 任一分片失败时整组都不发布
+        for (auto &pending : pendings)
+            pending.discard();
+        return res;
+    }
+
+    std::vector<size_t> all(numShards);
+    for (size_t shard = 0; shard < numShards; ++shard)
+        all[shard] = shard;
+    res = forEachShard(all, [&](size_t shard)
+                       { return publishOutput(pendings[shard]); });
+    if (res.isError())
+    {
+        for (auto &pending : pendings)
+            pending.discard();
+        return res;
+    }
+
+    // 分片索引最后发布，出现即表示这一组的所有分片都已完整
+    std::string baseDir = fs::path(outputSstPath).parent_path().string();
+    json index = {{"output", fs::path(outputSstPath).stem().string()}, {"shardFunction", shardFunction_->describe()}};
+    json shardList = json::array();
+    std::vector<std::string> finalPaths;
+    for (const auto &pending : pendings)
+    {
+        if (pending.finalPaths.empty())
+            continue;
+        shardList.push_back({{"shard", pending.shard},
+                             {"manifest", fs::path(manifestPath(pending.outputSstPath)).lexically_relative(baseDir).string()},
+                             {"entries", pending.entries},
+                             {"files", pending.finalPaths.size()}});
+        finalPaths.insert(finalPaths.end(), pending.finalPaths.begin(), pending.finalPaths.end());
+    }
+    shardOutputs.add(shardList.size());
+    index["shards"] = std::move(shardList);
+
+    std::error_code ec;
+    if (finalPaths.empty())
+    {
+        fs::remove(shardIndexPath(outputSstPath), ec);
+        if (outputs)
+            outputs->clear();
+        return Result(Result::Ret::kOk, "No entries left for any shard of " + outputSstPath);
+    }
+    res = publishJson(shardIndexPath(outputSstPath), index);
+    if (res.isError())
+    {
+        return res;
+    }
+    if (outputs)
+    {
+        outputs->clear();
+        for (const auto &path : finalPaths)
+            outputs->push_back(fs::path(path).lexically_relative(DEFAULTDIC).string());
+    }
+    return Result(Result::Ret::kOk, std::to_string(finalPaths.size()) + " SST files in " + std::to_string(index["shards"].size()) +
+                                        " shards created successfully: " + shardIndexPath(outputSstPath));
+}
+
+json SstProcessor::outputManifest(const PendingOutput &pending) const
+{
+    std::string baseDir = fs::path(pending.outputSstPath).parent_path().string();
+    json manifest;
+    if (pending.cfWriter)
+    {
+        manifest = pending.cfWriter->manifest(baseDir);
+    }
+    else
+    {
+        // 单 CF 输出使用与 Pika 布局相同的清单格式
+        json files = json::array();
+        for (size_t i = 0; i < pending.finalPaths.size() && i < pending.infos.size(); ++i)
+            files.push_back(sstFileManifest(pending.finalPaths[i], pending.infos[i], baseDir));
+        manifest = {{"columnFamilies", json::array({{{"name", cfh_ != nullptr ? cfh_->GetName() : rocksdb::kDefaultColumnFamilyName},
+                                                     {"comparator", options_.comparator->Name()},
+                                                     {"entries", pending.entries},
+                                                     {"files", std::move(files)}}})}};
+    }
+    manifest["output"] = fs::path(pending.outputSstPath).stem().string();
+    if (shardFunction_)
+    {
+        manifest["shard"] = pending.shard;
+        manifest["shardFunction"] = shardFunction_->describe();
+    }
+    return manifest;
+}
+
+Result SstProcessor::publishJson(const std::string &path, const json &content)
+{
+    std::string tempPath = FilePublisher::tempPath(path);
+    {
+        std::ofstream out(tempPath);
+        out << content.dump(4);
+        out.close();
+        if (!out)
+        {
+            FilePublisher::discard(tempPath);
+            return Result(Result::Ret::kFileWriteError, "Failed to write " + tempPath);
+        }
+    }
+    return publisher_->publish(tempPath, path);
+}
+
+void SstProcessor::removeStaleOutputs(const std::string &outputSstPath, const std::vector<std::string> &keep) const
+{
+    std::set<std::string> kept(keep.begin(), keep.end());
+    std::vector<std::string> bases;
+    if (layout_)
+    {
+        for (size_t cf = 0; cf < kPikaCfCount; ++cf)
+            bases.push_back(cfPath(outputSstPath, cf));
+    }
+    else
+    {
+        bases.push_back(outputSstPath);
+    }
+
+    std::error_code ec;
+    if ((layout_ || shardFunction_) && keep.empty())
+    {
+        fs::remove(manifestPath(outputSstPath), ec);
+    }
+    for (const auto &base : bases)
+    {
+        if (kept.count(base) == 0)
+            fs::remove(base, ec);
+        // 分片总是从 0 连续编号，保留的分片之后遇到第一个不存在的编号即停止
+        for (size_t part = 0; splitting(); ++part)
+        {
+            std::string path = partPath(base, part);
+            if (kept.count(path) == 0 && !fs::remove(path, ec))
+                break;
+        }
+    }
+}
+
+void SstProcessor::removeOutput(const std::string &outputSstPath) const
+{
+    if (shardFunction_)
+    {
+        std::error_code ec;
+        fs::remove(shardIndexPath(outputSstPath), ec);
+        for (size_t shard = 0; shard < shardFunction_->numShards(); ++shard)
+            removeStaleOutputs(shardPath(outputSstPath, shard), {});
+        return;
+    }
+    removeStaleOutputs(outputSstPath, {});
+}
+
+Result SstProcessor::mutiProcessSstFile(JsonFileManagerBase *fileManager, const std::string &inputDicPath,
+                                        const std::string &outputDicPath)
+{
+    fs::path inputDic = DEFAULTDIC / inputDicPath;
+    if (!fs::is_directory(inputDic))
+    {
+        return Result(Result::Ret::kInvalidParam, "Input directory not found: " + inputDic.string());
+    }
+
+    std::vector<std::pair<uintmax_t, std::string>> inputs;
+    for (const auto &entry : fs::directory_iterator(inputDic))
+    {
+        if (entry.is_regular_file() && isKvInput(entry.path().filename().string()))
+        {
+            inputs.emplace_back(entry.file_size(), entry.path().filename().string());
+        }
+    }
+    if (inputs.empty())
+    {
+        LOG_WARN("No json files found in " + inputDic.string());
+        return Result(Result::Ret::kOk, "No json files to process.");
+    }
+
+    // 分组：默认每个输入单独一组；切分模式下按自然序合并相邻的小输入，分组只取决于文件名与大小，重跑时保持稳定
+    std::sort(inputs.begin(), inputs.end(), [](const auto &a, const auto &b)
+              { return naturalLess(a.second, b.second); });
+    std::vector<ConvertTask> groups;
+    for (const auto &input : inputs)
+    {
+        bool coalesce = splitting() && targetFileSize_ > 0 && !groups.empty() &&
+                        groups.back().bytes + input.first <= targetFileSize_;
+        if (!coalesce)
+        {
+            groups.emplace_back();
+            groups.back().output = (fs::path(outputDicPath) / sstName(input.second)).string();
+        }
+        else
+        {
+            // 合并进前一组的输入没有自己的输出。分组随文件增减或大小变化而移动时，
+            // 以它命名的旧输出（含与新分组重复的 key）不在本次规划中，需要删除
+            removeOutput((DEFAULTDIC / outputDicPath / sstName(input.second)).string());
+        }
+        groups.back().inputs.push_back((fs::path(inputDicPath) / input.second).string());
+        groups.back().bytes += input.first;
+    }
+
+    static MetricsCounter &skipped = metricsCounter("bingest_exchange_skipped_files_total", "files skipped as already converted by the work journal");
+    size_t numSkipped = 0;
+    std::vector<ConvertTask> tasks;
+    for (auto &group : groups)
+    {
+        // 组内所有输入都已完成且未变化时跳过整组
+        bool done = journal_ != nullptr;
+        std::string output = (DEFAULTDIC / group.output).string();
+        for (size_t i = 0; done && i < group.inputs.size(); ++i)
+        {
+            done = journal_->upToDate(group.inputs[i], (DEFAULTDIC / group.inputs[i]).string(), output);
+        }
+        if (done)
+        {
+            numSkipped += group.inputs.size();
+            continue;
+        }
+        tasks.push_back(std::move(group));
+    }
+    skipped.add(numSkipped);
+    if (numSkipped > 0)
+    {
+        LOG_INFO(std::to_string(numSkipped) + " files already converted according to " + journal_->path());
+    }
 
-    auto status = writer.Open(ac_outputSstPath);
-    if (!status.ok())
+    // 跨文件去重预处理覆盖目录下全部输入（包括日志判定已完成的），胜者所在的输入可能已经转换过
+    if (crossFileDedupBits_ > 0 && !tasks.empty())
     {
-        return Result(Result::Ret::kFileWriteError, "Failed to open SST file: " + status.ToString());
+        std::vector<std::string> allInputs;
+        for (const auto &input : inputs)
+            allInputs.push_back((fs::path(inputDicPath) / input.second).string());
+        crossFileDedup_ = std::make_unique<CrossFileDedup>(crossFileDedupBits_);
+        TaskScheduler scheduler(std::min(numThreads_, allInputs.size()));
+        Result res = crossFileDedup_->build(fileManager, allInputs, scheduler);
+        if (res.isError())
+        {
+            crossFileDedup_.reset();
+            return res;
+        }
     }
 
-    // 先按 ComparePair 排序
-    std::sort(data.begin(), data.end(), ComparePair());
+    // 按输入大小从大到小提交，让大任务尽早开始，小任务填补空闲 worker
+    std::stable_sort(tasks.begin(), tasks.end(), [](const ConvertTask &a, const ConvertTask &b)
+                     { return a.bytes > b.bytes; });
+    size_t numInputs = 0;
+    Result res(Result::Ret::kOk);
+    if (!tasks.empty())
+    {
+        // Pika 布局下每个转换任务还会按 CF 拆出子任务，分片输出按分片拆出子任务，zstd 输入会按帧并行解压，这些情况调度器不按文件数收缩
+        bool compressed = std::any_of(tasks.begin(), tasks.end(), [](const ConvertTask &task)
+                                      { return std::any_of(task.inputs.begin(), task.inputs.end(), [](const std::string &input)
+                                                           { return codecFromPath(input) != Codec::kNone; }); });
+        TaskScheduler scheduler(layout_ || shardFunction_ || compressed ? numThreads_ : std::min(numThreads_, tasks.size()));
+        scheduler_ = &scheduler;
+        fileManager->setScheduler(&scheduler);
+        TaskGroup group(scheduler);
+        size_t window = scheduler.size();
+        for (size_t t = 0; t < tasks.size(); ++t)
+        {
+            numInputs += tasks[t].inputs.size();
+            // 任务开始时预读之后第 window 个任务的输入，读取与当前的转换重叠
+            const ConvertTask *next = t + window < tasks.size() ? &tasks[t + window] : nullptr;
+            // 预算不足时在这里等待已提交的任务结束，只有提交线程会阻塞
+            std::shared_ptr<MemoryReservation> reservation;
+            if (memoryBudget_)
+                reservation = std::make_shared<MemoryReservation>(memoryBudget_->reserve(memoryBudget_->estimate(tasks[t].bytes)));
+            group.run([this, fileManager, task = tasks[t], next, reservation]
+                      {
+                          if (next)
+                          {
+                              for (const auto &input : next->inputs)
+                                  fileManager->prefetch((DEFAULTDIC / input).string());
+                          }
+                          Result res = convertFile(fileManager, task.inputs, task.output);
+                          if (reservation)
+                              reservation->release();
+                          return res; });
+        }
+        res = group.wait();
+        fileManager->setScheduler(nullptr);
+        scheduler_ = nullptr;
+    }
+    crossFileDedup_.reset();
+    Result flushRes = publisher_->flush();
+    if (flushRes.isError() && !res.isError())
+    {
+        res = flushRes;
+    }
+    if (journal_)
+    {
+        // 保存 upToDate 中刷新的 mtime
+        journal_->save();
+    }
+    if (res.isError())
+    {
+        return res;
+    }
+    return Result(Result::Ret::kOk, std::to_string(numInputs) + " files converted into " + std::to_string(tasks.size()) +
+                                         " outputs in " + (DEFAULTDIC / outputDicPath).string() +
+                                         ", " + std::to_string(numSkipped) + " skipped");
+}
 
-    // 去重处理
-    std::vector<KvEntry> deduped;
-    for (size_t i = 0; i < data.size();)
+std::vector<std::string> SstProcessor::journalFiles(const std::string &outputPath, const std::vector<std::string> &outputs) const
+{
+    std::vector<std::string> files;
+    std::set<std::string> manifests;
+    std::string name = fs::path(outputPath).filename().string();
+    for (const auto &output : outputs)
+    {
+        fs::path path = DEFAULTDIC / output;
+        files.push_back(path.string());
+        // 分片输出时每个分片目录下各有一份与本组同名的清单
+        if (layout_ || shardFunction_)
+            manifests.insert(manifestPath((path.parent_path() / name).string()));
+    }
+    files.insert(files.end(), manifests.begin(), manifests.end());
+    if (shardFunction_ && !outputs.empty())
+        files.push_back(shardIndexPath((DEFAULTDIC / outputPath).string()));
+    return files;
+}
+
+Result SstProcessor::convertFile(JsonFileManagerBase *fileManager, const std::vector<std::string> &inputPaths, const std::string &outputPath)
+{
+    std::vector<std::string> outputs;
+    Result res = processSstGroup(fileManager, inputPaths, outputPath, &outputs);
+    if (res.isError())
+    {
+        LOG_ERROR("Failed to convert " + inputPaths.front() + ": " + res.message_raw());
+        return res;
+    }
+    if (journal_)
     {
-        deduped.push_back(data[i]);
-        // skip all with same key
-        size_t j = i + 1;
-        while (j < data.size() && data[j].key == data[i].key)
+        std::vector<std::pair<std::string, std::string>> inputs;
+        for (const auto &inputPath : inputPaths)
+            inputs.emplace_back(inputPath, (DEFAULTDIC / inputPath).string());
+        // 全部过期或被 -D 去掉时 outputs 为空，记录为空输出，重跑时不再重新转换
+        Result jres = journal_->record(inputs, (DEFAULTDIC / outputPath).string(), journalFiles(outputPath, outputs));
+        if (jres.isError())
         {
-            ++j;
+            LOG_WARN("Failed to record " + inputPaths.front() + " in work journal: " + jres.message_raw());
         }
-        i = j;
+    }
+    return res;
+}
+
+Result SstProcessor::watchSstFiles(JsonFileManagerBase *fileManager, const std::string &inputDicPath,
+                                   const std::string &outputDicPath, const std::atomic<bool> &stop,
+                                   std::chrono::milliseconds idleTimeout)
+{
+    static MetricsCounter &skipped = metricsCounter("bingest_exchange_skipped_files_total", "files skipped as already converted by the work journal");
+    fs::path inputDic = DEFAULTDIC / inputDicPath;
+    if (!fs::is_directory(inputDic))
+    {
+        return Result(Result::Ret::kInvalidParam, "Input directory not found: " + inputDic.string());
     }
 
-    // 写入去重后的数据
-    for (const auto &entry : deduped)
+    // 先建立 watch 再扫描已有文件，两者之间写完的文件不会漏掉（至多重复提交，由 running/journal 去重）
+    DirWatcher watcher(inputDic.string());
+    Result res = watcher.open();
+    if (res.isError())
     {
-        status = writer.Put(entry.key, entry.encodedValue());
-        if (!status.ok())
+        return res;
+    }
+    LOG_INFO("Watching " + inputDic.string() + " for finished kv files");
+
+    // 状态先于调度器声明，保证任务全部结束后才析构
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::set<std::string> running; // 已提交尚未结束的文件
+    std::set<std::string> rerun;   // 转换期间又被写完一次，结束后需要重做
+    std::set<std::string> failed;  // 最近一次转换失败的文件
+    size_t converted = 0;
+    size_t numSkipped = 0;
+    std::function<void(const std::string &, std::shared_ptr<MemoryReservation>)> submit;
+
+    // 按输入当前的大小预留内存；block 为 false 时立即预留，用于 worker 内的重新提交
+    auto reserveFor = [&](const std::string &name, bool block) -> std::shared_ptr<MemoryReservation>
+    {
+        if (!memoryBudget_)
+            return nullptr;
+        std::error_code ec;
+        uintmax_t size = fs::file_size(inputDic / name, ec);
+        uint64_t bytes = memoryBudget_->estimate(ec ? 0 : size);
+        return std::make_shared<MemoryReservation>(block ? memoryBudget_->reserve(bytes) : memoryBudget_->reserveNow(bytes));
+    };
+
+    TaskScheduler scheduler(numThreads_);
+    scheduler_ = &scheduler;
+    fileManager->setScheduler(&scheduler);
+    TaskGroup group(scheduler);
+    const size_t maxPending = 2 * scheduler.size();
+
+    // 调用方持有 mutex
+    submit = [&](const std::string &name, std::shared_ptr<MemoryReservation> reservation)
+    {
+        running.insert(name);
+        group.run([&, name, reservation]
+                  {
+                      std::string inputPath = (fs::path(inputDicPath) / name).string();
+                      std::string outputPath = (fs::path(outputDicPath) / sstName(name)).string();
+                      Result res = convertFile(fileManager, {inputPath}, outputPath);
+                      if (reservation)
+                          reservation->release();
+
+                      std::lock_guard<std::mutex> lock(mutex);
+                      running.erase(name);
+                      if (res.isError())
+                      {
+                          failed.insert(name);
+                      }
+                      else
+                      {
+                          failed.erase(name);
+                          ++converted;
+                      }
+                      if (rerun.erase(name) > 0)
+                      {
+                          submit(name, reserveFor(name, false));
+                      }
+                      cv.notify_all();
+                      return Result(Result::Ret::kOk); });
+    };
+
+    auto enqueue = [&](const std::string &name)
+    {
+        // 只处理 *.json（及其压缩形式），忽略隐藏文件与写入方的临时文件
+        if (name.empty() || name[0] == '.' || !isKvInput(name))
+            return;
+        std::unique_lock<std::mutex> lock(mutex);
+        if (running.count(name) > 0)
+        {
+            rerun.insert(name);
+            return;
+        }
+        lock.unlock();
+        std::string inputPath = (fs::path(inputDicPath) / name).string();
+        std::string outputPath = (fs::path(outputDicPath) / sstName(name)).string();
+        if (journal_ && journal_->upToDate(inputPath, (DEFAULTDIC / inputPath).string(), (DEFAULTDIC / outputPath).string()))
         {
-            writer.Finish().PermitUncheckedError();
-            return Result(Result::Ret::kFileWriteError, "Put failed: " + status.ToString());
+            skipped.add();
+            lock.lock();
+            ++numSkipped;
+            return;
         }
+        // 预算不足时在不持有 mutex 的情况下等待，让转换中的任务能够结束并释放
+        std::shared_ptr<MemoryReservation> reservation = reserveFor(name, true);
+        lock.lock();
+        cv.wait(lock, [&]
+                { return running.size() < maxPending; });
+        if (running.count(name) > 0)
+        {
+            rerun.insert(name);
+            return;
+        }
+        submit(name, reservation);
+    };
+
+    std::vector<std::pair<uintmax_t, std::string>> existing;
+    for (const auto &entry : fs::directory_iterator(inputDic))
+    {
+        if (entry.is_regular_file())
+        {
+            existing.emplace_back(entry.file_size(), entry.path().filename().string());
+        }
+    }
+    std::sort(existing.begin(), existing.end(), std::greater<>());
+    for (const auto &item : existing)
+    {
+        enqueue(item.second);
     }
 
-    // 完成 SST 写入
-    status = writer.Finish();
-    if (!status.ok())
+    auto lastActivity = std::chrono::steady_clock::now();
+    while (!stop.load(std::memory_order_acquire))
     {
-        return Result(Result::Ret::kFileWriteError, "Finish failed: " + status.ToString());
+        std::vector<std::string> names;
+        res = watcher.poll(std::chrono::milliseconds(200), names);
+        if (res.isError())
+        {
+            LOG_ERROR("Watch failed: " + res.message_raw());
+            break;
+        }
+        for (const auto &name : names)
+        {
+            enqueue(name);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!names.empty() || !running.empty())
+                lastActivity = now;
+        }
+        if (idleTimeout.count() > 0 && now - lastActivity >= idleTimeout)
+        {
+            LOG_INFO("No new kv files for " + std::to_string(idleTimeout.count()) + "ms, stop watching");
+            break;
+        }
     }
 
-    return Result(Result::Ret::kOk, "SST file created successfully: " + ac_outputSstPath);
+    group.wait();
+    fileManager->setScheduler(nullptr);
+    scheduler_ = nullptr;
+    Result flushRes = publisher_->flush();
+    if (journal_)
+    {
+        journal_->save();
+    }
+    if (res.isError())
+    {
+        return res;
+    }
+    if (flushRes.isError())
+    {
+        return flushRes;
+    }
+    std::string summary = std::to_string(converted) + " SST files created in " + (DEFAULTDIC / outputDicPath).string() +
+                          ", " + std::to_string(numSkipped) + " skipped";
+    if (!failed.empty())
+    {
+        return Result(Result::Ret::kFileWriteError, summary + ", " + std::to_string(failed.size()) + " failed (first: " + *failed.begin() + ")");
+    }
+    return Result(Result::Ret::kOk, summary);
 }
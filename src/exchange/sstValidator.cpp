@@ -0,0 +1,236 @@
+#include "exchange/sstValidator.h"
+#include "exchange/JsonFileManager.h"
+#include "rocksdb/sst_file_reader.h"
+#include "utils/metrics.h"
+#include "utils/trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string_view>
+#include <unordered_map>
+
+void KvDigest::add(const char *key, size_t keySize, const char *value, size_t valueSize)
+{
+    // value 的种子取自 key 的哈希，使 (key, value) 的切分方式参与哈希
+    Hash128 keyHash = murmurHash128(key, keySize);
+    Hash128 valueHash = murmurHash128(value, valueSize, keyHash.lo);
+    Hash128 h{valueHash.lo ^ keyHash.hi, valueHash.hi};
+
+    xorHash.lo ^= h.lo;
+    xorHash.hi ^= h.hi;
+    sumHash.lo += h.lo;
+    sumHash.hi += h.hi + (sumHash.lo < h.lo ? 1 : 0);
+    ++count;
+}
+
+void KvDigest::merge(const KvDigest &other)
+{
+    xorHash.lo ^= other.xorHash.lo;
+    xorHash.hi ^= other.xorHash.hi;
+    sumHash.lo += other.sumHash.lo;
+    sumHash.hi += other.sumHash.hi + (sumHash.lo < other.sumHash.lo ? 1 : 0);
+    count += other.count;
+}
+
+std::string KvDigest::toString() const
+{
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "count=%llu xor=%016llx%016llx sum=%016llx%016llx",
+                  static_cast<unsigned long long>(count),
+                  static_cast<unsigned long long>(xorHash.hi), static_cast<unsigned long long>(xorHash.lo),
+                  static_cast<unsigned long long>(sumHash.hi), static_cast<unsigned long long>(sumHash.lo));
+    return buf;
+}
+
+KvDigest SstValidator::digestSource(const DataType &data, DataType *samples) const
+{
+    TRACE_SPAN("digestSource");
+    std::unordered_map<std::string_view, const KvEntry *> newest;
+    newest.reserve(data.size());
+    for (const auto &entry : data)
+    {
+        auto it = newest.try_emplace(entry.key, &entry).first;
+        const KvEntry *cur = it->second;
+        if (entry.timestamp > cur->timestamp || (entry.timestamp == cur->timestamp && entry.value < cur->value))
+            it->second = &entry;
+    }
+
+    KvDigest digest;
+    std::mt19937_64 gen(seed_ != 0 ? seed_ : std::random_device{}());
+    size_t seen = 0;
+    if (samples)
+    {
+        samples->clear();
+        samples->reserve(std::min(numSamples_, newest.size()));
+    }
+    std::string encoded;
+    for (const auto &item : newest)
+    {
+        const KvEntry &entry = *item.second;
+        if (expireCutoff_ != 0 && isExpired(entry, expireCutoff_))
+            continue;
+        encoded.clear();
+        encoder_->encode(entry, encoded);
+        digest.add(entry.key, encoded);
+        if (!samples || numSamples_ == 0)
+            continue;
+        // 蓄水池抽样
+        if (seen < numSamples_)
+        {
+            samples->push_back(entry);
+        }
+        else
+        {
+            size_t slot = std::uniform_int_distribution<size_t>(0, seen)(gen);
+            if (slot < numSamples_)
+                (*samples)[slot] = entry;
+        }
+        ++seen;
+    }
+    return digest;
+}
+
+Result SstValidator::digestSst(const std::string &sstPath, KvDigest &digest) const
+{
+    TRACE_SPAN_ARG("digestSst", sstPath);
+    digest = KvDigest();
+    rocksdb::SstFileReader reader(options_);
+    rocksdb::Status status = reader.Open(sstPath);
+    if (!status.ok())
+        return Result(Result::Ret::kFileReadError, sstPath + ": open failed: " + status.ToString());
+
+    rocksdb::ReadOptions readOptions;
+    readOptions.fill_cache = false;
+    std::unique_ptr<rocksdb::Iterator> it(reader.NewIterator(readOptions));
+    for (it->SeekToFirst(); it->Valid(); it->Next())
+    {
+        rocksdb::Slice key = it->key();
+        rocksdb::Slice value = it->value();
+        digest.add(key.data(), key.size(), value.data(), value.size());
+    }
+    if (!it->status().ok())
+        return Result(Result::Ret::kFileReadError, sstPath + ": iterator error: " + it->status().ToString());
+    return Result(Result::Ret::kOk, sstPath);
+}
+
+Result SstValidator::lookupSamples(const std::string &sstPath, DataType samples) const
+{
+    TRACE_SPAN_ARG("lookupSamples", sstPath);
+    if (samples.empty())
+        return Result(Result::Ret::kOk, sstPath);
+
+    rocksdb::SstFileReader reader(options_);
+    rocksdb::Status status = reader.Open(sstPath);
+    if (!status.ok())
+        return Result(Result::Ret::kFileReadError, sstPath + ": open failed: " + status.ToString());
+
+    // 按 key 排序后依次 Seek，读取的 data block 单调前进
+    std::sort(samples.begin(), samples.end(), [](const KvEntry &a, const KvEntry &b)
+              { return a.key < b.key; });
+    std::unique_ptr<rocksdb::Iterator> it(reader.NewIterator(rocksdb::ReadOptions()));
+    for (const auto &sample : samples)
+    {
+        it->Seek(sample.key);
+        if (!it->Valid() || it->key() != rocksdb::Slice(sample.key))
+        {
+            if (!it->status().ok())
+                return Result(Result::Ret::kFileReadError, sstPath + ": iterator error: " + it->status().ToString());
+            return Result(Result::Ret::kDataSizeMismatch, sstPath + ": sampled key '" + sample.key + "' not found");
+        }
+        if (!encoder_->matches(sample, it->value().data(), it->value().size()))
+            return Result(Result::Ret::kDataSizeMismatch, sstPath + ": sampled key '" + sample.key + "' has a stale or wrong value");
+    }
+    return Result(Result::Ret::kOk, sstPath);
+}
+
+Result SstValidator::verify(const std::string &sstPath, const KvDigest &expected, const DataType &samples) const
+{
+    static MetricsHistogram &validateLatency = metricsHistogram("bingest_validate_ns", "SstValidator::verify latency per file");
+    static MetricsCounter &failures = metricsCounter("bingest_validate_failures_total", "sst files failing round-trip validation");
+    ScopedLatency timer(validateLatency);
+
+    KvDigest actual;
+    Result res = digestSst(sstPath, actual);
+    if (!res.isError() && actual != expected)
+    {
+        res = Result(Result::Ret::kDataSizeMismatch, sstPath + ": digest mismatch, source " + expected.toString() +
+                                                         ", sst " + actual.toString());
+    }
+    if (!res.isError())
+        res = lookupSamples(sstPath, samples);
+    if (res.isError())
+        failures.add();
+    return res;
+}
+
+Result SstValidator::verify(const std::vector<std::string> &sstPaths, const KvDigest &expected, const DataType &samples) const
+{
+    static MetricsHistogram &validateLatency = metricsHistogram("bingest_validate_ns", "SstValidator::verify latency per file");
+    static MetricsCounter &failures = metricsCounter("bingest_validate_failures_total", "sst files failing round-trip validation");
+    if (sstPaths.size() == 1)
+        return verify(sstPaths.front(), expected, samples);
+    ScopedLatency timer(validateLatency);
+
+    KvDigest actual;
+    Result res(Result::Ret::kOk);
+    for (const auto &path : sstPaths)
+    {
+        KvDigest part;
+        res = digestSst(path, part);
+        if (res.isError())
+            break;
+        actual.merge(part);
+    }
+    if (!res.isError() && actual != expected)
+    {
+        res = Result(Result::Ret::kDataSizeMismatch, sstPaths.front() + " (+" + std::to_string(sstPaths.size() - 1) +
+                                                         " parts): digest mismatch, source " + expected.toString() +
+                                                         ", sst " + actual.toString());
+    }
+
+    // 各文件 key 区间互不重叠且依次递增，按每个文件的最大 key 分配样本
+    for (size_t i = 0; i < sstPaths.size() && !res.isError(); ++i)
+    {
+        rocksdb::SstFileReader reader(options_);
+        rocksdb::Status status = reader.Open(sstPaths[i]);
+        if (!status.ok())
+        {
+            res = Result(Result::Ret::kFileReadError, sstPaths[i] + ": open failed: " + status.ToString());
+            break;
+        }
+        std::unique_ptr<rocksdb::Iterator> it(reader.NewIterator(rocksdb::ReadOptions()));
+        it->SeekToLast();
+        std::string largest = it->Valid() ? it->key().ToString() : std::string();
+        it->SeekToFirst();
+        std::string smallest = it->Valid() ? it->key().ToString() : std::string();
+        bool last = i + 1 == sstPaths.size();
+
+        DataType partSamples;
+        for (const auto &sample : samples)
+        {
+            if ((i == 0 || sample.key >= smallest) && (last || sample.key <= largest))
+                partSamples.push_back(sample);
+        }
+        res = lookupSamples(sstPaths[i], std::move(partSamples));
+    }
+    if (res.isError())
+        failures.add();
+    return res;
+}
+
+Result SstValidator::validate(JsonFileManagerBase *fileManager, const std::string &jsonPath, const std::string &sstPath) const
+{
+    DataType data;
+    try
+    {
+        data = fileManager->parse(jsonPath);
+    }
+    catch (const std::exception &e)
+    {
+        return Result(Result::Ret::kFileReadError, "JSON parse failed: " + std::string(e.what()));
+    }
+    DataType samples;
+    KvDigest expected = digestSource(data, &samples);
+    return verify(sstPath, expected, samples);
+}
@@ -0,0 +1,377 @@
+#include "exchange/workJournal.h"
+#include "exchange/multiCfSstWriter.h"
+#include "utils/filePublisher.h"
+#include "utils/hash.h"
+#include "utils/klog.h"
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // hi 在前、各自按大端排列，与日志中已有的哈希格式相同
+    std::string toHex(const Hash128 &h)
+    {
+        std::string bytes(16, '\0');
+        for (int i = 0; i < 8; ++i)
+        {
+            bytes[i] = static_cast<char>(h.hi >> (56 - 8 * i));
+            bytes[8 + i] = static_cast<char>(h.lo >> (56 - 8 * i));
+        }
+        return ::toHex(bytes);
+    }
+
+    bool statFile(const std::string &path, uint64_t &size, int64_t &mtime)
+    {
+        std::error_code ec;
+        size = fs::file_size(path, ec);
+        if (ec)
+            return false;
+        auto time = fs::last_write_time(path, ec);
+        if (ec)
+            return false;
+        mtime = static_cast<int64_t>(time.time_since_epoch().count());
+        return true;
+    }
+
+    bool writeAll(int fd, const std::string &content)
+    {
+        size_t written = 0;
+        while (written < content.size())
+        {
+            ssize_t n = ::write(fd, content.data() + written, content.size() - written);
+            if (n < 0)
+                return false;
+            written += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // 新建或 rename 后的目录项落盘需要 fsync 所在目录
+    void syncParentDir(const fs::path &path)
+    {
+        std::string dir = path.has_parent_path() ? path.parent_path().string() : ".";
+        int dirFd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (dirFd >= 0)
+        {
+            ::fsync(dirFd);
+            ::close(dirFd);
+        }
+    }
+}
+
+json JournalEntry::toJson() const
+{
+    json outputs = json::array();
+    for (const auto &file : files)
+        outputs.push_back({{"path", file.path}, {"size", file.size}, {"mtime", file.mtime}, {"hash", file.hash}});
+    return json{{"size", size},
+                {"mtime", mtime},
+                {"hash", hash},
+                {"output", output},
+                {"files", outputs}};
+}
+
+JournalEntry JournalEntry::fromJson(const json &j)
+{
+    JournalEntry entry;
+    entry.size = j.at("size").get<uint64_t>();
+    entry.mtime = j.at("mtime").get<int64_t>();
+    entry.hash = j.at("hash").get<std::string>();
+    entry.output = j.value("output", "");
+    if (j.contains("files"))
+    {
+        for (const auto &item : j.at("files"))
+        {
+            JournalOutput file;
+            file.path = item.at("path").get<std::string>();
+            file.size = item.at("size").get<uint64_t>();
+            file.mtime = item.value("mtime", int64_t(0));
+            file.hash = item.at("hash").get<std::string>();
+            entry.files.push_back(std::move(file));
+        }
+    }
+    else if (j.contains("outputHash"))
+    {
+        // 旧版日志只记录一个输出文件
+        JournalOutput file;
+        file.path = entry.output;
+        file.size = j.value("outputSize", uint64_t(0));
+        file.mtime = j.value("outputMtime", int64_t(0));
+        file.hash = j.value("outputHash", "");
+        entry.files.push_back(std::move(file));
+    }
+    return entry;
+}
+
+WorkJournal::~WorkJournal()
+{
+    if (logFd_ >= 0)
+        ::close(logFd_);
+}
+
+Result WorkJournal::load()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    std::ifstream in(path_);
+    if (in)
+    {
+        try
+        {
+            json j;
+            in >> j;
+            for (const auto &item : j.at("files").items())
+                entries_[item.key()] = JournalEntry::fromJson(item.value());
+        }
+        catch (const std::exception &e)
+        {
+            entries_.clear();
+            return Result(Result::Ret::kConfigError, "invalid work journal " + path_ + ": " + e.what());
+        }
+    }
+
+    // 重放上次 save() 之后追加的记录；写了一半的行（进程在追加时退出）跳过
+    std::ifstream log(logPath());
+    if (!in && !log)
+    {
+        LOG_DEBUG("Work journal not found, starting fresh: " + path_);
+        return Result(Result::Ret::kOk, path_);
+    }
+    std::string line;
+    while (std::getline(log, line))
+    {
+        if (line.empty())
+            continue;
+        try
+        {
+            json j = json::parse(line);
+            entries_[j.at("input").get<std::string>()] = JournalEntry::fromJson(j);
+        }
+        catch (const std::exception &e)
+        {
+            LOG_WARN("Ignoring damaged record in " + logPath() + ": " + e.what());
+        }
+    }
+    return Result(Result::Ret::kOk, path_);
+}
+
+Result WorkJournal::save() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return saveLocked();
+}
+
+Result WorkJournal::saveLocked() const
+{
+    json files = json::object();
+    for (const auto &item : entries_)
+        files[item.first] = item.second.toJson();
+    std::string content = json{{"version", 1}, {"files", files}}.dump(4);
+
+    fs::path target(path_);
+    if (target.has_parent_path())
+    {
+        std::error_code ec;
+        fs::create_directories(target.parent_path(), ec);
+    }
+    // 快照 fsync 后 rename 并 fsync 目录，确认落盘后才能清空增量日志
+    Result res = FilePublisher::writeFile(path_, content, true);
+    if (res.isError())
+        return res;
+
+    // 快照已包含 .log 中的全部记录；先落盘快照再清空，中间退出时重放也是幂等的
+    if (logFd_ >= 0)
+    {
+        if (::ftruncate(logFd_, 0) != 0)
+            return Result(Result::Ret::kFileWriteError, logPath());
+    }
+    else
+    {
+        ::unlink(logPath().c_str());
+    }
+    return Result(Result::Ret::kOk, path_);
+}
+
+bool WorkJournal::upToDate(const std::string &input, const std::string &inputPath, const std::string &outputPath)
+{
+    JournalEntry entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(input);
+        if (it == entries_.end())
+            return false;
+        entry = it->second;
+    }
+
+    // 输入重新分组后，旧记录描述的是另一个输出
+    if (entry.output != outputPath)
+        return false;
+
+    // 只有 mtime 变了（例如被 touch、重新拷贝，或输出被同样大小的文件替换），比较内容
+    bool touched = false;
+    auto unchanged = [&touched](const std::string &path, uint64_t expectedSize, int64_t &expectedMtime, const std::string &expectedHash)
+    {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        if (!statFile(path, size, mtime) || size != expectedSize)
+            return false;
+        if (mtime == expectedMtime)
+            return true;
+        std::string hash;
+        if (hashFile(path, hash).isError() || hash != expectedHash)
+            return false;
+        expectedMtime = mtime;
+        touched = true;
+        return true;
+    };
+    if (!unchanged(inputPath, entry.size, entry.mtime, entry.hash))
+        return false;
+    for (auto &file : entry.files)
+    {
+        if (!unchanged(file.path, file.size, file.mtime, file.hash))
+            return false;
+    }
+    if (!touched)
+        return true;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(input);
+    if (it != entries_.end())
+        it->second = std::move(entry);
+    return true;
+}
+
+Result WorkJournal::record(const std::string &input, const std::string &inputPath, const std::string &outputPath)
+{
+    return record({{input, inputPath}}, outputPath, {outputPath});
+}
+
+Result WorkJournal::record(const std::vector<std::pair<std::string, std::string>> &inputs, const std::string &outputPath,
+                           const std::vector<std::string> &files)
+{
+    // 哈希在锁外计算，每个输出文件只哈希一次
+    JournalEntry output;
+    output.output = outputPath;
+    Result res(Result::Ret::kOk);
+    for (const auto &path : files)
+    {
+        JournalOutput file;
+        file.path = path;
+        if (!statFile(path, file.size, file.mtime))
+            return Result(Result::Ret::kFileReadError, path);
+        res = hashFile(path, file.hash);
+        if (res.isError())
+            return res;
+        output.files.push_back(std::move(file));
+    }
+
+    std::vector<std::pair<std::string, JournalEntry>> records;
+    std::string lines;
+    for (const auto &input : inputs)
+    {
+        JournalEntry entry = output;
+        if (!statFile(input.second, entry.size, entry.mtime))
+            return Result(Result::Ret::kFileReadError, input.second);
+        res = hashFile(input.second, entry.hash);
+        if (res.isError())
+            return res;
+        json line = entry.toJson();
+        line["input"] = input.first;
+        lines += line.dump() + "\n";
+        records.emplace_back(input.first, std::move(entry));
+    }
+
+    int fd = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (logFd_ < 0)
+        {
+            fs::path target(path_);
+            if (target.has_parent_path())
+            {
+                std::error_code ec;
+                fs::create_directories(target.parent_path(), ec);
+            }
+            logFd_ = ::open(logPath().c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+            if (logFd_ < 0)
+                return Result(Result::Ret::kFileOpenError, logPath());
+            syncParentDir(logPath());
+        }
+        if (!writeAll(logFd_, lines))
+            return Result(Result::Ret::kFileWriteError, logPath());
+        for (auto &record : records)
+            entries_[record.first] = std::move(record.second);
+        fd = logFd_;
+    }
+    // 在锁外落盘，并发的记录可以共用同一次 fdatasync
+    if (::fdatasync(fd) != 0)
+        return Result(Result::Ret::kFileWriteError, logPath());
+    return Result(Result::Ret::kOk, path_);
+}
+
+void WorkJournal::forget(const std::string &input)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.erase(input);
+}
+
+bool WorkJournal::contains(const std::string &input) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.count(input) > 0;
+}
+
+std::vector<std::string> WorkJournal::inputsOf(const std::string &file) const
+{
+    std::error_code ec;
+    fs::path target = fs::weakly_canonical(file, ec);
+    if (ec)
+        target = fs::path(file).lexically_normal();
+    std::vector<std::string> inputs;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &item : entries_)
+    {
+        for (const auto &output : item.second.files)
+        {
+            fs::path path = fs::weakly_canonical(output.path, ec);
+            if ((ec ? fs::path(output.path).lexically_normal() : path) == target)
+            {
+                inputs.push_back(item.first);
+                break;
+            }
+        }
+    }
+    return inputs;
+}
+
+size_t WorkJournal::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+Result WorkJournal::hashFile(const std::string &path, std::string &hex)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return Result(Result::Ret::kFileOpenError, path);
+    std::vector<char> buf(1 << 20);
+    Hash128 h;
+    while (in)
+    {
+        in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+        std::streamsize n = in.gcount();
+        if (n <= 0)
+            break;
+        h = murmurHash128(buf.data(), static_cast<size_t>(n), h.lo ^ h.hi);
+    }
+    if (in.bad())
+        return Result(Result::Ret::kFileReadError, path);
+    hex = toHex(h);
+    return Result(Result::Ret::kOk, path);
+}
@@ -5,12 +5,15 @@
 #include <thread>
 #include <filesystem>
 #include "utils/klog.h"
-#include <ThreadPool.h>
 #include <shared_mutex>
 #include <vector>
 #include <unordered_map>
 #include "mock/fileManager.h"
 #include "utils/compare.h"
+#include "utils/hash.h"
+#include "utils/metrics.h"
+#include "utils/trace.h"
+#include "utils/workerBuffers.h"
 
 namespace fs = std::filesystem;
 
@@ -54,6 +57,40 @@ Result DataGen::loadConfig(const std::string &configFilePath)
     valuePrefix_ = config_["valuePrefix"];
     maxFileSizeMB_ = config_["maxFileSizeMB"];
     approxEntrySizeKB_ = config_["approxEntrySizeKB"];
+    pinThreads_ = config_.value("pinThreads", false);
+    numaAware_ = config_.value("numaAware", false);
+    subTaskEntries_ = std::max<size_t>(1, config_.value("subTaskEntries", subTaskEntries_));
+    collectionSize_ = std::max<size_t>(1, config_.value("collectionSize", collectionSize_));
+    typeCdf_.clear();
+    if (config_.contains("typeRatios"))
+    {
+        // {"string": 0.6, "hash": 0.2, ...}：按权重归一化为累积分布，未列出的类型权重为 0
+        std::vector<double> weights(kNumKvTypes, 0.0);
+        double total = 0;
+        for (const auto &item : config_["typeRatios"].items())
+        {
+            KvType type;
+            double weight = item.value().get<double>();
+            if (!parseKvType(item.key(), type) || weight < 0)
+            {
+                LOG_ERROR("Invalid type ratio: " + item.key());
+                return Result(Result::Ret::kConfigError, "Invalid type ratio: " + item.key());
+            }
+            weights[static_cast<size_t>(type)] = weight;
+            total += weight;
+        }
+        if (total <= 0)
+        {
+            LOG_ERROR("Type ratios must not all be zero.");
+            return Result(Result::Ret::kConfigError, "Type ratios must not all be zero.");
+        }
+        double sum = 0;
+        for (double weight : weights)
+        {
+            sum += weight / total;
+            typeCdf_.push_back(sum);
+        }
+    }
     if (maxFileSizeMB_ <= 0 || approxEntrySizeKB_ <= 0)
     {
         LOG_ERROR("Max file size and approx entry size must be greater than zero.");
@@ -76,72 +113,231 @@ Result DataGen::generateData()
               " MB, Total files to generate: " + std::to_string(totalFiles) +
               ", Remainder: " + std::to_string(remainder) + " MB.");
 
-    // 创建线程池
-    ThreadPool pool(numThreads_);
+    // 创建工作窃取调度器，generateFile 会把大文件拆成子任务交给同一个调度器
+    TaskScheduler scheduler(numThreads_, pinThreads_, numaAware_);
+    scheduler_ = &scheduler;
 
     LOG_DEBUG("numThreads: " + std::to_string(numThreads_));
 
-    // 提交文件生成任务到线程池
+    TaskGroup group(scheduler);
+    // 预算不足时在这里等待已提交的文件写完，只有提交线程会阻塞
+    auto submit = [&](double fileSizeMB)
+    {
+        std::shared_ptr<MemoryReservation> reservation;
+        if (memoryBudget_)
+            reservation = std::make_shared<MemoryReservation>(memoryBudget_->reserve(memoryBudget_->estimate(static_cast<uint64_t>(fileSizeMB * (1 << 20)))));
+        group.run([this, fileSizeMB, reservation]
+                  {
+                      Result res = this->generateFile(fileSizeMB);
+                      if (reservation)
+                          reservation->release();
+                      return res; });
+    };
+    // 提交文件生成任务
     for (size_t i = 1; i < totalFiles; ++i)
     {
-        pool.enqueue([this, perFileDataSize]
-                     { this->generateFile(perFileDataSize); });
+        submit(perFileDataSize);
     }
 
-    // 最后一个线程处理 remainder
-    pool.enqueue([this, perFileDataSize, remainder]
-                 { this->generateFile(perFileDataSize + remainder); });
+    // 最后一个任务处理 remainder
+    submit(perFileDataSize + remainder);
 
+    Result res = group.wait();
+    scheduler_ = nullptr;
+    if (res.isError())
+    {
+        LOG_ERROR("Data generation failed: " + res.message());
+        return res;
+    }
+    res = fileManager_->flush();
+    if (res.isError())
+    {
+        LOG_ERROR("Failed to flush generated files: " + res.message());
+        return res;
+    }
     return Result(Result::Ret::kOk, "Data generation completed successfully.");
 }
 
 // 生成指定大小的文件
 Result DataGen::generateFile(size_t fileSize)
 {
-    DataType data;
+    static MetricsHistogram &generateLatency = metricsHistogram("bingest_mock_generate_file_ns", "DataGen::generateFile latency (generate + sort + write)");
+    static MetricsHistogram &writeLatency = metricsHistogram("bingest_mock_write_ns", "FileManagerBase::write latency per file");
+    static MetricsCounter &entries = metricsCounter("bingest_mock_entries_total", "entries generated");
+    static MetricsCounter &files = metricsCounter("bingest_mock_files_total", "files written");
+    ScopedLatency timer(generateLatency);
+    TRACE_SPAN("generateFile");
+
+    // 条目与 vector 取自当前线程的回收池，写完后还回去，下一个文件复用
+    WorkerBuffers &buffers = WorkerBuffers::local();
+    DataType data = buffers.takeVector();
+    struct Recycle
+    {
+        WorkerBuffers &buffers;
+        DataType &data;
+        ~Recycle() { buffers.recycle(data); }
+    } recycle{buffers, data};
     Result res;
 
     size_t numEntries = fileSize * 1024 / approxEntrySizeKB_; // 计算每个文件需要多少条数据
 
-    // 为每个线程创建独立的随机生成器和分布器
-    std::random_device rd;
-    std::mt19937 gen(rd());                                             // 线程局部随机数生成器
-    std::uniform_int_distribution<size_t> dist(0, keyPool_.size() - 1); // 线程局部分布器
-
-    for (size_t i = 0; i < numEntries; ++i)
+    if (scheduler_ != nullptr && numEntries > subTaskEntries_)
     {
-        KvEntry entry;
-        try
+        // 大文件拆分为多个子任务并行生成，各自排序后再归并，避免 remainder 文件拖慢整体
+        size_t numParts = (numEntries + subTaskEntries_ - 1) / subTaskEntries_;
+        std::vector<DataType> parts(numParts);
+        TaskGroup group(*scheduler_);
+        for (size_t p = 0; p < numParts; ++p)
         {
-            entry.key = generateKey().message_raw(); // 你要确保返回的是 string
-            entry.value = valuePrefix_ + std::to_string(dist(gen));
-            entry.timestamp = generateRandomTimestamp();
-            data.emplace_back(entry);
+            size_t count = std::min(subTaskEntries_, numEntries - p * subTaskEntries_);
+            group.run([this, &parts, p, count]
+                      { return this->generateEntries(count, parts[p]); });
         }
-        catch (const std::exception &e)
+        res = group.wait();
+        if (res.isError())
         {
-            LOG_ERROR("Failed to generate key: " + std::string(e.what()));
-            rebuildKeyPool(); // 如果发生异常，重新初始化键池
-            --i;              // 重试当前条目
+            return res;
+        }
+
+        TRACE_SPAN("merge");
+        data.reserve(numEntries);
+        for (auto &part : parts)
+        {
+            size_t mid = data.size();
+            data.insert(data.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+            std::inplace_merge(data.begin(), data.begin() + mid, data.end(), ComparePair());
+            buffers.recycleVector(part);
+        }
+    }
+    else
+    {
+        res = generateEntries(numEntries, data);
+        if (res.isError())
+        {
+            return res;
         }
     }
 
-    std::sort(data.begin(), data.end(), ComparePair());
+    if (memoryBudget_)
+    {
+        // 拆分生成时归并期间各部分与合并结果同时存在，按两倍计
+        size_t peak = kvMemoryBytes(data) * (numEntries > subTaskEntries_ ? 2 : 1);
+        memoryBudget_->observe(static_cast<uint64_t>(fileSize) << 20, peak);
+    }
 
     if (data.empty())
     {
         LOG_WARN("No data generated for file, skipping write.");
         return Result(Result::Ret::kOk, "No data generated for file.");
     }
-    res = fileManager_->write(data);
+    entries.add(data.size());
+    {
+        TRACE_SPAN("write");
+        ScopedLatency writeTimer(writeLatency);
+        res = fileManager_->write(data);
+    }
     if (res.isError())
     {
         LOG_ERROR("File write error : " + res.message());
         return Result(Result::Ret::kFileWriteError, res.message());
     }
+    files.add();
     return Result(Result::Ret::kOk, "File generated successfully.");
 }
 
+Result DataGen::generateEntries(size_t numEntries, DataType &data)
+{
+    data.reserve(data.size() + numEntries);
+    WorkerBuffers &buffers = WorkerBuffers::local();
+
+    // 为每个线程创建独立的随机生成器和分布器
+    std::random_device rd;
+    std::mt19937 gen(rd());                                             // 线程局部随机数生成器
+    std::uniform_int_distribution<size_t> dist(0, keyPool_.size() - 1); // 线程局部分布器
+
+    {
+        TRACE_SPAN("generate");
+        for (size_t i = 0; i < numEntries; ++i)
+        {
+            // 复用回收池中条目的字符串容量
+            KvEntry entry = buffers.takeEntry();
+            try
+            {
+                entry.key = generateKey().message_raw(); // 你要确保返回的是 string
+                entry.type = pickType(entry.key);
+                if (entry.type == KvType::kString)
+                {
+                    entry.value.assign(valuePrefix_);
+                    entry.value.append(std::to_string(dist(gen)));
+                }
+                else
+                    fillCollection(entry, gen);
+                entry.timestamp = generateRandomTimestamp();
+                data.push_back(std::move(entry));
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR("Failed to generate key: " + std::string(e.what()));
+                rebuildKeyPool(); // 如果发生异常，重新初始化键池
+                --i;              // 重试当前条目
+            }
+        }
+    }
+
+    {
+        TRACE_SPAN("sort");
+        std::sort(data.begin(), data.end(), ComparePair());
+    }
+    return Result(Result::Ret::kOk, "Entries generated.");
+}
+
+KvType DataGen::pickType(const std::string &key) const
+{
+    if (typeCdf_.empty())
+        return KvType::kString;
+    // 由 key 的哈希决定类型，同一个 key 在所有文件中类型相同，与 Redis / Pika 中一个 key 只有一种类型一致
+    double u = static_cast<double>(murmurHash128(key.data(), key.size()).lo >> 11) * 0x1.0p-53;
+    for (size_t i = 0; i < typeCdf_.size(); ++i)
+    {
+        if (u < typeCdf_[i])
+            return static_cast<KvType>(i);
+    }
+    return static_cast<KvType>(typeCdf_.size() - 1);
+}
+
+void DataGen::fillCollection(KvEntry &entry, std::mt19937 &gen) const
+{
+    // 元素个数在 [1, 2 * collectionSize_ - 1] 内均匀分布，均值为 collectionSize_
+    std::uniform_int_distribution<size_t> sizeDist(1, 2 * collectionSize_ - 1);
+    std::uniform_int_distribution<size_t> valueDist(0, keyPoolSize_);
+    std::uniform_real_distribution<double> scoreDist(0.0, 1000.0);
+    size_t n = sizeDist(gen);
+    entry.fields.clear();
+    entry.fields.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        KvField field;
+        switch (entry.type)
+        {
+        case KvType::kHash:
+            field.name = "field_" + std::to_string(i);
+            field.value = valuePrefix_ + std::to_string(valueDist(gen));
+            break;
+        case KvType::kSet:
+            field.name = "member_" + std::to_string(valueDist(gen));
+            break;
+        case KvType::kZSet:
+            field.name = "member_" + std::to_string(i);
+            field.score = scoreDist(gen);
+            break;
+        default:
+            field.value = valuePrefix_ + std::to_string(valueDist(gen));
+            break;
+        }
+        entry.fields.push_back(std::move(field));
+    }
+}
+
 // 随机从键池中选择一个键
 Result DataGen::generateKey()
 {
@@ -154,7 +350,7 @@ Result DataGen::generateKey()
 
     std::mt19937 gen(std::random_device{}());
     std::uniform_int_distribution<size_t> dist(0, keyPool_.size() - 1);
-    LOG_DEBUG("Thread ID: " + thread_id_to_string(std::this_thread::get_id()) + " Generating key from pool of size: " + std::to_string(keyPool_.size()));
+    LOG_DEBUG_EVERY_N(10000, "Thread ID: " + thread_id_to_string(std::this_thread::get_id()) + " Generating key from pool of size: " + std::to_string(keyPool_.size()));
     return Result(Result::Ret::kOk, keyPool_[dist(gen)]);
 }
 
@@ -11,6 +11,10 @@
 #include <iomanip>
 #include <fstream>
 #include "mock/mock.h"
+#include "mock/sstFileManager.h"
+#include "utils/metrics.h"
+#include "utils/trace.h"
+#include "utils/workerBuffers.h"
 
 /**
  *  ./mock.sh -n 1G -d "kvdict"
@@ -39,6 +43,16 @@ class MockCmd
 {
 public:
     std::string directory = "kvdict"; // 默认目录是 "kvdict"
+    std::string format = "json";      // 输出格式：json 或 sst（直接生成 SST，跳过 JSON）
+    std::string metrics;              // 指标导出路径前缀，生成 <prefix>.json 与 <prefix>.prom
+    std::string trace;                // Chrome trace 输出路径（需以 BINGEST_TRACE 编译）
+    SyncPolicy syncPolicy = SyncPolicy::kNone; // 输出落盘策略
+    size_t syncBatchSize = 64;                 // batch 策略下每批文件数
+    std::string valueEncoding = "ttl";         // sst 格式下的 value 编码：raw / ttl / pika
+    std::string ioBackend = "posix";           // json 格式下的写入后端：posix / uring / auto
+    Codec codec = Codec::kNone;                // json 格式下的输出压缩：gzip / zstd / lz4
+    int codecLevel = 0;                        // 压缩级别，0 为各格式默认值
+    uint64_t memoryBudget = 0;                 // 并发生成的内存预算（字节），0 表示不限制
     std::string keyPrefix;
     std::string valuePrefix;
     double maxFileSizeMB;
@@ -86,7 +100,7 @@ public:
     Result parse(int argc, char **argv)
     {
         int opt;
-        while ((opt = getopt(argc, argv, "n:d:")) != -1)
+        while ((opt = getopt(argc, argv, "n:d:f:m:t:y:E:I:z:B:")) != -1)
         {
             switch (opt)
             {
@@ -96,16 +110,98 @@ public:
             case 'd':
                 directory = optarg; // 解析 -d 后的值
                 break;
+            case 'f':
+                format = optarg; // 解析 -f 后的值
+                break;
+            case 'm':
+                metrics = optarg; // 解析 -m 后的值
+                break;
+            case 't':
+                trace = optarg; // 解析 -t 后的值
+                break;
+            case 'E':
+                valueEncoding = optarg; // 解析 -E 后的值
+                break;
+            case 'I':
+                ioBackend = optarg; // 解析 -I 后的值
+                break;
+            case 'z':
+            {
+                Result res = parseCompression(optarg); // 解析 -z 后的值
+                if (res.isError())
+                {
+                    return res;
+                }
+                break;
+            }
+            case 'B':
+            {
+                if (std::string(optarg) == "auto")
+                {
+                    memoryBudget = MemoryBudget::autoCapacity();
+                    break;
+                }
+                Result res = parseSize(optarg); // 解析 -B 后的值（MB）
+                if (res.isError())
+                {
+                    return res;
+                }
+                memoryBudget = static_cast<uint64_t>(stod(res.message_raw()) * (1 << 20));
+                break;
+            }
+            case 'y':
+            {
+                Result res = parseSyncPolicy(optarg, syncPolicy, syncBatchSize); // 解析 -y 后的值
+                if (res.isError())
+                {
+                    return res;
+                }
+                break;
+            }
             default:
-                LOG_INFO("Usage: ./mock -n <size> -d <directory>");
-                LOG_INFO("Example: ./mock -n 1G -d kvdict");
+                LOG_INFO("Usage: ./mock -n <size> -d <directory> [-f json|json-compact|sst] [-m <metrics_prefix>] [-t <trace.json>] [-y none|file|batch[:N]] [-E raw|ttl|pika] [-I posix|uring|auto] [-z gzip|zstd|lz4[:level]] [-B <size>|auto]");
+                LOG_INFO("Example: ./mock -n 1G -d kvdict -f sst");
                 return Result(Result::kError, "Invalid option");
             }
         }
+        if (format != "json" && format != "json-compact" && format != "sst")
+        {
+            return Result(Result::kInvalidParam, "format must be json, json-compact or sst: " + format);
+        }
+        if (codec != Codec::kNone && format == "sst")
+        {
+            return Result(Result::kInvalidParam, "-z only applies to json formats");
+        }
         return Result(Result::kOk, "Parsed successfully");
     }
 
 private:
+    // 解析 gzip|zstd|lz4[:level]
+    Result parseCompression(const std::string &spec)
+    {
+        size_t colon = spec.find(':');
+        if (!parseCodec(spec.substr(0, colon), codec))
+        {
+            return Result(Result::kInvalidParam, "compression must be gzip, zstd or lz4: " + spec);
+        }
+        if (!codecAvailable(codec))
+        {
+            return Result(Result::kInvalidParam, std::string("built without ") + codecName(codec) + " support");
+        }
+        if (colon != std::string::npos)
+        {
+            try
+            {
+                codecLevel = std::stoi(spec.substr(colon + 1));
+            }
+            catch (const std::exception &)
+            {
+                return Result(Result::kInvalidParam, "invalid compression level: " + spec);
+            }
+        }
+        return Result(Result::kOk);
+    }
+
     // 解析像 10G 这种带有单位的大小参数
     Result parseSize(const char *sizeStr)
     {
@@ -155,6 +251,7 @@ int main(int argc, char **argv)
 
     LOG_DEBUG("Target size: " + std::to_string(cmd.targetSizeMB) + "MB");
     LOG_DEBUG("Directory: " + cmd.directory);
+    LOG_DEBUG("Output format: " + cmd.format);
     LOG_DEBUG("Approximate entry size: " + std::to_string(cmd.approxEntrySizeKB) + "KB");
 
     // 检查目录是否存在
@@ -203,10 +300,67 @@ int main(int argc, char **argv)
         }
         LOG_DEBUG("Wrote config to " + configFile);
 
+        // 周期导出指标，析构时写出最终快照
+        std::unique_ptr<MetricsExporter> exporter;
+        if (!cmd.metrics.empty())
+        {
+            exporter = std::make_unique<MetricsExporter>(cmd.metrics + ".json", cmd.metrics + ".prom", std::chrono::seconds(1));
+        }
+
         // 构造并启动数据生成器
         DataGen generator(configFile, cmd.directory);
+        if (cmd.memoryBudget > 0)
+        {
+            auto budget = std::make_shared<MemoryBudget>(cmd.memoryBudget);
+            generator.setMemoryBudget(budget);
+            WorkerBuffers::setMemoryBudget(budget);
+        }
+        auto publisher = std::make_shared<FilePublisher>(cmd.syncPolicy, cmd.syncBatchSize);
+        if (cmd.format == "sst")
+        {
+            std::shared_ptr<const ValueEncoder> encoder;
+            Result encoderRes = makeValueEncoder(cmd.valueEncoding, encoder);
+            if (encoderRes.isError())
+            {
+                LOG_ERROR("Invalid value encoding: " + encoderRes.message());
+                return -1;
+            }
+            auto fileManager = std::make_shared<SstFileManager>(cmd.directory);
+            fileManager->setPublisher(publisher);
+            fileManager->setValueEncoder(encoder);
+            generator.setFileManager(fileManager);
+        }
+        else
+        {
+            std::shared_ptr<IoBackend> backend;
+            Result backendRes = makeIoBackend(cmd.ioBackend, backend);
+            if (backendRes.isError())
+            {
+                LOG_ERROR("Invalid I/O backend: " + backendRes.message());
+                return -1;
+            }
+            auto fileManager = std::make_shared<FileManager>(cmd.directory);
+            fileManager->setPublisher(publisher);
+            fileManager->setIoBackend(backend);
+            fileManager->setCodec(cmd.codec, cmd.codecLevel);
+            if (cmd.format == "json-compact")
+                fileManager->setJsonStyle(KvJsonWriter::Style::kCompact);
+            generator.setFileManager(fileManager);
+        }
+        if (!cmd.trace.empty())
+        {
+            if (!Tracer::compiledIn())
+                LOG_WARN("Tracing is compiled out, rebuild with -DBINGEST_TRACE=ON to record spans");
+            Tracer::instance().setEnabled(true);
+        }
         LOG_DEBUG("Starting data generation...");
         generator.generateData();
+        if (!cmd.trace.empty())
+        {
+            Result traceRes = Tracer::instance().dumpChromeTrace(cmd.trace);
+            if (traceRes.isError())
+                LOG_ERROR("Failed to write trace: " + traceRes.message());
+        }
     }
     catch (const std::exception &e)
     {
@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include "exchange/replicaBench.h"
+#include "mock/dataGen.h"
+#include "utils/argParse.h"
+#include "utils/kconfig.h"
+#include "utils/klog.h"
+
+namespace fs = std::filesystem;
+
+void print_usage(const char *prog)
+{
+    std::cout << "Usage: " << prog << " [-c <config.json>] [-n <size>] [-w <work_dir>] [-m both|writebatch|ingest] [-b <batch>] [-s] [-f <bytes>] [-E raw|ttl|pika] [-o <result.json>]\n"
+              << "  -c DataGen 配置，默认与 mock 相同（PROJECT_DIR/config.json）\n"
+              << "  -n 数据集大小（如 256M、1G），覆盖配置中的 targetSizeMB\n"
+              << "  -w 工作目录，相对路径按 DEFAULTDIC 解析，默认 replbench\n"
+              << "  -m 只跑某一种同步方式，默认两种都跑\n"
+              << "  -b 写路径下主节点每个 WriteBatch 的条数（正整数），默认 1000\n"
+              << "  -s 写路径的每次 Write 都 fsync WAL\n"
+              << "  -f ingest 路径按大小切分 SST（如 64M）\n"
+              << "  -E value 编码，默认 ttl\n"
+              << "  -o 把结果写成 JSON\n";
+}
+
+static void printStats(const ReplicaBenchStats &stats)
+{
+    std::printf("%-10s entries=%llu wall=%.3fs primary=%.3fs catch-up=%.3fs written=%llu (WA %.2f, storage %llu) moved=%llu (binlog %llu, objects %llu) disk=%llu/%llu\n",
+                stats.mode.c_str(), static_cast<unsigned long long>(stats.entries), stats.wallSeconds, stats.primarySeconds,
+                stats.wallSeconds - stats.primarySeconds, static_cast<unsigned long long>(stats.bytesWritten), stats.writeAmplification(),
+                static_cast<unsigned long long>(stats.storageBytesWritten), static_cast<unsigned long long>(stats.bytesMoved()),
+                static_cast<unsigned long long>(stats.binlogBytes), static_cast<unsigned long long>(stats.objectBytes),
+                static_cast<unsigned long long>(stats.primaryDiskBytes), static_cast<unsigned long long>(stats.replicaDiskBytes));
+}
+
+int main(int argc, char **argv)
+{
+    std::string configPath = (fs::path(PROJECT_DIR) / "config.json").string();
+    std::string targetSize;
+    std::string workDir = "replbench";
+    std::string mode = "both";
+    size_t batchSize = 1000;
+    bool syncWrites = false;
+    std::string targetFileSize;
+    std::string valueEncoding = "ttl";
+    std::string resultPath;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:n:w:m:b:sf:E:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'c':
+            configPath = optarg;
+            break;
+        case 'n':
+            targetSize = optarg;
+            break;
+        case 'w':
+            workDir = optarg;
+            break;
+        case 'm':
+            mode = optarg;
+            break;
+        case 'b':
+            if (!parseCount(optarg, batchSize) || batchSize == 0)
+            {
+                std::cerr << "Error: invalid batch size for -b: " << optarg << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 's':
+            syncWrites = true;
+            break;
+        case 'f':
+            targetFileSize = optarg;
+            break;
+        case 'E':
+            valueEncoding = optarg;
+            break;
+        case 'o':
+            resultPath = optarg;
+            break;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (mode != "both" && mode != "writebatch" && mode != "ingest")
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    ReplicaBench bench((DEFAULTDIC / workDir).string());
+    bench.setBatchSize(batchSize);
+    bench.setSyncWrites(syncWrites);
+    std::shared_ptr<const ValueEncoder> encoder;
+    Result encoderRes = makeValueEncoder(valueEncoding, encoder);
+    if (encoderRes.isError())
+    {
+        std::cerr << "Error: " << encoderRes.message() << std::endl;
+        return 1;
+    }
+    bench.setValueEncoder(encoder);
+    if (!targetFileSize.empty())
+    {
+        SstSplitPolicy split;
+        if (!parseByteSize(targetFileSize, split.targetFileSize))
+        {
+            std::cerr << "Error: invalid size for -f: " << targetFileSize << std::endl;
+            return 1;
+        }
+        bench.setSplitPolicy(split);
+    }
+
+    // 数据集由 DataGen 生成后留在内存里，不计入任何一种方式的耗时
+    json config;
+    {
+        std::ifstream in(configPath);
+        if (!in)
+        {
+            std::cerr << "Error: cannot open config " << configPath << std::endl;
+            return 1;
+        }
+        try
+        {
+            in >> config;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error: invalid config " << configPath << ": " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    if (!targetSize.empty())
+    {
+        uint64_t bytes = 0;
+        if (!parseByteSize(targetSize, bytes) || bytes == 0)
+        {
+            std::cerr << "Error: invalid size for -n: " << targetSize << std::endl;
+            return 1;
+        }
+        config["targetSizeMB"] = static_cast<double>(bytes) / (1 << 20);
+    }
+    fs::create_directories(DEFAULTDIC / workDir);
+    std::string benchConfig = (DEFAULTDIC / workDir / "config.json").string();
+    {
+        std::ofstream out(benchConfig, std::ios::trunc);
+        out << config.dump(4);
+    }
+
+    std::vector<DataType> files;
+    size_t skipped = 0;
+    try
+    {
+        DataGen generator(benchConfig, workDir);
+        auto collector = std::make_shared<DatasetCollector>();
+        generator.setFileManager(collector);
+        Result res = generator.generateData();
+        if (res.isError())
+        {
+            std::cerr << "Error: " << res.message() << std::endl;
+            return 1;
+        }
+        files = collector->take(&skipped);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (skipped > 0)
+    {
+        std::cout << "Skipped " << skipped << " non-string records (flat SST output only supports strings)\n";
+    }
+
+    size_t entries = 0;
+    for (const auto &data : files)
+        entries += data.size();
+    json result = {{"dataset", {{"files", files.size()}, {"entries", entries}, {"skipped", skipped}}}, {"modes", json::array()}};
+    std::vector<ReplicaBenchStats> runs;
+    bool failed = false;
+    for (const std::string &run : {std::string("writebatch"), std::string("ingest")})
+    {
+        if (mode != "both" && mode != run)
+            continue;
+        ReplicaBenchStats stats;
+        Result res = run == "writebatch" ? bench.runWriteBatch(files, stats) : bench.runIngest(files, stats);
+        if (res.isError())
+        {
+            std::cerr << "Error: " << run << ": " << res.message() << std::endl;
+            failed = true;
+            continue;
+        }
+        printStats(stats);
+        result["modes"].push_back(stats.toJson());
+        runs.push_back(stats);
+    }
+
+    if (runs.size() == 2)
+    {
+        const ReplicaBenchStats &write = runs[0];
+        const ReplicaBenchStats &ingest = runs[1];
+        bool same = write.primaryDigest == ingest.primaryDigest;
+        std::printf("ingest vs writebatch: wall x%.2f, catch-up x%.2f, bytes written x%.2f, bytes moved x%.2f, digest %s\n",
+                    write.wallSeconds / std::max(ingest.wallSeconds, 1e-9),
+                    (write.wallSeconds - write.primarySeconds) / std::max(ingest.wallSeconds - ingest.primarySeconds, 1e-9),
+                    static_cast<double>(write.bytesWritten) / std::max<double>(ingest.bytesWritten, 1),
+                    static_cast<double>(write.bytesMoved()) / std::max<double>(ingest.bytesMoved(), 1),
+                    same ? "match" : "MISMATCH");
+        result["digestMatch"] = same;
+        failed = failed || !same;
+    }
+
+    if (!resultPath.empty())
+    {
+        std::ofstream out(resultPath, std::ios::trunc);
+        out << result.dump(4);
+        if (!out)
+        {
+            std::cerr << "Error: failed to write " << resultPath << std::endl;
+            return 1;
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,335 @@
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <filesystem>
+#include "exchange/sstChecker.h"
+#include "exchange/JsonFileManager.h"
+#include "exchange/multiCfSstWriter.h"
+#include "exchange/workJournal.h"
+#include "utils/argParse.h"
+#include "utils/compression.h"
+#include "utils/kconfig.h"
+#include "utils/taskScheduler.h"
+
+namespace fs = std::filesystem;
+
+void print_usage(const char *prog)
+{
+    std::cout << "Usage: " << prog << " [-j <json_path>] [-M <manifest>] [-o <manifest_out>] [-p <threads>] [-E raw|ttl|pika] <sst_path>...\n"
+              << "  <sst_path> 可以是文件或目录（目录下所有 *.sst），相对路径找不到时按 DEFAULTDIC 解析\n"
+              << "  -j 与源 JSON 逐条比对：文件或目录。目录下优先按 exchange -r 的工作日志找到每组输出的输入，\n"
+              << "     否则按组名配对 <stem>.json（或 .json.gz / .zst / .lz4）；切分的各段合起来与源比对\n"
+              << "  -M 与 manifest 比对 entries / fileSize / smallestKey / largestKey：sstcheck -o 的输出或 exchange 的清单\n"
+              << "  -o 把校验摘要写成 manifest\n"
+              << "  -p 并发线程数，默认等于 CPU 核数\n"
+              << "  -E value 编码，需与 exchange 的 -E 一致，默认 ttl\n";
+}
+
+// 先按原样解析，不存在时再尝试 DEFAULTDIC 下的相对路径
+fs::path resolvePath(const std::string &path)
+{
+    fs::path p(path);
+    if (fs::exists(p) || p.is_absolute())
+        return p;
+    return DEFAULTDIC / p;
+}
+
+// 输出的组名：data_3.sst / data_3.0002.sst（切分的第 2 段）-> data_3
+std::string outputStem(const fs::path &sstPath)
+{
+    std::string name = sstPath.filename().string();
+    return name.substr(0, name.find('.'));
+}
+
+// exchange -r 的工作日志记录了每组输出由哪些输入生成：分片输出时在上一级目录
+const WorkJournal *findJournal(const fs::path &sstDir, std::map<std::string, std::unique_ptr<WorkJournal>> &journals)
+{
+    for (const fs::path &dir : {sstDir, sstDir.parent_path()})
+    {
+        fs::path path = dir / ".bingest_journal.json";
+        auto it = journals.find(path.string());
+        if (it == journals.end())
+        {
+            std::unique_ptr<WorkJournal> journal;
+            std::error_code ec;
+            if (fs::exists(path, ec))
+            {
+                journal = std::make_unique<WorkJournal>(path.string());
+                if (journal->load().isError())
+                    journal.reset();
+            }
+            it = journals.emplace(path.string(), std::move(journal)).first;
+        }
+        if (it->second)
+            return it->second.get();
+    }
+    return nullptr;
+}
+
+// 目录模式下一组输出的源文件：优先取工作日志中的输入（合并转换的一组有多个），
+// 否则按组名找 <stem>.json 及其压缩版本（.json.gz / .json.zst / .json.lz4）
+std::vector<std::string> findSources(const fs::path &jsonDir, const std::string &sstPath,
+                                     std::map<std::string, std::unique_ptr<WorkJournal>> &journals)
+{
+    std::vector<std::string> sources;
+    if (const WorkJournal *journal = findJournal(fs::path(sstPath).parent_path(), journals))
+    {
+        for (const auto &input : journal->inputsOf(sstPath))
+            sources.push_back((jsonDir / fs::path(input).filename()).string());
+        if (!sources.empty())
+            return sources;
+    }
+    std::string stem = outputStem(sstPath);
+    for (Codec codec : {Codec::kNone, Codec::kGzip, Codec::kZstd, Codec::kLz4})
+    {
+        fs::path candidate = jsonDir / (stem + ".json" + codecExtension(codec));
+        std::error_code ec;
+        if (fs::exists(candidate, ec))
+        {
+            sources.push_back(candidate.string());
+            break;
+        }
+    }
+    return sources;
+}
+
+// 读取 manifest，按文件名索引：sstcheck -o 的 {"files": [...]}（key 为原始字节），
+// 或 exchange 的 {"columnFamilies": [{"files": [...]}]}（key 为十六进制，这里解码后比对）
+Result loadManifest(const fs::path &path, std::map<std::string, json> &entries)
+{
+    std::ifstream in(path);
+    if (!in)
+        return Result(Result::Ret::kFileOpenError, "cannot open manifest " + path.string());
+    try
+    {
+        json manifest;
+        in >> manifest;
+        if (!manifest.contains("columnFamilies"))
+        {
+            for (const auto &item : manifest.at("files"))
+                entries[item.at("file").get<std::string>()] = item;
+            return Result(Result::Ret::kOk);
+        }
+        for (const auto &cf : manifest.at("columnFamilies"))
+        {
+            for (const auto &item : cf.at("files"))
+            {
+                json entry = item;
+                for (const char *field : {"smallestKey", "largestKey"})
+                {
+                    std::string key;
+                    if (!fromHex(item.at(field).get<std::string>(), key))
+                        return Result(Result::Ret::kInvalidParam, "invalid manifest " + path.string() + ": bad " + field + " for " + item.at("file").get<std::string>());
+                    entry[field] = key;
+                }
+                entries[fs::path(item.at("file").get<std::string>()).filename().string()] = entry;
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        return Result(Result::Ret::kInvalidParam, "invalid manifest " + path.string() + ": " + e.what());
+    }
+    return Result(Result::Ret::kOk);
+}
+
+int main(int argc, char **argv)
+{
+    std::string jsonPath;
+    std::string manifestPath;
+    std::string manifestOut;
+    size_t numThreads = 0;
+    std::string valueEncoding = "ttl";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "j:M:o:p:E:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'j':
+            jsonPath = optarg;
+            break;
+        case 'M':
+            manifestPath = optarg;
+            break;
+        case 'o':
+            manifestOut = optarg;
+            break;
+        case 'p':
+            if (!parseCount(optarg, numThreads))
+            {
+                std::cerr << "Error: invalid thread count for -p: " << optarg << std::endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'E':
+            valueEncoding = optarg;
+            break;
+        default:
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> paths;
+    for (int i = optind; i < argc; ++i)
+    {
+        fs::path p = resolvePath(argv[i]);
+        if (fs::is_directory(p))
+        {
+            std::vector<std::string> dirFiles;
+            for (const auto &entry : fs::directory_iterator(p))
+            {
+                if (entry.is_regular_file() && entry.path().extension() == ".sst")
+                    dirFiles.push_back(entry.path().string());
+            }
+            std::sort(dirFiles.begin(), dirFiles.end());
+            paths.insert(paths.end(), dirFiles.begin(), dirFiles.end());
+        }
+        else
+        {
+            paths.push_back(p.string());
+        }
+    }
+
+    std::shared_ptr<const ValueEncoder> encoder;
+    Result encoderRes = makeValueEncoder(valueEncoding, encoder);
+    if (encoderRes.isError())
+    {
+        std::cerr << "Error: " << encoderRes.message() << std::endl;
+        return 1;
+    }
+
+    SstChecker checker;
+    checker.setValueEncoder(encoder);
+    if (numThreads > 0)
+        checker.setNumThreads(numThreads);
+
+    std::vector<SstFileSummary> summaries;
+    Result result = checker.checkFiles(paths, summaries);
+    bool failed = result.isError();
+
+    // manifest 按文件名索引
+    std::map<std::string, json> manifestEntries;
+    if (!manifestPath.empty())
+    {
+        Result res = loadManifest(resolvePath(manifestPath), manifestEntries);
+        if (res.isError())
+        {
+            std::cerr << "Error: " << res.message() << std::endl;
+            return 1;
+        }
+    }
+
+    // 交叉比对：与 manifest / 源 JSON（比对 JSON 需要完整解析，同样并发执行）
+    std::vector<std::string> crossErrors(summaries.size());
+    if (!jsonPath.empty() || !manifestPath.empty())
+    {
+        fs::path jsonBase = jsonPath.empty() ? fs::path() : resolvePath(jsonPath);
+        bool jsonIsDir = !jsonPath.empty() && fs::is_directory(jsonBase);
+        JsonFileManager fileManager;
+        TaskScheduler scheduler(numThreads > 0 ? numThreads : checker.getNumThreads());
+        TaskGroup group(scheduler);
+        if (!manifestPath.empty())
+        {
+            for (size_t i = 0; i < summaries.size(); ++i)
+            {
+                if (!summaries[i].ok)
+                    continue;
+                std::string fileName = fs::path(summaries[i].path).filename().string();
+                auto entry = manifestEntries.find(fileName);
+                Result res = entry != manifestEntries.end()
+                                 ? SstChecker::crossCheckManifest(summaries[i], entry->second)
+                                 : Result(Result::Ret::kInvalidParam, fileName + " not listed in manifest");
+                if (res.isError())
+                {
+                    crossErrors[i] = res.message_raw();
+                    failed = true;
+                }
+            }
+        }
+        if (!jsonPath.empty())
+        {
+            // 切分的各段（data_3.0001.sst、data_3.0002.sst ...）合起来才是一组输出，按组与源 JSON 比对
+            std::map<std::string, std::vector<size_t>> outputs;
+            for (size_t i = 0; i < summaries.size(); ++i)
+            {
+                if (summaries[i].ok)
+                    outputs[(fs::path(summaries[i].path).parent_path() / outputStem(summaries[i].path)).string()].push_back(i);
+            }
+            std::map<std::string, std::unique_ptr<WorkJournal>> journals;
+            for (auto &output : outputs)
+            {
+                std::vector<size_t> members = output.second;
+                std::sort(members.begin(), members.end(), [&summaries](size_t a, size_t b)
+                          { return summaries[a].path < summaries[b].path; });
+                std::vector<std::string> ssts;
+                for (size_t i : members)
+                    ssts.push_back(summaries[i].path);
+                std::vector<std::string> sources = jsonIsDir ? findSources(jsonBase, ssts.front(), journals)
+                                                             : std::vector<std::string>{jsonBase.string()};
+                group.run([&, members, ssts, sources]
+                          {
+                              Result res = sources.empty()
+                                               ? Result(Result::Ret::kFileOpenError, "no source JSON for " + ssts.front() + " in " + jsonBase.string())
+                                               : checker.crossCheckJson(ssts, &fileManager, sources);
+                              if (res.isError())
+                              {
+                                  for (size_t i : members)
+                                  {
+                                      if (crossErrors[i].empty())
+                                          crossErrors[i] = res.message_raw();
+                                  }
+                              }
+                              return res; });
+            }
+        }
+        if (group.wait().isError())
+            failed = true;
+    }
+
+    uint64_t totalEntries = 0;
+    uint64_t totalBytes = 0;
+    for (size_t i = 0; i < summaries.size(); ++i)
+    {
+        const SstFileSummary &s = summaries[i];
+        totalEntries += s.entries;
+        totalBytes += s.fileSize;
+        if (!s.ok)
+        {
+            std::cout << "FAIL " << s.path << ": " << s.error << "\n";
+            continue;
+        }
+        std::cout << (crossErrors[i].empty() ? "OK   " : "FAIL ") << s.path
+                  << " entries=" << s.entries << " bytes=" << s.fileSize
+                  << " keys=[" << s.smallestKey << ", " << s.largestKey << "]"
+                  << " persistent=" << s.persistentEntries
+                  << " expire=[" << s.minExpire << ", " << s.maxExpire << "]\n";
+        if (!crossErrors[i].empty())
+            std::cout << "     " << crossErrors[i] << "\n";
+    }
+    std::cout << "Checked " << summaries.size() << " files, " << totalEntries << " entries, "
+              << totalBytes << " bytes: " << (failed ? "FAILED" : "OK") << std::endl;
+
+    if (!manifestOut.empty())
+    {
+        std::ofstream out(manifestOut, std::ios::trunc);
+        out << SstChecker::manifest(summaries).dump(4);
+        if (!out)
+        {
+            std::cerr << "Error: failed to write manifest " << manifestOut << std::endl;
+            return 1;
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,77 @@
+#include "utils/argParse.h"
+#include <cctype>
+#include <cmath>
+#include <stdexcept>
+
+bool parseByteSize(const std::string &str, uint64_t &bytes)
+{
+    // stoull 会跳过前导空白并接受负号（按无符号回绕），这里要求以数字开头
+    if (str.empty() || !std::isdigit(static_cast<unsigned char>(str[0])))
+        return false;
+    size_t pos = 0;
+    unsigned long long value = 0;
+    try
+    {
+        value = std::stoull(str, &pos);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+    std::string unit = str.substr(pos);
+    int shift = 0;
+    if (unit.empty() || unit == "B")
+        shift = 0;
+    else if (unit == "K")
+        shift = 10;
+    else if (unit == "M")
+        shift = 20;
+    else if (unit == "G")
+        shift = 30;
+    else
+        return false;
+    if (value > (UINT64_MAX >> shift))
+        return false;
+    bytes = static_cast<uint64_t>(value) << shift;
+    return true;
+}
+
+bool parseCount(const std::string &str, size_t &count)
+{
+    if (str.empty() || !std::isdigit(static_cast<unsigned char>(str[0])))
+        return false;
+    size_t pos = 0;
+    size_t value = 0;
+    try
+    {
+        value = std::stoul(str, &pos);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+    if (pos != str.size())
+        return false;
+    count = value;
+    return true;
+}
+
+bool parseNumber(const std::string &str, double &value)
+{
+    if (str.empty() || !(std::isdigit(static_cast<unsigned char>(str[0])) || str[0] == '-' || str[0] == '.'))
+        return false;
+    size_t pos = 0;
+    double parsed = 0;
+    try
+    {
+        parsed = std::stod(str, &pos);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+    if (pos != str.size() || !std::isfinite(parsed))
+        return false;
+    value = parsed;
+    return true;
+}
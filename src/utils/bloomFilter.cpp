@@ -0,0 +1,60 @@
+#include "utils/bloomFilter.h"
+#include <algorithm>
+#include <cmath>
+
+BlockedBloomFilter::BlockedBloomFilter(size_t expectedKeys, double bitsPerKey, size_t numPartitions)
+{
+    // 分区数取 2 的幂，用哈希高位直接选分区
+    size_t partitions = 1;
+    int bits = 0;
+    while (partitions < std::max<size_t>(1, numPartitions))
+    {
+        partitions <<= 1;
+        ++bits;
+    }
+    partitionShift_ = 64 - bits;
+    double totalBits = std::max(1.0, static_cast<double>(expectedKeys) * std::max(1.0, bitsPerKey));
+    wordsPerPartition_ = std::max<size_t>(1, static_cast<size_t>(std::ceil(totalBits / 64 / partitions)));
+
+    partitions_.reserve(partitions);
+    for (size_t p = 0; p < partitions; ++p)
+    {
+        partitions_.emplace_back(new std::atomic<uint64_t>[wordsPerPartition_]);
+        for (size_t i = 0; i < wordsPerPartition_; ++i)
+            partitions_.back()[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+std::atomic<uint64_t> &BlockedBloomFilter::word(const Hash128 &hash) const
+{
+    size_t partition = partitionShift_ >= 64 ? 0 : static_cast<size_t>(hash.lo >> partitionShift_);
+    // 低 32 位乘法取模，避免除法，与分区所用的高位互不相关
+    size_t index = static_cast<size_t>(((hash.lo & 0xffffffffULL) * wordsPerPartition_) >> 32);
+    return partitions_[partition][index];
+}
+
+uint64_t BlockedBloomFilter::mask(const Hash128 &hash)
+{
+    // 每个探测位取 hi 的 6 位
+    uint64_t m = 0;
+    uint64_t h = hash.hi;
+    for (int i = 0; i < kNumProbes; ++i)
+    {
+        m |= uint64_t(1) << (h & 63);
+        h >>= 6;
+    }
+    return m;
+}
+
+bool BlockedBloomFilter::insert(const Hash128 &hash)
+{
+    uint64_t m = mask(hash);
+    uint64_t before = word(hash).fetch_or(m, std::memory_order_relaxed);
+    return (before & m) == m;
+}
+
+bool BlockedBloomFilter::mayContain(const Hash128 &hash) const
+{
+    uint64_t m = mask(hash);
+    return (word(hash).load(std::memory_order_relaxed) & m) == m;
+}
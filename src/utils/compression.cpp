@@ -0,0 +1,567 @@
+#include "utils/compression.h"
+#include "utils/metrics.h"
+#include "utils/trace.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+#ifdef BINGEST_WITH_ZSTD
+#include <zstd.h>
+#endif
+#ifdef BINGEST_WITH_LZ4
+#include <lz4frame.h>
+#endif
+
+namespace
+{
+    bool endsWith(const std::string &text, const char *suffix)
+    {
+        size_t n = std::strlen(suffix);
+        return n > 0 && text.size() >= n && text.compare(text.size() - n, n, suffix) == 0;
+    }
+
+    Result unavailable(Codec codec)
+    {
+        return Result(Result::Ret::kInvalidParam, std::string("built without ") + codecName(codec) + " support");
+    }
+
+    // 输出缓冲区剩余不足 minFree 时按倍数扩容
+    void growFor(std::string &out, size_t produced, size_t minFree)
+    {
+        if (out.size() - produced < minFree)
+            out.resize(std::max(out.size() * 2, produced + minFree));
+    }
+
+    // ------------------------------------------------------------------ gzip
+    Result gunzip(const std::string &data, std::string &out)
+    {
+        constexpr size_t kStep = 1 << 20;
+        z_stream zs{};
+        // 15 + 32：自动识别 gzip / zlib 头
+        if (inflateInit2(&zs, 15 + 32) != Z_OK)
+            return Result(Result::Ret::kOutOfMemory, "inflateInit2 failed");
+
+        // gzip 尾部 ISIZE 是最后一个成员原始大小的低 32 位，只作为预留容量的提示（deflate 压缩比不超过 1032:1）
+        size_t hint = data.size() * 4;
+        if (data.size() >= 18)
+        {
+            uint32_t isize;
+            std::memcpy(&isize, data.data() + data.size() - 4, sizeof(isize));
+            hint = std::max<size_t>(hint, std::min<size_t>(isize, data.size() * 1032));
+        }
+        out.resize(std::max(hint, kStep));
+
+        const unsigned char *in = reinterpret_cast<const unsigned char *>(data.data());
+        size_t consumed = 0;
+        size_t produced = 0;
+        int ret = Z_OK;
+        while (true)
+        {
+            growFor(out, produced, kStep);
+            size_t inChunk = std::min<size_t>(data.size() - consumed, UINT_MAX);
+            size_t outChunk = std::min<size_t>(out.size() - produced, UINT_MAX);
+            zs.next_in = const_cast<unsigned char *>(in + consumed);
+            zs.avail_in = static_cast<uInt>(inChunk);
+            zs.next_out = reinterpret_cast<unsigned char *>(&out[produced]);
+            zs.avail_out = static_cast<uInt>(outChunk);
+            ret = inflate(&zs, Z_NO_FLUSH);
+            consumed += inChunk - zs.avail_in;
+            produced += outChunk - zs.avail_out;
+            if (ret == Z_STREAM_END)
+            {
+                // 多个 gzip 成员首尾相接（cat a.gz b.gz）
+                if (consumed == data.size())
+                    break;
+                inflateReset(&zs);
+                continue;
+            }
+            if (ret == Z_BUF_ERROR && consumed == data.size())
+                break;
+            if (ret != Z_OK && ret != Z_BUF_ERROR)
+                break;
+        }
+        std::string message = zs.msg ? zs.msg : "";
+        inflateEnd(&zs);
+        out.resize(produced);
+        if (ret != Z_STREAM_END)
+            return Result(Result::Ret::kFileReadError, "gzip: " + (message.empty() ? std::string("truncated input") : message));
+        return Result(Result::Ret::kOk);
+    }
+
+#ifdef BINGEST_WITH_ZSTD
+    // ------------------------------------------------------------------ zstd
+    struct ZstdFrame
+    {
+        size_t offset; // 压缩数据中的偏移
+        size_t size;
+        size_t plainOffset; // 解压结果中的偏移
+        size_t plainSize;
+    };
+
+    bool isSkippableFrame(const char *src, size_t size)
+    {
+        if (size < 4)
+            return false;
+        uint32_t magic;
+        std::memcpy(&magic, src, sizeof(magic));
+        return (magic & 0xFFFFFFF0U) == 0x184D2A50U;
+    }
+
+    // 切分帧并取得每帧原始大小；有帧未记录原始大小时返回 false
+    bool splitFrames(const std::string &data, std::vector<ZstdFrame> &frames, size_t &total, Result &res)
+    {
+        size_t offset = 0;
+        total = 0;
+        bool sized = true;
+        while (offset < data.size())
+        {
+            const char *src = data.data() + offset;
+            size_t remain = data.size() - offset;
+            size_t frameSize = ZSTD_findFrameCompressedSize(src, remain);
+            if (ZSTD_isError(frameSize))
+            {
+                res = Result(Result::Ret::kFileReadError, std::string("zstd: ") + ZSTD_getErrorName(frameSize));
+                return false;
+            }
+            if (!isSkippableFrame(src, remain))
+            {
+                unsigned long long plain = ZSTD_getFrameContentSize(src, remain);
+                if (plain == ZSTD_CONTENTSIZE_UNKNOWN || plain == ZSTD_CONTENTSIZE_ERROR)
+                    sized = false;
+                else
+                {
+                    frames.push_back({offset, frameSize, total, static_cast<size_t>(plain)});
+                    total += static_cast<size_t>(plain);
+                }
+            }
+            offset += frameSize;
+        }
+        return sized;
+    }
+
+    ZSTD_DCtx *threadDCtx()
+    {
+        struct Holder
+        {
+            ZSTD_DCtx *ctx = ZSTD_createDCtx();
+            ~Holder() { ZSTD_freeDCtx(ctx); }
+        };
+        thread_local Holder holder;
+        return holder.ctx;
+    }
+
+    Result unzstdFrame(const std::string &data, const ZstdFrame &frame, std::string &out)
+    {
+        size_t n = ZSTD_decompressDCtx(threadDCtx(), &out[frame.plainOffset], frame.plainSize,
+                                       data.data() + frame.offset, frame.size);
+        if (ZSTD_isError(n))
+            return Result(Result::Ret::kFileReadError, std::string("zstd: ") + ZSTD_getErrorName(n));
+        if (n != frame.plainSize)
+            return Result(Result::Ret::kFileReadError, "zstd: frame content size mismatch");
+        return Result(Result::Ret::kOk);
+    }
+
+    // 帧未记录原始大小（例如 zstd 命令行从管道压缩）时流式解压
+    Result unzstdStream(const std::string &data, std::string &out)
+    {
+        ZSTD_DCtx *ctx = threadDCtx();
+        ZSTD_DCtx_reset(ctx, ZSTD_reset_session_only);
+        out.resize(std::max(data.size() * 4, ZSTD_DStreamOutSize()));
+        ZSTD_inBuffer in{data.data(), data.size(), 0};
+        size_t produced = 0;
+        size_t ret = 0;
+        while (in.pos < in.size)
+        {
+            growFor(out, produced, ZSTD_DStreamOutSize());
+            ZSTD_outBuffer dst{&out[produced], out.size() - produced, 0};
+            ret = ZSTD_decompressStream(ctx, &dst, &in);
+            if (ZSTD_isError(ret))
+            {
+                out.clear();
+                return Result(Result::Ret::kFileReadError, std::string("zstd: ") + ZSTD_getErrorName(ret));
+            }
+            produced += dst.pos;
+        }
+        // ret 非 0 时仍有缓存的输出或帧不完整
+        while (ret != 0)
+        {
+            growFor(out, produced, ZSTD_DStreamOutSize());
+            ZSTD_outBuffer dst{&out[produced], out.size() - produced, 0};
+            ret = ZSTD_decompressStream(ctx, &dst, &in);
+            if (ZSTD_isError(ret) || dst.pos == 0)
+            {
+                out.clear();
+                return Result(Result::Ret::kFileReadError, "zstd: truncated input");
+            }
+            produced += dst.pos;
+        }
+        out.resize(produced);
+        return Result(Result::Ret::kOk);
+    }
+
+    Result unzstd(const std::string &data, std::string &out, TaskScheduler *scheduler)
+    {
+        static MetricsCounter &parallelFrames = metricsCounter("bingest_decompress_parallel_frames_total", "zstd frames decompressed in parallel");
+        std::vector<ZstdFrame> frames;
+        size_t total = 0;
+        Result res(Result::Ret::kOk);
+        if (!splitFrames(data, frames, total, res))
+            return res.isError() ? res : unzstdStream(data, out);
+
+        out.resize(total);
+        if (!scheduler || frames.size() < 2)
+        {
+            for (const auto &frame : frames)
+            {
+                res = unzstdFrame(data, frame, out);
+                if (res.isError())
+                    break;
+            }
+        }
+        else
+        {
+            TRACE_SPAN("zstdParallelFrames");
+            TaskGroup group(*scheduler);
+            for (const auto &frame : frames)
+                group.run([&data, &out, frame]
+                          { return unzstdFrame(data, frame, out); });
+            res = group.wait();
+            parallelFrames.add(frames.size());
+        }
+        if (res.isError())
+            out.clear();
+        return res;
+    }
+#endif
+
+#ifdef BINGEST_WITH_LZ4
+    // ------------------------------------------------------------------ lz4
+    Result unlz4(const std::string &data, std::string &out)
+    {
+        constexpr size_t kStep = 1 << 20;
+        LZ4F_dctx *ctx = nullptr;
+        if (LZ4F_isError(LZ4F_createDecompressionContext(&ctx, LZ4F_VERSION)))
+            return Result(Result::Ret::kOutOfMemory, "LZ4F_createDecompressionContext failed");
+
+        out.resize(std::max(data.size() * 4, kStep));
+        size_t consumed = 0;
+        size_t produced = 0;
+        size_t ret = 0;
+        Result res(Result::Ret::kOk);
+        while (consumed < data.size())
+        {
+            growFor(out, produced, kStep);
+            size_t dstSize = out.size() - produced;
+            size_t srcSize = data.size() - consumed;
+            // 一帧结束（返回 0）后上下文自动重置，可以继续解压下一帧
+            ret = LZ4F_decompress(ctx, &out[produced], &dstSize, data.data() + consumed, &srcSize, nullptr);
+            if (LZ4F_isError(ret))
+            {
+                res = Result(Result::Ret::kFileReadError, std::string("lz4: ") + LZ4F_getErrorName(ret));
+                break;
+            }
+            consumed += srcSize;
+            produced += dstSize;
+        }
+        if (!res.isError() && ret != 0)
+            res = Result(Result::Ret::kFileReadError, "lz4: truncated input");
+        LZ4F_freeDecompressionContext(ctx);
+        out.resize(!res.isError() ? produced : 0);
+        return res;
+    }
+#endif
+}
+
+const char *codecName(Codec codec)
+{
+    switch (codec)
+    {
+    case Codec::kGzip:
+        return "gzip";
+    case Codec::kZstd:
+        return "zstd";
+    case Codec::kLz4:
+        return "lz4";
+    default:
+        return "none";
+    }
+}
+
+const char *codecExtension(Codec codec)
+{
+    switch (codec)
+    {
+    case Codec::kGzip:
+        return ".gz";
+    case Codec::kZstd:
+        return ".zst";
+    case Codec::kLz4:
+        return ".lz4";
+    default:
+        return "";
+    }
+}
+
+bool parseCodec(const std::string &name, Codec &codec)
+{
+    if (name == "none")
+        codec = Codec::kNone;
+    else if (name == "gzip" || name == "gz")
+        codec = Codec::kGzip;
+    else if (name == "zstd" || name == "zst")
+        codec = Codec::kZstd;
+    else if (name == "lz4")
+        codec = Codec::kLz4;
+    else
+        return false;
+    return true;
+}
+
+bool codecAvailable(Codec codec)
+{
+    switch (codec)
+    {
+#ifdef BINGEST_WITH_ZSTD
+    case Codec::kZstd:
+        return true;
+#endif
+#ifdef BINGEST_WITH_LZ4
+    case Codec::kLz4:
+        return true;
+#endif
+    case Codec::kNone:
+    case Codec::kGzip:
+        return true;
+    default:
+        return false;
+    }
+}
+
+Codec codecFromPath(const std::string &path)
+{
+    for (Codec codec : {Codec::kGzip, Codec::kZstd, Codec::kLz4})
+    {
+        if (endsWith(path, codecExtension(codec)))
+            return codec;
+    }
+    return Codec::kNone;
+}
+
+std::string stripCodecExtension(const std::string &path)
+{
+    return path.substr(0, path.size() - std::strlen(codecExtension(codecFromPath(path))));
+}
+
+Result decompress(Codec codec, const std::string &data, std::string &out, TaskScheduler *scheduler)
+{
+    static MetricsHistogram &latency = metricsHistogram("bingest_decompress_ns", "decompression latency per input file");
+    ScopedLatency timer(latency);
+    TRACE_SPAN("decompress");
+    (void)scheduler;
+
+    switch (codec)
+    {
+    case Codec::kNone:
+        out = data;
+        return Result(Result::Ret::kOk);
+    case Codec::kGzip:
+        return gunzip(data, out);
+    case Codec::kZstd:
+#ifdef BINGEST_WITH_ZSTD
+        return unzstd(data, out, scheduler);
+#else
+        return unavailable(codec);
+#endif
+    case Codec::kLz4:
+#ifdef BINGEST_WITH_LZ4
+        return unlz4(data, out);
+#else
+        return unavailable(codec);
+#endif
+    }
+    return unavailable(codec);
+}
+
+// ---------------------------------------------------------------------- 写入
+
+struct CompressingWriter::State
+{
+    z_stream zs{};
+    bool deflating = false;
+#ifdef BINGEST_WITH_ZSTD
+    ZSTD_CCtx *cctx = nullptr;
+#endif
+
+    ~State()
+    {
+        if (deflating)
+            deflateEnd(&zs);
+#ifdef BINGEST_WITH_ZSTD
+        ZSTD_freeCCtx(cctx);
+#endif
+    }
+};
+
+Result CompressingWriter::create(Codec codec, int level, std::unique_ptr<IoWriter> inner, std::unique_ptr<IoWriter> &writer)
+{
+    if (codec == Codec::kNone)
+    {
+        writer = std::move(inner);
+        return Result(Result::Ret::kOk);
+    }
+    if (!codecAvailable(codec))
+        return unavailable(codec);
+
+    std::unique_ptr<CompressingWriter> result(new CompressingWriter(codec, level, std::move(inner)));
+    State &state = *result->state_;
+    if (codec == Codec::kGzip)
+    {
+        // 15 + 16：带 gzip 头尾
+        if (deflateInit2(&state.zs, level == 0 ? Z_DEFAULT_COMPRESSION : level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            return Result(Result::Ret::kInvalidParam, "deflateInit2 failed, level " + std::to_string(level));
+        state.deflating = true;
+    }
+#ifdef BINGEST_WITH_ZSTD
+    if (codec == Codec::kZstd)
+    {
+        state.cctx = ZSTD_createCCtx();
+        if (!state.cctx)
+            return Result(Result::Ret::kOutOfMemory, "ZSTD_createCCtx failed");
+    }
+#endif
+    writer = std::move(result);
+    return Result(Result::Ret::kOk);
+}
+
+CompressingWriter::CompressingWriter(Codec codec, int level, std::unique_ptr<IoWriter> inner)
+    : codec_(codec), level_(level), inner_(std::move(inner)), state_(std::make_unique<State>())
+{
+}
+
+CompressingWriter::~CompressingWriter() = default;
+
+Result CompressingWriter::emitFrame(const char *data, size_t size)
+{
+    switch (codec_)
+    {
+#ifdef BINGEST_WITH_ZSTD
+    case Codec::kZstd:
+    {
+        output_.resize(ZSTD_compressBound(size));
+        // 单次压缩会在帧头记录原始大小，解压端据此按帧并行
+        size_t n = ZSTD_compressCCtx(state_->cctx, &output_[0], output_.size(), data, size,
+                                     level_ == 0 ? ZSTD_CLEVEL_DEFAULT : level_);
+        if (ZSTD_isError(n))
+            return Result(Result::Ret::kFileWriteError, std::string("zstd: ") + ZSTD_getErrorName(n));
+        return inner_->write(output_.data(), n);
+    }
+#endif
+#ifdef BINGEST_WITH_LZ4
+    case Codec::kLz4:
+    {
+        LZ4F_preferences_t prefs;
+        std::memset(&prefs, 0, sizeof(prefs));
+        prefs.frameInfo.contentSize = size;
+        prefs.compressionLevel = level_;
+        output_.resize(LZ4F_compressFrameBound(size, &prefs));
+        size_t n = LZ4F_compressFrame(&output_[0], output_.size(), data, size, &prefs);
+        if (LZ4F_isError(n))
+            return Result(Result::Ret::kFileWriteError, std::string("lz4: ") + LZ4F_getErrorName(n));
+        return inner_->write(output_.data(), n);
+    }
+#endif
+    default:
+        (void)data;
+        (void)size;
+        return unavailable(codec_);
+    }
+}
+
+Result CompressingWriter::write(const char *data, size_t size)
+{
+    if (codec_ == Codec::kGzip)
+    {
+        constexpr size_t kOut = 1 << 20;
+        z_stream &zs = state_->zs;
+        output_.resize(kOut);
+        while (size > 0)
+        {
+            size_t chunk = std::min<size_t>(size, UINT_MAX);
+            zs.next_in = reinterpret_cast<unsigned char *>(const_cast<char *>(data));
+            zs.avail_in = static_cast<uInt>(chunk);
+            while (zs.avail_in > 0)
+            {
+                zs.next_out = reinterpret_cast<unsigned char *>(&output_[0]);
+                zs.avail_out = static_cast<uInt>(kOut);
+                deflate(&zs, Z_NO_FLUSH);
+                size_t n = kOut - zs.avail_out;
+                if (n > 0)
+                {
+                    Result res = inner_->write(output_.data(), n);
+                    if (res.isError())
+                        return res;
+                }
+            }
+            data += chunk;
+            size -= chunk;
+        }
+        return Result(Result::Ret::kOk);
+    }
+
+    while (size > 0)
+    {
+        size_t take = std::min(size, kFrameBytes - pending_.size());
+        if (pending_.empty() && take == kFrameBytes)
+        {
+            // 整帧直接压缩，不经过 pending_
+            Result res = emitFrame(data, take);
+            if (res.isError())
+                return res;
+        }
+        else
+        {
+            pending_.append(data, take);
+            if (pending_.size() == kFrameBytes)
+            {
+                Result res = emitFrame(pending_.data(), pending_.size());
+                pending_.clear();
+                if (res.isError())
+                    return res;
+            }
+        }
+        data += take;
+        size -= take;
+    }
+    return Result(Result::Ret::kOk);
+}
+
+Result CompressingWriter::close()
+{
+    Result res(Result::Ret::kOk);
+    if (codec_ == Codec::kGzip)
+    {
+        constexpr size_t kOut = 1 << 20;
+        z_stream &zs = state_->zs;
+        output_.resize(kOut);
+        zs.avail_in = 0;
+        int ret = Z_OK;
+        while (ret != Z_STREAM_END && !res.isError())
+        {
+            zs.next_out = reinterpret_cast<unsigned char *>(&output_[0]);
+            zs.avail_out = static_cast<uInt>(kOut);
+            ret = deflate(&zs, Z_FINISH);
+            if (ret == Z_STREAM_ERROR)
+                res = Result(Result::Ret::kFileWriteError, "gzip: deflate failed");
+            else if (kOut > zs.avail_out)
+                res = inner_->write(output_.data(), kOut - zs.avail_out);
+        }
+    }
+    else if (!pending_.empty())
+    {
+        res = emitFrame(pending_.data(), pending_.size());
+        pending_.clear();
+    }
+    Result closed = inner_->close();
+    return res.isError() ? res : closed;
+}
@@ -0,0 +1,95 @@
+#include "utils/dirWatcher.h"
+#include "utils/klog.h"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+DirWatcher::~DirWatcher()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+}
+
+Result DirWatcher::open()
+{
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0)
+    {
+        return Result(Result::Ret::kFileOpenError, "inotify_init1: " + std::string(std::strerror(errno)));
+    }
+    wd_ = inotify_add_watch(fd_, dir_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd_ < 0)
+    {
+        return Result(Result::Ret::kFileOpenError, "inotify_add_watch " + dir_ + ": " + std::strerror(errno));
+    }
+    return Result(Result::Ret::kOk, dir_);
+}
+
+Result DirWatcher::poll(std::chrono::milliseconds timeout, std::vector<std::string> &names)
+{
+    if (fd_ < 0)
+    {
+        return Result(Result::Ret::kInvalidParam, "watcher not opened: " + dir_);
+    }
+    struct pollfd pfd = {fd_, POLLIN, 0};
+    int ready = ::poll(&pfd, 1, static_cast<int>(timeout.count()));
+    if (ready < 0)
+    {
+        if (errno == EINTR)
+            return Result(Result::Ret::kOk, dir_);
+        return Result(Result::Ret::kFileReadError, "poll " + dir_ + ": " + std::strerror(errno));
+    }
+    if (ready == 0)
+    {
+        return Result(Result::Ret::kOk, dir_);
+    }
+
+    alignas(struct inotify_event) char buf[64 * 1024];
+    bool overflow = false;
+    while (true)
+    {
+        ssize_t len = ::read(fd_, buf, sizeof(buf));
+        if (len < 0)
+        {
+            if (errno == EAGAIN || errno == EINTR)
+                break;
+            return Result(Result::Ret::kFileReadError, "read inotify " + dir_ + ": " + std::strerror(errno));
+        }
+        for (char *p = buf; p < buf + len;)
+        {
+            auto *event = reinterpret_cast<struct inotify_event *>(p);
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                overflow = true;
+            }
+            else if (event->len > 0 && !(event->mask & IN_ISDIR))
+            {
+                names.emplace_back(event->name);
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    if (overflow)
+    {
+        LOG_WARN("inotify queue overflow, rescanning " + dir_);
+        rescan(names);
+    }
+    return Result(Result::Ret::kOk, dir_);
+}
+
+void DirWatcher::rescan(std::vector<std::string> &names) const
+{
+    std::error_code ec;
+    for (const auto &entry : fs::directory_iterator(dir_, ec))
+    {
+        if (entry.is_regular_file())
+            names.push_back(entry.path().filename().string());
+    }
+}
@@ -1,24 +1,50 @@
 #include "mock/fileManager.h"
 #include "utils/klog.h"
-#include <nlohmann/json.hpp>
-
-using json = nlohmann::json;
 
 Result FileManager::write(const DataType &data)
 {
-    getFileName();
-    LOG_DEBUG("Writing data to file: " + filePath_);
+    // 用 getFileName 的返回值而不是 filePath_，并发写入时 filePath_ 可能已被其他线程改写
+    std::string filePath = getFileName().message_raw();
+    std::string tempPath = FilePublisher::tempPath(filePath);
+    LOG_DEBUG("Writing data to file: " + tempPath);
 
-    std::ofstream file(filePath_);
-    if (!file.is_open())
+    std::unique_ptr<IoWriter> file;
+    Result openRes = backend_->openForWrite(tempPath, file);
+    if (openRes.isError())
+    {
+        LOG_ERROR("Failed to open file for writing: " + tempPath);
+        return Result(Result::Ret::kFileOpenError, tempPath);
+    }
+    std::unique_ptr<IoWriter> out;
+    Result codecRes = CompressingWriter::create(codec_, codecLevel_, std::move(file), out);
+    if (codecRes.isError())
     {
-        LOG_ERROR("Failed to open file for writing: " + filePath_);
-        return Result(Result::Ret::kFileOpenError, filePath_);
+        LOG_ERROR("Failed to set up " + std::string(codecName(codec_)) + " for " + tempPath + ": " + codecRes.message_raw());
+        FilePublisher::discard(tempPath);
+        return Result(Result::Ret::kInvalidParam, tempPath);
     }
 
-    json j = data;
-    file << j.dump(4); // 缩进为 4 空格，美化输出
-    file.close();
+    // 每个线程复用自己的序列化缓冲区
+    thread_local KvJsonWriter writer;
+    writer.setStyle(style_);
+    Result writeRes = writer.write(*out, data);
+    Result closeRes = out->close();
+    if (!writeRes.isError())
+    {
+        writeRes = closeRes;
+    }
+    if (writeRes.isError())
+    {
+        LOG_ERROR("Failed to write file: " + tempPath + ": " + writeRes.message_raw());
+        FilePublisher::discard(tempPath);
+        return Result(Result::Ret::kFileWriteError, tempPath);
+    }
 
-    return Result(Result::Ret::kOk, filePath_);
-}
\ No newline at end of file
+    Result res = publisher_->publish(tempPath, filePath);
+    if (res.isError())
+    {
+        LOG_ERROR("Failed to publish " + filePath + ": " + res.message_raw());
+        return res;
+    }
+    return Result(Result::Ret::kOk, filePath);
+}
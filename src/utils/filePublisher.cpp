@@ -0,0 +1,215 @@
+#include "utils/filePublisher.h"
+#include "utils/klog.h"
+#include "utils/metrics.h"
+#include "utils/trace.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    std::string parentDir(const std::string &path)
+    {
+        fs::path parent = fs::path(path).parent_path();
+        return parent.empty() ? "." : parent.string();
+    }
+
+    Result fsyncPath(const std::string &path, int flags)
+    {
+        int fd = ::open(path.c_str(), flags);
+        if (fd < 0)
+            return Result(Result::Ret::kFileOpenError, path + ": " + std::strerror(errno));
+        int rc = ::fsync(fd);
+        int err = errno;
+        ::close(fd);
+        if (rc != 0)
+            return Result(Result::Ret::kFileWriteError, "fsync " + path + ": " + std::strerror(err));
+        return Result(Result::Ret::kOk, path);
+    }
+}
+
+Result parseSyncPolicy(const std::string &spec, SyncPolicy &policy, size_t &batchSize)
+{
+    if (spec == "none")
+    {
+        policy = SyncPolicy::kNone;
+        return Result(Result::Ret::kOk, spec);
+    }
+    if (spec == "file")
+    {
+        policy = SyncPolicy::kPerFile;
+        return Result(Result::Ret::kOk, spec);
+    }
+    if (spec.rfind("batch", 0) == 0)
+    {
+        if (spec.size() > 5)
+        {
+            if (spec[5] != ':')
+                return Result(Result::Ret::kInvalidParam, "sync policy must be none, file or batch[:N]: " + spec);
+            try
+            {
+                long n = std::stol(spec.substr(6));
+                if (n <= 0)
+                    return Result(Result::Ret::kInvalidParam, "batch size must be positive: " + spec);
+                batchSize = static_cast<size_t>(n);
+            }
+            catch (const std::exception &)
+            {
+                return Result(Result::Ret::kInvalidParam, "invalid batch size: " + spec);
+            }
+        }
+        policy = SyncPolicy::kBatched;
+        return Result(Result::Ret::kOk, spec);
+    }
+    return Result(Result::Ret::kInvalidParam, "sync policy must be none, file or batch[:N]: " + spec);
+}
+
+FilePublisher::~FilePublisher()
+{
+    Result res = flush();
+    if (res.isError())
+        LOG_ERROR("Failed to flush published files: " + res.message_raw());
+}
+
+std::string FilePublisher::tempPath(const std::string &finalPath)
+{
+    fs::path path(finalPath);
+    return (path.parent_path() / ("." + path.filename().string() + ".tmp")).string();
+}
+
+void FilePublisher::discard(const std::string &tempPath)
+{
+    std::error_code ec;
+    fs::remove(tempPath, ec);
+}
+
+Result FilePublisher::writeFile(const std::string &finalPath, const std::string &content, bool durable)
+{
+    std::string temp = tempPath(finalPath);
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return Result(Result::Ret::kFileOpenError, temp + ": " + std::strerror(errno));
+    size_t written = 0;
+    int err = 0;
+    while (written < content.size() && err == 0)
+    {
+        ssize_t n = ::write(fd, content.data() + written, content.size() - written);
+        if (n >= 0)
+            written += static_cast<size_t>(n);
+        else if (errno != EINTR)
+            err = errno;
+    }
+    if (err == 0 && durable && ::fsync(fd) != 0)
+        err = errno;
+    ::close(fd);
+    if (err != 0)
+    {
+        discard(temp);
+        return Result(Result::Ret::kFileWriteError, temp + ": " + std::strerror(err));
+    }
+
+    if (std::rename(temp.c_str(), finalPath.c_str()) != 0)
+    {
+        err = errno;
+        discard(temp);
+        return Result(Result::Ret::kFileWriteError, "rename " + temp + " -> " + finalPath + ": " + std::strerror(err));
+    }
+    if (durable)
+        return fsyncPath(parentDir(finalPath), O_RDONLY | O_DIRECTORY);
+    return Result(Result::Ret::kOk, finalPath);
+}
+
+Result FilePublisher::publish(const std::string &tempPath, const std::string &finalPath)
+{
+    static MetricsHistogram &fsyncLatency = metricsHistogram("bingest_publish_fsync_ns", "fsync latency per published file (file policy)");
+    static MetricsCounter &published = metricsCounter("bingest_published_files_total", "files published by temp-file rename");
+    TRACE_SPAN("publish");
+
+    if (policy_ == SyncPolicy::kPerFile)
+    {
+        ScopedLatency timer(fsyncLatency);
+        Result res = fsyncPath(tempPath, O_RDONLY);
+        if (res.isError())
+        {
+            discard(tempPath);
+            return res;
+        }
+    }
+
+    if (std::rename(tempPath.c_str(), finalPath.c_str()) != 0)
+    {
+        int err = errno;
+        discard(tempPath);
+        return Result(Result::Ret::kFileWriteError, "rename " + tempPath + " -> " + finalPath + ": " + std::strerror(err));
+    }
+    published.add();
+
+    std::string dir = parentDir(finalPath);
+    if (policy_ == SyncPolicy::kPerFile)
+    {
+        return fsyncPath(dir, O_RDONLY | O_DIRECTORY);
+    }
+    if (policy_ == SyncPolicy::kBatched)
+    {
+        bool full = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pendingDirs_.insert(dir);
+            full = ++pendingFiles_ >= batchSize_;
+        }
+        if (full)
+            return flush();
+    }
+    return Result(Result::Ret::kOk, finalPath);
+}
+
+Result FilePublisher::flush()
+{
+    static MetricsHistogram &flushLatency = metricsHistogram("bingest_publish_flush_ns", "syncfs + directory fsync latency per batch");
+    if (policy_ != SyncPolicy::kBatched)
+        return Result(Result::Ret::kOk);
+
+    // 取出待刷目录后释放锁，刷盘期间其他任务可以继续发布
+    std::set<std::string> dirs;
+    size_t numFiles = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dirs.swap(pendingDirs_);
+        numFiles = pendingFiles_;
+        pendingFiles_ = 0;
+    }
+    if (dirs.empty())
+        return Result(Result::Ret::kOk);
+
+    TRACE_SPAN("flush");
+    ScopedLatency timer(flushLatency);
+    Result res(Result::Ret::kOk, std::to_string(numFiles) + " files synced");
+    std::set<dev_t> syncedDevices; // 每个文件系统只做一次 syncfs
+    for (const auto &dir : dirs)
+    {
+        int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd < 0)
+        {
+            res = Result(Result::Ret::kFileOpenError, dir + ": " + std::strerror(errno));
+            continue;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && syncedDevices.insert(st.st_dev).second && ::syncfs(fd) != 0)
+        {
+            res = Result(Result::Ret::kFileWriteError, "syncfs " + dir + ": " + std::strerror(errno));
+        }
+        if (::fsync(fd) != 0)
+        {
+            res = Result(Result::Ret::kFileWriteError, "fsync " + dir + ": " + std::strerror(errno));
+        }
+        ::close(fd);
+    }
+    LOG_DEBUG("Flushed " + std::to_string(numFiles) + " published files in " + std::to_string(dirs.size()) + " directories");
+    return res;
+}
@@ -0,0 +1,774 @@
+#include "utils/ioBackend.h"
+#include "utils/klog.h"
+#include "utils/metrics.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    std::string errnoMessage(const std::string &what, int err)
+    {
+        return what + ": " + std::strerror(err);
+    }
+
+    Result openRead(const std::string &path, int &fd, size_t &size)
+    {
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return Result(Result::Ret::kFileOpenError, path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            int err = errno;
+            ::close(fd);
+            return Result(Result::Ret::kFileReadError, errnoMessage(path, err));
+        }
+        size = static_cast<size_t>(st.st_size);
+        return Result(Result::Ret::kOk);
+    }
+
+    Result openWrite(const std::string &path, int &fd)
+    {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            return Result(Result::Ret::kFileOpenError, path);
+        }
+        return Result(Result::Ret::kOk);
+    }
+
+    class PosixWriter : public IoWriter
+    {
+    public:
+        explicit PosixWriter(int fd) : fd_(fd) {}
+        ~PosixWriter() override
+        {
+            if (fd_ >= 0)
+                ::close(fd_);
+        }
+
+        Result write(const char *data, size_t size) override
+        {
+            while (size > 0)
+            {
+                ssize_t n = ::pwrite(fd_, data, size, static_cast<off_t>(offset_));
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return Result(Result::Ret::kFileWriteError, errnoMessage("pwrite", errno));
+                }
+                data += n;
+                size -= static_cast<size_t>(n);
+                offset_ += static_cast<uint64_t>(n);
+            }
+            return Result(Result::Ret::kOk);
+        }
+
+        Result close() override
+        {
+            int fd = fd_;
+            fd_ = -1;
+            if (fd >= 0 && ::close(fd) != 0)
+            {
+                return Result(Result::Ret::kFileWriteError, errnoMessage("close", errno));
+            }
+            return Result(Result::Ret::kOk);
+        }
+
+    private:
+        int fd_;
+        uint64_t offset_ = 0;
+    };
+}
+
+Result PosixIoBackend::readFile(const std::string &path, std::string &out)
+{
+    int fd;
+    size_t size;
+    Result res = openRead(path, fd, size);
+    if (res.isError())
+        return res;
+    out.resize(size);
+    size_t done = 0;
+    while (done < size)
+    {
+        ssize_t n = ::pread(fd, &out[done], size - done, static_cast<off_t>(done));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            int err = errno;
+            ::close(fd);
+            return Result(Result::Ret::kFileReadError, errnoMessage(path, err));
+        }
+        if (n == 0)
+            break; // 文件在读取期间变短
+        done += static_cast<size_t>(n);
+    }
+    out.resize(done);
+    ::close(fd);
+    return Result(Result::Ret::kOk);
+}
+
+void PosixIoBackend::prefetch(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    ::close(fd);
+}
+
+Result PosixIoBackend::openForWrite(const std::string &path, std::unique_ptr<IoWriter> &writer)
+{
+    int fd;
+    Result res = openWrite(path, fd);
+    if (res.isError())
+        return res;
+    writer = std::make_unique<PosixWriter>(fd);
+    return Result(Result::Ret::kOk);
+}
+
+// -------- io_uring --------
+
+namespace
+{
+    // 只被一个线程使用的 ring：SQE 分配、提交与 CQE 收割
+    class Ring
+    {
+    public:
+        Ring() = default;
+        Ring(const Ring &) = delete;
+        Ring &operator=(const Ring &) = delete;
+        ~Ring()
+        {
+            if (sqes_ != MAP_FAILED)
+                ::munmap(sqes_, sqesSize_);
+            if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_)
+                ::munmap(cqRing_, cqRingSize_);
+            if (sqRing_ != MAP_FAILED)
+                ::munmap(sqRing_, sqRingSize_);
+            if (fd_ >= 0)
+                ::close(fd_);
+        }
+
+        Result init(unsigned entries)
+        {
+            io_uring_params params;
+            std::memset(&params, 0, sizeof(params));
+            fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+            if (fd_ < 0)
+            {
+                return Result(Result::Ret::kError, errnoMessage("io_uring_setup", errno));
+            }
+
+            sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (singleMmap)
+                sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+            sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+            if (sqRing_ == MAP_FAILED)
+                return Result(Result::Ret::kError, errnoMessage("mmap sq ring", errno));
+            cqRing_ = singleMmap ? sqRing_ : ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+            if (cqRing_ == MAP_FAILED)
+                return Result(Result::Ret::kError, errnoMessage("mmap cq ring", errno));
+            sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+            void *sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+            if (sqes == MAP_FAILED)
+                return Result(Result::Ret::kError, errnoMessage("mmap sqes", errno));
+            sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+            char *sq = static_cast<char *>(sqRing_);
+            sqHead_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+            sqTail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+            sqMask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+            sqArray_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+            sqEntries_ = params.sq_entries;
+            char *cq = static_cast<char *>(cqRing_);
+            cqHead_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+            cqTail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+            cqMask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+            cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+            sqeTail_ = *sqTail_;
+            return Result(Result::Ret::kOk);
+        }
+
+        int fd() const { return fd_; }
+
+        // 队列满时返回 nullptr
+        io_uring_sqe *nextSqe()
+        {
+            unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+            if (sqeTail_ - head >= sqEntries_)
+                return nullptr;
+            unsigned index = sqeTail_ & sqMask_;
+            sqArray_[index] = index;
+            ++sqeTail_;
+            io_uring_sqe *sqe = &sqes_[index];
+            std::memset(sqe, 0, sizeof(*sqe));
+            return sqe;
+        }
+
+        // 一次系统调用提交全部已分配的 SQE，waitNr > 0 时同时等待完成
+        Result enter(unsigned waitNr)
+        {
+            static MetricsCounter &enters = metricsCounter("bingest_io_uring_enter_total", "io_uring_enter system calls");
+            __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+            while (true)
+            {
+                unsigned toSubmit = sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+                if (toSubmit == 0 && waitNr == 0)
+                    return Result(Result::Ret::kOk);
+                long ret = ::syscall(__NR_io_uring_enter, fd_, toSubmit, waitNr, waitNr > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+                enters.add();
+                if (ret >= 0)
+                    return Result(Result::Ret::kOk);
+                if (errno != EINTR)
+                    return Result(Result::Ret::kError, errnoMessage("io_uring_enter", errno));
+            }
+        }
+
+        bool peek(io_uring_cqe &cqe)
+        {
+            unsigned head = *cqHead_;
+            if (head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE))
+                return false;
+            cqe = cqes_[head & cqMask_];
+            __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+            return true;
+        }
+
+    private:
+        int fd_ = -1;
+        void *sqRing_ = MAP_FAILED;
+        void *cqRing_ = MAP_FAILED;
+        io_uring_sqe *sqes_ = static_cast<io_uring_sqe *>(MAP_FAILED);
+        size_t sqRingSize_ = 0;
+        size_t cqRingSize_ = 0;
+        size_t sqesSize_ = 0;
+        unsigned *sqHead_ = nullptr;
+        unsigned *sqTail_ = nullptr;
+        unsigned *sqArray_ = nullptr;
+        unsigned sqMask_ = 0;
+        unsigned sqEntries_ = 0;
+        unsigned *cqHead_ = nullptr;
+        unsigned *cqTail_ = nullptr;
+        unsigned cqMask_ = 0;
+        io_uring_cqe *cqes_ = nullptr;
+        unsigned sqeTail_ = 0; // 已分配的 SQE 尾部，enter 时才对内核可见
+    };
+
+    // ring 及其写缓冲区，缓冲区在第一次写入时分配并尝试注册
+    struct RingContext
+    {
+        Ring ring;
+        char *buffers = nullptr;
+        bool registered = false;
+
+        ~RingContext() { std::free(buffers); }
+
+        Result ensureBuffers()
+        {
+            if (buffers)
+                return Result(Result::Ret::kOk);
+            constexpr size_t bytes = IoUringBackend::kQueueDepth * IoUringBackend::kChunkSize;
+            buffers = static_cast<char *>(std::aligned_alloc(4096, bytes));
+            if (!buffers)
+                return Result(Result::Ret::kOutOfMemory, "io_uring write buffers");
+            iovec iov[IoUringBackend::kQueueDepth];
+            for (unsigned i = 0; i < IoUringBackend::kQueueDepth; ++i)
+                iov[i] = iovec{buffers + i * IoUringBackend::kChunkSize, IoUringBackend::kChunkSize};
+            // 注册受 RLIMIT_MEMLOCK 限制，失败时退回普通 WRITE，功能不变
+            registered = ::syscall(__NR_io_uring_register, ring.fd(), IORING_REGISTER_BUFFERS, iov, IoUringBackend::kQueueDepth) == 0;
+            if (!registered)
+                LOG_DEBUG("io_uring buffer registration failed, using unregistered writes: " + std::string(std::strerror(errno)));
+            return Result(Result::Ret::kOk);
+        }
+
+        char *buffer(size_t slot) const { return buffers + slot * IoUringBackend::kChunkSize; }
+    };
+}
+
+struct IoUringBackend::Impl
+{
+    struct PendingRead;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<RingContext>> idle;
+
+    // 一个预读项；read 为空表示正在锁外打开文件、发起读取，已占用名额
+    struct ReadAhead
+    {
+        std::unique_ptr<PendingRead> read;
+        size_t bytes = 0;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    std::mutex readAheadMutex;
+    std::unordered_map<std::string, ReadAhead> readAhead;
+    size_t readAheadBytes = 0;
+    std::chrono::milliseconds readAheadExpiry = IoUringBackend::kReadAheadExpiry;
+
+    // 调用方持有 readAheadMutex：取出超时未被读取的预读项，由调用方在锁外释放（等待在途请求、归还 ring 与 fd）
+    void takeExpired(std::vector<std::unique_ptr<PendingRead>> &expired);
+
+    Result acquire(std::unique_ptr<RingContext> &context)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!idle.empty())
+            {
+                context = std::move(idle.back());
+                idle.pop_back();
+                return Result(Result::Ret::kOk);
+            }
+        }
+        auto created = std::make_unique<RingContext>();
+        Result res = created->ring.init(kQueueDepth);
+        if (res.isError())
+            return res;
+        context = std::move(created);
+        return Result(Result::Ret::kOk);
+    }
+
+    void release(std::unique_ptr<RingContext> context)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(std::move(context));
+    }
+};
+
+namespace
+{
+    // 一个文件上的在途请求。每个槽位对应一个请求，写入时槽位 i 使用 ring 的第 i 个缓冲区
+    class RingFile
+    {
+    public:
+        RingFile(std::shared_ptr<IoUringBackend::Impl> pool, std::unique_ptr<RingContext> context, int fd)
+            : pool_(std::move(pool)), context_(std::move(context)), fd_(fd)
+        {
+        }
+        RingFile(const RingFile &) = delete;
+        RingFile &operator=(const RingFile &) = delete;
+        ~RingFile()
+        {
+            // 内核仍可能写入在途缓冲区，归还 ring 前必须收完全部完成事件
+            drain();
+            if (fd_ >= 0)
+                ::close(fd_);
+            pool_->release(std::move(context_));
+        }
+
+        RingContext &context() { return *context_; }
+
+        bool hasFreeSlot() const { return inflight_ < IoUringBackend::kQueueDepth; }
+
+        // 取一个空闲槽位，没有时等待一个请求完成
+        Result acquireSlot(size_t &slot)
+        {
+            while (!hasFreeSlot())
+            {
+                Result res = waitOne();
+                if (res.isError())
+                    return res;
+            }
+            for (slot = 0; slot < IoUringBackend::kQueueDepth && slots_[slot].busy; ++slot)
+            {
+            }
+            return Result(Result::Ret::kOk);
+        }
+
+        // 在 slot 上发起请求，enter 之前不会提交
+        Result start(size_t slot, bool write, char *addr, size_t len, uint64_t offset)
+        {
+            slots_[slot] = Slot{addr, len, offset, write, true};
+            ++inflight_;
+            return prepare(slot);
+        }
+
+        Result submit() { return context_->ring.enter(0); }
+
+        // 等待全部请求完成，返回第一个错误
+        Result drain()
+        {
+            while (inflight_ > 0)
+            {
+                Result res = waitOne();
+                if (res.isError())
+                {
+                    // ring 本身出错时无法再收割，放弃这些槽位
+                    inflight_ = 0;
+                    return res;
+                }
+            }
+            return error_;
+        }
+
+        Result closeFile()
+        {
+            Result res = drain();
+            int fd = fd_;
+            fd_ = -1;
+            if (::close(fd) != 0 && !res.isError())
+                res = Result(Result::Ret::kFileWriteError, errnoMessage("close", errno));
+            return res;
+        }
+
+    private:
+        struct Slot
+        {
+            char *addr = nullptr;
+            size_t len = 0;
+            uint64_t offset = 0;
+            bool write = false;
+            bool busy = false;
+        };
+
+        Result prepare(size_t slot)
+        {
+            Ring &ring = context_->ring;
+            io_uring_sqe *sqe = ring.nextSqe();
+            if (!sqe)
+            {
+                Result res = ring.enter(0);
+                if (res.isError())
+                    return res;
+                sqe = ring.nextSqe();
+                if (!sqe)
+                    return Result(Result::Ret::kError, "io_uring submission queue full");
+            }
+            const Slot &s = slots_[slot];
+            bool fixed = s.write && context_->registered;
+            sqe->opcode = s.write ? (fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE) : IORING_OP_READ;
+            sqe->fd = fd_;
+            sqe->addr = reinterpret_cast<uint64_t>(s.addr);
+            sqe->len = static_cast<uint32_t>(s.len);
+            sqe->off = s.offset;
+            sqe->buf_index = fixed ? static_cast<uint16_t>(slot) : 0;
+            sqe->user_data = slot;
+            return Result(Result::Ret::kOk);
+        }
+
+        Result waitOne()
+        {
+            Ring &ring = context_->ring;
+            io_uring_cqe cqe;
+            while (!ring.peek(cqe))
+            {
+                Result res = ring.enter(1);
+                if (res.isError())
+                    return res;
+            }
+            Slot &s = slots_[cqe.user_data];
+            if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+                return prepare(cqe.user_data);
+            if (cqe.res > 0 && static_cast<size_t>(cqe.res) < s.len)
+            {
+                // 短读写：在同一槽位上继续剩余部分
+                s.addr += cqe.res;
+                s.len -= static_cast<size_t>(cqe.res);
+                s.offset += static_cast<uint64_t>(cqe.res);
+                return prepare(cqe.user_data);
+            }
+            if (cqe.res <= 0 && !error_.isError())
+            {
+                Result::Ret ret = s.write ? Result::Ret::kFileWriteError : Result::Ret::kFileReadError;
+                error_ = cqe.res < 0 ? Result(ret, errnoMessage(s.write ? "io_uring write" : "io_uring read", -cqe.res))
+                                     : Result(ret, "unexpected end of file");
+            }
+            s.busy = false;
+            --inflight_;
+            return Result(Result::Ret::kOk);
+        }
+
+        std::shared_ptr<IoUringBackend::Impl> pool_;
+        std::unique_ptr<RingContext> context_;
+        int fd_;
+        Slot slots_[IoUringBackend::kQueueDepth];
+        size_t inflight_ = 0;
+        Result error_{Result::Ret::kOk};
+    };
+
+    class UringWriter : public IoWriter
+    {
+    public:
+        explicit UringWriter(std::unique_ptr<RingFile> file) : file_(std::move(file)) {}
+
+        Result write(const char *data, size_t size) override
+        {
+            while (size > 0)
+            {
+                size_t slot;
+                Result res = file_->acquireSlot(slot);
+                if (res.isError())
+                    return res;
+                size_t n = std::min(size, IoUringBackend::kChunkSize);
+                char *buffer = file_->context().buffer(slot);
+                std::memcpy(buffer, data, n);
+                res = file_->start(slot, true, buffer, n, offset_);
+                if (res.isError())
+                    return res;
+                data += n;
+                size -= n;
+                offset_ += n;
+            }
+            return file_->submit();
+        }
+
+        Result close() override
+        {
+            Result res = file_->submit();
+            Result closeRes = file_->closeFile();
+            return res.isError() ? res : closeRes;
+        }
+
+    private:
+        std::unique_ptr<RingFile> file_;
+        uint64_t offset_ = 0;
+    };
+}
+
+// 一个文件的整读：按块提交，队列有空位就继续提交后面的块
+struct IoUringBackend::Impl::PendingRead
+{
+    std::string data;
+    std::unique_ptr<RingFile> file;
+    size_t nextOffset = 0;
+
+    Result start(const std::shared_ptr<Impl> &pool, const std::string &path)
+    {
+        int fd;
+        size_t size;
+        Result res = openRead(path, fd, size);
+        if (res.isError())
+            return res;
+        std::unique_ptr<RingContext> context;
+        res = pool->acquire(context);
+        if (res.isError())
+        {
+            ::close(fd);
+            return res;
+        }
+        file = std::make_unique<RingFile>(pool, std::move(context), fd);
+        data.resize(size);
+        return pump(false);
+    }
+
+    // wait 为 false 时只填满空闲槽位，不阻塞
+    Result pump(bool wait)
+    {
+        while (nextOffset < data.size() && (wait || file->hasFreeSlot()))
+        {
+            size_t slot;
+            Result res = file->acquireSlot(slot);
+            if (res.isError())
+                return res;
+            size_t n = std::min(data.size() - nextOffset, kChunkSize);
+            res = file->start(slot, false, &data[nextOffset], n, nextOffset);
+            if (res.isError())
+                return res;
+            nextOffset += n;
+        }
+        return file->submit();
+    }
+
+    Result finish(std::string &out)
+    {
+        Result res = pump(true);
+        Result closeRes = file->closeFile();
+        if (res.isError())
+            return res;
+        if (closeRes.isError())
+            return closeRes;
+        out = std::move(data);
+        return Result(Result::Ret::kOk);
+    }
+};
+
+Result IoUringBackend::create(std::shared_ptr<IoBackend> &backend)
+{
+    auto impl = std::make_shared<Impl>();
+    std::unique_ptr<RingContext> context;
+    Result res = impl->acquire(context);
+    if (res.isError())
+        return res;
+    impl->release(std::move(context));
+    backend.reset(new IoUringBackend(std::move(impl)));
+    return Result(Result::Ret::kOk, "uring");
+}
+
+void IoUringBackend::Impl::takeExpired(std::vector<std::unique_ptr<PendingRead>> &expired)
+{
+    static MetricsCounter &expiredReads = metricsCounter("bingest_io_read_ahead_expired_total", "read-ahead files dropped because nobody read them in time");
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = readAhead.begin(); it != readAhead.end();)
+    {
+        if (it->second.read && now - it->second.started >= readAheadExpiry)
+        {
+            readAheadBytes -= it->second.bytes;
+            expired.push_back(std::move(it->second.read));
+            it = readAhead.erase(it);
+            expiredReads.add();
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+IoUringBackend::~IoUringBackend()
+{
+    // 预读项持有 impl_ 的引用，先释放它们
+    std::lock_guard<std::mutex> lock(impl_->readAheadMutex);
+    impl_->readAhead.clear();
+}
+
+void IoUringBackend::setReadAheadExpiry(std::chrono::milliseconds expiry)
+{
+    std::lock_guard<std::mutex> lock(impl_->readAheadMutex);
+    impl_->readAheadExpiry = expiry;
+}
+
+size_t IoUringBackend::readAheadFiles() const
+{
+    std::lock_guard<std::mutex> lock(impl_->readAheadMutex);
+    return impl_->readAhead.size();
+}
+
+Result IoUringBackend::readFile(const std::string &path, std::string &out)
+{
+    static MetricsCounter &hits = metricsCounter("bingest_io_read_ahead_hits_total", "files already being read ahead when requested");
+    std::unique_ptr<Impl::PendingRead> pending;
+    std::vector<std::unique_ptr<Impl::PendingRead>> expired;
+    {
+        std::lock_guard<std::mutex> lock(impl_->readAheadMutex);
+        impl_->takeExpired(expired);
+        auto it = impl_->readAhead.find(path);
+        // 仍在发起中的预读不等待，直接自己读；它发起后无人认领，到期丢弃
+        if (it != impl_->readAhead.end() && it->second.read)
+        {
+            pending = std::move(it->second.read);
+            impl_->readAheadBytes -= it->second.bytes;
+            impl_->readAhead.erase(it);
+        }
+    }
+    expired.clear();
+    if (pending)
+    {
+        hits.add();
+    }
+    else
+    {
+        pending = std::make_unique<Impl::PendingRead>();
+        Result res = pending->start(impl_, path);
+        if (res.isError())
+            return res;
+    }
+    return pending->finish(out);
+}
+
+void IoUringBackend::prefetch(const std::string &path)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0)
+        return;
+    size_t size = static_cast<size_t>(st.st_size);
+    std::vector<std::unique_ptr<Impl::PendingRead>> expired;
+    {
+        // 锁内只清理过期项并占用名额，打开文件与借用 ring 在锁外进行
+        std::lock_guard<std::mutex> lock(impl_->readAheadMutex);
+        impl_->takeExpired(expired);
+        if (impl_->readAhead.count(path) || impl_->readAhead.size() >= kMaxReadAheadFiles ||
+            impl_->readAheadBytes + size > kMaxReadAheadBytes)
+        {
+            return;
+        }
+        Impl::ReadAhead &slot = impl_->readAhead[path];
+        slot.bytes = size;
+        impl_->readAheadBytes += size;
+    }
+    expired.clear();
+
+    auto pending = std::make_unique<Impl::PendingRead>();
+    bool started = !pending->start(impl_, path).isError();
+    std::lock_guard<std::mutex> lock(impl_->readAheadMutex);
+    auto it = impl_->readAhead.find(path);
+    if (!started)
+    {
+        impl_->readAheadBytes -= it->second.bytes;
+        impl_->readAhead.erase(it);
+        return;
+    }
+    it->second.read = std::move(pending);
+    it->second.started = std::chrono::steady_clock::now();
+}
+
+Result IoUringBackend::openForWrite(const std::string &path, std::unique_ptr<IoWriter> &writer)
+{
+    std::unique_ptr<RingContext> context;
+    Result res = impl_->acquire(context);
+    if (res.isError())
+        return res;
+    res = context->ensureBuffers();
+    if (res.isError())
+    {
+        impl_->release(std::move(context));
+        return res;
+    }
+    int fd;
+    res = openWrite(path, fd);
+    if (res.isError())
+    {
+        impl_->release(std::move(context));
+        return res;
+    }
+    writer = std::make_unique<UringWriter>(std::make_unique<RingFile>(impl_, std::move(context), fd));
+    return Result(Result::Ret::kOk);
+}
+
+Result makeIoBackend(const std::string &name, std::shared_ptr<IoBackend> &backend)
+{
+    if (name == "posix")
+    {
+        backend = std::make_shared<PosixIoBackend>();
+        return Result(Result::Ret::kOk, name);
+    }
+    if (name == "uring")
+    {
+        return IoUringBackend::create(backend);
+    }
+    if (name == "auto")
+    {
+        Result res = IoUringBackend::create(backend);
+        if (res.isError())
+        {
+            LOG_WARN("io_uring unavailable (" + res.message_raw() + "), using posix I/O");
+            backend = std::make_shared<PosixIoBackend>();
+        }
+        return Result(Result::Ret::kOk, backend->name());
+    }
+    return Result(Result::Ret::kInvalidParam, "I/O backend must be posix, uring or auto: " + name);
+}
+
+const std::shared_ptr<IoBackend> &defaultIoBackend()
+{
+    static const std::shared_ptr<IoBackend> instance = std::make_shared<PosixIoBackend>();
+    return instance;
+}
@@ -0,0 +1,247 @@
+#include "utils/klog.h"
+#include <algorithm>
+#include <ctime>
+
+namespace
+{
+    const char *levelTag(KLogger::KLogLevel level)
+    {
+        switch (level)
+        {
+        case KLogger::Debug:
+            return "[DEBUG] ";
+        case KLogger::Info:
+            return "[INFO] ";
+        case KLogger::Warning:
+            return "[WARNING] ";
+        case KLogger::Error:
+            return "[ERROR] ";
+        }
+        return "[INFO] ";
+    }
+
+    constexpr auto kFlushInterval = std::chrono::milliseconds(20);
+}
+
+bool KLogger::Ring::push(Record &record)
+{
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) >= kCapacity)
+        return false;
+    slots_[tail % kCapacity] = std::move(record);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool KLogger::Ring::pop(Record &record)
+{
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+        return false;
+    record = std::move(slots_[head % kCapacity]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+KLogger::~KLogger()
+{
+    stop_.store(true, std::memory_order_release);
+    flushCv_.notify_all();
+    if (flusher_.joinable())
+        flusher_.join();
+    // 收尾：写出 flusher 退出前最后一刻入队的日志
+    drain();
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    if (file_ != nullptr)
+    {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+KLogger::Ring &KLogger::localRing()
+{
+    struct LocalRing
+    {
+        const KLogger *owner = nullptr;
+        RingHolder holder;
+    };
+    thread_local LocalRing local;
+    if (local.owner != this || !local.holder.ring)
+    {
+        if (local.holder.ring)
+            local.holder.ring->retired.store(true, std::memory_order_release);
+        local.holder.ring = std::make_shared<Ring>();
+        local.owner = this;
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        rings_.push_back(local.holder.ring);
+    }
+    return *local.holder.ring;
+}
+
+void KLogger::start()
+{
+    flusher_ = std::thread([this]
+                           { flusherLoop(); });
+    running_.store(true, std::memory_order_release);
+}
+
+void KLogger::log(KLogLevel level, std::string msg)
+{
+    Record record;
+    record.level = level;
+    record.time = std::chrono::system_clock::now();
+    record.message = std::move(msg);
+
+    if (stop_.load(std::memory_order_acquire))
+    {
+        // 析构阶段 flusher 已退出，直接同步写出
+        std::lock_guard<std::mutex> lock(fileMutex_);
+        write(record);
+        return;
+    }
+
+    std::call_once(started_, [this]
+                   { start(); });
+
+    Ring &ring = localRing();
+    while (!ring.push(record))
+    {
+        // 缓冲满时唤醒 flusher 并让出 CPU，形成反压而不是丢日志
+        flushCv_.notify_one();
+        std::this_thread::yield();
+    }
+    if (level >= Error)
+        flushCv_.notify_one();
+}
+
+void KLogger::flush()
+{
+    if (!running_.load(std::memory_order_acquire))
+        return;
+    std::unique_lock<std::mutex> lock(flushMutex_);
+    uint64_t ticket = ++flushRequested_;
+    flushCv_.notify_one();
+    flushedCv_.wait(lock, [this, ticket]
+                    { return flushCompleted_ >= ticket || stop_.load(std::memory_order_acquire); });
+}
+
+void KLogger::setLogFile(const std::string &fileName)
+{
+    flush();
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    if (file_ != nullptr)
+    {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    fileName_ = fileName;
+    fileOpened_ = false;
+}
+
+void KLogger::flusherLoop()
+{
+    while (true)
+    {
+        uint64_t ticket;
+        {
+            std::unique_lock<std::mutex> lock(flushMutex_);
+            flushCv_.wait_for(lock, kFlushInterval, [this]
+                              { return stop_.load(std::memory_order_acquire) || flushRequested_ != flushCompleted_; });
+            ticket = flushRequested_;
+        }
+
+        bool stopping = stop_.load(std::memory_order_acquire);
+        size_t written = drain();
+        if (written > 0 || ticket != flushCompleted_ || stopping)
+        {
+            std::lock_guard<std::mutex> lock(fileMutex_);
+            if (file_ != nullptr)
+                std::fflush(file_);
+            std::fflush(stdout);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(flushMutex_);
+            flushCompleted_ = ticket;
+        }
+        flushedCv_.notify_all();
+
+        if (stopping)
+            return;
+    }
+}
+
+size_t KLogger::drain()
+{
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        // 回收已退出且已清空的线程缓冲
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::shared_ptr<Ring> &ring)
+                                    { return ring->retired.load(std::memory_order_acquire) && ring->empty(); }),
+                     rings_.end());
+        rings = rings_;
+    }
+
+    std::vector<Record> batch;
+    Record record;
+    for (auto &ring : rings)
+    {
+        while (ring->pop(record))
+            batch.push_back(std::move(record));
+    }
+    if (batch.empty())
+        return 0;
+
+    // 不同线程的日志按时间归并后再写出
+    std::stable_sort(batch.begin(), batch.end(), [](const Record &a, const Record &b)
+                     { return a.time < b.time; });
+
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    for (const auto &item : batch)
+        write(item);
+    return batch.size();
+}
+
+void KLogger::write(const Record &record)
+{
+    const char *tag = levelTag(record.level);
+
+    if (console_.load(std::memory_order_relaxed))
+    {
+        std::FILE *out = record.level == Error ? stderr : stdout;
+        std::fputs(tag, out);
+        std::fwrite(record.message.data(), 1, record.message.size(), out);
+        std::fputc('\n', out);
+    }
+
+    if (!fileOpened_)
+    {
+        fileOpened_ = true;
+        if (!fileName_.empty())
+        {
+            file_ = std::fopen(fileName_.c_str(), "a");
+            if (file_ != nullptr)
+                std::setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+        }
+    }
+    if (file_ == nullptr)
+        return;
+
+    // 同一秒内复用格式化好的时间戳
+    static thread_local std::time_t lastSecond = 0;
+    static thread_local char timeBuf[32] = {0};
+    std::time_t second = std::chrono::system_clock::to_time_t(record.time);
+    if (second != lastSecond)
+    {
+        std::tm tm{};
+        localtime_r(&second, &tm);
+        std::strftime(timeBuf, sizeof(timeBuf), "%Y-%m-%d %H:%M:%S ", &tm);
+        lastSecond = second;
+    }
+    std::fputs(timeBuf, file_);
+    std::fputs(tag, file_);
+    std::fwrite(record.message.data(), 1, record.message.size(), file_);
+    std::fputc('\n', file_);
+}
@@ -0,0 +1,326 @@
+#include "utils/kvJsonWriter.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace
+{
+    constexpr int kIndent = 4;
+
+    // 需要转义或校验的字节：控制字符、'"'、'\\' 以及所有非 ASCII
+    struct EscapeTable
+    {
+        bool special[256];
+        EscapeTable()
+        {
+            for (int c = 0; c < 256; ++c)
+                special[c] = c < 0x20 || c == '"' || c == '\\' || c >= 0x80;
+        }
+    };
+    const EscapeTable kEscape;
+
+    // 合法 UTF-8 序列的长度（拒绝过长编码、代理区与超出 U+10FFFF 的码点），非法时返回 0
+    size_t utf8Length(const unsigned char *p, const unsigned char *end)
+    {
+        auto cont = [&](size_t i, unsigned char lo = 0x80, unsigned char hi = 0xbf)
+        {
+            return p + i < end && p[i] >= lo && p[i] <= hi;
+        };
+        unsigned char c = p[0];
+        if (c >= 0xc2 && c <= 0xdf)
+            return cont(1) ? 2 : 0;
+        if (c == 0xe0)
+            return cont(1, 0xa0) && cont(2) ? 3 : 0;
+        if ((c >= 0xe1 && c <= 0xec) || c == 0xee || c == 0xef)
+            return cont(1) && cont(2) ? 3 : 0;
+        if (c == 0xed)
+            return cont(1, 0x80, 0x9f) && cont(2) ? 3 : 0;
+        if (c == 0xf0)
+            return cont(1, 0x90) && cont(2) && cont(3) ? 4 : 0;
+        if (c >= 0xf1 && c <= 0xf3)
+            return cont(1) && cont(2) && cont(3) ? 4 : 0;
+        if (c == 0xf4)
+            return cont(1, 0x80, 0x8f) && cont(2) && cont(3) ? 4 : 0;
+        return 0;
+    }
+
+    // 按名字排序，同名取最后一个，与 json 对象逐个赋值的结果一致
+    std::vector<const KvField *> sortedUnique(const std::vector<KvField> &fields)
+    {
+        std::vector<const KvField *> sorted;
+        sorted.reserve(fields.size());
+        for (const auto &field : fields)
+            sorted.push_back(&field);
+        std::stable_sort(sorted.begin(), sorted.end(), [](const KvField *a, const KvField *b)
+                         { return a->name < b->name; });
+        std::vector<const KvField *> unique;
+        unique.reserve(sorted.size());
+        for (size_t i = 0; i < sorted.size(); ++i)
+        {
+            if (i + 1 < sorted.size() && sorted[i + 1]->name == sorted[i]->name)
+                continue;
+            unique.push_back(sorted[i]);
+        }
+        return unique;
+    }
+}
+
+void KvJsonWriter::newline(int level)
+{
+    if (style_ == Style::kPretty)
+    {
+        buffer_.push_back('\n');
+        buffer_.append(static_cast<size_t>(level * kIndent), ' ');
+    }
+}
+
+void KvJsonWriter::name(const char *text)
+{
+    buffer_.push_back('"');
+    buffer_.append(text);
+    buffer_.append(style_ == Style::kPretty ? "\": " : "\":");
+}
+
+bool KvJsonWriter::string(const std::string &text)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(text.data());
+    const unsigned char *end = p + text.size();
+    const unsigned char *run = p;
+    while (p < end && !kEscape.special[*p])
+        ++p;
+    buffer_.push_back('"');
+    if (p == end)
+    {
+        // 纯 ASCII 快速路径
+        buffer_.append(text);
+        buffer_.push_back('"');
+        return true;
+    }
+
+    while (p < end)
+    {
+        if (!kEscape.special[*p])
+        {
+            ++p;
+            continue;
+        }
+        buffer_.append(reinterpret_cast<const char *>(run), p - run);
+        unsigned char c = *p;
+        if (c >= 0x80)
+        {
+            size_t length = utf8Length(p, end);
+            if (length == 0)
+                return false;
+            buffer_.append(reinterpret_cast<const char *>(p), length);
+            p += length;
+            run = p;
+            continue;
+        }
+        switch (c)
+        {
+        case '"':
+            buffer_.append("\\\"");
+            break;
+        case '\\':
+            buffer_.append("\\\\");
+            break;
+        case '\b':
+            buffer_.append("\\b");
+            break;
+        case '\f':
+            buffer_.append("\\f");
+            break;
+        case '\n':
+            buffer_.append("\\n");
+            break;
+        case '\r':
+            buffer_.append("\\r");
+            break;
+        case '\t':
+            buffer_.append("\\t");
+            break;
+        default:
+        {
+            static const char digits[] = "0123456789abcdef";
+            char escaped[] = {'\\', 'u', '0', '0', digits[c >> 4], digits[c & 0xf]};
+            buffer_.append(escaped, sizeof(escaped));
+            break;
+        }
+        }
+        run = ++p;
+    }
+    buffer_.append(reinterpret_cast<const char *>(run), end - run);
+    buffer_.push_back('"');
+    return true;
+}
+
+bool KvJsonWriter::entry(const KvEntry &entry)
+{
+    bool first = true;
+    auto member = [&](const char *text)
+    {
+        if (!first)
+            buffer_.push_back(',');
+        first = false;
+        newline(2);
+        name(text);
+    };
+    // 集合内容：object 为真时写成 {name: value} 对象，否则写成数组
+    auto container = [&](bool object, const std::vector<const KvField *> &items, auto &&writeItem)
+    {
+        if (items.empty())
+        {
+            buffer_.append(object ? "{}" : "[]");
+            return true;
+        }
+        buffer_.push_back(object ? '{' : '[');
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            if (i > 0)
+                buffer_.push_back(',');
+            newline(3);
+            if (!writeItem(*items[i]))
+                return false;
+        }
+        newline(2);
+        buffer_.push_back(object ? '}' : ']');
+        return true;
+    };
+    auto inOrder = [&entry]
+    {
+        std::vector<const KvField *> items;
+        items.reserve(entry.fields.size());
+        for (const auto &field : entry.fields)
+            items.push_back(&field);
+        return items;
+    };
+    auto nameItem = [this](const KvField &field)
+    { return string(field.name); };
+    auto valueItem = [this](const KvField &field)
+    { return string(field.value); };
+    auto pairItem = [this](const KvField &field, bool score)
+    {
+        if (!string(field.name))
+            return false;
+        buffer_.append(style_ == Style::kPretty ? ": " : ":");
+        if (!score)
+            return string(field.value);
+        buffer_.append(json(field.score).dump());
+        return true;
+    };
+    auto typeMember = [&]
+    {
+        member("type");
+        buffer_.push_back('"');
+        buffer_.append(kvTypeName(entry.type));
+        buffer_.push_back('"');
+    };
+
+    buffer_.push_back('{');
+    if (entry.timestamp != 0)
+    {
+        member("expire");
+        char digits[16];
+        auto result = std::to_chars(digits, digits + sizeof(digits), entry.timestamp);
+        buffer_.append(digits, result.ptr);
+    }
+
+    // 成员顺序即名字的字典序：expire < fields < key < members < type < value(s)
+    bool ok = true;
+    switch (entry.type)
+    {
+    case KvType::kString:
+        member("key");
+        ok = string(entry.key);
+        member("value");
+        ok = ok && string(entry.value);
+        break;
+    case KvType::kHash:
+        member("fields");
+        ok = container(true, sortedUnique(entry.fields), [&](const KvField &field)
+                       { return pairItem(field, false); });
+        member("key");
+        ok = ok && string(entry.key);
+        typeMember();
+        break;
+    case KvType::kSet:
+        member("key");
+        ok = string(entry.key);
+        member("members");
+        ok = ok && container(false, inOrder(), nameItem);
+        typeMember();
+        break;
+    case KvType::kZSet:
+        member("key");
+        ok = string(entry.key);
+        member("members");
+        ok = ok && container(true, sortedUnique(entry.fields), [&](const KvField &field)
+                             { return pairItem(field, true); });
+        typeMember();
+        break;
+    case KvType::kList:
+        member("key");
+        ok = string(entry.key);
+        typeMember();
+        member("values");
+        ok = ok && container(false, inOrder(), valueItem);
+        break;
+    }
+    newline(1);
+    buffer_.push_back('}');
+    return ok;
+}
+
+Result KvJsonWriter::flushTo(IoWriter &out)
+{
+    Result res = out.write(buffer_.data(), buffer_.size());
+    buffer_.clear();
+    return res;
+}
+
+Result KvJsonWriter::encode(const DataType &data, IoWriter *out)
+{
+    buffer_.clear();
+    if (out && buffer_.capacity() < kFlushBytes + kFlushBytes / 4)
+        buffer_.reserve(kFlushBytes + kFlushBytes / 4);
+    if (data.empty())
+    {
+        buffer_.append("[]");
+    }
+    else
+    {
+        buffer_.push_back('[');
+        for (size_t i = 0; i < data.size(); ++i)
+        {
+            if (i > 0)
+                buffer_.push_back(',');
+            newline(1);
+            if (!entry(data[i]))
+            {
+                buffer_.clear();
+                return Result(Result::Ret::kInvalidParam, "invalid UTF-8 in entry #" + std::to_string(i));
+            }
+            if (out && buffer_.size() >= kFlushBytes)
+            {
+                Result res = flushTo(*out);
+                if (res.isError())
+                    return res;
+            }
+        }
+        newline(0);
+        buffer_.push_back(']');
+    }
+    return out ? flushTo(*out) : Result(Result::Ret::kOk);
+}
+
+Result KvJsonWriter::write(IoWriter &out, const DataType &data)
+{
+    return encode(data, &out);
+}
+
+Result KvJsonWriter::serialize(const DataType &data, std::string &out)
+{
+    Result res = encode(data, nullptr);
+    out = buffer_;
+    return res;
+}
@@ -0,0 +1,177 @@
+#include "utils/memoryBudget.h"
+#include "utils/metrics.h"
+#include "utils/trace.h"
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+namespace
+{
+    MetricsGauge &reservedGauge()
+    {
+        static MetricsGauge &gauge = metricsGauge("bingest_memory_reserved_bytes", "bytes currently reserved from the memory budget");
+        return gauge;
+    }
+
+    MetricsGauge &retainedGauge()
+    {
+        static MetricsGauge &gauge = metricsGauge("bingest_memory_retained_bytes", "bytes kept by worker buffer pools and charged to the memory budget");
+        return gauge;
+    }
+
+    // cgroup v2 的 memory.max 或 v1 的 memory.limit_in_bytes，没有限制时返回 0
+    uint64_t cgroupLimit()
+    {
+        for (const char *path : {"/sys/fs/cgroup/memory.max", "/sys/fs/cgroup/memory/memory.limit_in_bytes"})
+        {
+            std::ifstream in(path);
+            std::string text;
+            if (in >> text && text != "max")
+            {
+                try
+                {
+                    return std::stoull(text);
+                }
+                catch (const std::exception &)
+                {
+                }
+            }
+        }
+        return 0;
+    }
+}
+
+MemoryBudget::MemoryBudget(uint64_t capacity, double expansion)
+    : capacity_(std::max<uint64_t>(capacity, 1)), expansion_(expansion)
+{
+    static MetricsGauge &budget = metricsGauge("bingest_memory_budget_bytes", "memory budget shared by concurrent tasks");
+    budget.set(static_cast<int64_t>(capacity_));
+}
+
+MemoryBudget::~MemoryBudget()
+{
+    // 预留应在预算销毁前全部归还，这里只兜底清理指标
+    std::lock_guard<std::mutex> lock(mutex_);
+    reservedGauge().add(-static_cast<int64_t>(reserved_));
+    retainedGauge().add(-static_cast<int64_t>(retained_));
+}
+
+uint64_t MemoryBudget::reserved() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reserved_;
+}
+
+uint64_t MemoryBudget::retained() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return retained_;
+}
+
+double MemoryBudget::expansion() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return expansion_;
+}
+
+uint64_t MemoryBudget::estimate(uint64_t inputBytes) const
+{
+    return static_cast<uint64_t>(static_cast<double>(inputBytes) * expansion());
+}
+
+void MemoryBudget::observe(uint64_t inputBytes, uint64_t memoryBytes)
+{
+    if (inputBytes == 0)
+        return;
+    double measured = static_cast<double>(memoryBytes) / static_cast<double>(inputBytes);
+    std::lock_guard<std::mutex> lock(mutex_);
+    expansion_ = measured > expansion_ ? measured : expansion_ + (measured - expansion_) / 4;
+}
+
+MemoryReservation MemoryBudget::reserve(uint64_t bytes)
+{
+    static MetricsCounter &waits = metricsCounter("bingest_memory_admission_waits_total", "task submissions that waited for the memory budget");
+    static MetricsHistogram &waitLatency = metricsHistogram("bingest_memory_admission_wait_ns", "time a submission waited for the memory budget");
+    bytes = std::min(bytes, capacity_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    // 没有任务预留时直接放行：缓冲池的保留可能来自空闲线程，只有下次回收或线程退出才会归还，等不到
+    auto admissible = [&]
+    { return reserved_ == 0 || reserved_ + retained_ + bytes <= capacity_; };
+    if (!admissible())
+    {
+        TRACE_SPAN("memoryBudgetWait");
+        ScopedLatency timer(waitLatency);
+        waits.add();
+        cv_.wait(lock, admissible);
+    }
+    reserved_ += bytes;
+    reservedGauge().add(static_cast<int64_t>(bytes));
+    return MemoryReservation(this, bytes);
+}
+
+MemoryReservation MemoryBudget::reserveNow(uint64_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    reserved_ += bytes;
+    reservedGauge().add(static_cast<int64_t>(bytes));
+    return MemoryReservation(this, bytes);
+}
+
+MemoryReservation MemoryBudget::retain(uint64_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    retained_ += bytes;
+    retainedGauge().add(static_cast<int64_t>(bytes));
+    return MemoryReservation(this, bytes, true);
+}
+
+void MemoryBudget::release(uint64_t bytes, bool retained)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t &counter = retained ? retained_ : reserved_;
+        counter -= std::min(bytes, counter);
+        (retained ? retainedGauge() : reservedGauge()).add(-static_cast<int64_t>(bytes));
+    }
+    cv_.notify_all();
+}
+
+uint64_t MemoryBudget::autoCapacity()
+{
+    long pages = ::sysconf(_SC_PHYS_PAGES);
+    long pageSize = ::sysconf(_SC_PAGESIZE);
+    uint64_t physical = pages > 0 && pageSize > 0 ? static_cast<uint64_t>(pages) * static_cast<uint64_t>(pageSize) : 0;
+    uint64_t limit = cgroupLimit();
+    uint64_t memory = limit > 0 && (physical == 0 || limit < physical) ? limit : physical;
+    return memory / 4 * 3;
+}
+
+MemoryReservation::MemoryReservation(MemoryReservation &&other) noexcept
+    : budget_(other.budget_), bytes_(other.bytes_), retained_(other.retained_)
+{
+    other.budget_ = nullptr;
+    other.bytes_ = 0;
+}
+
+MemoryReservation &MemoryReservation::operator=(MemoryReservation &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        budget_ = other.budget_;
+        bytes_ = other.bytes_;
+        retained_ = other.retained_;
+        other.budget_ = nullptr;
+        other.bytes_ = 0;
+    }
+    return *this;
+}
+
+void MemoryReservation::release()
+{
+    if (budget_)
+        budget_->release(bytes_, retained_);
+    budget_ = nullptr;
+    bytes_ = 0;
+}
@@ -0,0 +1,278 @@
+#include "utils/metrics.h"
+#include "utils/filePublisher.h"
+#include "utils/klog.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace
+{
+    std::atomic<size_t> nextShard{0};
+
+    void atomicMin(std::atomic<uint64_t> &target, uint64_t value)
+    {
+        uint64_t cur = target.load(std::memory_order_relaxed);
+        while (value < cur && !target.compare_exchange_weak(cur, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void atomicMax(std::atomic<uint64_t> &target, uint64_t value)
+    {
+        uint64_t cur = target.load(std::memory_order_relaxed);
+        while (value > cur && !target.compare_exchange_weak(cur, value, std::memory_order_relaxed))
+        {
+        }
+    }
+}
+
+size_t metricsShardIndex()
+{
+    thread_local size_t index = nextShard.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+uint64_t MetricsCounter::value() const
+{
+    uint64_t total = 0;
+    for (const auto &shard : shards_)
+        total += shard.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+size_t MetricsHistogram::bucketIndex(uint64_t value)
+{
+    if (value < kSubBuckets)
+        return static_cast<size_t>(value);
+    size_t exponent = 63 - __builtin_clzll(value);
+    size_t sub = (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+    return kSubBuckets + (exponent - kSubBucketBits) * kSubBuckets + sub;
+}
+
+uint64_t MetricsHistogram::bucketLowerBound(size_t index)
+{
+    if (index < kSubBuckets)
+        return index;
+    size_t exponent = (index - kSubBuckets) / kSubBuckets + kSubBucketBits;
+    size_t sub = (index - kSubBuckets) % kSubBuckets;
+    return (uint64_t(1) << exponent) + (uint64_t(sub) << (exponent - kSubBucketBits));
+}
+
+uint64_t MetricsHistogram::bucketUpperBound(size_t index)
+{
+    if (index + 1 >= kBuckets)
+        return UINT64_MAX;
+    return bucketLowerBound(index + 1) - 1;
+}
+
+void MetricsHistogram::record(uint64_t value)
+{
+    Shard &shard = shards_[metricsShardIndex() % kShards];
+    shard.count.fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+    shard.buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    atomicMin(shard.min, value);
+    atomicMax(shard.max, value);
+}
+
+MetricsHistogram::Snapshot MetricsHistogram::snapshot() const
+{
+    Snapshot snap;
+    uint64_t min = UINT64_MAX;
+    for (const auto &shard : shards_)
+    {
+        snap.count += shard.count.load(std::memory_order_relaxed);
+        snap.sum += shard.sum.load(std::memory_order_relaxed);
+        min = std::min(min, shard.min.load(std::memory_order_relaxed));
+        snap.max = std::max(snap.max, shard.max.load(std::memory_order_relaxed));
+        for (size_t i = 0; i < kBuckets; ++i)
+            snap.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+    }
+    snap.min = snap.count ? min : 0;
+    return snap;
+}
+
+uint64_t MetricsHistogram::Snapshot::percentile(double q) const
+{
+    if (count == 0)
+        return 0;
+    q = std::min(1.0, std::max(0.0, q));
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * count)));
+    if (rank >= count)
+        return max;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            uint64_t lo = bucketLowerBound(i);
+            uint64_t hi = bucketUpperBound(i);
+            uint64_t mid = lo + (hi - lo) / 2;
+            return std::min(std::max(mid, min), max);
+        }
+    }
+    return max;
+}
+
+MetricsRegistry &MetricsRegistry::instance()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsCounter &MetricsRegistry::counter(const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &entry = counters_[name];
+    if (!entry.metric)
+    {
+        entry.metric = std::make_unique<MetricsCounter>();
+        entry.help = help;
+    }
+    return *entry.metric;
+}
+
+MetricsGauge &MetricsRegistry::gauge(const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &entry = gauges_[name];
+    if (!entry.metric)
+    {
+        entry.metric = std::make_unique<MetricsGauge>();
+        entry.help = help;
+    }
+    return *entry.metric;
+}
+
+MetricsHistogram &MetricsRegistry::histogram(const std::string &name, const std::string &help)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &entry = histograms_[name];
+    if (!entry.metric)
+    {
+        entry.metric = std::make_unique<MetricsHistogram>();
+        entry.help = help;
+    }
+    return *entry.metric;
+}
+
+json MetricsRegistry::toJson() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    json j;
+    j["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+    j["counters"] = json::object();
+    j["gauges"] = json::object();
+    j["histograms"] = json::object();
+    for (const auto &[name, entry] : counters_)
+        j["counters"][name] = entry.metric->value();
+    for (const auto &[name, entry] : gauges_)
+        j["gauges"][name] = entry.metric->value();
+    for (const auto &[name, entry] : histograms_)
+    {
+        MetricsHistogram::Snapshot snap = entry.metric->snapshot();
+        j["histograms"][name] = {
+            {"count", snap.count},
+            {"sum", snap.sum},
+            {"min", snap.min},
+            {"max", snap.max},
+            {"mean", snap.mean()},
+            {"p50", snap.percentile(0.5)},
+            {"p90", snap.percentile(0.9)},
+            {"p99", snap.percentile(0.99)},
+            {"p999", snap.percentile(0.999)}};
+    }
+    return j;
+}
+
+std::string MetricsRegistry::toPrometheus() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream out;
+    for (const auto &[name, entry] : counters_)
+    {
+        if (!entry.help.empty())
+            out << "# HELP " << name << " " << entry.help << "\n";
+        out << "# TYPE " << name << " counter\n"
+            << name << " " << entry.metric->value() << "\n";
+    }
+    for (const auto &[name, entry] : gauges_)
+    {
+        if (!entry.help.empty())
+            out << "# HELP " << name << " " << entry.help << "\n";
+        out << "# TYPE " << name << " gauge\n"
+            << name << " " << entry.metric->value() << "\n";
+    }
+    // 直方图桶太多，按 summary 导出分位数
+    for (const auto &[name, entry] : histograms_)
+    {
+        MetricsHistogram::Snapshot snap = entry.metric->snapshot();
+        if (!entry.help.empty())
+            out << "# HELP " << name << " " << entry.help << "\n";
+        out << "# TYPE " << name << " summary\n";
+        for (double q : {0.5, 0.9, 0.99, 0.999})
+            out << name << "{quantile=\"" << q << "\"} " << snap.percentile(q) << "\n";
+        out << name << "_sum " << snap.sum << "\n"
+            << name << "_count " << snap.count << "\n";
+    }
+    return out.str();
+}
+
+MetricsExporter::MetricsExporter(const std::string &jsonPath, const std::string &promPath,
+                                 std::chrono::milliseconds interval)
+    : jsonPath_(jsonPath), promPath_(promPath), interval_(interval)
+{
+    thread_ = std::thread([this]
+                          {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_)
+        {
+            if (cv_.wait_for(lock, interval_, [this]
+                             { return stop_; }))
+                break;
+            lock.unlock();
+            writeOnce();
+            lock.lock();
+        } });
+}
+
+void MetricsExporter::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_)
+            return;
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+    writeOnce();
+}
+
+Result MetricsExporter::writeOnce() const
+{
+    const MetricsRegistry &registry = MetricsRegistry::instance();
+    if (!jsonPath_.empty())
+    {
+        Result res = FilePublisher::writeFile(jsonPath_, registry.toJson().dump(4));
+        if (res.isError())
+        {
+            LOG_WARN_RATE_LIMITED(1, "Failed to export metrics json: " + res.message_raw());
+            return res;
+        }
+    }
+    if (!promPath_.empty())
+    {
+        Result res = FilePublisher::writeFile(promPath_, registry.toPrometheus());
+        if (res.isError())
+        {
+            LOG_WARN_RATE_LIMITED(1, "Failed to export metrics prom: " + res.message_raw());
+            return res;
+        }
+    }
+    return Result(Result::Ret::kOk);
+}
@@ -0,0 +1,272 @@
+#include "utils/pikaLayout.h"
+#include "utils/coding.h"
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    uint64_t doubleBits(double d)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        return bits;
+    }
+
+    double bitsDouble(uint64_t bits)
+    {
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        return d;
+    }
+
+    int compareBytes(const char *a, size_t na, const char *b, size_t nb)
+    {
+        return rocksdb::Slice(a, na).compare(rocksdb::Slice(b, nb));
+    }
+
+    // 跳过 reserve1 与 encoded key，返回结束符 \x00\x00 之后的位置；格式不完整时返回 end
+    const char *seekUserKeyEnd(const char *p, const char *end)
+    {
+        if (static_cast<size_t>(end - p) < PikaLayout::kPrefixReserveLength)
+            return end;
+        p += PikaLayout::kPrefixReserveLength;
+        while (p + 1 < end)
+        {
+            if (*p == '\0')
+            {
+                if (p[1] == '\0')
+                    return p + 2;
+                p += 2;
+            }
+            else
+            {
+                ++p;
+            }
+        }
+        return end;
+    }
+
+    int compareU64(uint64_t a, uint64_t b)
+    {
+        return a < b ? -1 : (a > b ? 1 : 0);
+    }
+
+    // reserve1 | key 前缀按字节比较，version 按数值比较，之后由 compareRest 比较各自的部分
+    template <typename CompareRest>
+    int compareVersionedKey(const rocksdb::Slice &a, const rocksdb::Slice &b, CompareRest compareRest)
+    {
+        const char *aEnd = a.data() + a.size();
+        const char *bEnd = b.data() + b.size();
+        const char *pa = seekUserKeyEnd(a.data(), aEnd);
+        const char *pb = seekUserKeyEnd(b.data(), bEnd);
+        int r = compareBytes(a.data(), pa - a.data(), b.data(), pb - b.data());
+        if (r != 0)
+            return r;
+        if (aEnd - pa < 8 || bEnd - pb < 8)
+            return compareBytes(pa, aEnd - pa, pb, bEnd - pb);
+        r = compareU64(getFixed64(pa), getFixed64(pb));
+        if (r != 0)
+            return r;
+        return compareRest(pa + 8, aEnd, pb + 8, bEnd);
+    }
+
+    // 与 Pika 的 ListsDataKeyComparator 一致：同一个 list 的元素按 index 数值排序
+    class ListsDataKeyComparator : public rocksdb::Comparator
+    {
+    public:
+        const char *Name() const override { return "floyd.ListsDataKeyComparator"; }
+
+        int Compare(const rocksdb::Slice &a, const rocksdb::Slice &b) const override
+        {
+            return compareVersionedKey(a, b, [](const char *pa, const char *aEnd, const char *pb, const char *bEnd)
+                                       {
+                                           if (aEnd - pa < 8 || bEnd - pb < 8)
+                                               return compareBytes(pa, aEnd - pa, pb, bEnd - pb);
+                                           int r = compareU64(getFixed64(pa), getFixed64(pb));
+                                           if (r != 0)
+                                               return r;
+                                           return compareBytes(pa + 8, aEnd - pa - 8, pb + 8, bEnd - pb - 8); });
+        }
+
+        void FindShortestSeparator(std::string *, const rocksdb::Slice &) const override {}
+        void FindShortSuccessor(std::string *) const override {}
+    };
+
+    // 与 Pika 的 ZSetsScoreKeyComparator 一致：同一个 zset 的成员按 score（double）再按 member 排序
+    class ZSetsScoreKeyComparator : public rocksdb::Comparator
+    {
+    public:
+        const char *Name() const override { return "floyd.ZSetsScoreKeyComparator"; }
+
+        int Compare(const rocksdb::Slice &a, const rocksdb::Slice &b) const override
+        {
+            return compareVersionedKey(a, b, [](const char *pa, const char *aEnd, const char *pb, const char *bEnd)
+                                       {
+                                           if (aEnd - pa < 8 || bEnd - pb < 8)
+                                               return compareBytes(pa, aEnd - pa, pb, bEnd - pb);
+                                           double sa = bitsDouble(getFixed64(pa));
+                                           double sb = bitsDouble(getFixed64(pb));
+                                           if (sa != sb)
+                                               return sa < sb ? -1 : 1;
+                                           return compareBytes(pa + 8, aEnd - pa - 8, pb + 8, bEnd - pb - 8); });
+        }
+
+        void FindShortestSeparator(std::string *, const rocksdb::Slice &) const override {}
+        void FindShortSuccessor(std::string *) const override {}
+    };
+}
+
+const char *pikaCfName(size_t cf)
+{
+    static const char *const names[kPikaCfCount] = {"default", "hash_data_cf", "set_data_cf",
+                                                    "list_data_cf", "zset_data_cf", "zset_score_cf"};
+    return cf < kPikaCfCount ? names[cf] : "unknown";
+}
+
+const rocksdb::Comparator *pikaCfComparator(size_t cf)
+{
+    static const ListsDataKeyComparator listsComparator;
+    static const ZSetsScoreKeyComparator zsetsComparator;
+    if (cf == kPikaListDataCf)
+        return &listsComparator;
+    if (cf == kPikaZSetScoreCf)
+        return &zsetsComparator;
+    return rocksdb::BytewiseComparator();
+}
+
+PikaLayout::PikaLayout()
+    : PikaLayout(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                           std::chrono::system_clock::now().time_since_epoch())
+                                           .count()))
+{
+}
+
+void PikaLayout::encodeUserKey(const std::string &key, std::string &out)
+{
+    for (char c : key)
+    {
+        out.push_back(c);
+        if (c == '\0')
+            out.push_back('\x01');
+    }
+    out.append(2, '\0');
+}
+
+std::string PikaLayout::metaKey(const std::string &key) const
+{
+    std::string out;
+    out.reserve(kPrefixReserveLength + key.size() + 2 + kSuffixReserveLength);
+    out.append(kPrefixReserveLength, '\0');
+    encodeUserKey(key, out);
+    out.append(kSuffixReserveLength, '\0');
+    return out;
+}
+
+std::string PikaLayout::dataKeyPrefix(const std::string &key, uint64_t version) const
+{
+    std::string out;
+    out.append(kPrefixReserveLength, '\0');
+    encodeUserKey(key, out);
+    putFixed64(out, version);
+    return out;
+}
+
+void PikaLayout::appendDataSuffix(std::string &value) const
+{
+    value.append(kSuffixReserveLength, '\0');
+    putFixed64(value, ctimeMs_);
+}
+
+void PikaLayout::append(const KvEntry &entry, uint64_t version, CfData &out) const
+{
+    uint64_t etimeMs = static_cast<uint64_t>(entry.timestamp) * 1000;
+    if (entry.type == KvType::kString)
+    {
+        out[kPikaMetaCf].emplace_back(metaKey(entry.key), stringEncoder_.encode(entry));
+        return;
+    }
+    if (entry.fields.empty())
+    {
+        // Pika 中不存在空集合，count 为 0 的 meta 表示已删除
+        return;
+    }
+
+    std::string prefix = dataKeyPrefix(entry.key, version);
+    auto dataKey = [&](const std::string &data)
+    {
+        std::string key;
+        key.reserve(prefix.size() + data.size() + kSuffixReserveLength);
+        key.append(prefix).append(data).append(kSuffixReserveLength, '\0');
+        return key;
+    };
+
+    std::string meta;
+    meta.push_back(static_cast<char>(entry.type));
+    if (entry.type == KvType::kList)
+    {
+        for (size_t i = 0; i < entry.fields.size(); ++i)
+        {
+            std::string key = prefix;
+            putFixed64(key, kInitialRightIndex + i);
+            key.append(kSuffixReserveLength, '\0');
+            std::string value = entry.fields[i].value;
+            appendDataSuffix(value);
+            out[kPikaListDataCf].emplace_back(std::move(key), std::move(value));
+        }
+        putFixed64(meta, entry.fields.size());
+        putFixed64(meta, version);
+        putFixed64(meta, kInitialLeftIndex);
+        putFixed64(meta, kInitialRightIndex + entry.fields.size());
+    }
+    else
+    {
+        // 同名元素只保留最后一个，保持首次出现的位置
+        std::unordered_map<std::string, size_t> position;
+        std::vector<const KvField *> fields;
+        fields.reserve(entry.fields.size());
+        for (const auto &field : entry.fields)
+        {
+            auto it = position.emplace(field.name, fields.size());
+            if (it.second)
+                fields.push_back(&field);
+            else
+                fields[it.first->second] = &field;
+        }
+
+        for (const KvField *field : fields)
+        {
+            std::string value;
+            if (entry.type == KvType::kHash)
+            {
+                value = field->value;
+                appendDataSuffix(value);
+                out[kPikaHashDataCf].emplace_back(dataKey(field->name), std::move(value));
+            }
+            else if (entry.type == KvType::kSet)
+            {
+                appendDataSuffix(value);
+                out[kPikaSetDataCf].emplace_back(dataKey(field->name), std::move(value));
+            }
+            else
+            {
+                putFixed64(value, doubleBits(field->score));
+                appendDataSuffix(value);
+                out[kPikaZSetDataCf].emplace_back(dataKey(field->name), std::move(value));
+
+                std::string scoreKey = prefix;
+                putFixed64(scoreKey, doubleBits(field->score));
+                scoreKey.append(field->name).append(kSuffixReserveLength, '\0');
+                std::string scoreValue;
+                appendDataSuffix(scoreValue);
+                out[kPikaZSetScoreCf].emplace_back(std::move(scoreKey), std::move(scoreValue));
+            }
+        }
+        putFixed32(meta, static_cast<uint32_t>(fields.size()));
+        putFixed64(meta, version);
+    }
+    meta.append(kSuffixReserveLength, '\0');
+    putFixed64(meta, ctimeMs_);
+    putFixed64(meta, etimeMs);
+    out[kPikaMetaCf].emplace_back(metaKey(entry.key), std::move(meta));
+}
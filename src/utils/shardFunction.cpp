@@ -0,0 +1,141 @@
+#include "utils/shardFunction.h"
+#include <algorithm>
+#include <fstream>
+#include <zlib.h>
+
+SlotShardFunction::SlotShardFunction(std::vector<uint32_t> slotMap, std::vector<uint32_t> groups)
+    : slotMap_(std::move(slotMap)), groups_(std::move(groups))
+{
+    for (uint32_t shard : slotMap_)
+        numShards_ = std::max<size_t>(numShards_, shard + 1);
+}
+
+SlotShardFunction::SlotShardFunction(size_t numSlots, size_t numShards) : numShards_(numShards)
+{
+    slotMap_.resize(numSlots);
+    for (size_t slot = 0; slot < numSlots; ++slot)
+        slotMap_[slot] = static_cast<uint32_t>(slot * numShards / numSlots);
+}
+
+uint32_t SlotShardFunction::slotOf(const std::string &key) const
+{
+    size_t open = key.find('{');
+    size_t close = open == std::string::npos ? std::string::npos : key.find('}', open + 1);
+    const char *data = key.data();
+    size_t size = key.size();
+    if (close != std::string::npos)
+    {
+        data += open + 1;
+        size = close - open - 1;
+    }
+    uLong crc = ::crc32(0L, reinterpret_cast<const Bytef *>(data), static_cast<uInt>(size));
+    return static_cast<uint32_t>(crc % slotMap_.size());
+}
+
+json SlotShardFunction::describe() const
+{
+    // 均匀分配时只记录参数，显式表则完整记录
+    bool uniform = true;
+    for (size_t slot = 0; slot < slotMap_.size() && uniform; ++slot)
+        uniform = slotMap_[slot] == slot * numShards_ / slotMap_.size();
+    json description = {{"hash", "crc32"}, {"hashTag", "{}"}, {"slots", slotMap_.size()}, {"shards", numShards_}};
+    if (!uniform)
+        description["slotMap"] = slotMap_;
+    if (!groups_.empty())
+        description["groups"] = groups_;
+    return description;
+}
+
+Result makeShardFunction(const std::string &spec, std::shared_ptr<const ShardFunction> &function)
+{
+    size_t colon = spec.find(':');
+    std::string kind = spec.substr(0, colon);
+    std::string arg = colon == std::string::npos ? std::string() : spec.substr(colon + 1);
+    if (kind == "crc32" && !arg.empty())
+    {
+        size_t slots = 0, shards = 0;
+        try
+        {
+            size_t pos = 0;
+            slots = std::stoul(arg, &pos);
+            shards = pos < arg.size() && arg[pos] == ':' ? std::stoul(arg.substr(pos + 1)) : slots;
+        }
+        catch (const std::exception &)
+        {
+            return Result(Result::Ret::kInvalidParam, "invalid shard function: " + spec);
+        }
+        if (slots == 0 || shards == 0 || shards > slots || slots > SlotShardFunction::kMaxSlots)
+        {
+            return Result(Result::Ret::kInvalidParam, "shard function needs 0 < shards <= slots <= " +
+                                                          std::to_string(SlotShardFunction::kMaxSlots) + ": " + spec);
+        }
+        function = std::make_shared<SlotShardFunction>(slots, shards);
+        return Result(Result::Ret::kOk, spec);
+    }
+    if (kind == "slotmap" && !arg.empty())
+    {
+        std::ifstream in(arg);
+        if (!in)
+        {
+            return Result(Result::Ret::kFileOpenError, "cannot open slot map: " + arg);
+        }
+        std::vector<uint32_t> slotMap;
+        bool codis = false;
+        try
+        {
+            json j = json::parse(in);
+            for (const auto &item : j)
+            {
+                if (item.is_number_unsigned())
+                {
+                    slotMap.push_back(item.get<uint32_t>());
+                    continue;
+                }
+                codis = true;
+                size_t slot = item.at("id").get<size_t>();
+                uint32_t group = item.at("group_id").get<uint32_t>();
+                if (slot >= SlotShardFunction::kMaxSlots)
+                {
+                    return Result(Result::Ret::kInvalidParam, "slot map " + arg + " has slot " + std::to_string(slot) +
+                                                                  " beyond " + std::to_string(SlotShardFunction::kMaxSlots));
+                }
+                if (group == 0)
+                {
+                    return Result(Result::Ret::kInvalidParam, "slot map " + arg + " leaves slot " + std::to_string(slot) + " unassigned (group_id 0)");
+                }
+                if (slot >= slotMap.size())
+                    slotMap.resize(slot + 1, 0);
+                slotMap[slot] = group;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            return Result(Result::Ret::kInvalidParam, "invalid slot map " + arg + ": " + e.what());
+        }
+        if (slotMap.empty() || slotMap.size() > SlotShardFunction::kMaxSlots)
+        {
+            return Result(Result::Ret::kInvalidParam, "slot map " + arg + " needs 1 to " + std::to_string(SlotShardFunction::kMaxSlots) + " slots");
+        }
+        std::vector<uint32_t> groups;
+        if (codis)
+        {
+            // 0 为未填的 slot；group_id 不必连续，按从小到大映射为分片号，分片数组不会因大的 group_id 而膨胀
+            if (std::count(slotMap.begin(), slotMap.end(), 0u) > 0)
+            {
+                return Result(Result::Ret::kInvalidParam, "slot map " + arg + " must assign every slot to a shard");
+            }
+            groups = slotMap;
+            std::sort(groups.begin(), groups.end());
+            groups.erase(std::unique(groups.begin(), groups.end()), groups.end());
+            for (uint32_t &shard : slotMap)
+                shard = static_cast<uint32_t>(std::lower_bound(groups.begin(), groups.end(), shard) - groups.begin());
+        }
+        else if (*std::max_element(slotMap.begin(), slotMap.end()) >= slotMap.size())
+        {
+            return Result(Result::Ret::kInvalidParam, "slot map " + arg + " needs shard numbers below the slot count");
+        }
+        function = std::make_shared<SlotShardFunction>(std::move(slotMap), std::move(groups));
+        return Result(Result::Ret::kOk, spec);
+    }
+    return Result(Result::Ret::kInvalidParam, "shard function must be crc32:<slots>[:<shards>] or slotmap:<file.json>: " + spec);
+}
@@ -0,0 +1,197 @@
+#include "utils/sortDedup.h"
+#include "utils/compare.h"
+#include "utils/hash.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    // 重复率估计抽样的目标条数
+    constexpr size_t kSampleTarget = 8192;
+
+    inline uint64_t keyHash(const std::string &key)
+    {
+        return murmurHash128(key.data(), key.size()).lo;
+    }
+}
+
+const char *dedupStrategyName(DedupStrategy strategy)
+{
+    switch (strategy)
+    {
+    case DedupStrategy::kAuto:
+        return "auto";
+    case DedupStrategy::kSort:
+        return "sort";
+    case DedupStrategy::kMergeRuns:
+        return "runs";
+    case DedupStrategy::kHash:
+        return "hash";
+    }
+    return "unknown";
+}
+
+bool parseDedupStrategy(const std::string &name, DedupStrategy &strategy)
+{
+    if (name == "auto")
+        strategy = DedupStrategy::kAuto;
+    else if (name == "sort")
+        strategy = DedupStrategy::kSort;
+    else if (name == "runs")
+        strategy = DedupStrategy::kMergeRuns;
+    else if (name == "hash")
+        strategy = DedupStrategy::kHash;
+    else
+        return false;
+    return true;
+}
+
+size_t countSortedRuns(const DataType &data, size_t maxRuns)
+{
+    if (data.empty())
+        return 0;
+    ComparePair less;
+    size_t runs = 1;
+    for (size_t i = 1; i < data.size() && runs <= maxRuns; ++i)
+    {
+        if (less(data[i], data[i - 1]))
+            ++runs;
+    }
+    return runs;
+}
+
+double sampleDuplicateRatio(const DataType &data)
+{
+    // 只抽取哈希低位为 0 的 key，样本内的重复率是全体重复率的无偏估计
+    uint64_t mask = 0;
+    while ((mask + 1) * kSampleTarget < data.size())
+        mask = mask * 2 + 1;
+    std::vector<uint64_t> sampled;
+    sampled.reserve(kSampleTarget * 2);
+    for (const auto &entry : data)
+    {
+        uint64_t h = keyHash(entry.key);
+        if ((h & mask) == 0)
+            sampled.push_back(h);
+    }
+    if (sampled.empty())
+        return 0;
+    std::sort(sampled.begin(), sampled.end());
+    size_t unique = static_cast<size_t>(std::unique(sampled.begin(), sampled.end()) - sampled.begin());
+    return static_cast<double>(sampled.size() - unique) / static_cast<double>(sampled.size());
+}
+
+DedupStrategy chooseDedupStrategy(const DataType &data)
+{
+    size_t maxRuns = std::max(kMaxMergeRuns, static_cast<size_t>(std::sqrt(static_cast<double>(data.size()))));
+    if (countSortedRuns(data, maxRuns) <= maxRuns)
+        return DedupStrategy::kMergeRuns;
+    if (sampleDuplicateRatio(data) >= kHashDedupMinDuplicates)
+        return DedupStrategy::kHash;
+    return DedupStrategy::kSort;
+}
+
+void mergeRuns(DataType &data)
+{
+    ComparePair less;
+    std::vector<size_t> bounds{0};
+    for (size_t i = 1; i < data.size(); ++i)
+    {
+        if (less(data[i], data[i - 1]))
+            bounds.push_back(i);
+    }
+    bounds.push_back(data.size());
+
+    // 相邻段两两归并，每轮段数减半
+    while (bounds.size() > 2)
+    {
+        std::vector<size_t> merged{0};
+        for (size_t r = 0; r + 2 < bounds.size(); r += 2)
+        {
+            std::inplace_merge(data.begin() + bounds[r], data.begin() + bounds[r + 1], data.begin() + bounds[r + 2], less);
+            merged.push_back(bounds[r + 2]);
+        }
+        if (merged.back() != data.size())
+            merged.push_back(data.size());
+        bounds.swap(merged);
+    }
+}
+
+size_t hashDedup(DataType &data, DataType *removed)
+{
+    if (data.size() < 2)
+        return 0;
+    if (data.size() >= std::numeric_limits<uint32_t>::max())
+    {
+        // 下标放不进 32 位时退回排序去重
+        size_t before = data.size();
+        std::sort(data.begin(), data.end(), ComparePair());
+        dedupSorted(data, removed);
+        return before - data.size();
+    }
+
+    // 负载因子不超过 1/2 的线性探测表，槽位记录当前胜者的下标与哈希高 32 位
+    constexpr uint32_t kEmpty = std::numeric_limits<uint32_t>::max();
+    struct Slot
+    {
+        uint32_t index = kEmpty;
+        uint32_t tag = 0;
+    };
+    size_t capacity = 1;
+    while (capacity < data.size() * 2)
+        capacity <<= 1;
+    std::vector<Slot> table(capacity);
+    std::vector<uint8_t> keep(data.size(), 1);
+
+    ComparePair less;
+    size_t dropped = 0;
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        uint64_t h = keyHash(data[i].key);
+        uint32_t tag = static_cast<uint32_t>(h >> 32);
+        for (size_t pos = h & (capacity - 1);; pos = (pos + 1) & (capacity - 1))
+        {
+            Slot &slot = table[pos];
+            if (slot.index == kEmpty)
+            {
+                slot.index = static_cast<uint32_t>(i);
+                slot.tag = tag;
+                break;
+            }
+            if (slot.tag == tag && data[slot.index].key == data[i].key)
+            {
+                if (less(data[i], data[slot.index]))
+                {
+                    keep[slot.index] = 0;
+                    slot.index = static_cast<uint32_t>(i);
+                }
+                else
+                {
+                    keep[i] = 0;
+                }
+                ++dropped;
+                break;
+            }
+        }
+    }
+
+    size_t out = 0;
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        if (!keep[i])
+        {
+            if (removed)
+                removed->push_back(std::move(data[i]));
+            continue;
+        }
+        if (out != i)
+            data[out] = std::move(data[i]);
+        ++out;
+    }
+    data.resize(out);
+    return dropped;
+}
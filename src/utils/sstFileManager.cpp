@@ -0,0 +1,74 @@
+#include "mock/sstFileManager.h"
+#include "utils/compare.h"
+#include "utils/klog.h"
+#include <algorithm>
+
+Result SstFileManager::write(const DataType &data)
+{
+    if (data.empty())
+    {
+        return Result(Result::Ret::kInvalidParam, "empty data");
+    }
+
+    // DataGen 输出已按 ComparePair 排序，此时无需拷贝，写入时按 nextDistinctKey 跳过重复 key 即可
+    const DataType *sorted = &data;
+    DataType copy;
+    if (!std::is_sorted(data.begin(), data.end(), ComparePair()))
+    {
+        copy = data;
+        std::sort(copy.begin(), copy.end(), ComparePair());
+        sorted = &copy;
+    }
+
+    std::string filePath = getFileName().message_raw();
+    std::string tempPath = FilePublisher::tempPath(filePath);
+    LOG_DEBUG("Writing " + std::to_string(sorted->size()) + " entries to sst: " + tempPath);
+
+    rocksdb::SstFileWriter writer(rocksdb::EnvOptions(), options_);
+    rocksdb::Status status = writer.Open(tempPath);
+    if (!status.ok())
+    {
+        LOG_ERROR("Failed to open sst file for writing: " + tempPath + " " + status.ToString());
+        return Result(Result::Ret::kFileOpenError, tempPath);
+    }
+
+    std::string value;
+    // 与 dedupSorted 相同的保留规则，只是不修改输入
+    for (size_t i = 0; i < sorted->size(); i = nextDistinctKey(*sorted, i))
+    {
+        const KvEntry &entry = (*sorted)[i];
+        if (entry.type != KvType::kString)
+        {
+            writer.Finish().PermitUncheckedError();
+            FilePublisher::discard(tempPath);
+            LOG_ERROR("sst output only supports string records, key " + entry.key + " is a " + kvTypeName(entry.type));
+            return Result(Result::Ret::kInvalidParam, entry.key);
+        }
+        value.clear();
+        encoder_->encode(entry, value);
+        status = writer.Put(entry.key, value);
+        if (!status.ok())
+        {
+            writer.Finish().PermitUncheckedError();
+            FilePublisher::discard(tempPath);
+            LOG_ERROR("Put failed for " + tempPath + ": " + status.ToString());
+            return Result(Result::Ret::kFileWriteError, tempPath);
+        }
+    }
+
+    status = writer.Finish();
+    if (!status.ok())
+    {
+        FilePublisher::discard(tempPath);
+        LOG_ERROR("Finish failed for " + tempPath + ": " + status.ToString());
+        return Result(Result::Ret::kFileWriteError, tempPath);
+    }
+
+    Result res = publisher_->publish(tempPath, filePath);
+    if (res.isError())
+    {
+        LOG_ERROR("Failed to publish " + filePath + ": " + res.message_raw());
+        return res;
+    }
+    return Result(Result::Ret::kOk, filePath);
+}
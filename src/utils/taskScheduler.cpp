@@ -0,0 +1,311 @@
+#include "utils/taskScheduler.h"
+#include "utils/klog.h"
+#include "utils/trace.h"
+#include <pthread.h>
+#include <sched.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    thread_local const TaskScheduler *tlsScheduler = nullptr;
+    thread_local int tlsWorkerIndex = -1;
+
+    // 解析形如 "0-3,8-11" 的 cpulist
+    std::vector<int> parseCpuList(const std::string &list)
+    {
+        std::vector<int> cpus;
+        std::stringstream ss(list);
+        std::string range;
+        while (std::getline(ss, range, ','))
+        {
+            if (range.empty())
+                continue;
+            size_t dash = range.find('-');
+            try
+            {
+                int lo = std::stoi(range.substr(0, dash));
+                int hi = (dash == std::string::npos) ? lo : std::stoi(range.substr(dash + 1));
+                for (int c = lo; c <= hi; ++c)
+                    cpus.push_back(c);
+            }
+            catch (const std::exception &)
+            {
+                continue;
+            }
+        }
+        return cpus;
+    }
+}
+
+TaskScheduler::TaskScheduler(size_t numThreads, bool pinThreads, bool numaAware)
+{
+    numThreads = std::max<size_t>(1, numThreads);
+    std::vector<int> nodes = cpuNumaNodes();
+
+    // 按 NUMA 节点排列 cpu，使相邻 worker 尽量落在同一节点
+    std::vector<int> cpus(nodes.size());
+    for (size_t c = 0; c < cpus.size(); ++c)
+        cpus[c] = static_cast<int>(c);
+    std::stable_sort(cpus.begin(), cpus.end(), [&nodes](int a, int b)
+                     { return nodes[a] < nodes[b]; });
+
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        auto worker = std::make_unique<Worker>();
+        if (!cpus.empty())
+        {
+            worker->cpu = cpus[i % cpus.size()];
+            worker->node = nodes[worker->cpu];
+        }
+        workers_.push_back(std::move(worker));
+    }
+
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        std::vector<size_t> &victims = workers_[i]->victims;
+        for (size_t k = 1; k < numThreads; ++k)
+            victims.push_back((i + k) % numThreads);
+        if (numaAware)
+        {
+            int node = workers_[i]->node;
+            std::stable_partition(victims.begin(), victims.end(), [this, node](size_t v)
+                                  { return workers_[v]->node == node; });
+        }
+    }
+
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        Worker &worker = *workers_[i];
+        worker.thread = std::thread([this, i]
+                                    { workerLoop(i); });
+        if (pinThreads && worker.cpu >= 0)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(worker.cpu, &set);
+            if (pthread_setaffinity_np(worker.thread.native_handle(), sizeof(set), &set) != 0)
+            {
+                LOG_WARN("Failed to pin worker " + std::to_string(i) + " to cpu " + std::to_string(worker.cpu));
+            }
+        }
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+        stop_.store(true);
+    }
+    idleCv_.notify_all();
+    for (auto &worker : workers_)
+    {
+        if (worker->thread.joinable())
+            worker->thread.join();
+    }
+}
+
+int TaskScheduler::currentWorker() const
+{
+    return tlsScheduler == this ? tlsWorkerIndex : -1;
+}
+
+std::vector<int> TaskScheduler::cpuNumaNodes()
+{
+    unsigned ncpu = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> nodes(ncpu, 0);
+
+    std::error_code ec;
+    const fs::path root("/sys/devices/system/node");
+    if (!fs::exists(root, ec))
+        return nodes;
+
+    for (const auto &entry : fs::directory_iterator(root, ec))
+    {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) != 0 || name.size() <= 4 ||
+            !std::all_of(name.begin() + 4, name.end(), ::isdigit))
+            continue;
+        std::ifstream in(entry.path() / "cpulist");
+        std::string list;
+        if (!std::getline(in, list))
+            continue;
+        int node = std::stoi(name.substr(4));
+        for (int cpu : parseCpuList(list))
+        {
+            if (cpu >= 0 && static_cast<size_t>(cpu) < nodes.size())
+                nodes[cpu] = node;
+        }
+    }
+    return nodes;
+}
+
+void TaskScheduler::submit(Task task)
+{
+    // worker 内部提交的子任务放入自己的队列，外部提交轮转分发
+    int self = currentWorker();
+    size_t index = self >= 0 ? static_cast<size_t>(self)
+                             : nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    // 先计数再入队，保证 runOne 中的递减不会下溢
+    {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+        queued_.fetch_add(1, std::memory_order_release);
+    }
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(std::move(task));
+    }
+    idleCv_.notify_one();
+}
+
+bool TaskScheduler::popLocal(size_t index, Task &task)
+{
+    Worker &worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty())
+        return false;
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool TaskScheduler::steal(size_t thief, Task &task)
+{
+    for (size_t victim : workers_[thief]->victims)
+    {
+        Worker &worker = *workers_[victim];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.tasks.empty())
+        {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TaskScheduler::runOne(int self)
+{
+    Task task;
+    bool found = false;
+    if (self >= 0)
+    {
+        found = popLocal(self, task) || steal(self, task);
+    }
+    else
+    {
+        // 非 worker 线程（例如在 wait() 中协助）从任意队列的队首取任务
+        for (size_t i = 0; i < workers_.size() && !found; ++i)
+        {
+            Worker &worker = *workers_[i];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (!worker.tasks.empty())
+            {
+                task = std::move(worker.tasks.front());
+                worker.tasks.pop_front();
+                found = true;
+            }
+        }
+    }
+    if (!found)
+        return false;
+
+    queued_.fetch_sub(1, std::memory_order_acq_rel);
+    execute(task);
+    return true;
+}
+
+void TaskScheduler::execute(Task &task)
+{
+    Result res(Result::Ret::kOk);
+    if (task.group->isCancelled())
+    {
+        res = Result(Result::Ret::kCancelled, "task skipped");
+    }
+    else
+    {
+        try
+        {
+            res = task.func();
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR("Task threw exception: " + std::string(e.what()));
+            res = Result(Result::Ret::kError, e.what());
+        }
+    }
+    task.group->finish(res);
+}
+
+void TaskScheduler::workerLoop(size_t index)
+{
+    tlsScheduler = this;
+    tlsWorkerIndex = static_cast<int>(index);
+    // 在执行任何任务前命名，trace 的 thread_name 与 top -H 才能区分各个 worker（名字最长 15 字节）
+    std::string name = "bingest-w" + std::to_string(index);
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+
+    while (true)
+    {
+        if (runOne(static_cast<int>(index)))
+            continue;
+
+        std::unique_lock<std::mutex> lock(idleMutex_);
+        idleCv_.wait(lock, [this]
+                     { return stop_.load() || queued_.load(std::memory_order_acquire) > 0; });
+        if (stop_.load() && queued_.load(std::memory_order_acquire) == 0)
+            return;
+    }
+}
+
+void TaskGroup::run(TaskScheduler::TaskFunc func)
+{
+    pending_.fetch_add(1, std::memory_order_acq_rel);
+    TaskScheduler::Task task;
+    task.func = std::move(func);
+    task.group = this;
+    scheduler_.submit(std::move(task));
+}
+
+void TaskGroup::finish(const Result &res)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 被取消而跳过的任务不算作错误
+    if (res.isError() && res.getRet() != Result::Ret::kCancelled && !hasError_)
+    {
+        firstError_ = res;
+        hasError_ = true;
+    }
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        cv_.notify_all();
+}
+
+Result TaskGroup::wait()
+{
+    TRACE_SPAN("TaskGroup::wait");
+    int self = scheduler_.currentWorker();
+    while (pending_.load(std::memory_order_acquire) > 0)
+    {
+        // 协助执行，避免 worker 内嵌套等待时死锁
+        if (scheduler_.runOne(self))
+            continue;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, std::chrono::milliseconds(1), [this]
+                     { return pending_.load(std::memory_order_acquire) == 0; });
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (hasError_)
+        return firstError_;
+    if (isCancelled())
+        return Result(Result::Ret::kCancelled, "task group cancelled");
+    return Result(Result::Ret::kOk);
+}
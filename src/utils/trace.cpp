@@ -0,0 +1,104 @@
+#include "utils/trace.h"
+#include "utils/filePublisher.h"
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+Tracer::Tracer() : origin_(std::chrono::steady_clock::now()) {}
+
+Tracer &Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+uint64_t Tracer::nowUs() const
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                     std::chrono::steady_clock::now() - origin_)
+                                     .count());
+}
+
+Tracer::ThreadBuffer &Tracer::localBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer)
+    {
+        buffer = std::make_shared<ThreadBuffer>();
+        buffer->tid = static_cast<int>(::syscall(SYS_gettid));
+        char name[32] = {0};
+        if (pthread_getname_np(pthread_self(), name, sizeof(name)) == 0)
+            buffer->threadName = name;
+        std::lock_guard<std::mutex> lock(buffersMutex_);
+        buffers_.push_back(buffer);
+    }
+    return *buffer;
+}
+
+void Tracer::record(Event &&event)
+{
+    ThreadBuffer &buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back(std::move(event));
+}
+
+size_t Tracer::eventCount() const
+{
+    std::lock_guard<std::mutex> lock(buffersMutex_);
+    size_t total = 0;
+    for (const auto &buffer : buffers_)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        total += buffer->events.size();
+    }
+    return total;
+}
+
+void Tracer::clear()
+{
+    std::lock_guard<std::mutex> lock(buffersMutex_);
+    for (auto &buffer : buffers_)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->events.clear();
+    }
+}
+
+Result Tracer::dumpChromeTrace(const std::string &path) const
+{
+    const int pid = static_cast<int>(::getpid());
+    json events = json::array();
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex_);
+        for (const auto &buffer : buffers_)
+        {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            if (!buffer->threadName.empty())
+            {
+                events.push_back({{"name", "thread_name"},
+                                  {"ph", "M"},
+                                  {"pid", pid},
+                                  {"tid", buffer->tid},
+                                  {"args", {{"name", buffer->threadName}}}});
+            }
+            for (const auto &event : buffer->events)
+            {
+                json e = {{"name", event.name},
+                          {"cat", "bingest"},
+                          {"ph", "X"},
+                          {"ts", event.startUs},
+                          {"dur", event.durUs},
+                          {"pid", pid},
+                          {"tid", buffer->tid}};
+                if (!event.detail.empty())
+                    e["args"] = {{"detail", event.detail}};
+                events.push_back(std::move(e));
+            }
+        }
+    }
+
+    return FilePublisher::writeFile(path, json{{"traceEvents", events}, {"displayTimeUnit", "ms"}}.dump());
+}
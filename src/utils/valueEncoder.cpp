@@ -0,0 +1,103 @@
+#include "utils/valueEncoder.h"
+#include "utils/coding.h"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+void RawValueEncoder::encode(const KvEntry &entry, std::string &out) const
+{
+    out.append(entry.value);
+}
+
+bool RawValueEncoder::decodeExpire(const char *, size_t, uint32_t &expire) const
+{
+    expire = 0;
+    return true;
+}
+
+void TtlSuffixValueEncoder::encode(const KvEntry &entry, std::string &out) const
+{
+    out.reserve(out.size() + entry.value.size() + sizeof(uint32_t));
+    out.append(entry.value);
+    putFixed32(out, entry.timestamp);
+}
+
+bool TtlSuffixValueEncoder::decodeExpire(const char *data, size_t size, uint32_t &expire) const
+{
+    if (size < sizeof(uint32_t))
+        return false;
+    expire = getFixed32(data + size - sizeof(uint32_t));
+    return true;
+}
+
+PikaStringValueEncoder::PikaStringValueEncoder()
+    : ctimeMs_(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                         std::chrono::system_clock::now().time_since_epoch())
+                                         .count()))
+{
+}
+
+void PikaStringValueEncoder::encode(const KvEntry &entry, std::string &out) const
+{
+    out.reserve(out.size() + 1 + entry.value.size() + kSuffixLength);
+    out.push_back(static_cast<char>(kStringsType));
+    out.append(entry.value);
+    out.append(kReserveLength, '\0');
+    putFixed64(out, ctimeMs_);
+    putFixed64(out, static_cast<uint64_t>(entry.timestamp) * 1000);
+}
+
+bool PikaStringValueEncoder::decodeExpire(const char *data, size_t size, uint32_t &expire) const
+{
+    if (size < 1 + kSuffixLength || static_cast<uint8_t>(data[0]) != kStringsType)
+        return false;
+    expire = static_cast<uint32_t>(getFixed64(data + size - sizeof(uint64_t)) / 1000);
+    return true;
+}
+
+bool PikaStringValueEncoder::matches(const KvEntry &entry, const char *data, size_t size) const
+{
+    std::string encoded = encode(entry);
+    if (encoded.size() != size)
+        return false;
+    size_t ctimeOffset = size - 2 * sizeof(uint64_t);
+    return encoded.compare(0, ctimeOffset, data, ctimeOffset) == 0 &&
+           encoded.compare(ctimeOffset + sizeof(uint64_t), sizeof(uint64_t), data + ctimeOffset + sizeof(uint64_t), sizeof(uint64_t)) == 0;
+}
+
+Result makeValueEncoder(const std::string &name, std::shared_ptr<const ValueEncoder> &encoder)
+{
+    if (name == "raw")
+        encoder = std::make_shared<RawValueEncoder>();
+    else if (name == "ttl")
+        encoder = std::make_shared<TtlSuffixValueEncoder>();
+    else if (name == "pika")
+        encoder = std::make_shared<PikaStringValueEncoder>();
+    else
+        return Result(Result::Ret::kInvalidParam, "value encoding must be raw, ttl or pika: " + name);
+    return Result(Result::Ret::kOk, name);
+}
+
+const std::shared_ptr<const ValueEncoder> &defaultValueEncoder()
+{
+    static const std::shared_ptr<const ValueEncoder> instance = std::make_shared<TtlSuffixValueEncoder>();
+    return instance;
+}
+
+uint32_t unixNowSeconds()
+{
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(
+                                     std::chrono::system_clock::now().time_since_epoch())
+                                     .count());
+}
+
+size_t dropExpired(DataType &data, uint32_t now, DataType *removed)
+{
+    auto end = std::remove_if(data.begin(), data.end(), [now](const KvEntry &entry)
+                              { return isExpired(entry, now); });
+    size_t dropped = static_cast<size_t>(data.end() - end);
+    if (removed)
+        removed->insert(removed->end(), std::make_move_iterator(end), std::make_move_iterator(data.end()));
+    data.erase(end, data.end());
+    return dropped;
+}
@@ -0,0 +1,277 @@
+#include "utils/workerBuffers.h"
+#include "utils/metrics.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <sys/mman.h>
+
+namespace
+{
+    std::atomic<bool> g_hugePages{false};
+
+    constexpr size_t kHugePageSize = 2 << 20;
+
+    std::mutex g_budgetMutex;
+    std::shared_ptr<MemoryBudget> g_budget;
+
+    size_t entryBytes(const KvEntry &entry)
+    {
+        size_t bytes = sizeof(KvEntry) + entry.key.capacity() + entry.value.capacity() + entry.fields.capacity() * sizeof(KvField);
+        for (const KvField &field : entry.fields)
+            bytes += field.name.capacity() + field.value.capacity();
+        return bytes;
+    }
+
+    void adviseHugePages(std::string &buffer)
+    {
+#ifdef MADV_HUGEPAGE
+        uintptr_t begin = reinterpret_cast<uintptr_t>(buffer.data());
+        uintptr_t end = begin + buffer.capacity();
+        uintptr_t alignedBegin = (begin + kHugePageSize - 1) & ~(kHugePageSize - 1);
+        uintptr_t alignedEnd = end & ~(kHugePageSize - 1);
+        if (alignedEnd > alignedBegin)
+        {
+            static MetricsCounter &advised = metricsCounter("bingest_worker_huge_page_bytes_total", "buffer bytes advised as transparent huge pages");
+            if (::madvise(reinterpret_cast<void *>(alignedBegin), alignedEnd - alignedBegin, MADV_HUGEPAGE) == 0)
+                advised.add(alignedEnd - alignedBegin);
+        }
+#else
+        (void)buffer;
+#endif
+    }
+}
+
+WorkerBuffers &WorkerBuffers::local()
+{
+    thread_local WorkerBuffers buffers;
+    return buffers;
+}
+
+void WorkerBuffers::setHugePages(bool enable)
+{
+    g_hugePages.store(enable, std::memory_order_relaxed);
+}
+
+bool WorkerBuffers::getHugePages()
+{
+    return g_hugePages.load(std::memory_order_relaxed);
+}
+
+void WorkerBuffers::setMemoryBudget(const std::shared_ptr<MemoryBudget> &budget)
+{
+    std::lock_guard<std::mutex> lock(g_budgetMutex);
+    g_budget = budget;
+}
+
+size_t WorkerBuffers::retainedBytes() const
+{
+    size_t bytes = spareBytes_;
+    for (const auto &buffer : fileBuffers_)
+        bytes += buffer->input.capacity() + buffer->plain.capacity();
+    for (const auto &vector : vectors_)
+        bytes += vector.capacity() * sizeof(KvEntry);
+    return bytes;
+}
+
+void WorkerBuffers::noteFill(std::string &buffer, size_t capacityBefore)
+{
+    static MetricsCounter &reused = metricsCounter("bingest_worker_buffer_reuse_total", "file buffers filled within the capacity kept from earlier files");
+    static MetricsCounter &grown = metricsCounter("bingest_worker_buffer_grow_total", "file buffers that had to grow");
+    if (buffer.capacity() <= capacityBefore)
+    {
+        reused.add();
+        return;
+    }
+    grown.add();
+    if (getHugePages() && buffer.capacity() >= kHugePageSize)
+        adviseHugePages(buffer);
+}
+
+KvEntry WorkerBuffers::takeEntry()
+{
+    if (spare_.empty())
+    {
+        ++entriesAllocated_;
+        return KvEntry();
+    }
+    ++entriesReused_;
+    KvEntry entry = std::move(spare_.back());
+    spare_.pop_back();
+    spareBytes_ -= std::min(spareBytes_, entryBytes(entry));
+    entry.key.clear();
+    entry.value.clear();
+    entry.timestamp = 0;
+    entry.type = KvType::kString;
+    entry.fields.clear();
+    return entry;
+}
+
+DataType WorkerBuffers::takeVector()
+{
+    if (vectors_.empty())
+        return DataType();
+    DataType data = std::move(vectors_.back());
+    vectors_.pop_back();
+    return data;
+}
+
+void WorkerBuffers::recycle(DataType &data)
+{
+    for (KvEntry &entry : data)
+    {
+        size_t bytes = entryBytes(entry);
+        if (spareBytes_ + bytes > kMaxSpareBytes)
+            break;
+        spareBytes_ += bytes;
+        spare_.push_back(std::move(entry));
+    }
+    recycleVector(data);
+}
+
+void WorkerBuffers::recycleVector(DataType &data)
+{
+    data.clear();
+    if (data.capacity() > 0)
+    {
+        // 池满时替换容量最小的一个，保留下来的总是最大的几个
+        if (vectors_.size() < kMaxSpareVectors)
+            vectors_.push_back(std::move(data));
+        else
+        {
+            auto smallest = std::min_element(vectors_.begin(), vectors_.end(), [](const DataType &a, const DataType &b)
+                                             { return a.capacity() < b.capacity(); });
+            if (smallest->capacity() < data.capacity())
+                smallest->swap(data);
+        }
+    }
+    data = DataType();
+    trim();
+    flushStats();
+}
+
+void WorkerBuffers::trim()
+{
+    for (auto &buffer : fileBuffers_)
+    {
+        if (buffer->input.capacity() > kMaxRetainedBufferBytes)
+            std::string().swap(buffer->input);
+        if (buffer->plain.capacity() > kMaxRetainedBufferBytes)
+            std::string().swap(buffer->plain);
+    }
+    for (auto &vector : vectors_)
+    {
+        if (vector.capacity() * sizeof(KvEntry) > kMaxRetainedBufferBytes)
+            DataType().swap(vector);
+    }
+
+    // dedupSorted / dropExpired 经 spare() 直接放入的条目没有计入 spareBytes_，这里重新统计
+    size_t spareLimit = kMaxSpareBytes;
+    auto fit = [&]()
+    {
+        size_t kept = 0;
+        spareBytes_ = 0;
+        for (; kept < spare_.size(); ++kept)
+        {
+            size_t bytes = entryBytes(spare_[kept]);
+            if (spareBytes_ + bytes > spareLimit)
+                break;
+            spareBytes_ += bytes;
+        }
+        if (kept < spare_.size())
+            spare_.resize(kept);
+    };
+    fit();
+
+    // 总量超限时先释放最大的文件缓冲区 / vector，仍超限再缩小条目池
+    size_t retained = retainedBytes();
+    while (retained > kMaxRetainedBytes)
+    {
+        std::string *largestString = nullptr;
+        DataType *largestVector = nullptr;
+        size_t largest = 0;
+        for (auto &buffer : fileBuffers_)
+        {
+            for (std::string *s : {&buffer->input, &buffer->plain})
+            {
+                if (s->capacity() > largest)
+                {
+                    largest = s->capacity();
+                    largestString = s;
+                    largestVector = nullptr;
+                }
+            }
+        }
+        for (auto &vector : vectors_)
+        {
+            if (vector.capacity() * sizeof(KvEntry) > largest)
+            {
+                largest = vector.capacity() * sizeof(KvEntry);
+                largestVector = &vector;
+                largestString = nullptr;
+            }
+        }
+        if (largest == 0 || largest <= spareBytes_)
+        {
+            spareLimit = spareBytes_ - std::min(spareBytes_, retained - kMaxRetainedBytes);
+            fit();
+            break;
+        }
+        if (largestString)
+            std::string().swap(*largestString);
+        else
+            DataType().swap(*largestVector);
+        retained -= largest;
+    }
+    updateReservation();
+}
+
+void WorkerBuffers::updateReservation()
+{
+    std::shared_ptr<MemoryBudget> budget;
+    {
+        std::lock_guard<std::mutex> lock(g_budgetMutex);
+        budget = g_budget;
+    }
+    size_t bytes = budget ? retainedBytes() : 0;
+    if (budget == budget_ && reservation_.bytes() == bytes)
+        return;
+    // 先归还旧的预留再重新预留，同一线程的保留量不会被计两次
+    reservation_.release();
+    budget_ = std::move(budget);
+    if (budget_ && bytes > 0)
+        reservation_ = budget_->retain(bytes);
+}
+
+void WorkerBuffers::flushStats()
+{
+    static MetricsCounter &reused = metricsCounter("bingest_worker_entries_reused_total", "KvEntry objects reused from the per-worker pool");
+    static MetricsCounter &allocated = metricsCounter("bingest_worker_entries_allocated_total", "KvEntry objects built fresh because the pool was empty");
+    if (entriesReused_ > 0)
+        reused.add(entriesReused_);
+    if (entriesAllocated_ > 0)
+        allocated.add(entriesAllocated_);
+    entriesReused_ = 0;
+    entriesAllocated_ = 0;
+}
+
+FileBufferLease::FileBufferLease() : owner_(WorkerBuffers::local())
+{
+    if (owner_.fileBuffers_.empty())
+    {
+        buffer_ = std::make_unique<WorkerBuffers::FileBuffer>();
+        return;
+    }
+    buffer_ = std::move(owner_.fileBuffers_.back());
+    owner_.fileBuffers_.pop_back();
+}
+
+FileBufferLease::~FileBufferLease()
+{
+    if (owner_.fileBuffers_.size() < WorkerBuffers::kMaxSpareFileBuffers)
+    {
+        owner_.fileBuffers_.push_back(std::move(buffer_));
+        owner_.trim();
+    }
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include "utils/argParse.h"
+
+TEST(ArgParseTest, ParsesByteSizes)
+{
+    uint64_t bytes = 0;
+    EXPECT_TRUE(parseByteSize("4096", bytes));
+    EXPECT_EQ(bytes, 4096u);
+    EXPECT_TRUE(parseByteSize("64M", bytes));
+    EXPECT_EQ(bytes, uint64_t(64) << 20);
+    EXPECT_TRUE(parseByteSize("2G", bytes));
+    EXPECT_EQ(bytes, uint64_t(2) << 30);
+
+    bytes = 7;
+    for (const char *bad : {"", "M", "-1", " 1", "1T", "1MB", "18446744073709551615G"})
+    {
+        EXPECT_FALSE(parseByteSize(bad, bytes)) << bad;
+        EXPECT_EQ(bytes, 7u) << bad;
+    }
+}
+
+TEST(ArgParseTest, ParsesCounts)
+{
+    size_t count = 0;
+    EXPECT_TRUE(parseCount("0", count));
+    EXPECT_EQ(count, 0u);
+    EXPECT_TRUE(parseCount("1000", count));
+    EXPECT_EQ(count, 1000u);
+
+    for (const char *bad : {"", "-5", "+5", "10x", "abc", "99999999999999999999999"})
+    {
+        EXPECT_FALSE(parseCount(bad, count)) << bad;
+        EXPECT_EQ(count, 1000u) << bad;
+    }
+}
+
+TEST(ArgParseTest, ParsesNumbers)
+{
+    double value = 0;
+    EXPECT_TRUE(parseNumber("12", value));
+    EXPECT_DOUBLE_EQ(value, 12.0);
+    EXPECT_TRUE(parseNumber("-1.5", value));
+    EXPECT_DOUBLE_EQ(value, -1.5);
+
+    for (const char *bad : {"", "abc", "12x", " 12", "inf", "nan", "1e999"})
+    {
+        EXPECT_FALSE(parseNumber(bad, value)) << bad;
+        EXPECT_DOUBLE_EQ(value, -1.5) << bad;
+    }
+}
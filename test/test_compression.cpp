@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include "exchange/JsonFileManager.h"
+#include "utils/compression.h"
+#include "utils/kvJsonWriter.h"
+
+namespace
+{
+    // 写入内存的 IoWriter
+    class StringWriter : public IoWriter
+    {
+    public:
+        explicit StringWriter(std::string &out) : out_(out) {}
+        Result write(const char *data, size_t size) override
+        {
+            out_.append(data, size);
+            return Result(Result::Ret::kOk);
+        }
+        Result close() override
+        {
+            closed = true;
+            return Result(Result::Ret::kOk);
+        }
+        bool closed = false;
+
+    private:
+        std::string &out_;
+    };
+
+    std::string pattern(size_t size)
+    {
+        std::string data(size, '\0');
+        for (size_t i = 0; i < size; ++i)
+            data[i] = static_cast<char>('a' + (i * 7 + i / 4096) % 26);
+        return data;
+    }
+
+    Result compressTo(Codec codec, const std::string &plain, std::string &compressed, size_t writeSize = 100000)
+    {
+        std::unique_ptr<IoWriter> writer;
+        Result res = CompressingWriter::create(codec, 0, std::make_unique<StringWriter>(compressed), writer);
+        if (res.isError())
+            return res;
+        for (size_t offset = 0; offset < plain.size(); offset += writeSize)
+        {
+            res = writer->write(plain.data() + offset, std::min(writeSize, plain.size() - offset));
+            if (res.isError())
+                return res;
+        }
+        return writer->close();
+    }
+}
+
+class CompressionTest : public ::testing::TestWithParam<Codec>
+{
+protected:
+    void SetUp() override
+    {
+        if (!codecAvailable(GetParam()))
+            GTEST_SKIP() << codecName(GetParam()) << " not compiled in";
+    }
+};
+
+TEST_P(CompressionTest, RoundTripAcrossFrames)
+{
+    // 超过两帧且不是帧大小的整数倍，写入大小与帧边界不对齐
+    std::string plain = pattern(CompressingWriter::kFrameBytes * 2 + 12345);
+    std::string compressed;
+    ASSERT_FALSE(compressTo(GetParam(), plain, compressed).isError());
+    EXPECT_LT(compressed.size(), plain.size() / 4);
+
+    std::string out;
+    ASSERT_FALSE(decompress(GetParam(), compressed, out).isError());
+    EXPECT_EQ(out, plain);
+
+    TaskScheduler scheduler(4);
+    out.clear();
+    ASSERT_FALSE(decompress(GetParam(), compressed, out, &scheduler).isError());
+    EXPECT_EQ(out, plain);
+}
+
+TEST_P(CompressionTest, ConcatenatedStreamsAndEmptyInput)
+{
+    std::string a = pattern(5000), b = pattern(7000), empty;
+    std::string ca, cb, ce;
+    ASSERT_FALSE(compressTo(GetParam(), a, ca).isError());
+    ASSERT_FALSE(compressTo(GetParam(), b, cb).isError());
+    ASSERT_FALSE(compressTo(GetParam(), empty, ce).isError());
+
+    std::string out;
+    ASSERT_FALSE(decompress(GetParam(), ca + cb, out).isError());
+    EXPECT_EQ(out, a + b);
+    ASSERT_FALSE(decompress(GetParam(), ce, out).isError());
+    EXPECT_TRUE(out.empty());
+}
+
+TEST_P(CompressionTest, TruncatedInputIsAnError)
+{
+    std::string compressed;
+    ASSERT_FALSE(compressTo(GetParam(), pattern(100000), compressed).isError());
+    compressed.resize(compressed.size() / 2);
+    std::string out;
+    EXPECT_TRUE(decompress(GetParam(), compressed, out).isError());
+}
+
+INSTANTIATE_TEST_SUITE_P(Codecs, CompressionTest, ::testing::Values(Codec::kGzip, Codec::kZstd, Codec::kLz4),
+                         [](const ::testing::TestParamInfo<Codec> &info)
+                         { return std::string(codecName(info.param)); });
+
+TEST(CompressionNameTest, ExtensionsAndNames)
+{
+    EXPECT_EQ(codecFromPath("kv/data_1.json.zst"), Codec::kZstd);
+    EXPECT_EQ(codecFromPath("kv/data_1.json.gz"), Codec::kGzip);
+    EXPECT_EQ(codecFromPath("kv/data_1.json.lz4"), Codec::kLz4);
+    EXPECT_EQ(codecFromPath("kv/data_1.json"), Codec::kNone);
+    EXPECT_EQ(stripCodecExtension("kv/data_1.json.zst"), "kv/data_1.json");
+    EXPECT_EQ(stripCodecExtension("kv/data_1.json"), "kv/data_1.json");
+
+    Codec codec;
+    EXPECT_TRUE(parseCodec("zst", codec));
+    EXPECT_EQ(codec, Codec::kZstd);
+    EXPECT_FALSE(parseCodec("brotli", codec));
+}
+
+TEST(CompressionNameTest, JsonFileManagerReadsCompressedInput)
+{
+    DataType data;
+    for (int i = 0; i < 1000; ++i)
+        data.push_back(KvEntry{"key" + std::to_string(i), "value" + std::to_string(i), static_cast<uint32_t>(i % 3)});
+    std::string plain;
+    ASSERT_FALSE(KvJsonWriter().serialize(data, plain).isError());
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "bingest_compression_test";
+    std::filesystem::create_directories(dir);
+    std::string path = (dir / "data_1.json.gz").string();
+    std::string compressed;
+    ASSERT_FALSE(compressTo(Codec::kGzip, plain, compressed).isError());
+    std::ofstream(path, std::ios::binary) << compressed;
+
+    JsonFileManager manager;
+    DataType parsed = manager.parse(path);
+    ASSERT_EQ(parsed.size(), data.size());
+    EXPECT_EQ(parsed[999].key, "key999");
+    EXPECT_EQ(parsed[999].value, "value999");
+
+    // 损坏的压缩输入按读取失败抛出
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << compressed.substr(0, compressed.size() / 2);
+    EXPECT_THROW(manager.parse(path), std::runtime_error);
+    std::filesystem::remove_all(dir);
+}
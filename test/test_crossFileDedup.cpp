@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include "exchange/crossFileDedup.h"
+#include "exchange/JsonFileManager.h"
+#include "exchange/sstProcessor.h"
+#include "rocksdb/sst_file_reader.h"
+#include "utils/bloomFilter.h"
+
+TEST(BlockedBloomFilterTest, NoFalseNegatives)
+{
+    BlockedBloomFilter filter(10000);
+    for (int i = 0; i < 10000; ++i)
+        filter.insert(murmurHash128("key_" + std::to_string(i)));
+    for (int i = 0; i < 10000; ++i)
+        EXPECT_TRUE(filter.mayContain(murmurHash128("key_" + std::to_string(i))));
+
+    size_t falsePositives = 0;
+    for (int i = 0; i < 10000; ++i)
+        falsePositives += filter.mayContain(murmurHash128("other_" + std::to_string(i)));
+    EXPECT_LT(falsePositives, 500u); // 约 2%，留足余量
+}
+
+TEST(BlockedBloomFilterTest, ConcurrentInsertFlagsExactlyOneDuplicate)
+{
+    // 两个线程同时插入同一批 key：每个 key 恰好有一方看到已存在
+    BlockedBloomFilter filter(100000);
+    std::atomic<size_t> flagged{0};
+    auto worker = [&]
+    {
+        for (int i = 0; i < 20000; ++i)
+            flagged += filter.insert(murmurHash128("key_" + std::to_string(i)));
+    };
+    std::thread a(worker), b(worker);
+    a.join();
+    b.join();
+    EXPECT_GE(flagged.load(), 20000u);
+}
+
+class CrossFileDedupTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path dir = DEFAULTDIC / "test_cross_dedup";
+
+    void SetUp() override
+    {
+        std::filesystem::create_directories(dir / "kv");
+    }
+    void TearDown() override
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    void writeJson(const std::string &name, const DataType &data)
+    {
+        std::ofstream out(dir / "kv" / name);
+        out << json(data).dump();
+    }
+
+    std::vector<std::pair<std::string, std::string>> readSst(const std::filesystem::path &path)
+    {
+        std::vector<std::pair<std::string, std::string>> out;
+        rocksdb::SstFileReader reader{rocksdb::Options()};
+        if (!reader.Open(path.string()).ok())
+            return out;
+        std::unique_ptr<rocksdb::Iterator> it(reader.NewIterator(rocksdb::ReadOptions()));
+        for (it->SeekToFirst(); it->Valid(); it->Next())
+            out.emplace_back(it->key().ToString(), it->value().ToString());
+        return out;
+    }
+};
+
+TEST_F(CrossFileDedupTest, KeepsNewestAcrossInputs)
+{
+    writeJson("data_0.json", {{"dup", "old", 100}, {"a", "1", 0}});
+    writeJson("data_1.json", {{"dup", "new", 200}, {"b", "2", 0}});
+    writeJson("data_2.json", {{"c", "3", 0}, {"dup", "older", 50}});
+
+    JsonFileManager fileManager;
+    CrossFileDedup dedup;
+    TaskScheduler scheduler(2);
+    std::string base = (std::filesystem::path("test_cross_dedup") / "kv").string();
+    std::vector<std::string> inputs = {base + "/data_0.json", base + "/data_1.json", base + "/data_2.json"};
+    Result res = dedup.build(&fileManager, inputs, scheduler);
+    ASSERT_FALSE(res.isError()) << res.message();
+    EXPECT_EQ(dedup.numDuplicateKeys(), 1u);
+
+    EXPECT_FALSE(dedup.keep(inputs[0], {"dup", "old", 100}));
+    EXPECT_TRUE(dedup.keep(inputs[1], {"dup", "new", 200}));
+    EXPECT_FALSE(dedup.keep(inputs[2], {"dup", "older", 50}));
+    EXPECT_TRUE(dedup.keep(inputs[0], {"a", "1", 0}));
+    EXPECT_TRUE(dedup.keep(inputs[2], {"c", "3", 0}));
+}
+
+TEST_F(CrossFileDedupTest, ProcessorDropsOlderVersions)
+{
+    writeJson("data_0.json", {{"dup", "old", 100}, {"a", "1", 0}});
+    writeJson("data_1.json", {{"dup", "new", 200}});
+    writeJson("data_2.json", {{"dup", "older", 50}});
+
+    JsonFileManager fileManager;
+    SstProcessor processor{rocksdb::Options()};
+    processor.setNumThreads(2);
+    processor.setCrossFileDedup(12);
+    Result res = processor.mutiProcessSstFile(&fileManager, "test_cross_dedup/kv", "test_cross_dedup/sst");
+    ASSERT_FALSE(res.isError()) << res.message();
+
+    auto first = readSst(dir / "sst" / "data_0.sst");
+    ASSERT_EQ(first.size(), 1u);
+    EXPECT_EQ(first[0].first, "a");
+    auto second = readSst(dir / "sst" / "data_1.sst");
+    ASSERT_EQ(second.size(), 1u);
+    EXPECT_EQ(second[0].first, "dup");
+    // data_2 中的 key 全部有更新版本，不生成 SST
+    EXPECT_FALSE(std::filesystem::exists(dir / "sst" / "data_2.sst"));
+}
@@ -2,10 +2,12 @@
 #include "mock/dataGen.h"
 #include <fstream>
 #include <filesystem>
+#include <map>
 #include "gmock/gmock.h"
 #include "mock/fileManager.h"
 #include "utils/kvEntry.h"
 #include "mock/mock.h"
+#include "utils/compare.h"
 
 // 创建一个 MockFileManager 类，继承自 FileManagerBase
 class MockFileManager : public FileManagerBase
@@ -268,3 +270,91 @@ TEST_F(DataGenTest, FolderHistoryLoadAndSave)
     // 清理测试文件
     std::filesystem::remove(testPath);
 }
+
+/**
+ * 测试大文件拆分为子任务并行生成后仍然完整且有序
+ */
+TEST_F(DataGenTest, GenerateDataSplitsLargeFilesIntoSubTasks)
+{
+    std::string configPath = "test_subtask_config.json";
+    std::ofstream config(configPath);
+    config << R"({
+        "targetSizeMB": 40,
+        "maxSizeGB": 2,
+        "keyPrefix": "key_",
+        "valuePrefix": "val_",
+        "maxFileSizeMB": 20,
+        "approxEntrySizeKB": 50,
+        "subTaskEntries": 64
+    })";
+    config.close();
+    gen = std::make_unique<DataGen>(configPath, outputDir);
+    gen->setFileManager(mockFileManager);
+    std::atomic<int> files{0};
+    EXPECT_CALL(*mockFileManager, write(testing::_)).WillRepeatedly([&files](const DataType &data)
+                                                                    {
+        files.fetch_add(1);
+        EXPECT_EQ(data.size(), 20u * 1024 / 50);
+        for (size_t i = 1; i < data.size(); ++i)
+        {
+            EXPECT_FALSE(ComparePair()(data[i], data[i - 1]));
+        }
+        return Result(Result::Ret::kOk, "File generated successfully."); });
+    EXPECT_EQ(gen->generateData().getRet(), Result::Ret::kOk);
+    EXPECT_EQ(files.load(), 2);
+    std::filesystem::remove(configPath);
+}
+
+/**
+ * 测试按 typeRatios 生成集合类型，同一个 key 的类型固定
+ */
+TEST_F(DataGenTest, GenerateEntriesFollowsTypeRatios)
+{
+    std::string configPath = "test_type_config.json";
+    std::ofstream config(configPath);
+    config << R"({
+        "targetSizeMB": 40,
+        "maxSizeGB": 2,
+        "keyPrefix": "key_",
+        "valuePrefix": "val_",
+        "maxFileSizeMB": 20,
+        "approxEntrySizeKB": 50,
+        "typeRatios": {"string": 1, "hash": 1, "zset": 1, "list": 1},
+        "collectionSize": 4
+    })";
+    config.close();
+    gen = std::make_unique<DataGen>(configPath, outputDir);
+
+    DataType data;
+    ASSERT_FALSE(gen->generateEntries(2000, data).isError());
+    std::map<KvType, size_t> counts;
+    std::map<std::string, KvType> types;
+    for (const auto &entry : data)
+    {
+        ++counts[entry.type];
+        auto it = types.emplace(entry.key, entry.type);
+        EXPECT_EQ(it.first->second, entry.type);
+        if (entry.type == KvType::kString)
+        {
+            EXPECT_TRUE(entry.fields.empty());
+        }
+        else
+        {
+            EXPECT_GE(entry.fields.size(), 1u);
+            EXPECT_LE(entry.fields.size(), 7u);
+        }
+    }
+    EXPECT_EQ(counts.count(KvType::kSet), 0u);
+    for (KvType type : {KvType::kString, KvType::kHash, KvType::kZSet, KvType::kList})
+    {
+        EXPECT_GT(counts[type], 300u) << kvTypeName(type);
+    }
+    std::filesystem::remove(configPath);
+
+    std::ofstream bad(configPath);
+    bad << R"({"targetSizeMB": 40, "maxSizeGB": 2, "keyPrefix": "key_", "valuePrefix": "val_",
+               "maxFileSizeMB": 20, "approxEntrySizeKB": 50, "typeRatios": {"stream": 1}})";
+    bad.close();
+    EXPECT_THROW(DataGen(configPath, outputDir), std::runtime_error);
+    std::filesystem::remove(configPath);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include "utils/dirWatcher.h"
+#include "utils/kconfig.h"
+#include "exchange/sstProcessor.h"
+#include "exchange/JsonFileManager.h"
+
+class DirWatcherTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path dir = DEFAULTDIC / "test_dir_watcher";
+
+    void SetUp() override
+    {
+        std::filesystem::create_directories(dir / "kv");
+    }
+    void TearDown() override
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    void writeFile(const std::filesystem::path &path, const std::string &content)
+    {
+        std::ofstream out(path, std::ios::trunc);
+        out << content;
+    }
+
+    // 轮询直到收集到 expected 个事件或超时
+    std::vector<std::string> collect(DirWatcher &watcher, size_t expected)
+    {
+        std::vector<std::string> names;
+        for (int i = 0; i < 20 && names.size() < expected; ++i)
+            EXPECT_FALSE(watcher.poll(std::chrono::milliseconds(100), names).isError());
+        return names;
+    }
+};
+
+TEST_F(DirWatcherTest, ReportsClosedAndRenamedFiles)
+{
+    DirWatcher watcher((dir / "kv").string());
+    ASSERT_FALSE(watcher.open().isError());
+
+    writeFile(dir / "kv" / "data_0.json", "[]");
+    writeFile(dir / "kv" / ".data_1.json.tmp", "[]");
+    std::filesystem::rename(dir / "kv" / ".data_1.json.tmp", dir / "kv" / "data_1.json");
+
+    std::vector<std::string> names = collect(watcher, 3);
+    EXPECT_NE(std::find(names.begin(), names.end(), "data_0.json"), names.end());
+    EXPECT_NE(std::find(names.begin(), names.end(), "data_1.json"), names.end());
+}
+
+TEST_F(DirWatcherTest, PollTimesOutWithoutEvents)
+{
+    DirWatcher watcher((dir / "kv").string());
+    ASSERT_FALSE(watcher.open().isError());
+    std::vector<std::string> names;
+    EXPECT_FALSE(watcher.poll(std::chrono::milliseconds(10), names).isError());
+    EXPECT_TRUE(names.empty());
+}
+
+TEST_F(DirWatcherTest, ProcessorConvertsFilesAsTheyArrive)
+{
+    writeFile(dir / "kv" / "data_0.json", json(DataType{{"key_1", "v1", 0}}).dump());
+
+    std::atomic<bool> stop{false};
+    SstProcessor processor{rocksdb::Options()};
+    processor.setNumThreads(2);
+    JsonFileManager fileManager;
+    Result result;
+    std::thread watcher([&]
+                        { result = processor.watchSstFiles(&fileManager, "test_dir_watcher/kv", "test_dir_watcher/sst", stop); });
+
+    writeFile(dir / "kv" / "data_1.json", json(DataType{{"key_2", "v2", 100}}).dump());
+    writeFile(dir / "kv" / "ignored.txt", "not kv");
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline &&
+           !(std::filesystem::exists(dir / "sst" / "data_0.sst") && std::filesystem::exists(dir / "sst" / "data_1.sst")))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    stop = true;
+    watcher.join();
+
+    EXPECT_FALSE(result.isError()) << result.message();
+    EXPECT_TRUE(std::filesystem::exists(dir / "sst" / "data_0.sst"));
+    EXPECT_TRUE(std::filesystem::exists(dir / "sst" / "data_1.sst"));
+    EXPECT_FALSE(std::filesystem::exists(dir / "sst" / "ignored.sst"));
+}
+
+TEST_F(DirWatcherTest, ProcessorStopsWhenIdle)
+{
+    std::atomic<bool> stop{false};
+    SstProcessor processor{rocksdb::Options()};
+    JsonFileManager fileManager;
+    Result result = processor.watchSstFiles(&fileManager, "test_dir_watcher/kv", "test_dir_watcher/sst", stop,
+                                            std::chrono::milliseconds(300));
+    EXPECT_FALSE(result.isError()) << result.message();
+}
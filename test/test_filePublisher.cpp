@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include "utils/filePublisher.h"
+#include "utils/kconfig.h"
+#include "mock/fileManager.h"
+
+class FilePublisherTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path dir = DEFAULTDIC / "test_file_publisher";
+
+    void SetUp() override
+    {
+        std::filesystem::create_directories(dir);
+    }
+    void TearDown() override
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string writeTemp(const std::string &name, const std::string &content)
+    {
+        std::string tempPath = FilePublisher::tempPath((dir / name).string());
+        std::ofstream out(tempPath);
+        out << content;
+        return tempPath;
+    }
+
+    size_t countTempFiles()
+    {
+        size_t n = 0;
+        for (const auto &entry : std::filesystem::directory_iterator(dir))
+            n += entry.path().extension() == ".tmp";
+        return n;
+    }
+};
+
+TEST_F(FilePublisherTest, ParseSyncPolicy)
+{
+    SyncPolicy policy = SyncPolicy::kNone;
+    size_t batchSize = 64;
+    EXPECT_FALSE(parseSyncPolicy("file", policy, batchSize).isError());
+    EXPECT_EQ(policy, SyncPolicy::kPerFile);
+    EXPECT_FALSE(parseSyncPolicy("batch", policy, batchSize).isError());
+    EXPECT_EQ(policy, SyncPolicy::kBatched);
+    EXPECT_EQ(batchSize, 64u);
+    EXPECT_FALSE(parseSyncPolicy("batch:8", policy, batchSize).isError());
+    EXPECT_EQ(batchSize, 8u);
+    EXPECT_FALSE(parseSyncPolicy("none", policy, batchSize).isError());
+    EXPECT_EQ(policy, SyncPolicy::kNone);
+
+    EXPECT_TRUE(parseSyncPolicy("batch:0", policy, batchSize).isError());
+    EXPECT_TRUE(parseSyncPolicy("batchy", policy, batchSize).isError());
+    EXPECT_TRUE(parseSyncPolicy("always", policy, batchSize).isError());
+}
+
+TEST_F(FilePublisherTest, TempPathIsHiddenSibling)
+{
+    EXPECT_EQ(FilePublisher::tempPath("/a/b/data_1.json"), "/a/b/.data_1.json.tmp");
+}
+
+TEST_F(FilePublisherTest, PublishRenamesUnderEveryPolicy)
+{
+    for (SyncPolicy policy : {SyncPolicy::kNone, SyncPolicy::kPerFile, SyncPolicy::kBatched})
+    {
+        FilePublisher publisher(policy, 2);
+        for (int i = 0; i < 3; ++i)
+        {
+            std::string name = "data_" + std::to_string(i) + ".json";
+            std::string tempPath = writeTemp(name, "[]");
+            ASSERT_FALSE(publisher.publish(tempPath, (dir / name).string()).isError());
+            EXPECT_TRUE(std::filesystem::exists(dir / name));
+        }
+        EXPECT_FALSE(publisher.flush().isError());
+        EXPECT_EQ(countTempFiles(), 0u);
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+    }
+}
+
+TEST_F(FilePublisherTest, FailedPublishRemovesTemp)
+{
+    FilePublisher publisher;
+    std::string tempPath = writeTemp("data_0.json", "[]");
+    EXPECT_TRUE(publisher.publish(tempPath, (dir / "missing" / "data_0.json").string()).isError());
+    EXPECT_EQ(countTempFiles(), 0u);
+}
+
+TEST_F(FilePublisherTest, WriteFileReplacesContent)
+{
+    std::string path = (dir / "metrics.json").string();
+    for (bool durable : {false, true})
+    {
+        std::string content = durable ? "{\"durable\":true}" : "{}";
+        ASSERT_FALSE(FilePublisher::writeFile(path, content, durable).isError());
+        std::ifstream in(path);
+        std::string got((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        EXPECT_EQ(got, content);
+        EXPECT_EQ(countTempFiles(), 0u);
+    }
+    EXPECT_TRUE(FilePublisher::writeFile((dir / "missing" / "metrics.json").string(), "{}").isError());
+    EXPECT_EQ(countTempFiles(), 0u);
+}
+
+TEST_F(FilePublisherTest, FileManagerLeavesOnlyFinalFiles)
+{
+    FileManager manager("test_file_publisher");
+    manager.setPublisher(std::make_shared<FilePublisher>(SyncPolicy::kBatched, 4));
+    Result res = manager.write(DataType{{"key_1", "v1", 0}});
+    ASSERT_FALSE(res.isError()) << res.message();
+    EXPECT_FALSE(manager.flush().isError());
+    EXPECT_TRUE(std::filesystem::exists(dir / "data_0.json"));
+    EXPECT_EQ(countTempFiles(), 0u);
+}
@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include "rocksdb/sst_file_writer.h"
+#include "exchange/ingestor.h"
+#include "utils/kconfig.h"
+
+namespace
+{
+    IngestFile range(const std::string &name, const std::string &smallest, const std::string &largest)
+    {
+        IngestFile file;
+        file.path = name;
+        file.smallestKey = smallest;
+        file.largestKey = largest;
+        return file;
+    }
+
+    std::vector<std::string> paths(const IngestBatch &batch)
+    {
+        std::vector<std::string> out;
+        for (const auto &file : batch.files)
+            out.push_back(file.path);
+        return out;
+    }
+}
+
+// 文件进入“晚于所有与它重叠的先导入文件”的最早一组
+TEST(IngestPlannerTest, GroupsNonOverlappingFilesInOrder)
+{
+    IngestPlanner planner;
+    planner.add(range("A", "a", "c"));
+    planner.add(range("B", "d", "f"));
+    planner.add(range("C", "b", "e")); // 与 A、B 重叠
+    planner.add(range("D", "g", "h"));
+    planner.add(range("E", "e", "g")); // 与 B、C、D 重叠，必须在 C 之后
+
+    IngestPlan plan;
+    ASSERT_FALSE(planner.plan(plan).isError());
+    ASSERT_EQ(plan.batches.size(), 3u);
+    EXPECT_EQ(paths(plan.batches[0]), (std::vector<std::string>{"A", "B", "D"}));
+    EXPECT_EQ(paths(plan.batches[1]), (std::vector<std::string>{"C"}));
+    EXPECT_EQ(paths(plan.batches[2]), (std::vector<std::string>{"E"}));
+
+    // 空 key 范围全部落在最底层，之后每组落在它覆盖的文件之上
+    EXPECT_EQ(plan.batches[0].expectedLevels, (std::vector<int>{6, 6, 6}));
+    EXPECT_EQ(plan.batches[1].expectedLevels, (std::vector<int>{5}));
+    EXPECT_EQ(plan.batches[2].expectedLevels, (std::vector<int>{4}));
+    EXPECT_TRUE(plan.batches[0].options.allow_global_seqno);
+    EXPECT_FALSE(plan.batches[0].options.write_global_seqno);
+    EXPECT_FALSE(plan.batches[0].options.ingest_behind);
+}
+
+// Pika 的 meta 在 default CF：每一组的全部 data CF 都先于 meta 导入，读者不会看到指向尚未导入元素的 meta
+TEST(IngestPlannerTest, IngestsDataColumnFamiliesBeforeMeta)
+{
+    auto inCf = [](IngestFile file, const std::string &cf)
+    {
+        file.columnFamily = cf;
+        return file;
+    };
+    IngestPlanner planner;
+    // 按输出顺序：每个输出的清单先列出 default，再列出各 data CF
+    planner.add(range("meta0", "a", "c"));
+    planner.add(inCf(range("hash0", "a", "c"), "hash_data_cf"));
+    planner.add(inCf(range("set0", "a", "c"), "set_data_cf"));
+    planner.add(range("meta1", "b", "d"));
+    planner.add(inCf(range("hash1", "b", "d"), "hash_data_cf"));
+
+    IngestPlan plan;
+    ASSERT_FALSE(planner.plan(plan).isError());
+    std::vector<std::string> order;
+    for (const auto &batch : plan.batches)
+        order.push_back(batch.columnFamily + ":" + paths(batch).front());
+    EXPECT_EQ(order, (std::vector<std::string>{"hash_data_cf:hash0", "set_data_cf:set0", "hash_data_cf:hash1",
+                                               "default:meta0", "default:meta1"}));
+}
+
+TEST(IngestPlannerTest, FallsBackToL0WhenLevelsRunOut)
+{
+    rocksdb::Options options;
+    options.num_levels = 2;
+    IngestPlanner planner(options);
+    planner.add(range("A", "a", "c"));
+    planner.add(range("B", "b", "d"));
+    planner.add(range("C", "c", "e"));
+
+    IngestPlan plan;
+    ASSERT_FALSE(planner.plan(plan).isError());
+    ASSERT_EQ(plan.batches.size(), 3u);
+    EXPECT_EQ(plan.batches[0].expectedLevels, (std::vector<int>{1}));
+    EXPECT_EQ(plan.batches[1].expectedLevels, (std::vector<int>{0}));
+    EXPECT_EQ(plan.batches[2].expectedLevels, (std::vector<int>{0}));
+    EXPECT_EQ(plan.toJson("")["l0Files"], 2);
+}
+
+TEST(IngestPlannerTest, IngestBehindNeedsSingleGroup)
+{
+    IngestPlanner planner;
+    planner.setIngestBehind(true);
+    planner.setMoveFiles(true);
+    planner.add(range("A", "a", "c"));
+    planner.add(range("B", "d", "f"));
+
+    IngestPlan plan;
+    ASSERT_FALSE(planner.plan(plan).isError());
+    ASSERT_EQ(plan.batches.size(), 1u);
+    EXPECT_TRUE(plan.batches[0].options.ingest_behind);
+    EXPECT_TRUE(plan.batches[0].options.move_files);
+    EXPECT_EQ(plan.batches[0].expectedLevels, (std::vector<int>{6, 6}));
+
+    planner.add(range("C", "b", "e"));
+    EXPECT_TRUE(planner.plan(plan).isError());
+}
+
+// 读取输出目录：没有清单的按 SST 首尾 key，有清单的按清单；执行后后导入的值胜出
+TEST(IngestPlannerTest, PlansAndExecutesOutputDirectory)
+{
+    std::filesystem::path dir = DEFAULTDIC / "test_ingest_plan";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    auto writeSst = [&](const std::string &name, const std::vector<std::pair<std::string, std::string>> &kvs)
+    {
+        rocksdb::SstFileWriter writer{rocksdb::EnvOptions(), rocksdb::Options()};
+        ASSERT_TRUE(writer.Open((dir / name).string()).ok());
+        for (const auto &kv : kvs)
+            ASSERT_TRUE(writer.Put(kv.first, kv.second).ok());
+        ASSERT_TRUE(writer.Finish().ok());
+    };
+    writeSst("data_0.sst", {{"k1", "old"}, {"k3", "old"}});
+    writeSst("data_10.sst", {{"k3", "new"}, {"k5", "new"}});
+    writeSst("data_2.sst", {{"x1", "v"}, {"x2", "v"}});
+    {
+        std::ofstream out(dir / "data_2.manifest.json");
+        out << R"({"columnFamilies": [{"name": "default", "comparator": "leveldb.BytewiseComparator", "entries": 2,
+                   "files": [{"file": "data_2.sst", "fileSize": 1, "entries": 2, "smallestKey": "7831", "largestKey": "7832"}]}],
+                   "output": "data_2"})";
+    }
+
+    IngestPlanner planner;
+    ASSERT_FALSE(planner.addDirectory(dir.string()).isError());
+    ASSERT_EQ(planner.size(), 3u);
+    IngestPlan plan;
+    ASSERT_FALSE(planner.plan(plan).isError());
+    ASSERT_EQ(plan.batches.size(), 2u);
+    ASSERT_EQ(plan.batches[0].files.size(), 2u);
+    EXPECT_EQ(plan.batches[0].files[1].smallestKey, "x1");
+    EXPECT_EQ(std::filesystem::path(plan.batches[1].files[0].path).filename(), "data_10.sst");
+
+    std::string planPath = (dir / "ingest_plan.json").string();
+    ASSERT_FALSE(writeIngestPlan(plan, planPath).isError());
+    std::ifstream in(planPath);
+    json written = json::parse(in);
+    EXPECT_EQ(written["calls"], 2);
+    EXPECT_EQ(written["batches"][1]["files"][0]["file"], "data_10.sst");
+
+    rocksdb::Options options;
+    options.create_if_missing = true;
+    rocksdb::DB *raw = nullptr;
+    ASSERT_TRUE(rocksdb::DB::Open(options, (dir / "db").string(), &raw).ok());
+    std::unique_ptr<rocksdb::DB> db(raw);
+    Result res = IngestPlanner::execute(db.get(), {}, plan);
+    ASSERT_FALSE(res.isError()) << res.message_raw();
+    std::string value;
+    ASSERT_TRUE(db->Get(rocksdb::ReadOptions(), "k3", &value).ok());
+    EXPECT_EQ(value, "new");
+    db.reset();
+    std::filesystem::remove_all(dir);
+}
+
+TEST(IngestPlannerTest, RejectsManifestWithOtherComparator)
+{
+    std::filesystem::path dir = DEFAULTDIC / "test_ingest_manifest";
+    std::filesystem::create_directories(dir);
+    std::string path = (dir / "data_0.manifest.json").string();
+    {
+        std::ofstream out(path);
+        out << R"({"columnFamilies": [{"name": "list_data_cf", "comparator": "leveldb.BytewiseComparator", "entries": 0, "files": []}]})";
+    }
+    IngestPlanner planner;
+    EXPECT_TRUE(planner.addManifest(path).isError());
+    std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "utils/ioBackend.h"
+
+class IoBackendTest : public ::testing::TestWithParam<std::string>
+{
+protected:
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "bingest_io_backend_test";
+    std::shared_ptr<IoBackend> backend;
+
+    void SetUp() override
+    {
+        Result res = makeIoBackend(GetParam(), backend);
+        if (res.isError())
+            GTEST_SKIP() << GetParam() << " unavailable: " << res.message_raw();
+        std::filesystem::create_directories(dir);
+    }
+    void TearDown() override
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    static std::string pattern(size_t size)
+    {
+        std::string data(size, '\0');
+        for (size_t i = 0; i < size; ++i)
+            data[i] = static_cast<char>('a' + (i * 7 + i / 4096) % 26);
+        return data;
+    }
+
+    std::string readBack(const std::filesystem::path &path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream content;
+        content << in.rdbuf();
+        return content.str();
+    }
+};
+
+TEST_P(IoBackendTest, WriteThenReadRoundTrip)
+{
+    // 大于 队列深度 x 块大小，且不是块大小的整数倍，覆盖等待槽位与尾块
+    std::string data = pattern(IoUringBackend::kQueueDepth * IoUringBackend::kChunkSize * 2 + 12345);
+    std::string path = (dir / "data.bin").string();
+
+    std::unique_ptr<IoWriter> writer;
+    ASSERT_FALSE(backend->openForWrite(path, writer).isError());
+    // 不同大小的多次写入，包括跨块的写入
+    size_t offsets[] = {0, 100, 100 + IoUringBackend::kChunkSize * 3, data.size() - 1, data.size()};
+    for (size_t i = 0; i + 1 < std::size(offsets); ++i)
+        ASSERT_FALSE(writer->write(data.data() + offsets[i], offsets[i + 1] - offsets[i]).isError());
+    ASSERT_FALSE(writer->close().isError());
+    EXPECT_EQ(readBack(path), data);
+
+    std::string read;
+    ASSERT_FALSE(backend->readFile(path, read).isError());
+    EXPECT_EQ(read, data);
+}
+
+TEST_P(IoBackendTest, PrefetchedReadMatchesFile)
+{
+    std::vector<std::string> paths;
+    for (int i = 0; i < 3; ++i)
+    {
+        paths.push_back((dir / ("data_" + std::to_string(i) + ".json")).string());
+        std::ofstream(paths.back(), std::ios::binary) << pattern(1000000 + i);
+        backend->prefetch(paths.back());
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        std::string read;
+        ASSERT_FALSE(backend->readFile(paths[i], read).isError());
+        EXPECT_EQ(read, pattern(1000000 + i));
+    }
+    // 预读了但没有读取的文件在后端销毁时收尾
+    std::string empty = (dir / "empty.json").string();
+    std::ofstream(empty).close();
+    backend->prefetch(empty);
+    backend->prefetch((dir / "missing.json").string());
+    std::string read = "x";
+    ASSERT_FALSE(backend->readFile(empty, read).isError());
+    EXPECT_TRUE(read.empty());
+    backend->prefetch(paths[0]);
+}
+
+// 没有被读取的预读项到期后释放，不会一直占着名额、ring 与缓冲区
+TEST(IoUringBackendTest, UnclaimedReadAheadExpires)
+{
+    std::shared_ptr<IoBackend> backend;
+    Result res = IoUringBackend::create(backend);
+    if (res.isError())
+        GTEST_SKIP() << "uring unavailable: " << res.message_raw();
+    auto &uring = static_cast<IoUringBackend &>(*backend);
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "bingest_io_read_ahead_test";
+    std::filesystem::create_directories(dir);
+    std::vector<std::string> paths;
+    for (size_t i = 0; i <= IoUringBackend::kMaxReadAheadFiles; ++i)
+    {
+        paths.push_back((dir / ("data_" + std::to_string(i) + ".json")).string());
+        std::ofstream(paths.back(), std::ios::binary) << std::string(4096 + i, 'x');
+    }
+
+    for (size_t i = 0; i < IoUringBackend::kMaxReadAheadFiles; ++i)
+        uring.prefetch(paths[i]);
+    EXPECT_EQ(uring.readAheadFiles(), IoUringBackend::kMaxReadAheadFiles);
+    // 名额已满，且都未到期：新的预读被忽略
+    uring.prefetch(paths.back());
+    EXPECT_EQ(uring.readAheadFiles(), IoUringBackend::kMaxReadAheadFiles);
+
+    uring.setReadAheadExpiry(std::chrono::milliseconds(0));
+    uring.prefetch(paths.back());
+    EXPECT_EQ(uring.readAheadFiles(), 1u);
+    std::string read;
+    ASSERT_FALSE(uring.readFile(paths[0], read).isError());
+    EXPECT_EQ(read.size(), 4096u);
+    EXPECT_EQ(uring.readAheadFiles(), 0u);
+    std::filesystem::remove_all(dir);
+}
+
+TEST_P(IoBackendTest, MissingFileIsOpenError)
+{
+    std::string read;
+    Result res = backend->readFile((dir / "missing.json").string(), read);
+    EXPECT_EQ(res.getRet(), Result::Ret::kFileOpenError);
+    std::unique_ptr<IoWriter> writer;
+    EXPECT_EQ(backend->openForWrite((dir / "no_dir" / "x").string(), writer).getRet(), Result::Ret::kFileOpenError);
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, IoBackendTest, ::testing::Values("posix", "uring"));
+
+TEST(IoBackendFactoryTest, RejectsUnknownName)
+{
+    std::shared_ptr<IoBackend> backend;
+    EXPECT_TRUE(makeIoBackend("aio", backend).isError());
+    ASSERT_FALSE(makeIoBackend("auto", backend).isError());
+    EXPECT_NE(backend, nullptr);
+}
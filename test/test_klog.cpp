@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utils/klog.h"
+
+class KLogTest : public ::testing::Test
+{
+protected:
+    const std::string logFile = "test_klog.txt";
+
+    void SetUp() override
+    {
+        std::filesystem::remove(logFile);
+        klogger.setConsole(false);
+        klogger.setLogFile(logFile);
+    }
+
+    void TearDown() override
+    {
+        klogger.setLogFile("KLog.txt");
+        klogger.setConsole(true);
+        std::filesystem::remove(logFile);
+    }
+
+    std::vector<std::string> readLines()
+    {
+        klogger.flush();
+        std::ifstream in(logFile);
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(in, line))
+            lines.push_back(line);
+        return lines;
+    }
+};
+
+TEST_F(KLogTest, WritesFormattedLinesAfterFlush)
+{
+    LOG_INFO("hello klog");
+    LOG_ERROR("bad thing");
+    auto lines = readLines();
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_NE(lines[0].find("[INFO] hello klog"), std::string::npos);
+    EXPECT_NE(lines[1].find("[ERROR] bad thing"), std::string::npos);
+}
+
+TEST_F(KLogTest, ConcurrentProducersLoseNothing)
+{
+    const int threads = 8;
+    const int perThread = 5000; // 超过单个环形缓冲容量，触发反压
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([t]
+                             {
+            for (int i = 0; i < perThread; ++i)
+            {
+                LOG_INFO("thread " + std::to_string(t) + " line " + std::to_string(i));
+            } });
+    }
+    for (auto &w : workers)
+        w.join();
+    EXPECT_EQ(readLines().size(), static_cast<size_t>(threads * perThread));
+}
+
+TEST_F(KLogTest, RuntimeLevelFilter)
+{
+    klogger.setLevel(KLogger::Warning);
+    LOG_INFO("filtered");
+    LOG_WARN("kept");
+    klogger.setLevel(KLogger::Debug);
+    auto lines = readLines();
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_NE(lines[0].find("[WARNING] kept"), std::string::npos);
+}
+
+TEST_F(KLogTest, EveryNAndRateLimitSuppressHotPaths)
+{
+    for (int i = 0; i < 100; ++i)
+    {
+        LOG_DEBUG_EVERY_N(10, "every n " + std::to_string(i));
+    }
+    for (int i = 0; i < 100; ++i)
+    {
+        LOG_WARN_RATE_LIMITED(5, "rate " + std::to_string(i));
+    }
+    auto lines = readLines();
+    size_t everyN = 0, rate = 0;
+    for (const auto &line : lines)
+    {
+        everyN += line.find("every n") != std::string::npos;
+        rate += line.find("rate") != std::string::npos;
+    }
+    EXPECT_EQ(everyN, 10u);
+    EXPECT_GE(rate, 5u);
+    EXPECT_LE(rate, 10u); // 跨秒边界时最多两个窗口
+}
+
+TEST_F(KLogTest, CompileTimeFilterSkipsEvaluation)
+{
+    // 低于 KLOG_MIN_LEVEL 的级别，参数表达式不会被求值
+    int evaluated = 0;
+    auto message = [&evaluated]
+    {
+        ++evaluated;
+        return std::string("evaluated");
+    };
+    if (KLOG_MIN_LEVEL > KLogger::Debug)
+    {
+        LOG_DEBUG(message());
+        EXPECT_EQ(evaluated, 0);
+    }
+    else
+    {
+        LOG_DEBUG(message());
+        EXPECT_EQ(evaluated, 1);
+    }
+}
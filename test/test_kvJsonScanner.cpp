@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include "exchange/JsonFileManager.h"
+#include "exchange/kvJsonScanner.h"
+
+namespace
+{
+    std::vector<SimdLevel> supportedLevels()
+    {
+        std::vector<SimdLevel> levels;
+        for (SimdLevel level : {SimdLevel::kScalar, SimdLevel::kSse42, SimdLevel::kAvx2})
+        {
+            if (level <= detectSimdLevel())
+                levels.push_back(level);
+        }
+        return levels;
+    }
+
+    DataType sampleData()
+    {
+        DataType data;
+        for (int i = 0; i < 200; ++i)
+        {
+            // 长度跨越 16/32 字节块边界
+            data.push_back({"key_" + std::to_string(i), std::string(i % 70, 'a' + i % 26), static_cast<uint32_t>(i * 1000003u)});
+        }
+        data.push_back({"escaped \"quote\" \\ / \b\f\n\r\t", std::string(40, 'x') + "\x01\x1f" + std::string(40, 'y'), 0});
+        data.push_back({"utf8 中文 😀", "é", UINT32_MAX});
+        data.push_back({"", "", 0});
+        return data;
+    }
+
+    void expectSame(const DataType &actual, const DataType &expected)
+    {
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            EXPECT_EQ(actual[i].key, expected[i].key) << i;
+            EXPECT_EQ(actual[i].value, expected[i].value) << i;
+            EXPECT_EQ(actual[i].timestamp, expected[i].timestamp) << i;
+        }
+    }
+}
+
+TEST(KvJsonScannerTest, MatchesNlohmannForPrettyAndCompact)
+{
+    DataType expected = sampleData();
+    for (int indent : {-1, 4})
+    {
+        std::string text = json(expected).dump(indent);
+        for (SimdLevel level : supportedLevels())
+        {
+            DataType actual;
+            Result res = KvJsonScanner(level).parse(text.data(), text.size(), actual);
+            ASSERT_FALSE(res.isError()) << simdLevelName(level) << ": " << res.message_raw();
+            expectSame(actual, expected);
+        }
+    }
+}
+
+TEST(KvJsonScannerTest, AcceptsEscapesAndFieldOrder)
+{
+    std::string text = "\r\n[ {\"expire\" : 7 , \"value\":\"\\u00e9\\ud83d\\ude00\\u4e2d\", \"key\":\"k\\/1\"},\t{\"key\":\"k2\",\"value\":\"v\"} ]\n";
+    for (SimdLevel level : supportedLevels())
+    {
+        DataType actual;
+        ASSERT_FALSE(KvJsonScanner(level).parse(text.data(), text.size(), actual).isError()) << simdLevelName(level);
+        expectSame(actual, json::parse(text).get<DataType>());
+    }
+}
+
+TEST(KvJsonScannerTest, RejectsWhatItDoesNotHandle)
+{
+    const char *inputs[] = {
+        R"([{"key":"k","type":"set","members":["a"]}])",
+        R"([{"key":"k","value":"v","expire":1.5}])",
+        R"([{"key":"k","value":"v","expire":-1}])",
+        R"([{"key":"k","value":"v","expire":4294967296}])",
+        R"([{"key":"k"}])",
+        R"([{"key":"k","value":1}])",
+        R"([{"key":"k","value":"v"},])",
+        R"([{"key":"k","value":"\ud800"}])",
+        "[{\"key\":\"k\",\"value\":\"a\nb\"}]",
+        R"([{"key":"k","value":"v"}] x)",
+        R"({"key":"k","value":"v"})",
+        "[{\"key\":\"k\",\"value\":\"a\xff\"}]",             // 不可能出现的字节
+        "[{\"key\":\"k\xc3\",\"value\":\"v\"}]",              // 被引号截断的两字节序列
+        "[{\"key\":\"k\",\"value\":\"\xc0\xaf\"}]",          // 过长编码
+        "[{\"key\":\"k\",\"value\":\"\xed\xa0\x80\"}]",     // 代理区
+        "[{\"key\":\"k\",\"value\":\"\xf4\x90\x80\x80\"}]", // 超出 U+10FFFF
+    };
+    for (SimdLevel level : supportedLevels())
+    {
+        for (const char *input : inputs)
+        {
+            DataType actual;
+            EXPECT_TRUE(KvJsonScanner(level).parse(input, std::strlen(input), actual).isError()) << simdLevelName(level) << ": " << input;
+            EXPECT_TRUE(actual.empty());
+        }
+    }
+}
+
+TEST(KvJsonScannerTest, FileManagerFallsBackForTypedRecords)
+{
+    std::filesystem::path dir = DEFAULTDIC / "test_kv_scanner";
+    std::filesystem::create_directories(dir);
+    DataType typed = {{"s", "v", 3}};
+    KvEntry set;
+    set.key = "members";
+    set.type = KvType::kSet;
+    set.fields = {{"a", "", 0}, {"b", "", 0}};
+    typed.push_back(set);
+    {
+        std::ofstream out(dir / "typed.json");
+        out << json(typed).dump(4);
+    }
+
+    JsonFileManager fileManager;
+    DataType parsed = fileManager.parse((dir / "typed.json").string());
+    ASSERT_EQ(parsed.size(), 2u);
+    EXPECT_EQ(parsed[0].value, "v");
+    EXPECT_EQ(parsed[1].type, KvType::kSet);
+    EXPECT_EQ(parsed[1].fields.size(), 2u);
+    std::filesystem::remove_all(dir);
+}
+
+// 非法 UTF-8 由扫描器拒绝后回退到 nlohmann::json，结果与直接使用 nlohmann 相同（解析失败）
+TEST(KvJsonScannerTest, InvalidUtf8MatchesNlohmann)
+{
+    std::string text = std::string("[{\"key\":\"k\",\"value\":\"") + std::string(40, 'a') + "\x80" + std::string(40, 'b') + "\"}]";
+    EXPECT_THROW(json::parse(text), json::parse_error);
+    for (SimdLevel level : supportedLevels())
+    {
+        DataType actual;
+        Result res = KvJsonScanner(level).parse(text.data(), text.size(), actual);
+        ASSERT_TRUE(res.isError()) << simdLevelName(level);
+        EXPECT_NE(res.message_raw().find("UTF-8"), std::string::npos) << res.message_raw();
+    }
+
+    std::filesystem::path dir = DEFAULTDIC / "test_kv_scanner_utf8";
+    std::filesystem::create_directories(dir);
+    {
+        std::ofstream out(dir / "bad.json", std::ios::binary);
+        out << text;
+    }
+    JsonFileManager fileManager;
+    EXPECT_ANY_THROW(fileManager.parse((dir / "bad.json").string()));
+    std::filesystem::remove_all(dir);
+}
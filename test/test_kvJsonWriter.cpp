@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "utils/kvJsonWriter.h"
+
+namespace
+{
+    KvEntry collection(const std::string &key, KvType type, std::vector<KvField> fields, uint32_t expire = 0)
+    {
+        KvEntry entry;
+        entry.key = key;
+        entry.type = type;
+        entry.fields = std::move(fields);
+        entry.timestamp = expire;
+        return entry;
+    }
+
+    DataType sampleData()
+    {
+        DataType data = {{"plain", "value", 1700000000u},
+                         {"no_expire", std::string(100, 'v'), 0},
+                         {"escaped \"q\" \\ / \b\f\n\r\t \x01\x1f\x7f", "中文 😀 é", UINT32_MAX},
+                         {"", "", 0}};
+        data.push_back(collection("h", KvType::kHash, {{"b", "2", 0}, {"a", "1", 0}, {"b", "3", 0}}, 42));
+        data.push_back(collection("h_empty", KvType::kHash, {}));
+        data.push_back(collection("s", KvType::kSet, {{"m2", "", 0}, {"m1", "", 0}}));
+        data.push_back(collection("s_empty", KvType::kSet, {}, 7));
+        data.push_back(collection("z", KvType::kZSet, {{"x", "", 1.5}, {"y", "", 1.0}, {"w", "", -3e20}, {"x", "", 0.1}}));
+        data.push_back(collection("l", KvType::kList, {{"", "first", 0}, {"", "sec\"ond", 0}}, 9));
+        return data;
+    }
+}
+
+TEST(KvJsonWriterTest, MatchesNlohmannDump)
+{
+    DataType data = sampleData();
+    std::string out;
+    KvJsonWriter writer;
+    ASSERT_FALSE(writer.serialize(data, out).isError());
+    EXPECT_EQ(out, json(data).dump(4));
+
+    writer.setStyle(KvJsonWriter::Style::kCompact);
+    ASSERT_FALSE(writer.serialize(data, out).isError());
+    EXPECT_EQ(out, json(data).dump());
+
+    ASSERT_FALSE(writer.serialize(DataType(), out).isError());
+    EXPECT_EQ(out, "[]");
+}
+
+TEST(KvJsonWriterTest, RejectsInvalidUtf8)
+{
+    KvJsonWriter writer;
+    std::string out;
+    for (std::string bad : {"\xff", "\xc0\xaf", "\xed\xa0\x80", "\xe4\xb8", "\xf4\x90\x80\x80"})
+    {
+        EXPECT_TRUE(writer.serialize({{"k", bad, 0}}, out).isError());
+        EXPECT_THROW(json(DataType{{"k", bad, 0}}).dump(), json::type_error);
+    }
+}
+
+TEST(KvJsonWriterTest, StreamsLargeDataToWriter)
+{
+    // 超过 kFlushBytes，覆盖中途刷出
+    DataType data;
+    for (int i = 0; i < 60000; ++i)
+        data.push_back({"key_" + std::to_string(i), std::string(64 + i % 32, 'a' + i % 26), static_cast<uint32_t>(i)});
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "bingest_kv_json_writer.json";
+    std::unique_ptr<IoWriter> out;
+    ASSERT_FALSE(defaultIoBackend()->openForWrite(path.string(), out).isError());
+    KvJsonWriter writer;
+    ASSERT_FALSE(writer.write(*out, data).isError());
+    ASSERT_FALSE(out->close().isError());
+
+    std::ifstream in(path);
+    std::stringstream content;
+    content << in.rdbuf();
+    EXPECT_GT(content.str().size(), KvJsonWriter::kFlushBytes);
+    EXPECT_EQ(content.str(), json(data).dump(4));
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include "utils/memoryBudget.h"
+#include "utils/workerBuffers.h"
+#include "exchange/sstProcessor.h"
+#include "rocksdb/options.h"
+
+TEST(MemoryBudgetTest, ReserveBlocksUntilReleased)
+{
+    MemoryBudget budget(100);
+    MemoryReservation first = budget.reserve(60);
+    EXPECT_EQ(budget.reserved(), 60u);
+
+    std::atomic<bool> admitted{false};
+    std::thread waiter([&]
+                       {
+                           MemoryReservation second = budget.reserve(60);
+                           admitted = true; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(admitted.load());
+
+    first.release();
+    waiter.join();
+    EXPECT_TRUE(admitted.load());
+    EXPECT_EQ(budget.reserved(), 0u);
+}
+
+TEST(MemoryBudgetTest, OversizedRequestRunsAlone)
+{
+    MemoryBudget budget(100);
+    {
+        // 超过总预算的请求按总预算计，不会永远等待
+        MemoryReservation big = budget.reserve(1000);
+        EXPECT_EQ(big.bytes(), 100u);
+        EXPECT_EQ(budget.reserved(), 100u);
+
+        // 不能等待的调用方可以超额预留
+        MemoryReservation extra = budget.reserveNow(10);
+        EXPECT_EQ(budget.reserved(), 110u);
+
+        MemoryReservation moved = std::move(extra);
+        EXPECT_EQ(extra.bytes(), 0u);
+        EXPECT_EQ(budget.reserved(), 110u);
+    }
+    EXPECT_EQ(budget.reserved(), 0u);
+}
+
+// 缓冲池的保留只在有任务运行时占用预算，空闲线程的保留不会让提交永远等待
+TEST(MemoryBudgetTest, RetainedPoolsDoNotBlockAnIdleBudget)
+{
+    MemoryBudget budget(100);
+    MemoryReservation pools = budget.retain(80);
+    EXPECT_EQ(budget.retained(), 80u);
+    EXPECT_EQ(budget.reserved(), 0u);
+    {
+        MemoryReservation alone = budget.reserve(1000);
+        EXPECT_EQ(alone.bytes(), 100u);
+    }
+
+    MemoryReservation first = budget.reserve(10);
+    std::atomic<bool> admitted{false};
+    std::thread waiter([&]
+                       {
+                           MemoryReservation second = budget.reserve(20);
+                           admitted = true; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(admitted.load()); // 10 + 80 + 20 超出预算
+
+    pools.release();
+    waiter.join();
+    EXPECT_TRUE(admitted.load());
+    first.release();
+    EXPECT_EQ(budget.reserved(), 0u);
+    EXPECT_EQ(budget.retained(), 0u);
+}
+
+TEST(MemoryBudgetTest, ExpansionRisesAtOnceAndDecaysSlowly)
+{
+    MemoryBudget budget(1 << 30, 2.0);
+    EXPECT_EQ(budget.estimate(100), 200u);
+
+    budget.observe(100, 1000);
+    EXPECT_DOUBLE_EQ(budget.expansion(), 10.0);
+
+    budget.observe(100, 200);
+    EXPECT_DOUBLE_EQ(budget.expansion(), 8.0);
+
+    budget.observe(0, 1000); // 没有输入的实测被忽略
+    EXPECT_DOUBLE_EQ(budget.expansion(), 8.0);
+    EXPECT_GT(MemoryBudget::autoCapacity(), 0u);
+}
+
+// 预算只够一个任务时，目录转换逐个提交仍全部成功，并以实测修正扩张系数
+TEST(MemoryBudgetTest, SstProcessorConvertsUnderTightBudget)
+{
+    const std::string inputDic = "budget_input";
+    const std::string outputDic = "budget_output";
+    std::filesystem::create_directories(DEFAULTDIC / inputDic);
+    for (int i = 0; i < 4; ++i)
+    {
+        std::ofstream out(DEFAULTDIC / inputDic / ("data_" + std::to_string(i) + ".json"));
+        out << "[";
+        for (int k = 0; k < 200; ++k)
+            out << (k ? "," : "") << "{\"key\":\"k" << i << "_" << k << "\",\"value\":\"v\"}";
+        out << "]";
+    }
+
+    JsonFileManager fileManager;
+    rocksdb::Options options;
+    SstProcessor processor(options);
+    processor.setNumThreads(4);
+    auto budget = std::make_shared<MemoryBudget>(1);
+    processor.setMemoryBudget(budget);
+    WorkerBuffers::setMemoryBudget(budget); // 与 exchange 的 -B 相同，缓冲池的保留也计入预算
+    Result res = processor.mutiProcessSstFile(&fileManager, inputDic, outputDic);
+    WorkerBuffers::setMemoryBudget(nullptr);
+    EXPECT_FALSE(res.isError()) << res.message_raw();
+    for (int i = 0; i < 4; ++i)
+        EXPECT_TRUE(std::filesystem::exists(DEFAULTDIC / outputDic / ("data_" + std::to_string(i) + ".sst")));
+    EXPECT_EQ(budget->reserved(), 0u);
+    EXPECT_NE(budget->expansion(), MemoryBudget::kDefaultExpansion);
+
+    std::filesystem::remove_all(DEFAULTDIC / inputDic);
+    std::filesystem::remove_all(DEFAULTDIC / outputDic);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include "utils/metrics.h"
+
+TEST(MetricsTest, CounterSumsAcrossThreads)
+{
+    MetricsCounter &counter = metricsCounter("test_counter_threads_total");
+    uint64_t before = counter.value();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t)
+    {
+        threads.emplace_back([&counter]
+                             {
+            for (int i = 0; i < 10000; ++i)
+                counter.add(); });
+    }
+    for (auto &t : threads)
+        t.join();
+    EXPECT_EQ(counter.value() - before, 80000u);
+}
+
+TEST(MetricsTest, RegistryReturnsSameInstance)
+{
+    EXPECT_EQ(&metricsCounter("test_same_total"), &metricsCounter("test_same_total"));
+    EXPECT_EQ(&metricsHistogram("test_same_ns"), &metricsHistogram("test_same_ns"));
+    EXPECT_EQ(&metricsGauge("test_same_gauge"), &metricsGauge("test_same_gauge"));
+}
+
+TEST(MetricsTest, HistogramBucketsAreContiguous)
+{
+    for (size_t i = 0; i + 1 < MetricsHistogram::kBuckets; ++i)
+    {
+        EXPECT_EQ(MetricsHistogram::bucketUpperBound(i) + 1, MetricsHistogram::bucketLowerBound(i + 1));
+    }
+    for (uint64_t v : std::vector<uint64_t>{0, 1, 15, 16, 17, 1000, 123456789, UINT64_MAX})
+    {
+        size_t idx = MetricsHistogram::bucketIndex(v);
+        EXPECT_LE(MetricsHistogram::bucketLowerBound(idx), v);
+        EXPECT_GE(MetricsHistogram::bucketUpperBound(idx), v);
+    }
+}
+
+TEST(MetricsTest, HistogramPercentilesWithinPrecision)
+{
+    MetricsHistogram histogram;
+    for (uint64_t v = 1; v <= 10000; ++v)
+        histogram.record(v);
+    MetricsHistogram::Snapshot snap = histogram.snapshot();
+    EXPECT_EQ(snap.count, 10000u);
+    EXPECT_EQ(snap.min, 1u);
+    EXPECT_EQ(snap.max, 10000u);
+    EXPECT_NEAR(static_cast<double>(snap.percentile(0.5)), 5000.0, 5000.0 * 0.07);
+    EXPECT_NEAR(static_cast<double>(snap.percentile(0.99)), 9900.0, 9900.0 * 0.07);
+    EXPECT_EQ(snap.percentile(1.0), 10000u);
+}
+
+TEST(MetricsTest, ExporterWritesJsonAndPrometheus)
+{
+    metricsCounter("test_export_total", "exported counter").add(3);
+    metricsGauge("test_export_gauge").set(-7);
+    metricsHistogram("test_export_ns").record(42);
+
+    const std::string jsonPath = "test_metrics.json";
+    const std::string promPath = "test_metrics.prom";
+    {
+        MetricsExporter exporter(jsonPath, promPath, std::chrono::milliseconds(10));
+    }
+
+    std::ifstream jin(jsonPath);
+    json j;
+    jin >> j;
+    EXPECT_GE(j["counters"]["test_export_total"].get<uint64_t>(), 3u);
+    EXPECT_EQ(j["gauges"]["test_export_gauge"].get<int64_t>(), -7);
+    EXPECT_GE(j["histograms"]["test_export_ns"]["count"].get<uint64_t>(), 1u);
+
+    std::ifstream pin(promPath);
+    std::string prom((std::istreambuf_iterator<char>(pin)), std::istreambuf_iterator<char>());
+    EXPECT_NE(prom.find("# HELP test_export_total exported counter"), std::string::npos);
+    EXPECT_NE(prom.find("# TYPE test_export_total counter"), std::string::npos);
+    EXPECT_NE(prom.find("test_export_gauge -7"), std::string::npos);
+    EXPECT_NE(prom.find("test_export_ns{quantile=\"0.5\"}"), std::string::npos);
+    EXPECT_NE(prom.find("test_export_ns_count"), std::string::npos);
+
+    std::filesystem::remove(jsonPath);
+    std::filesystem::remove(promPath);
+}
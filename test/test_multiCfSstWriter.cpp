@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "exchange/multiCfSstWriter.h"
+#include "exchange/sstValidator.h"
+#include "utils/filePublisher.h"
+#include "utils/kconfig.h"
+
+class MultiCfSstWriterTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path dir = DEFAULTDIC / "test_multi_cf_writer";
+
+    void SetUp() override
+    {
+        std::filesystem::create_directories(dir);
+    }
+    void TearDown() override
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::vector<CfSpec> specs(size_t n)
+    {
+        std::vector<CfSpec> cfs(n);
+        for (size_t i = 0; i < n; ++i)
+            cfs[i].name = "cf" + std::to_string(i);
+        return cfs;
+    }
+
+    std::string pathOf(size_t cf) { return (dir / ("out.cf" + std::to_string(cf) + ".sst")).string(); }
+};
+
+TEST_F(MultiCfSstWriterTest, WritesEachNonEmptyCfSorted)
+{
+    MultiCfSstWriter writer(specs(3));
+    writer.setValidate(true);
+    for (int i = 9; i >= 0; --i)
+    {
+        writer.add(0, "key_" + std::to_string(i), "v");
+        if (i % 2 == 0)
+            writer.add(2, "member_" + std::to_string(i), "");
+    }
+
+    TaskScheduler scheduler(2);
+    Result res = writer.write(&scheduler, 2, [this](size_t cf)
+                              { return pathOf(cf); });
+    ASSERT_FALSE(res.isError()) << res.message();
+    EXPECT_EQ(writer.numEntries(), 15u);
+    EXPECT_EQ(writer.finalPaths(), (std::vector<std::string>{pathOf(0), pathOf(2)}));
+
+    // 写入的是临时文件，发布之前最终路径不存在
+    for (const auto &tempPath : writer.tempPaths())
+        EXPECT_TRUE(std::filesystem::exists(tempPath));
+    EXPECT_FALSE(std::filesystem::exists(pathOf(0)));
+
+    json manifest = writer.manifest(dir.string());
+    ASSERT_EQ(manifest["columnFamilies"].size(), 2u);
+    const json &cf0 = manifest["columnFamilies"][0];
+    EXPECT_EQ(cf0["name"], "cf0");
+    EXPECT_EQ(cf0["entries"], 10);
+    EXPECT_EQ(cf0["files"][0]["file"], "out.cf0.sst");
+    EXPECT_EQ(cf0["files"][0]["smallestKey"], "6b65795f30"); // key_0
+    EXPECT_EQ(manifest["columnFamilies"][1]["name"], "cf2");
+}
+
+TEST_F(MultiCfSstWriterTest, SplitsEachCfIndependently)
+{
+    MultiCfSstWriter writer(specs(2), SstSplitPolicy{0, 2});
+    for (int i = 0; i < 5; ++i)
+    {
+        writer.add(0, "a" + std::to_string(i), "v");
+        writer.add(1, "b" + std::to_string(i), "v");
+    }
+    Result res = writer.write(nullptr, 2, [this](size_t cf)
+                              { return pathOf(cf); });
+    ASSERT_FALSE(res.isError()) << res.message();
+    std::vector<std::string> paths = writer.finalPaths();
+    ASSERT_EQ(paths.size(), 6u);
+    EXPECT_EQ(paths[0], sstPartPath(pathOf(0), 0));
+    EXPECT_EQ(paths[5], sstPartPath(pathOf(1), 2));
+}
+
+TEST_F(MultiCfSstWriterTest, FailedCfDiscardsWholeGroup)
+{
+    MultiCfSstWriter writer(specs(2));
+    writer.add(0, "a", "v");
+    writer.add(1, "b", "v");
+    Result res = writer.write(nullptr, 2, [this](size_t cf)
+                              { return cf == 1 ? (dir / "missing" / "out.sst").string() : pathOf(cf); });
+    EXPECT_TRUE(res.isError());
+    EXPECT_TRUE(writer.tempPaths().empty());
+    EXPECT_FALSE(std::filesystem::exists(FilePublisher::tempPath(pathOf(0))));
+}
+
+TEST_F(MultiCfSstWriterTest, EmptyWriterIsAnError)
+{
+    MultiCfSstWriter writer(specs(2));
+    EXPECT_TRUE(writer.write(nullptr, 1, [this](size_t cf)
+                             { return pathOf(cf); })
+                    .isError());
+}
+
+// 清单的 key 范围编码可以往返，非法的十六进制被拒绝
+TEST(ManifestHexTest, RoundTripsAndRejectsInvalid)
+{
+    std::string bytes("\x00\x7f\x80\xff" "ab", 6);
+    EXPECT_EQ(toHex(bytes), "007f80ff6162");
+    std::string decoded;
+    ASSERT_TRUE(fromHex("007F80ff6162", decoded));
+    EXPECT_EQ(decoded, bytes);
+
+    decoded = "keep";
+    for (const char *bad : {"0", "0g", "+f", " f", "zz"})
+    {
+        EXPECT_FALSE(fromHex(bad, decoded)) << bad;
+        EXPECT_EQ(decoded, "keep") << bad;
+    }
+}
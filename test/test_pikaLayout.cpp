@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include "utils/pikaLayout.h"
+#include "utils/compare.h"
+
+namespace
+{
+    KvEntry makeCollection(const std::string &key, KvType type, std::vector<KvField> fields, uint32_t expire = 0)
+    {
+        KvEntry entry;
+        entry.key = key;
+        entry.type = type;
+        entry.fields = std::move(fields);
+        entry.timestamp = expire;
+        return entry;
+    }
+
+    std::string fixed64(uint64_t v)
+    {
+        std::string out;
+        for (int i = 0; i < 8; ++i)
+            out.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+        return out;
+    }
+}
+
+TEST(PikaLayoutTest, EncodeUserKeyEscapesZeroBytes)
+{
+    std::string out;
+    PikaLayout::encodeUserKey(std::string("a\0b", 3), out);
+    EXPECT_EQ(out, std::string("a\0\1b\0\0", 6));
+}
+
+TEST(PikaLayoutTest, StringGoesToMetaCf)
+{
+    PikaLayout layout(1000);
+    CfData out;
+    layout.append(KvEntry{"k", "v", 7}, out);
+    ASSERT_EQ(out[kPikaMetaCf].size(), 1u);
+    for (size_t cf = kPikaHashDataCf; cf < kPikaCfCount; ++cf)
+        EXPECT_TRUE(out[cf].empty());
+
+    const KvPair &pair = out[kPikaMetaCf].front();
+    EXPECT_EQ(pair.first, std::string(8, '\0') + std::string("k\0\0", 3) + std::string(16, '\0'));
+    EXPECT_EQ(pair.second, PikaStringValueEncoder(1000).encode(KvEntry{"k", "v", 7}));
+}
+
+TEST(PikaLayoutTest, HashKeepsLastDuplicateField)
+{
+    PikaLayout layout(1000);
+    CfData out;
+    layout.append(makeCollection("h", KvType::kHash, {{"f1", "a", 0}, {"f2", "b", 0}, {"f1", "c", 0}}, 5), out);
+    ASSERT_EQ(out[kPikaHashDataCf].size(), 2u);
+    ASSERT_EQ(out[kPikaMetaCf].size(), 1u);
+
+    std::string prefix = std::string(8, '\0') + std::string("h\0\0", 3) + fixed64(layout.version());
+    EXPECT_EQ(out[kPikaHashDataCf][0].first, prefix + "f1" + std::string(16, '\0'));
+    EXPECT_EQ(out[kPikaHashDataCf][0].second.substr(0, 1), "c");
+
+    // | type | count (4B) | version | reserve | ctime | etime |
+    const std::string &meta = out[kPikaMetaCf].front().second;
+    ASSERT_EQ(meta.size(), 1u + 4 + 8 + 16 + 8 + 8);
+    EXPECT_EQ(meta[0], static_cast<char>(KvType::kHash));
+    EXPECT_EQ(meta[1], 2);
+    EXPECT_EQ(meta.substr(meta.size() - 8), fixed64(5000));
+}
+
+TEST(PikaLayoutTest, ZSetWritesMemberAndScoreCfs)
+{
+    PikaLayout layout(1000);
+    CfData out;
+    layout.append(makeCollection("z", KvType::kZSet, {{"m1", "", 2.5}, {"m2", "", -1}}), out);
+    EXPECT_EQ(out[kPikaZSetDataCf].size(), 2u);
+    ASSERT_EQ(out[kPikaZSetScoreCf].size(), 2u);
+
+    // score CF 按 score 排序：-1 在 2.5 之前，尽管 -1 的位模式按字节更大
+    auto &scores = out[kPikaZSetScoreCf];
+    const rocksdb::Comparator *comparator = pikaCfComparator(kPikaZSetScoreCf);
+    EXPECT_STREQ(comparator->Name(), "floyd.ZSetsScoreKeyComparator");
+    EXPECT_GT(comparator->Compare(scores[0].first, scores[1].first), 0);
+    EXPECT_GT(scores[1].first.compare(scores[0].first), 0);
+}
+
+TEST(PikaLayoutTest, ListIndexesFollowRpushOrder)
+{
+    PikaLayout layout(1000);
+    CfData out;
+    std::vector<KvField> values;
+    for (int i = 0; i < 300; ++i)
+        values.push_back(KvField{"", "v" + std::to_string(i), 0});
+    layout.append(makeCollection("l", KvType::kList, values), out);
+    auto &data = out[kPikaListDataCf];
+    ASSERT_EQ(data.size(), 300u);
+
+    // 小端编码的 index 按字节序不递增，必须使用 ListsDataKeyComparator 排序
+    const rocksdb::Comparator *comparator = pikaCfComparator(kPikaListDataCf);
+    EXPECT_STREQ(comparator->Name(), "floyd.ListsDataKeyComparator");
+    EXPECT_TRUE(std::is_sorted(data.begin(), data.end(), [comparator](const KvPair &a, const KvPair &b)
+                               { return comparator->Compare(a.first, b.first) < 0; }));
+    EXPECT_FALSE(std::is_sorted(data.begin(), data.end()));
+
+    // | type | count (8B) | version | left | right | reserve | ctime | etime |
+    const std::string &meta = out[kPikaMetaCf].front().second;
+    ASSERT_EQ(meta.size(), 1u + 8 * 4 + 16 + 8 + 8);
+    EXPECT_EQ(meta.substr(1, 8), fixed64(300));
+    EXPECT_EQ(meta.substr(25, 8), fixed64(PikaLayout::kInitialRightIndex + 300));
+}
+
+TEST(PikaLayoutTest, EmptyCollectionIsSkipped)
+{
+    PikaLayout layout;
+    CfData out;
+    layout.append(makeCollection("s", KvType::kSet, {}), out);
+    for (const auto &pairs : out)
+        EXPECT_TRUE(pairs.empty());
+}
+
+TEST(PikaLayoutTest, TypedRecordJsonRoundTrip)
+{
+    DataType data = {
+        KvEntry{"s", "v", 9},
+        makeCollection("h", KvType::kHash, {{"f", "v", 0}}),
+        makeCollection("set", KvType::kSet, {{"m", "", 0}}),
+        makeCollection("z", KvType::kZSet, {{"m", "", 1.5}}, 3),
+        makeCollection("l", KvType::kList, {{"", "b", 0}, {"", "a", 0}}),
+    };
+    json j = data;
+    EXPECT_FALSE(j[0].contains("type"));
+    EXPECT_EQ(j[1]["type"], "hash");
+    DataType parsed = j.get<DataType>();
+    ASSERT_EQ(parsed.size(), data.size());
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        EXPECT_EQ(parsed[i].key, data[i].key);
+        EXPECT_EQ(parsed[i].type, data[i].type);
+        EXPECT_EQ(parsed[i].value, data[i].value);
+        EXPECT_EQ(parsed[i].timestamp, data[i].timestamp);
+        EXPECT_EQ(parsed[i].fields, data[i].fields);
+    }
+
+    json bad = {{"key", "k"}, {"type", "stream"}};
+    EXPECT_THROW(bad.get<KvEntry>(), std::runtime_error);
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "exchange/replicaBench.h"
+#include "utils/kconfig.h"
+
+class ReplicaBenchTest : public ::testing::Test
+{
+protected:
+    const std::filesystem::path workDir = DEFAULTDIC / "test_replica_bench";
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(workDir);
+    }
+
+    // 两个文件有重叠的 key，后一个文件的值胜出
+    std::vector<DataType> dataset()
+    {
+        DatasetCollector collector;
+        DataType first;
+        DataType second;
+        for (int i = 0; i < 200; ++i)
+            first.push_back({"key_" + std::to_string(i), "a" + std::to_string(i), 0});
+        first.push_back({"key_7", "older", 0});
+        for (int i = 150; i < 300; ++i)
+            second.push_back({"key_" + std::to_string(i), "b" + std::to_string(i), 0});
+        EXPECT_FALSE(collector.write(first).isError());
+        EXPECT_FALSE(collector.write(second).isError());
+        return collector.take();
+    }
+};
+
+TEST_F(ReplicaBenchTest, CollectorDedupsAndSkipsCollections)
+{
+    DatasetCollector collector;
+    KvEntry hash{"h", "", 0};
+    hash.type = KvType::kHash;
+    ASSERT_FALSE(collector.write({{"b", "x", 1}, {"a", "old", 1}, {"a", "new", 5}, hash}).isError());
+    size_t skipped = 0;
+    std::vector<DataType> files = collector.take(&skipped);
+    ASSERT_EQ(files.size(), 1u);
+    EXPECT_EQ(skipped, 1u);
+    ASSERT_EQ(files[0].size(), 2u);
+    EXPECT_EQ(files[0][0].value, "new");
+    EXPECT_TRUE(collector.take().empty());
+}
+
+// 两种同步方式都让从节点与主节点一致，且最终内容相同；ingest 的 binlog 只有清单
+TEST_F(ReplicaBenchTest, BothModesConvergeToSameState)
+{
+    std::vector<DataType> files = dataset();
+    ReplicaBench bench(workDir.string());
+    bench.setBatchSize(64);
+    SstSplitPolicy split;
+    split.targetFileEntries = 50;
+    bench.setSplitPolicy(split);
+
+    ReplicaBenchStats write;
+    Result res = bench.runWriteBatch(files, write);
+    ASSERT_FALSE(res.isError()) << res.message_raw();
+    ReplicaBenchStats ingest;
+    res = bench.runIngest(files, ingest);
+    ASSERT_FALSE(res.isError()) << res.message_raw();
+
+    EXPECT_EQ(write.entries, 350u);
+    EXPECT_EQ(ingest.entries, write.entries);
+    EXPECT_EQ(ingest.userBytes, write.userBytes);
+    EXPECT_EQ(write.primaryDigest, write.replicaDigest);
+    EXPECT_EQ(ingest.primaryDigest, ingest.replicaDigest);
+    EXPECT_EQ(ingest.primaryDigest, write.primaryDigest);
+
+    EXPECT_EQ(write.objectBytes, 0u);
+    EXPECT_GT(write.binlogBytes, write.userBytes);
+    EXPECT_GT(ingest.objectBytes, 0u);
+    EXPECT_LT(ingest.binlogBytes, write.binlogBytes);
+    EXPECT_TRUE(std::filesystem::exists(workDir / "ingest" / "s3" / "data_1.manifest.json"));
+    EXPECT_EQ(ingest.toJson()["bytesMoved"], ingest.binlogBytes + ingest.objectBytes);
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include "utils/shardFunction.h"
+#include "utils/kconfig.h"
+
+// 与 Codis 相同：crc32(key) % 1024，hash tag 内的部分决定 slot
+TEST(ShardFunctionTest, Crc32SlotsMatchCodis)
+{
+    SlotShardFunction function(1024, 1024);
+    EXPECT_EQ(function.slotOf("foo"), 289u);
+    EXPECT_EQ(function.slotOf("user:{foo}:name"), 289u);
+    EXPECT_EQ(function.shardOf("{foo}"), 289u);
+    // 没有闭合的 '}' 时使用整个 key；空 tag 与 Codis 一样按空串计算
+    EXPECT_EQ(function.slotOf("{foo"), 178u);
+    EXPECT_EQ(function.slotOf("a{}b"), 0u);
+}
+
+TEST(ShardFunctionTest, SlotsSpreadEvenlyOverShards)
+{
+    SlotShardFunction function(1024, 4);
+    EXPECT_EQ(function.numShards(), 4u);
+    EXPECT_EQ(function.shardOf("foo"), 1u); // slot 289 落在 [256, 512)
+    EXPECT_EQ(function.describe()["slots"], 1024);
+    EXPECT_FALSE(function.describe().contains("slotMap"));
+
+    std::shared_ptr<const ShardFunction> parsed;
+    ASSERT_FALSE(makeShardFunction("crc32:1024:4", parsed).isError());
+    EXPECT_EQ(parsed->numShards(), 4u);
+    EXPECT_EQ(parsed->shardOf("foo"), 1u);
+    ASSERT_FALSE(makeShardFunction("crc32:8", parsed).isError());
+    EXPECT_EQ(parsed->numShards(), 8u);
+    EXPECT_TRUE(makeShardFunction("crc32:4:8", parsed).isError());
+    EXPECT_TRUE(makeShardFunction("md5:8", parsed).isError());
+}
+
+TEST(ShardFunctionTest, LoadsCodisSlotMap)
+{
+    std::filesystem::create_directories(DEFAULTDIC);
+    std::string path = (DEFAULTDIC / "slotmap.json").string();
+    {
+        std::ofstream out(path);
+        out << R"([{"id": 0, "group_id": 7}, {"id": 1, "group_id": 1}, {"id": 2, "group_id": 3}, {"id": 3, "group_id": 7}])";
+    }
+    std::shared_ptr<const ShardFunction> function;
+    Result res = makeShardFunction("slotmap:" + path, function);
+    ASSERT_FALSE(res.isError()) << res.message_raw();
+    // group_id 1 / 3 / 7 映射为分片 0 / 1 / 2
+    EXPECT_EQ(function->numShards(), 3u);
+    // crc32("foo") % 4 = 1
+    EXPECT_EQ(function->shardOf("foo"), 0u);
+    EXPECT_EQ(function->describe()["slotMap"], json::array({2, 0, 1, 2}));
+    EXPECT_EQ(function->describe()["groups"], json::array({1, 3, 7}));
+
+    {
+        std::ofstream out(path);
+        out << R"([{"id": 0, "group_id": 1}, {"id": 1, "group_id": 0}])";
+    }
+    EXPECT_TRUE(makeShardFunction("slotmap:" + path, function).isError()); // group_id 0 为未分配
+
+    {
+        std::ofstream out(path);
+        out << R"([{"id": 0, "group_id": 1}, {"id": 2, "group_id": 1}])";
+    }
+    EXPECT_TRUE(makeShardFunction("slotmap:" + path, function).isError()); // slot 1 未分配
+    std::filesystem::remove(path);
+}
+
+// slot 号与分片号有上限，错误的参数或 slot 表不会申请巨大的表与分片数组
+TEST(ShardFunctionTest, RejectsOutOfRangeSlotsAndShards)
+{
+    std::shared_ptr<const ShardFunction> function;
+    EXPECT_TRUE(makeShardFunction("crc32:4294967295", function).isError());
+    EXPECT_FALSE(makeShardFunction("crc32:" + std::to_string(SlotShardFunction::kMaxSlots), function).isError());
+
+    std::filesystem::create_directories(DEFAULTDIC);
+    std::string path = (DEFAULTDIC / "slotmap_range.json").string();
+    {
+        std::ofstream out(path);
+        out << R"([{"id": 4000000000, "group_id": 1}])";
+    }
+    EXPECT_TRUE(makeShardFunction("slotmap:" + path, function).isError());
+    {
+        std::ofstream out(path);
+        out << "[0, 1, 4000000000]";
+    }
+    EXPECT_TRUE(makeShardFunction("slotmap:" + path, function).isError());
+    {
+        std::ofstream out(path);
+        out << "[0, 2, 1]";
+    }
+    ASSERT_FALSE(makeShardFunction("slotmap:" + path, function).isError());
+    EXPECT_EQ(function->numShards(), 3u);
+    std::filesystem::remove(path);
+}
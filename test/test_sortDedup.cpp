@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include "utils/sortDedup.h"
+#include "utils/compare.h"
+
+namespace
+{
+    // 每个 key 平均出现 copies 次，timestamp 与 value 随机
+    DataType randomEntries(size_t numKeys, size_t copies, uint32_t seed)
+    {
+        std::mt19937 gen(seed);
+        std::uniform_int_distribution<size_t> keyDist(0, numKeys - 1);
+        std::uniform_int_distribution<uint32_t> tsDist(0, 5);
+        DataType data;
+        for (size_t i = 0; i < numKeys * copies; ++i)
+        {
+            size_t k = keyDist(gen);
+            data.push_back({"key_" + std::to_string(k), "v" + std::to_string(gen() % 3), tsDist(gen)});
+        }
+        return data;
+    }
+
+    DataType reference(DataType data)
+    {
+        std::sort(data.begin(), data.end(), ComparePair());
+        dedupSorted(data);
+        return data;
+    }
+
+    // 与 SstProcessor::processSstGroup 相同：hash 策略先去重再排序，不再做 dedupSorted
+    DataType apply(DataType data, DedupStrategy strategy)
+    {
+        if (strategy == DedupStrategy::kHash)
+            hashDedup(data);
+        if (strategy == DedupStrategy::kMergeRuns)
+            mergeRuns(data);
+        else
+            std::sort(data.begin(), data.end(), ComparePair());
+        if (strategy != DedupStrategy::kHash)
+            dedupSorted(data);
+        return data;
+    }
+}
+
+// 三种策略在无序、已排序、多段输入上的结果都与整体排序后去重相同
+TEST(SortDedupTest, StrategiesMatchSortThenDedup)
+{
+    DataType unsorted = randomEntries(500, 4, 1);
+    DataType sorted = unsorted;
+    std::sort(sorted.begin(), sorted.end(), ComparePair());
+    DataType runs;
+    for (uint32_t r = 0; r < 5; ++r)
+    {
+        DataType part = randomEntries(200, 2, 10 + r);
+        std::sort(part.begin(), part.end(), ComparePair());
+        runs.insert(runs.end(), part.begin(), part.end());
+    }
+
+    for (const DataType *input : {&unsorted, &sorted, &runs})
+    {
+        DataType expected = reference(*input);
+        for (DedupStrategy strategy : {DedupStrategy::kSort, DedupStrategy::kMergeRuns, DedupStrategy::kHash})
+        {
+            DataType actual = apply(*input, strategy);
+            ASSERT_EQ(actual.size(), expected.size()) << dedupStrategyName(strategy);
+            for (size_t i = 0; i < expected.size(); ++i)
+            {
+                EXPECT_EQ(actual[i].key, expected[i].key);
+                EXPECT_EQ(actual[i].value, expected[i].value);
+                EXPECT_EQ(actual[i].timestamp, expected[i].timestamp);
+            }
+        }
+    }
+}
+
+TEST(SortDedupTest, HashDedupKeepsNewestAndHandsBackLosers)
+{
+    DataType data = {{"a", "old", 1}, {"b", "only", 0}, {"a", "new", 9}, {"a", "mid", 5}};
+    DataType removed;
+    EXPECT_EQ(hashDedup(data, &removed), 2u);
+    ASSERT_EQ(data.size(), 2u);
+    // 留下的条目保持原有相对顺序
+    EXPECT_EQ(data[0].key, "b");
+    EXPECT_EQ(data[1].value, "new");
+    ASSERT_EQ(removed.size(), 2u);
+}
+
+TEST(SortDedupTest, ChoosesStrategyFromInputShape)
+{
+    DataType unique = randomEntries(1 << 16, 1, 2);
+    std::sort(unique.begin(), unique.end(), ComparePair());
+    unique.erase(std::unique(unique.begin(), unique.end(), [](const KvEntry &a, const KvEntry &b)
+                             { return a.key == b.key; }),
+                 unique.end());
+    EXPECT_EQ(countSortedRuns(unique, 10), 1u);
+    EXPECT_EQ(chooseDedupStrategy(unique), DedupStrategy::kMergeRuns);
+
+    std::mt19937 gen(3);
+    std::shuffle(unique.begin(), unique.end(), gen);
+    EXPECT_EQ(countSortedRuns(unique, 10), 11u);
+    EXPECT_LT(sampleDuplicateRatio(unique), 0.01);
+    EXPECT_EQ(chooseDedupStrategy(unique), DedupStrategy::kSort);
+
+    DataType duplicated = randomEntries(1 << 12, 8, 4);
+    EXPECT_GT(sampleDuplicateRatio(duplicated), 0.5);
+    EXPECT_EQ(chooseDedupStrategy(duplicated), DedupStrategy::kHash);
+
+    DedupStrategy strategy = DedupStrategy::kSort;
+    EXPECT_TRUE(parseDedupStrategy("runs", strategy));
+    EXPECT_EQ(strategy, DedupStrategy::kMergeRuns);
+    EXPECT_FALSE(parseDedupStrategy("radix", strategy));
+}
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include "rocksdb/sst_file_writer.h"
+#include "exchange/sstChecker.h"
+#include "exchange/JsonFileManager.h"
+#include "utils/compare.h"
+#include "utils/kconfig.h"
+
+class SstCheckerTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path dir = DEFAULTDIC / "test_sst_checker";
+
+    void SetUp() override
+    {
+        std::filesystem::create_directories(dir);
+    }
+    void TearDown() override
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    // 按 SstProcessor 的方式写 SST：排序、去重、value 附加 timestamp
+    std::string writeSst(const std::string &name, DataType data)
+    {
+        std::sort(data.begin(), data.end(), ComparePair());
+        dedupSorted(data);
+        std::string path = (dir / name).string();
+        rocksdb::SstFileWriter writer{rocksdb::EnvOptions(), rocksdb::Options()};
+        EXPECT_TRUE(writer.Open(path).ok());
+        for (const auto &entry : data)
+            EXPECT_TRUE(writer.Put(entry.key, entry.encodedValue()).ok());
+        EXPECT_TRUE(writer.Finish().ok());
+        return path;
+    }
+
+    std::string writeJson(const std::string &name, const DataType &data)
+    {
+        std::string path = (dir / name).string();
+        std::ofstream out(path);
+        out << json(data).dump(4);
+        return path;
+    }
+
+    DataType sample() const
+    {
+        return {{"key_3", "v3", 300}, {"key_1", "v1", 0}, {"key_2", "old", 100}, {"key_2", "new", 200}};
+    }
+};
+
+TEST_F(SstCheckerTest, CheckFileSummarizes)
+{
+    std::string path = writeSst("data_0.sst", sample());
+    SstChecker checker;
+    SstFileSummary summary;
+    Result res = checker.checkFile(path, summary);
+    ASSERT_FALSE(res.isError()) << res.message();
+    EXPECT_TRUE(summary.ok);
+    EXPECT_EQ(summary.entries, 3u);
+    EXPECT_EQ(summary.smallestKey, "key_1");
+    EXPECT_EQ(summary.largestKey, "key_3");
+    EXPECT_EQ(summary.persistentEntries, 1u);
+    EXPECT_EQ(summary.minExpire, 200u);
+    EXPECT_EQ(summary.maxExpire, 300u);
+    EXPECT_EQ(summary.fileSize, std::filesystem::file_size(path));
+}
+
+TEST_F(SstCheckerTest, DetectsCorruption)
+{
+    std::string path = writeSst("data_0.sst", sample());
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(static_cast<std::streamoff>(std::filesystem::file_size(path) / 2));
+        f.put('\x7f');
+    }
+    SstChecker checker;
+    SstFileSummary summary;
+    EXPECT_TRUE(checker.checkFile(path, summary).isError());
+    EXPECT_FALSE(summary.ok);
+    EXPECT_FALSE(summary.error.empty());
+}
+
+TEST_F(SstCheckerTest, CrossCheckJson)
+{
+    std::string sst = writeSst("data_0.sst", sample());
+    std::string same = writeJson("data_0.json", sample());
+    DataType changed = sample();
+    changed[0].value = "other";
+    std::string other = writeJson("data_1.json", changed);
+
+    SstChecker checker;
+    JsonFileManager fileManager;
+    EXPECT_FALSE(checker.crossCheckJson(sst, &fileManager, same).isError());
+    EXPECT_TRUE(checker.crossCheckJson(sst, &fileManager, other).isError());
+}
+
+// 合并转换的多个输入与切分出的多段整体比对：各段首尾相接即整组排序去重后的数据
+TEST_F(SstCheckerTest, CrossCheckJsonAcrossPartsAndInputs)
+{
+    DataType first = {{"key_1", "v1", 0}, {"key_2", "v2", 0}};
+    DataType second = {{"key_3", "v3", 0}, {"key_4", "v4", 0}, {"key_1", "v1", 0}};
+    std::vector<std::string> inputs = {writeJson("data_3.json", first), writeJson("data_4.json", second)};
+    std::vector<std::string> parts = {writeSst("data_3.0000.sst", {{"key_1", "v1", 0}, {"key_2", "v2", 0}}),
+                                      writeSst("data_3.0001.sst", {{"key_3", "v3", 0}, {"key_4", "v4", 0}})};
+
+    SstChecker checker;
+    JsonFileManager fileManager;
+    Result res = checker.crossCheckJson(parts, &fileManager, inputs);
+    EXPECT_FALSE(res.isError()) << res.message_raw();
+    // 单独一段或只有一个输入都对不上
+    EXPECT_TRUE(checker.crossCheckJson({parts[0]}, &fileManager, inputs).isError());
+    EXPECT_TRUE(checker.crossCheckJson(parts, &fileManager, {inputs[0]}).isError());
+}
+
+TEST_F(SstCheckerTest, ManifestRoundTrip)
+{
+    std::vector<std::string> paths;
+    for (int i = 0; i < 8; ++i)
+    {
+        DataType data;
+        for (int k = 0; k < 100 + i; ++k)
+            data.push_back({"key_" + std::to_string(i) + "_" + std::to_string(k), "v", static_cast<uint32_t>(k)});
+        paths.push_back(writeSst("data_" + std::to_string(i) + ".sst", data));
+    }
+
+    SstChecker checker;
+    checker.setNumThreads(4);
+    std::vector<SstFileSummary> summaries;
+    ASSERT_FALSE(checker.checkFiles(paths, summaries).isError());
+    ASSERT_EQ(summaries.size(), paths.size());
+    for (size_t i = 0; i < summaries.size(); ++i)
+    {
+        EXPECT_EQ(summaries[i].path, paths[i]);
+        EXPECT_EQ(summaries[i].entries, 100u + i);
+    }
+
+    json manifest = SstChecker::manifest(summaries);
+    ASSERT_EQ(manifest["files"].size(), paths.size());
+    EXPECT_FALSE(SstChecker::crossCheckManifest(summaries[3], manifest["files"][3]).isError());
+
+    json tampered = manifest["files"][3];
+    tampered["entries"] = 1;
+    EXPECT_TRUE(SstChecker::crossCheckManifest(summaries[3], tampered).isError());
+}
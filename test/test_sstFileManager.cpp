@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include "rocksdb/sst_file_reader.h"
+#include "mock/sstFileManager.h"
+#include "mock/dataGen.h"
+#include "utils/compare.h"
+
+class SstFileManagerTest : public ::testing::Test
+{
+protected:
+    const std::string outputDir = "test_sst_output";
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(DEFAULTDIC / outputDir);
+    }
+
+    // 读回 SST 中的全部 key/value
+    std::vector<std::pair<std::string, std::string>> readSst(const std::string &path)
+    {
+        std::vector<std::pair<std::string, std::string>> kvs;
+        rocksdb::SstFileReader reader{rocksdb::Options()};
+        EXPECT_TRUE(reader.Open(path).ok());
+        std::unique_ptr<rocksdb::Iterator> it(reader.NewIterator(rocksdb::ReadOptions()));
+        for (it->SeekToFirst(); it->Valid(); it->Next())
+        {
+            kvs.emplace_back(it->key().ToString(), it->value().ToString());
+        }
+        return kvs;
+    }
+};
+
+TEST_F(SstFileManagerTest, WriteSortsAndKeepsNewestDuplicate)
+{
+    SstFileManager manager(outputDir);
+    DataType data = {
+        {"key_2", "old", 100},
+        {"key_1", "value_1", 0},
+        {"key_2", "new", 200},
+    };
+
+    Result res = manager.write(data);
+    ASSERT_EQ(res.getRet(), Result::Ret::kOk);
+    EXPECT_EQ(std::filesystem::path(res.message_raw()).filename(), "data_0.sst");
+
+    auto kvs = readSst(res.message_raw());
+    ASSERT_EQ(kvs.size(), 2u);
+    EXPECT_EQ(kvs[0].first, "key_1");
+    EXPECT_EQ(kvs[0].second, data[1].encodedValue());
+    EXPECT_EQ(kvs[1].first, "key_2");
+    EXPECT_EQ(kvs[1].second, data[2].encodedValue());
+}
+
+TEST_F(SstFileManagerTest, WriteRejectsEmptyData)
+{
+    SstFileManager manager(outputDir);
+    EXPECT_TRUE(manager.write(DataType()).isError());
+}
+
+TEST_F(SstFileManagerTest, DataGenWritesSstDirectly)
+{
+    const std::string configPath = "test_sst_config.json";
+    std::ofstream config(configPath);
+    config << R"({
+        "targetSizeMB": 40,
+        "maxSizeGB": 2,
+        "keyPrefix": "key_",
+        "valuePrefix": "val_",
+        "maxFileSizeMB": 20,
+        "approxEntrySizeKB": 50
+    })";
+    config.close();
+
+    DataGen gen(configPath, outputDir);
+    gen.setFileManager(std::make_shared<SstFileManager>(outputDir));
+    EXPECT_EQ(gen.generateData().getRet(), Result::Ret::kOk);
+
+    size_t files = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(DEFAULTDIC / outputDir))
+    {
+        ASSERT_EQ(entry.path().extension(), ".sst");
+        auto kvs = readSst(entry.path().string());
+        EXPECT_FALSE(kvs.empty());
+        for (size_t i = 1; i < kvs.size(); ++i)
+        {
+            EXPECT_LT(kvs[i - 1].first, kvs[i].first);
+        }
+        ++files;
+    }
+    EXPECT_EQ(files, 2u);
+    std::filesystem::remove(configPath);
+}
@@ -3,6 +3,8 @@
 #include "exchange/sstProcessor.h"
 #include "utils/result.h"
 #include "exchange/JsonFileManager.h"
+#include "rocksdb/sst_file_reader.h"
+#include <cstring>
 #include <sstream>
 #include <nlohmann/json.hpp>
 #include <fstream>
@@ -133,3 +135,330 @@ TEST_F(SstProcessorTest, TestProcessSstFileErrorParsingJson)
     std::filesystem::remove(tempJsonFile_);
     std::filesystem::remove(outputSstPath);
 }
+
+// 测试: 目录模式下每个 json 文件都被并发转换为同名 sst
+TEST_F(SstProcessorTest, TestMutiProcessSstFile)
+{
+    const std::string inputDic = "muti_input";
+    const std::string outputDic = "muti_output";
+    std::filesystem::create_directories(DEFAULTDIC / inputDic);
+    for (int i = 0; i < 3; ++i)
+    {
+        std::ofstream out(DEFAULTDIC / inputDic / ("data_" + std::to_string(i) + ".json"));
+        out << kTestJson;
+    }
+
+    MockJsonFileManager mockFileManager;
+    EXPECT_CALL(mockFileManager, parse(testing::_))
+        .Times(3)
+        .WillRepeatedly([](const std::string &)
+                        { return MockParseJson(kTestJson); });
+
+    sstProcessor_->setNumThreads(2);
+    Result result = sstProcessor_->mutiProcessSstFile(&mockFileManager, inputDic, outputDic);
+
+    EXPECT_EQ(result.getRet(), Result::Ret::kOk);
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_TRUE(std::filesystem::exists(DEFAULTDIC / outputDic / ("data_" + std::to_string(i) + ".sst")));
+    }
+
+    std::filesystem::remove_all(DEFAULTDIC / inputDic);
+    std::filesystem::remove_all(DEFAULTDIC / outputDic);
+}
+
+// 测试: 按条数切分输出，分片名确定，重跑后多余的旧分片被删除
+TEST_F(SstProcessorTest, TestSplitByEntries)
+{
+    const std::string outputDic = "split_output";
+    MockJsonFileManager mockFileManager;
+    EXPECT_CALL(mockFileManager, parse(testing::_))
+        .Times(2)
+        .WillRepeatedly([](const std::string &)
+                        { return MockParseJson(kTestJson); });
+
+    sstProcessor_->setTargetFileEntries(1);
+    sstProcessor_->setValidateSamples(10); // 样本分布在多个分片中
+    std::vector<std::string> outputs;
+    Result result = sstProcessor_->processSstGroup(&mockFileManager, {"split.json"}, outputDic + "/data_0.sst", &outputs);
+    ASSERT_EQ(result.getRet(), Result::Ret::kOk) << result.message_raw();
+    ASSERT_EQ(outputs.size(), 4u);
+    EXPECT_EQ(outputs[0], outputDic + "/data_0.0000.sst");
+    EXPECT_EQ(outputs[3], outputDic + "/data_0.0003.sst");
+    EXPECT_FALSE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_0.sst"));
+
+    sstProcessor_->setTargetFileEntries(2);
+    result = sstProcessor_->processSstGroup(&mockFileManager, {"split.json"}, outputDic + "/data_0.sst", &outputs);
+    ASSERT_EQ(result.getRet(), Result::Ret::kOk) << result.message_raw();
+    EXPECT_EQ(outputs.size(), 2u);
+    EXPECT_TRUE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_0.0001.sst"));
+    EXPECT_FALSE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_0.0002.sst"));
+    EXPECT_FALSE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_0.0003.sst"));
+
+    std::filesystem::remove_all(DEFAULTDIC / outputDic);
+}
+
+// 测试: 切分模式下相邻的小输入被合并到同一组输出，以组内第一个文件命名
+TEST_F(SstProcessorTest, TestCoalesceSmallInputs)
+{
+    const std::string inputDic = "coalesce_input";
+    const std::string outputDic = "coalesce_output";
+    std::filesystem::create_directories(DEFAULTDIC / inputDic);
+    for (int i : {2, 10, 1})
+    {
+        std::ofstream out(DEFAULTDIC / inputDic / ("data_" + std::to_string(i) + ".json"));
+        out << kTestJson;
+    }
+
+    MockJsonFileManager mockFileManager;
+    EXPECT_CALL(mockFileManager, parse(testing::_))
+        .Times(3)
+        .WillRepeatedly([](const std::string &)
+                        { return MockParseJson(kTestJson); });
+
+    sstProcessor_->setTargetFileSize(1 << 20);
+    Result result = sstProcessor_->mutiProcessSstFile(&mockFileManager, inputDic, outputDic);
+
+    EXPECT_EQ(result.getRet(), Result::Ret::kOk) << result.message_raw();
+    EXPECT_TRUE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_1.0000.sst"));
+    EXPECT_FALSE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_2.0000.sst"));
+    EXPECT_FALSE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_10.0000.sst"));
+
+    std::filesystem::remove_all(DEFAULTDIC / inputDic);
+    std::filesystem::remove_all(DEFAULTDIC / outputDic);
+}
+
+// 测试: 分组变化后，合并进其他组的输入以自己命名的旧输出被删除
+TEST_F(SstProcessorTest, TestRegroupRemovesOldOutputs)
+{
+    const std::string inputDic = "regroup_input";
+    const std::string outputDic = "regroup_output";
+    std::filesystem::create_directories(DEFAULTDIC / inputDic);
+    for (int i : {1, 2, 10})
+    {
+        std::ofstream out(DEFAULTDIC / inputDic / ("data_" + std::to_string(i) + ".json"));
+        out << kTestJson;
+    }
+
+    MockJsonFileManager mockFileManager;
+    EXPECT_CALL(mockFileManager, parse(testing::_))
+        .Times(6)
+        .WillRepeatedly([](const std::string &)
+                        { return MockParseJson(kTestJson); });
+
+    // 目标大小小于单个输入：每个输入单独一组
+    sstProcessor_->setTargetFileSize(1);
+    Result result = sstProcessor_->mutiProcessSstFile(&mockFileManager, inputDic, outputDic);
+    ASSERT_EQ(result.getRet(), Result::Ret::kOk) << result.message_raw();
+    EXPECT_TRUE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_10.0000.sst"));
+
+    sstProcessor_->setTargetFileSize(1 << 20);
+    result = sstProcessor_->mutiProcessSstFile(&mockFileManager, inputDic, outputDic);
+    ASSERT_EQ(result.getRet(), Result::Ret::kOk) << result.message_raw();
+    EXPECT_TRUE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_1.0000.sst"));
+    EXPECT_FALSE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_2.0000.sst"));
+    EXPECT_FALSE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_10.0000.sst"));
+
+    std::filesystem::remove_all(DEFAULTDIC / inputDic);
+    std::filesystem::remove_all(DEFAULTDIC / outputDic);
+}
+
+// 测试: Pika 布局下每个 CF 输出一个 SST，没有条目的 CF 不生成文件，重跑后不再有条目的 CF 文件被删除
+TEST_F(SstProcessorTest, TestPikaLayoutWritesCfSet)
+{
+    const std::string outputDic = "layout_output";
+    DataType typed = MockParseJson(kTestJson);
+    KvEntry hash;
+    hash.key = "hash_1";
+    hash.type = KvType::kHash;
+    hash.fields = {{"f1", "v1", 0}, {"f2", "v2", 0}};
+    typed.push_back(hash);
+    KvEntry zset;
+    zset.key = "zset_1";
+    zset.type = KvType::kZSet;
+    zset.fields = {{"m1", "", 3}, {"m2", "", -2}};
+    typed.push_back(zset);
+
+    MockJsonFileManager mockFileManager;
+    EXPECT_CALL(mockFileManager, parse(testing::_))
+        .WillOnce(Return(typed))
+        .WillOnce(Return(typed))
+        .WillOnce(Return(MockParseJson(kTestJson)));
+
+    // 未设置布局时集合记录报错，不产生输出
+    Result result = sstProcessor_->processSstGroup(&mockFileManager, {"typed.json"}, outputDic + "/data_0.sst");
+    EXPECT_EQ(result.getRet(), Result::Ret::kInvalidParam);
+
+    sstProcessor_->setPikaLayout(std::make_shared<PikaLayout>());
+    sstProcessor_->setValidateSamples(10);
+    std::vector<std::string> outputs;
+    result = sstProcessor_->processSstGroup(&mockFileManager, {"typed.json"}, outputDic + "/data_0.sst", &outputs);
+    ASSERT_EQ(result.getRet(), Result::Ret::kOk) << result.message_raw();
+    EXPECT_EQ(outputs, (std::vector<std::string>{outputDic + "/data_0.default.sst", outputDic + "/data_0.hash_data_cf.sst",
+                                                 outputDic + "/data_0.zset_data_cf.sst", outputDic + "/data_0.zset_score_cf.sst"}));
+    EXPECT_FALSE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_0.set_data_cf.sst"));
+    EXPECT_FALSE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_0.sst"));
+
+    // 一次解析得到的整组输出记录在清单中：meta 为 4 个 string + 2 个集合的 meta
+    std::ifstream manifestFile(DEFAULTDIC / outputDic / "data_0.manifest.json");
+    ASSERT_TRUE(manifestFile.is_open());
+    nlohmann::json manifest;
+    manifestFile >> manifest;
+    EXPECT_EQ(manifest["output"], "data_0");
+    ASSERT_EQ(manifest["columnFamilies"].size(), 4u);
+    EXPECT_EQ(manifest["columnFamilies"][0]["name"], "default");
+    EXPECT_EQ(manifest["columnFamilies"][0]["entries"], 6);
+    EXPECT_EQ(manifest["columnFamilies"][3]["comparator"], "floyd.ZSetsScoreKeyComparator");
+    EXPECT_EQ(manifest["columnFamilies"][3]["files"][0]["file"], "data_0.zset_score_cf.sst");
+
+    result = sstProcessor_->processSstGroup(&mockFileManager, {"typed.json"}, outputDic + "/data_0.sst", &outputs);
+    ASSERT_EQ(result.getRet(), Result::Ret::kOk) << result.message_raw();
+    EXPECT_EQ(outputs.size(), 1u);
+    EXPECT_TRUE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_0.default.sst"));
+    EXPECT_FALSE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_0.hash_data_cf.sst"));
+    EXPECT_FALSE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_0.zset_score_cf.sst"));
+
+    std::filesystem::remove_all(DEFAULTDIC / outputDic);
+}
+
+// 分片输出：每个 key 只出现在所属分片的 SST 中，每个分片附带清单，索引列出非空分片；分片变空时删除旧输出
+TEST_F(SstProcessorTest, TestShardedOutput)
+{
+    const std::string outputDic = "shard_output";
+    DataType data;
+    for (int i = 0; i < 40; ++i)
+        data.push_back({"key_" + std::to_string(i), "value_" + std::to_string(i), 0});
+
+    MockJsonFileManager mockFileManager;
+    EXPECT_CALL(mockFileManager, parse(testing::_))
+        .WillOnce(Return(data))
+        .WillOnce(Return(DataType{{"foo", "v", 0}}));
+
+    auto function = std::make_shared<SlotShardFunction>(16, 4);
+    sstProcessor_->setShardFunction(function);
+    sstProcessor_->setValidateSamples(5);
+    std::vector<std::string> outputs;
+    Result result = sstProcessor_->processSstGroup(&mockFileManager, {"data_0.json"}, outputDic + "/data_0.sst", &outputs);
+    ASSERT_EQ(result.getRet(), Result::Ret::kOk) << result.message_raw();
+    EXPECT_FALSE(std::filesystem::exists(DEFAULTDIC / outputDic / "data_0.sst"));
+
+    std::ifstream indexFile(DEFAULTDIC / outputDic / "data_0.shards.json");
+    ASSERT_TRUE(indexFile.is_open());
+    nlohmann::json index;
+    indexFile >> index;
+    EXPECT_EQ(index["shardFunction"]["shards"], 4);
+    ASSERT_EQ(index["shards"].size(), outputs.size());
+    size_t total = 0;
+    for (const auto &shard : index["shards"])
+    {
+        size_t id = shard["shard"].get<size_t>();
+        std::string sstPath = SstProcessor::shardPath((DEFAULTDIC / outputDic / "data_0.sst").string(), id);
+        EXPECT_TRUE(std::filesystem::exists(sstPath));
+
+        std::ifstream manifestFile(DEFAULTDIC / outputDic / shard["manifest"].get<std::string>());
+        ASSERT_TRUE(manifestFile.is_open());
+        nlohmann::json manifest;
+        manifestFile >> manifest;
+        EXPECT_EQ(manifest["shard"], id);
+        EXPECT_EQ(manifest["columnFamilies"][0]["name"], "default");
+        EXPECT_EQ(manifest["columnFamilies"][0]["files"][0]["file"], "data_0.sst");
+        EXPECT_EQ(manifest["columnFamilies"][0]["entries"], shard["entries"]);
+        total += shard["entries"].get<size_t>();
+
+        // SST 中只有属于该分片的 key
+        rocksdb::SstFileReader reader(options_);
+        ASSERT_TRUE(reader.Open(sstPath).ok());
+        std::unique_ptr<rocksdb::Iterator> it(reader.NewIterator(rocksdb::ReadOptions()));
+        for (it->SeekToFirst(); it->Valid(); it->Next())
+            EXPECT_EQ(function->shardOf(it->key().ToString()), id);
+    }
+    EXPECT_EQ(total, 40u);
+
+    // 重新转换后只剩 foo 所在的分片，其余分片的旧 SST 与清单被删除
+    result = sstProcessor_->processSstGroup(&mockFileManager, {"data_0.json"}, outputDic + "/data_0.sst", &outputs);
+    ASSERT_EQ(result.getRet(), Result::Ret::kOk) << result.message_raw();
+    ASSERT_EQ(outputs.size(), 1u);
+    size_t fooShard = function->shardOf("foo");
+    for (size_t shard = 0; shard < 4; ++shard)
+    {
+        std::string sstPath = SstProcessor::shardPath((DEFAULTDIC / outputDic / "data_0.sst").string(), shard);
+        EXPECT_EQ(std::filesystem::exists(sstPath), shard == fooShard);
+        EXPECT_EQ(std::filesystem::exists(SstProcessor::manifestPath(sstPath)), shard == fooShard);
+    }
+
+    std::filesystem::remove_all(DEFAULTDIC / outputDic);
+}
+
+// 测试: 同一个集合 key 出现在两个输入中时，两个输出使用不同的版本号；按输出顺序 ingest 后生效的 meta 计数与可见元素一致
+TEST_F(SstProcessorTest, TestPikaCollectionVersionPerOutput)
+{
+    const std::string inputDic = "version_input";
+    const std::string outputDic = "version_output";
+    std::filesystem::create_directories(DEFAULTDIC / inputDic);
+    for (int i : {0, 1})
+    {
+        std::ofstream out(DEFAULTDIC / inputDic / ("data_" + std::to_string(i) + ".json"));
+        out << kTestJson;
+    }
+    auto hash = [](std::vector<KvField> fields)
+    {
+        KvEntry entry;
+        entry.key = "h";
+        entry.type = KvType::kHash;
+        entry.fields = std::move(fields);
+        return DataType{entry};
+    };
+
+    MockJsonFileManager mockFileManager;
+    EXPECT_CALL(mockFileManager, parse(testing::_))
+        .Times(2)
+        .WillRepeatedly([&](const std::string &path)
+                        { return path.find("data_0") != std::string::npos ? hash({{"f1", "a", 0}, {"f2", "b", 0}, {"f3", "c", 0}})
+                                                                           : hash({{"f1", "d", 0}}); });
+    sstProcessor_->setPikaLayout(std::make_shared<PikaLayout>(1000));
+    Result result = sstProcessor_->mutiProcessSstFile(&mockFileManager, inputDic, outputDic);
+    ASSERT_EQ(result.getRet(), Result::Ret::kOk) << result.message_raw();
+
+    auto readSst = [this, &outputDic](const std::string &name)
+    {
+        std::vector<std::pair<std::string, std::string>> kvs;
+        rocksdb::SstFileReader reader(options_);
+        EXPECT_TRUE(reader.Open((DEFAULTDIC / outputDic / name).string()).ok()) << name;
+        std::unique_ptr<rocksdb::Iterator> it(reader.NewIterator(rocksdb::ReadOptions()));
+        for (it->SeekToFirst(); it->Valid(); it->Next())
+            kvs.emplace_back(it->key().ToString(), it->value().ToString());
+        return kvs;
+    };
+    // | type | count (4B) | version (8B) | ...
+    auto metaVersion = [](const std::string &meta)
+    {
+        uint64_t version = 0;
+        std::memcpy(&version, meta.data() + 5, sizeof(version));
+        return version;
+    };
+
+    auto firstMeta = readSst("data_0.default.sst");
+    auto lastMeta = readSst("data_1.default.sst");
+    ASSERT_EQ(firstMeta.size(), 1u);
+    ASSERT_EQ(lastMeta.size(), 1u);
+    EXPECT_NE(metaVersion(firstMeta[0].second), metaVersion(lastMeta[0].second));
+
+    // data_1 后 ingest，它的 meta 生效；data CF 中两个文件的元素并存，只有版本号相同的可见
+    uint64_t version = metaVersion(lastMeta[0].second);
+    uint32_t count = static_cast<uint8_t>(lastMeta[0].second[1]);
+    size_t visible = 0;
+    for (const std::string name : {"data_0.hash_data_cf.sst", "data_1.hash_data_cf.sst"})
+    {
+        for (const auto &kv : readSst(name))
+        {
+            uint64_t dataVersion = 0;
+            std::memcpy(&dataVersion, kv.first.data() + PikaLayout::kPrefixReserveLength + 3, sizeof(dataVersion));
+            visible += dataVersion == version;
+        }
+    }
+    EXPECT_EQ(count, 1u);
+    EXPECT_EQ(visible, count);
+
+    std::filesystem::remove_all(DEFAULTDIC / inputDic);
+    std::filesystem::remove_all(DEFAULTDIC / outputDic);
+}
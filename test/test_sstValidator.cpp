@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include "rocksdb/sst_file_writer.h"
+#include "exchange/sstValidator.h"
+#include "exchange/sstProcessor.h"
+#include "exchange/JsonFileManager.h"
+#include "utils/kconfig.h"
+
+class SstValidatorTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path dir = DEFAULTDIC / "test_sst_validator";
+
+    void SetUp() override
+    {
+        std::filesystem::create_directories(dir);
+    }
+    void TearDown() override
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    // 按给定顺序原样写入（调用方保证 key 有序且唯一）
+    std::string writeSst(const std::string &name, const DataType &data)
+    {
+        std::string path = (dir / name).string();
+        rocksdb::SstFileWriter writer{rocksdb::EnvOptions(), rocksdb::Options()};
+        EXPECT_TRUE(writer.Open(path).ok());
+        for (const auto &entry : data)
+            EXPECT_TRUE(writer.Put(entry.key, entry.encodedValue()).ok());
+        EXPECT_TRUE(writer.Finish().ok());
+        return path;
+    }
+
+    // 含重复 key 的源数据；去重后为 key_1/v1/0、key_2/new/200、key_3/v3/300
+    DataType source() const
+    {
+        return {{"key_3", "v3", 300}, {"key_2", "old", 100}, {"key_1", "v1", 0}, {"key_2", "new", 200}};
+    }
+};
+
+TEST_F(SstValidatorTest, DigestIsOrderIndependent)
+{
+    KvDigest a;
+    KvDigest b;
+    a.add("k1", "v1");
+    a.add("k2", "v2");
+    b.add("k2", "v2");
+    b.add("k1", "v1");
+    EXPECT_EQ(a, b);
+
+    // key/value 的切分方式不同，摘要也不同
+    KvDigest c;
+    c.add("k1v", "1");
+    c.add("k2", "v2");
+    EXPECT_NE(a, c);
+}
+
+TEST_F(SstValidatorTest, DetectsStaleValue)
+{
+    std::string good = writeSst("good.sst", {{"key_1", "v1", 0}, {"key_2", "new", 200}, {"key_3", "v3", 300}});
+    std::string stale = writeSst("stale.sst", {{"key_1", "v1", 0}, {"key_2", "old", 100}, {"key_3", "v3", 300}});
+
+    SstValidator validator(rocksdb::Options(), 10, 42);
+    DataType samples;
+    KvDigest expected = validator.digestSource(source(), &samples);
+    EXPECT_EQ(expected.count, 3u);
+    EXPECT_EQ(samples.size(), 3u);
+
+    Result res = validator.verify(good, expected, samples);
+    EXPECT_FALSE(res.isError()) << res.message();
+    EXPECT_TRUE(validator.verify(stale, expected, samples).isError());
+    EXPECT_TRUE(validator.lookupSamples(stale, samples).isError());
+}
+
+TEST_F(SstValidatorTest, SamplesAreBounded)
+{
+    DataType data;
+    for (int i = 0; i < 1000; ++i)
+        data.push_back({"key_" + std::to_string(i), "v", static_cast<uint32_t>(i)});
+    SstValidator validator(rocksdb::Options(), 16, 7);
+    DataType samples;
+    KvDigest digest = validator.digestSource(data, &samples);
+    EXPECT_EQ(digest.count, 1000u);
+    EXPECT_EQ(samples.size(), 16u);
+}
+
+TEST_F(SstValidatorTest, ProcessorValidatesOutput)
+{
+    std::string jsonName = "test_sst_validator/data_0.json";
+    {
+        std::ofstream out(DEFAULTDIC / jsonName);
+        out << json(source()).dump(4);
+    }
+
+    rocksdb::Options options;
+    SstProcessor processor(options);
+    processor.setValidateSamples(8);
+    JsonFileManager fileManager;
+    Result res = processor.processSstFile(&fileManager, jsonName, "test_sst_validator/data_0.sst");
+    ASSERT_FALSE(res.isError()) << res.message();
+
+    SstValidator validator(options, 8);
+    res = validator.validate(&fileManager, (DEFAULTDIC / jsonName).string(), (dir / "data_0.sst").string());
+    EXPECT_FALSE(res.isError()) << res.message();
+}
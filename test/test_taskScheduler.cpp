@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <set>
+#include <thread>
+#include <pthread.h>
+#include "utils/taskScheduler.h"
+
+class TaskSchedulerTest : public ::testing::Test
+{
+protected:
+    TaskScheduler scheduler{4};
+};
+
+TEST_F(TaskSchedulerTest, RunsAllTasksAndWaits)
+{
+    std::atomic<int> counter{0};
+    TaskGroup group(scheduler);
+    for (int i = 0; i < 1000; ++i)
+    {
+        group.run([&counter]
+                  {
+                      counter.fetch_add(1);
+                      return Result(Result::Ret::kOk); });
+    }
+    EXPECT_EQ(group.wait().getRet(), Result::Ret::kOk);
+    EXPECT_EQ(counter.load(), 1000);
+}
+
+TEST_F(TaskSchedulerTest, WaitReturnsFirstError)
+{
+    TaskGroup group(scheduler);
+    group.run([]
+              { return Result(Result::Ret::kOk); });
+    group.run([]
+              { return Result(Result::Ret::kFileWriteError, "boom"); });
+    Result res = group.wait();
+    EXPECT_EQ(res.getRet(), Result::Ret::kFileWriteError);
+    EXPECT_EQ(res.message_raw(), "boom");
+}
+
+TEST_F(TaskSchedulerTest, WorkersAreNamed)
+{
+    // 用 future 等待而不是 wait()，避免任务被调用线程协助执行
+    std::promise<std::string> name;
+    TaskGroup group(scheduler);
+    group.run([&name]
+              {
+                  char buf[16] = {0};
+                  pthread_getname_np(pthread_self(), buf, sizeof(buf));
+                  name.set_value(buf);
+                  return Result(Result::Ret::kOk); });
+    std::string worker = name.get_future().get();
+    ASSERT_EQ(group.wait().getRet(), Result::Ret::kOk);
+    EXPECT_EQ(worker.rfind("bingest-w", 0), 0u) << worker;
+}
+
+TEST_F(TaskSchedulerTest, ExceptionBecomesError)
+{
+    TaskGroup group(scheduler);
+    group.run([]() -> Result
+              { throw std::runtime_error("bad task"); });
+    EXPECT_EQ(group.wait().getRet(), Result::Ret::kError);
+}
+
+TEST_F(TaskSchedulerTest, CancelSkipsPendingTasks)
+{
+    TaskScheduler single(1);
+    std::atomic<int> executed{0};
+    std::atomic<bool> release{false};
+    TaskGroup group(single);
+    // 第一个任务占住唯一的 worker，其余任务在队列里等待
+    group.run([&]
+              {
+                  while (!release.load())
+                      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                  executed.fetch_add(1);
+                  return Result(Result::Ret::kOk); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    for (int i = 0; i < 10; ++i)
+    {
+        group.run([&]
+                  {
+                      executed.fetch_add(1);
+                      return Result(Result::Ret::kOk); });
+    }
+    group.cancel();
+    release = true;
+    EXPECT_EQ(group.wait().getRet(), Result::Ret::kCancelled);
+    EXPECT_EQ(executed.load(), 1);
+}
+
+TEST_F(TaskSchedulerTest, NestedGroupsDoNotDeadlock)
+{
+    // 每个外层任务在 worker 内部再开子任务组并等待
+    std::atomic<int> leaves{0};
+    TaskGroup outer(scheduler);
+    for (int i = 0; i < 16; ++i)
+    {
+        outer.run([this, &leaves]
+                  {
+                      TaskGroup inner(scheduler);
+                      for (int j = 0; j < 16; ++j)
+                      {
+                          inner.run([&leaves]
+                                    {
+                                        leaves.fetch_add(1);
+                                        return Result(Result::Ret::kOk); });
+                      }
+                      return inner.wait(); });
+    }
+    EXPECT_EQ(outer.wait().getRet(), Result::Ret::kOk);
+    EXPECT_EQ(leaves.load(), 256);
+}
+
+TEST_F(TaskSchedulerTest, IdleWorkersStealUnevenWork)
+{
+    // 所有任务都由同一个 worker 派生，其他 worker 只能通过窃取参与
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    TaskGroup outer(scheduler);
+    outer.run([&]
+              {
+                  TaskGroup inner(scheduler);
+                  for (int i = 0; i < 64; ++i)
+                  {
+                      inner.run([&]
+                                {
+                                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                                    std::lock_guard<std::mutex> lock(mutex);
+                                    threads.insert(std::this_thread::get_id());
+                                    return Result(Result::Ret::kOk); });
+                  }
+                  return inner.wait(); });
+    EXPECT_EQ(outer.wait().getRet(), Result::Ret::kOk);
+    EXPECT_GT(threads.size(), 1u);
+}
+
+TEST_F(TaskSchedulerTest, PinnedNumaAwareSchedulerRuns)
+{
+    TaskScheduler pinned(2, true, true);
+    std::atomic<int> counter{0};
+    TaskGroup group(pinned);
+    for (int i = 0; i < 100; ++i)
+    {
+        group.run([&counter]
+                  {
+                      counter.fetch_add(1);
+                      return Result(Result::Ret::kOk); });
+    }
+    EXPECT_EQ(group.wait().getRet(), Result::Ret::kOk);
+    EXPECT_EQ(counter.load(), 100);
+    EXPECT_EQ(TaskScheduler::cpuNumaNodes().size(), std::max(1u, std::thread::hardware_concurrency()));
+}
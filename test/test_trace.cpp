@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "utils/trace.h"
+
+class TraceTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        Tracer::instance().clear();
+        Tracer::instance().setEnabled(true);
+    }
+    void TearDown() override
+    {
+        Tracer::instance().setEnabled(false);
+        Tracer::instance().clear();
+    }
+};
+
+TEST_F(TraceTest, DisabledRecordsNothing)
+{
+    Tracer::instance().setEnabled(false);
+    {
+        ScopedSpan span("disabled");
+    }
+    EXPECT_EQ(Tracer::instance().eventCount(), 0u);
+}
+
+TEST_F(TraceTest, DumpsChromeTraceFromAllThreads)
+{
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([]
+                             {
+            for (int i = 0; i < 10; ++i)
+            {
+                ScopedSpan outer("outer", "detail");
+                ScopedSpan inner("inner");
+            } });
+    }
+    for (auto &t : threads)
+        t.join();
+    EXPECT_EQ(Tracer::instance().eventCount(), 80u);
+
+    std::string path = (std::filesystem::temp_directory_path() / "bingest_trace_test.json").string();
+    ASSERT_FALSE(Tracer::instance().dumpChromeTrace(path).isError());
+
+    std::ifstream in(path);
+    nlohmann::json trace = nlohmann::json::parse(in);
+    std::set<int> tids;
+    size_t spans = 0;
+    for (const auto &e : trace["traceEvents"])
+    {
+        if (e["ph"] != "X")
+            continue;
+        ++spans;
+        tids.insert(e["tid"].get<int>());
+        EXPECT_TRUE(e.contains("ts"));
+        EXPECT_TRUE(e.contains("dur"));
+        if (e["name"] == "outer")
+            EXPECT_EQ(e["args"]["detail"], "detail");
+    }
+    EXPECT_EQ(spans, 80u);
+    EXPECT_EQ(tids.size(), 4u);
+    std::filesystem::remove(path);
+}
+
+TEST_F(TraceTest, NestedSpanEndsWithinParent)
+{
+    {
+        ScopedSpan outer("outer");
+        ScopedSpan inner("inner");
+    }
+    std::string path = (std::filesystem::temp_directory_path() / "bingest_trace_nested.json").string();
+    ASSERT_FALSE(Tracer::instance().dumpChromeTrace(path).isError());
+    std::ifstream in(path);
+    nlohmann::json trace = nlohmann::json::parse(in);
+    nlohmann::json outer, inner;
+    for (const auto &e : trace["traceEvents"])
+    {
+        if (e["name"] == "outer")
+            outer = e;
+        else if (e["name"] == "inner")
+            inner = e;
+    }
+    ASSERT_FALSE(outer.is_null());
+    ASSERT_FALSE(inner.is_null());
+    EXPECT_LE(outer["ts"].get<uint64_t>(), inner["ts"].get<uint64_t>());
+    EXPECT_GE(outer["ts"].get<uint64_t>() + outer["dur"].get<uint64_t>(),
+              inner["ts"].get<uint64_t>() + inner["dur"].get<uint64_t>());
+    std::filesystem::remove(path);
+}
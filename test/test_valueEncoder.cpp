@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "rocksdb/sst_file_reader.h"
+#include "utils/valueEncoder.h"
+#include "exchange/sstProcessor.h"
+#include "exchange/JsonFileManager.h"
+
+TEST(ValueEncoderTest, TtlSuffixMatchesEncodedValue)
+{
+    KvEntry entry{"key", "value", 0x01020304};
+    TtlSuffixValueEncoder encoder;
+    std::string encoded = encoder.encode(entry);
+    EXPECT_EQ(encoded, entry.encodedValue());
+    EXPECT_EQ(encoded, std::string("value\x04\x03\x02\x01", 9));
+
+    uint32_t expire = 0;
+    ASSERT_TRUE(encoder.decodeExpire(encoded.data(), encoded.size(), expire));
+    EXPECT_EQ(expire, 0x01020304u);
+    EXPECT_FALSE(encoder.decodeExpire("ab", 2, expire));
+}
+
+TEST(ValueEncoderTest, RawKeepsValueOnly)
+{
+    RawValueEncoder encoder;
+    EXPECT_EQ(encoder.encode(KvEntry{"key", "value", 100}), "value");
+}
+
+TEST(ValueEncoderTest, PikaStringLayout)
+{
+    PikaStringValueEncoder encoder(0x1122334455667788ULL);
+    KvEntry entry{"key", "v", 1000};
+    std::string encoded = encoder.encode(entry);
+    ASSERT_EQ(encoded.size(), 1 + 1 + PikaStringValueEncoder::kSuffixLength);
+    EXPECT_EQ(encoded[0], '\0');
+    EXPECT_EQ(encoded[1], 'v');
+    EXPECT_EQ(encoded.substr(2, 16), std::string(16, '\0'));
+    EXPECT_EQ(static_cast<uint8_t>(encoded[18]), 0x88); // ctime 小端
+    EXPECT_EQ(static_cast<uint8_t>(encoded[25]), 0x11);
+
+    uint32_t expire = 0;
+    ASSERT_TRUE(encoder.decodeExpire(encoded.data(), encoded.size(), expire));
+    EXPECT_EQ(expire, 1000u); // etime 以毫秒存储
+
+    // ctime 不同的实例写出的 value 仍视为同一条
+    PikaStringValueEncoder other(1);
+    EXPECT_TRUE(other.matches(entry, encoded.data(), encoded.size()));
+    EXPECT_FALSE(other.matches(KvEntry{"key", "v", 2000}, encoded.data(), encoded.size()));
+}
+
+TEST(ValueEncoderTest, MakeValueEncoderByName)
+{
+    std::shared_ptr<const ValueEncoder> encoder;
+    for (const char *name : {"raw", "ttl", "pika"})
+    {
+        ASSERT_FALSE(makeValueEncoder(name, encoder).isError());
+        EXPECT_STREQ(encoder->name(), name);
+    }
+    EXPECT_TRUE(makeValueEncoder("json", encoder).isError());
+}
+
+TEST(ValueEncoderTest, DropExpiredKeepsOrder)
+{
+    DataType data{{"a", "1", 0}, {"b", "2", 50}, {"c", "3", 200}, {"d", "4", 100}};
+    EXPECT_EQ(dropExpired(data, 100), 2u);
+    ASSERT_EQ(data.size(), 2u);
+    EXPECT_EQ(data[0].key, "a");
+    EXPECT_EQ(data[1].key, "c");
+}
+
+class ExpiredDropTest : public ::testing::Test
+{
+protected:
+    class FixedFileManager : public JsonFileManagerBase
+    {
+    public:
+        explicit FixedFileManager(DataType data) : data_(std::move(data)) {}
+        DataType parse(const std::string &) override { return data_; }
+
+    private:
+        DataType data_;
+    };
+
+    std::filesystem::path dir = DEFAULTDIC / "test_expired_drop";
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(dir);
+    }
+};
+
+TEST_F(ExpiredDropTest, ProcessorDropsExpiredKeysAfterDedup)
+{
+    uint32_t future = unixNowSeconds() + 3600;
+    // key_2 的最新一条已过期：整个 key 丢弃，不会回退到更旧的版本
+    FixedFileManager fileManager({{"key_1", "live", 0}, {"key_2", "old", 1}, {"key_2", "dead", 2}, {"key_3", "ttl", future}});
+    SstProcessor processor{rocksdb::Options()};
+    processor.setDropExpired(true);
+    processor.setValidateSamples(10);
+    Result res = processor.processSstFile(&fileManager, "unused.json", "test_expired_drop/data_0.sst");
+    ASSERT_FALSE(res.isError()) << res.message_raw();
+
+    rocksdb::SstFileReader reader{rocksdb::Options()};
+    ASSERT_TRUE(reader.Open((dir / "data_0.sst").string()).ok());
+    std::unique_ptr<rocksdb::Iterator> it(reader.NewIterator(rocksdb::ReadOptions()));
+    std::vector<std::string> keys;
+    for (it->SeekToFirst(); it->Valid(); it->Next())
+        keys.push_back(it->key().ToString());
+    EXPECT_EQ(keys, (std::vector<std::string>{"key_1", "key_3"}));
+}
+
+TEST_F(ExpiredDropTest, AllExpiredProducesNoOutput)
+{
+    FixedFileManager fileManager({{"key_1", "dead", 1}});
+    SstProcessor processor{rocksdb::Options()};
+    processor.setDropExpired(true);
+    Result res = processor.processSstFile(&fileManager, "unused.json", "test_expired_drop/data_0.sst");
+    EXPECT_FALSE(res.isError()) << res.message_raw();
+    EXPECT_FALSE(std::filesystem::exists(dir / "data_0.sst"));
+}
@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include "exchange/workJournal.h"
+#include "exchange/sstProcessor.h"
+#include "exchange/JsonFileManager.h"
+#include "utils/kconfig.h"
+#include "utils/shardFunction.h"
+
+// 统计 parse 调用次数，用于确认续跑时跳过了哪些文件
+class CountingJsonFileManager : public JsonFileManager
+{
+public:
+    DataType parse(const std::string &filePath) override
+    {
+        ++calls;
+        return JsonFileManager::parse(filePath);
+    }
+    std::atomic<int> calls{0};
+};
+
+class WorkJournalTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path dir = DEFAULTDIC / "test_work_journal";
+
+    void SetUp() override
+    {
+        std::filesystem::create_directories(dir / "kv");
+        std::filesystem::create_directories(dir / "sst");
+    }
+    void TearDown() override
+    {
+        std::filesystem::remove_all(dir);
+    }
+
+    void writeFile(const std::filesystem::path &path, const std::string &content)
+    {
+        std::ofstream out(path, std::ios::trunc);
+        out << content;
+    }
+
+    void writeKv(const std::string &name, const DataType &data)
+    {
+        writeFile(dir / "kv" / name, json(data).dump(4));
+    }
+};
+
+TEST_F(WorkJournalTest, RecordAndDetectChanges)
+{
+    std::string input = (dir / "kv" / "a.json").string();
+    std::string output = (dir / "sst" / "a.sst").string();
+    writeFile(input, "source");
+    writeFile(output, "output");
+
+    WorkJournal journal((dir / "journal.json").string());
+    EXPECT_FALSE(journal.upToDate("a", input, output));
+    ASSERT_FALSE(journal.record("a", input, output).isError());
+    EXPECT_TRUE(journal.upToDate("a", input, output));
+
+    // 重新加载后状态保持
+    WorkJournal reloaded((dir / "journal.json").string());
+    ASSERT_FALSE(reloaded.load().isError());
+    EXPECT_TRUE(reloaded.contains("a"));
+    EXPECT_TRUE(reloaded.upToDate("a", input, output));
+
+    // 内容相同只改 mtime 仍视为最新
+    std::filesystem::last_write_time(input, std::filesystem::last_write_time(input) + std::chrono::seconds(10));
+    EXPECT_TRUE(reloaded.upToDate("a", input, output));
+
+    // 源文件变化、输出缺失都需要重做
+    writeFile(input, "changed");
+    EXPECT_FALSE(reloaded.upToDate("a", input, output));
+    writeFile(input, "source");
+    std::filesystem::remove(output);
+    EXPECT_FALSE(reloaded.upToDate("a", input, output));
+}
+
+// 输出被同样大小的文件替换（mtime 随之变化）时按内容判定
+TEST_F(WorkJournalTest, ReplacedOutputOfSameSizeIsStale)
+{
+    std::string input = (dir / "kv" / "a.json").string();
+    std::string output = (dir / "sst" / "a.sst").string();
+    writeFile(input, "source");
+    writeFile(output, "output");
+
+    WorkJournal journal((dir / "journal.json").string());
+    ASSERT_FALSE(journal.record("a", input, output).isError());
+    auto recorded = std::filesystem::last_write_time(output);
+
+    // 只 touch 输出：内容相同，仍是最新
+    std::filesystem::last_write_time(output, recorded + std::chrono::seconds(10));
+    EXPECT_TRUE(journal.upToDate("a", input, output));
+
+    writeFile(output, "OUTPUT");
+    std::filesystem::last_write_time(output, recorded + std::chrono::seconds(20));
+    EXPECT_FALSE(journal.upToDate("a", input, output));
+}
+
+// record 只追加 .log；load 重放 .log 并跳过写了一半的行，save 写快照后清空 .log
+TEST_F(WorkJournalTest, RecordsAppendToLogUntilSave)
+{
+    std::string output = (dir / "sst" / "group.sst").string();
+    writeFile(output, "output");
+    std::vector<std::pair<std::string, std::string>> inputs;
+    for (const std::string name : {"a", "b"})
+    {
+        writeFile(dir / "kv" / name, "source " + name);
+        inputs.emplace_back(name, (dir / "kv" / name).string());
+    }
+    std::filesystem::path path = dir / "journal.json";
+    std::filesystem::path log = dir / "journal.json.log";
+    {
+        WorkJournal journal(path.string());
+        ASSERT_FALSE(journal.record(inputs, output, {output}).isError());
+        EXPECT_FALSE(std::filesystem::exists(path));
+        EXPECT_GT(std::filesystem::file_size(log), 0u);
+    }
+    {
+        std::ofstream out(log, std::ios::app);
+        out << R"({"input": "c", "size": 1)";
+    }
+
+    WorkJournal reloaded(path.string());
+    ASSERT_FALSE(reloaded.load().isError());
+    EXPECT_EQ(reloaded.size(), 2u);
+    EXPECT_TRUE(reloaded.upToDate("b", inputs[1].second, output));
+    ASSERT_FALSE(reloaded.save().isError());
+    EXPECT_TRUE(std::filesystem::exists(path));
+    EXPECT_FALSE(std::filesystem::exists(log));
+
+    WorkJournal snapshot(path.string());
+    ASSERT_FALSE(snapshot.load().isError());
+    EXPECT_EQ(snapshot.size(), 2u);
+}
+
+TEST_F(WorkJournalTest, CorruptJournalIsReported)
+{
+    writeFile(dir / "journal.json", "{not json");
+    WorkJournal journal((dir / "journal.json").string());
+    EXPECT_TRUE(journal.load().isError());
+    EXPECT_EQ(journal.size(), 0u);
+}
+
+TEST_F(WorkJournalTest, ProcessorSkipsConvertedFiles)
+{
+    writeKv("data_0.json", {{"key_1", "v1", 0}, {"key_2", "v2", 100}});
+    writeKv("data_1.json", {{"key_3", "v3", 0}});
+
+    WorkJournal journal((dir / "sst" / ".bingest_journal.json").string());
+    ASSERT_FALSE(journal.load().isError());
+    SstProcessor processor{rocksdb::Options()};
+    processor.setJournal(&journal);
+
+    CountingJsonFileManager first;
+    ASSERT_FALSE(processor.mutiProcessSstFile(&first, "test_work_journal/kv", "test_work_journal/sst").isError());
+    EXPECT_EQ(first.calls, 2);
+    EXPECT_EQ(journal.size(), 2u);
+
+    // 只修改一个文件，重跑时只转换它
+    writeKv("data_1.json", {{"key_3", "v3", 0}, {"key_4", "v4", 0}});
+    CountingJsonFileManager second;
+    ASSERT_FALSE(processor.mutiProcessSstFile(&second, "test_work_journal/kv", "test_work_journal/sst").isError());
+    EXPECT_EQ(second.calls, 1);
+}
+
+// 切分输出时日志记录每一段，任何一段缺失都重新转换
+TEST_F(WorkJournalTest, MissingSplitPartIsReconverted)
+{
+    writeKv("data_0.json", {{"key_1", "v1", 0}, {"key_2", "v2", 0}, {"key_3", "v3", 0}});
+
+    WorkJournal journal((dir / "sst" / ".bingest_journal.json").string());
+    SstProcessor processor{rocksdb::Options()};
+    processor.setJournal(&journal);
+    processor.setTargetFileEntries(1);
+
+    CountingJsonFileManager first;
+    ASSERT_FALSE(processor.mutiProcessSstFile(&first, "test_work_journal/kv", "test_work_journal/sst").isError());
+    ASSERT_TRUE(std::filesystem::exists(dir / "sst" / "data_0.0002.sst"));
+
+    CountingJsonFileManager second;
+    ASSERT_FALSE(processor.mutiProcessSstFile(&second, "test_work_journal/kv", "test_work_journal/sst").isError());
+    EXPECT_EQ(second.calls, 0);
+
+    std::filesystem::remove(dir / "sst" / "data_0.0002.sst");
+    CountingJsonFileManager third;
+    ASSERT_FALSE(processor.mutiProcessSstFile(&third, "test_work_journal/kv", "test_work_journal/sst").isError());
+    EXPECT_EQ(third.calls, 1);
+    EXPECT_TRUE(std::filesystem::exists(dir / "sst" / "data_0.0002.sst"));
+}
+
+// 条目全部过期时没有输出：记录为空输出，重跑时跳过；分片输出时同样如此
+TEST_F(WorkJournalTest, EmptyOutputIsRecorded)
+{
+    writeKv("data_0.json", {{"key_1", "v1", 100}, {"key_2", "v2", 100}});
+    std::shared_ptr<const ShardFunction> shards;
+    ASSERT_FALSE(makeShardFunction("crc32:16:2", shards).isError());
+
+    for (bool sharded : {false, true})
+    {
+        std::filesystem::remove_all(dir / "sst");
+        WorkJournal journal((dir / "sst" / ".bingest_journal.json").string());
+        SstProcessor processor{rocksdb::Options()};
+        processor.setJournal(&journal);
+        processor.setDropExpired(true);
+        if (sharded)
+            processor.setShardFunction(shards);
+
+        CountingJsonFileManager first;
+        ASSERT_FALSE(processor.mutiProcessSstFile(&first, "test_work_journal/kv", "test_work_journal/sst").isError());
+        EXPECT_EQ(first.calls, 1);
+        EXPECT_FALSE(std::filesystem::exists(dir / "sst" / "data_0.sst"));
+        EXPECT_FALSE(std::filesystem::exists(dir / "sst" / "data_0.shards.json"));
+        EXPECT_TRUE(journal.contains("test_work_journal/kv/data_0.json"));
+
+        CountingJsonFileManager second;
+        ASSERT_FALSE(processor.mutiProcessSstFile(&second, "test_work_journal/kv", "test_work_journal/sst").isError());
+        EXPECT_EQ(second.calls, 0) << "sharded=" << sharded;
+    }
+}
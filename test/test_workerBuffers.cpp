@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include "utils/workerBuffers.h"
+#include "utils/compare.h"
+#include "utils/metrics.h"
+#include "utils/valueEncoder.h"
+#include "exchange/JsonFileManager.h"
+
+TEST(WorkerBuffersTest, TakeEntryReusesCapacityAndResetsFields)
+{
+    WorkerBuffers &buffers = WorkerBuffers::local();
+    DataType data = buffers.takeVector();
+    KvEntry entry;
+    entry.key.assign(200, 'k');
+    entry.value.assign(500, 'v');
+    entry.timestamp = 42;
+    entry.type = KvType::kHash;
+    entry.fields.push_back(KvField{"f", "v"});
+    data.push_back(std::move(entry));
+    buffers.recycle(data);
+    EXPECT_TRUE(data.empty());
+
+    KvEntry reused = buffers.takeEntry();
+    EXPECT_TRUE(reused.key.empty());
+    EXPECT_TRUE(reused.value.empty());
+    EXPECT_GE(reused.key.capacity(), 200u);
+    EXPECT_GE(reused.value.capacity(), 500u);
+    EXPECT_EQ(reused.timestamp, 0u);
+    EXPECT_EQ(reused.type, KvType::kString);
+    EXPECT_TRUE(reused.fields.empty());
+}
+
+TEST(WorkerBuffersTest, RecycledVectorKeepsCapacity)
+{
+    WorkerBuffers &buffers = WorkerBuffers::local();
+    DataType data;
+    data.reserve(1000);
+    data.resize(10);
+    buffers.recycle(data);
+    EXPECT_EQ(data.capacity(), 0u);
+
+    DataType reused = buffers.takeVector();
+    EXPECT_TRUE(reused.empty());
+    EXPECT_GE(reused.capacity(), 1000u);
+    buffers.recycleVector(reused);
+}
+
+// 条目池按字节而不是条目数封顶：大条目只保留到 kMaxSpareBytes 为止
+TEST(WorkerBuffersTest, SparePoolIsCappedInBytes)
+{
+    std::thread([]
+                {
+        WorkerBuffers &buffers = WorkerBuffers::local();
+        DataType data;
+        const size_t valueBytes = 1 << 20;
+        for (size_t i = 0; i < 2 * WorkerBuffers::kMaxSpareBytes / valueBytes; ++i)
+        {
+            KvEntry entry;
+            entry.value.assign(valueBytes, 'v');
+            data.push_back(std::move(entry));
+        }
+        buffers.recycle(data);
+        EXPECT_LE(buffers.retainedBytes(), WorkerBuffers::kMaxSpareBytes + 2 * WorkerBuffers::kMaxSpareBytes / valueBytes * sizeof(KvEntry));
+        EXPECT_GE(buffers.retainedBytes(), WorkerBuffers::kMaxSpareBytes / 2); })
+        .join();
+}
+
+// 设置了内存预算时，线程保留的字节数计入预算，线程退出后归还
+TEST(WorkerBuffersTest, RetainedBytesAreReservedInBudget)
+{
+    auto budget = std::make_shared<MemoryBudget>(uint64_t(1) << 40);
+    WorkerBuffers::setMemoryBudget(budget);
+    std::thread([&budget]
+                {
+        WorkerBuffers &buffers = WorkerBuffers::local();
+        DataType data;
+        data.reserve(1 << 16);
+        buffers.recycleVector(data);
+        EXPECT_EQ(budget->retained(), buffers.retainedBytes());
+        EXPECT_GE(budget->retained(), (1u << 16) * sizeof(KvEntry));
+        EXPECT_EQ(budget->reserved(), 0u); })
+        .join();
+    EXPECT_EQ(budget->retained(), 0u);
+    WorkerBuffers::setMemoryBudget(nullptr);
+}
+
+// 去重与过期过滤丢弃的条目移入 removed，而不是随 resize 析构
+TEST(WorkerBuffersTest, DedupAndExpireHandBackRemovedEntries)
+{
+    DataType data = {{"a", "1", 0}, {"a", "2", 0}, {"b", "3", 0}, {"c", "4", 5}};
+    DataType removed;
+    dedupSorted(data, &removed);
+    ASSERT_EQ(data.size(), 3u);
+    ASSERT_EQ(removed.size(), 1u);
+
+    EXPECT_EQ(dropExpired(data, 10, &removed), 1u);
+    ASSERT_EQ(data.size(), 2u);
+    EXPECT_EQ(data[0].key, "a");
+    EXPECT_EQ(data[1].key, "b");
+    ASSERT_EQ(removed.size(), 2u);
+    EXPECT_EQ(removed[1].key, "c");
+}
+
+// 嵌套借出（wait 中执行了另一个文件的任务）时各用各的缓冲区，归还后下一次复用
+TEST(WorkerBuffersTest, NestedLeasesGetDistinctBuffers)
+{
+    WorkerBuffers::FileBuffer *outerBuffer = nullptr;
+    {
+        FileBufferLease outer;
+        outer->input.assign(4096, 'x');
+        outerBuffer = &*outer;
+        {
+            FileBufferLease inner;
+            EXPECT_NE(&*inner, outerBuffer);
+            inner->input.assign("inner");
+        }
+        EXPECT_EQ(outer->input.size(), 4096u);
+    }
+    FileBufferLease again;
+    EXPECT_EQ(&*again, outerBuffer);
+    EXPECT_GE(again->input.capacity(), 4096u);
+}
+
+// 连续解析两个大小相同的文件，第二个文件的读入缓冲区与条目都来自第一个文件
+TEST(WorkerBuffersTest, JsonFileManagerReusesBuffersAcrossFiles)
+{
+    std::filesystem::path dir = DEFAULTDIC / "test_worker_buffers";
+    std::filesystem::create_directories(dir);
+    for (int i = 0; i < 2; ++i)
+    {
+        std::ofstream out(dir / ("data_" + std::to_string(i) + ".json"));
+        out << "[";
+        for (int k = 0; k < 100; ++k)
+            out << (k ? "," : "") << "{\"key\":\"key_" << i << "_" << k << "\",\"value\":\"value_" << k << "\"}";
+        out << "]";
+    }
+
+    MetricsCounter &bufferReuse = metricsCounter("bingest_worker_buffer_reuse_total", "");
+    MetricsCounter &entriesReused = metricsCounter("bingest_worker_entries_reused_total", "");
+    WorkerBuffers &buffers = WorkerBuffers::local();
+    JsonFileManager fileManager;
+
+    DataType first = fileManager.parse((dir / "data_0.json").string());
+    ASSERT_EQ(first.size(), 100u);
+    buffers.recycle(first);
+
+    uint64_t bufferReuseBefore = bufferReuse.value();
+    uint64_t entriesReusedBefore = entriesReused.value();
+    DataType second = fileManager.parse((dir / "data_1.json").string());
+    ASSERT_EQ(second.size(), 100u);
+    EXPECT_EQ(second[0].key, "key_1_0");
+    EXPECT_EQ(second[99].value, "value_99");
+    buffers.recycle(second);
+
+    EXPECT_EQ(bufferReuse.value(), bufferReuseBefore + 1);
+    EXPECT_GE(entriesReused.value(), entriesReusedBefore + 100);
+
+    std::filesystem::remove_all(dir);
+}